@@ -0,0 +1,461 @@
+// Host benchmark: firmware hot paths, built from the firmware sources
+// against the simulated board in sim/ (the same stand-ins pico_sim uses).
+//
+// For each path it reports ns/call (best of BENCH_REPEATS runs), heap
+// allocations per call, and rough cycle estimates for the two boards the
+// firmware runs on: the Pico 2's Cortex-M33 and the Pico's Cortex-M0+.
+// The estimates scale measured host cycles by the kind of arithmetic the
+// path does (cycle_scale below); they are good for spotting a path that
+// got 2x slower, not for an exact loop budget.
+//
+//   bench_hotpaths                      table on stdout
+//   bench_hotpaths --tsv > FILE         machine-readable, e.g. to refresh
+//                                       bench_hotpaths.tsv
+//   bench_hotpaths --compare FILE       deltas against FILE; exits 1 if
+//                                       any allocation count changed
+//   bench_hotpaths --iters N            calls per run (default 20000)
+//
+// bench_hotpaths.tsv holds the reference numbers; refresh it in the same
+// change as anything that moves them, so the diff shows up in review.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hal.h"
+#include "motor_ramp.h"
+
+// The static hot paths are reached by compiling their translation units
+// into this one.
+#include "adc_sampler.c"
+#include "imu.c"
+#include "temp_simple.c"
+#include "tempctrl.c"
+
+#define BENCH_ITERS   20000u
+#define BENCH_REPEATS 5
+#define SLOWER_FLAG   1.25   // --compare marks paths this much slower
+
+/* ------------------------------------------------------------------ */
+/* Allocation counting                                                */
+/* ------------------------------------------------------------------ */
+// Built with -Wl,--wrap=malloc,... (CMakeLists.txt), every allocation
+// made by firmware code goes through these. libc's own are not counted.
+#ifdef BENCH_WRAP_MALLOC
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+
+static unsigned long alloc_count;
+
+void *__wrap_malloc(size_t size) {
+    alloc_count++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    alloc_count++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t size) {
+    alloc_count++;
+    return __real_realloc(p, size);
+}
+#define ALLOCS_COUNTED 1
+#else
+static unsigned long alloc_count;
+#define ALLOCS_COUNTED 0
+#endif
+
+/* ------------------------------------------------------------------ */
+/* Benchmarks                                                         */
+/* ------------------------------------------------------------------ */
+// What dominates a path's cost on the target. Scales are host cycles ->
+// target cycles: an in-order core against a wide out-of-order one, worse
+// where the host has hardware the target lacks. The M33 has a
+// single-precision FPU and does doubles and libm in software; the M0+
+// does all floating point in software (the RP2040 ROM routines).
+enum { COST_INT, COST_F32, COST_LIBM, COST_F64 };
+static const struct {
+    double m33, m0plus;
+} cycle_scale[] = {
+    [COST_INT]  = {  3.0,  4.0 },
+    [COST_F32]  = {  4.0, 15.0 },
+    [COST_LIBM] = {  8.0, 20.0 },
+    [COST_F64]  = { 12.0, 20.0 },
+};
+
+static volatile uint32_t sink;
+
+static void null_writer(const char *buf, size_t len) {
+    (void)buf;
+    sink += (uint32_t)len;
+}
+
+static void setup_json(void) {
+    send_json_set_writer(null_writer);
+    set_status_format(STATUS_FORMAT_JSON);
+}
+
+static void setup_binary(void) {
+    send_json_set_writer(null_writer);
+    set_status_format(STATUS_FORMAT_BINARY);
+}
+
+// motor_status(): strings and ints.
+static void run_send_json_motor(uint32_t i) {
+    send_json(12,
+        KV_STR, "sensor_name", "motor",
+        KV_STR, "status", "update",
+        KV_INT, "app_id", 0,
+        KV_INT, "boot_id", 123456789,
+        KV_INT, "az_pos", (int)i,
+        KV_INT, "az_target_pos", 20000,
+        KV_INT, "el_pos", -(int)(i & 0xfff),
+        KV_INT, "el_target_pos", -4096,
+        KV_INT, "az_ramp_profile", 1,
+        KV_INT, "el_ramp_profile", 0,
+        KV_INT, "wp_index", -1,
+        KV_INT, "wp_count", 0);
+}
+
+// A tempctrl_status() channel: mostly non-integral floats.
+static void run_send_json_floats(uint32_t i) {
+    float t = 25.0f + (float)(i & 0xff) * 0.01f;
+    send_json(10,
+        KV_STR, "sensor_name", "tempctrl_lna",
+        KV_FLOAT, "T_now", (double)t,
+        KV_FLOAT, "T_target", 30.0,
+        KV_FLOAT, "drive", (double)(0.2f * (t - 25.0f)),
+        KV_FLOAT, "voltage", (double)(t / 20.0f),
+        KV_FLOAT, "resistance", (double)(t * 400.0f),
+        KV_FLOAT, "Kp", 0.2,
+        KV_FLOAT, "Ki", 0.0,
+        KV_FLOAT, "integral", (double)(t * 0.001f),
+        KV_BOOL, "enabled", 1);
+}
+
+static uint32_t ramp_steps = 100, ramp_cruise = 1200;
+static RampTable ramp_table;
+
+static void setup_ramp(void) {
+    ramp_table_build(&ramp_table, RAMP_PROFILE_LINEAR, ramp_steps, 2.5f,
+                     ramp_cruise);
+}
+
+static void run_ramp_extra(uint32_t i) {
+    sink += ramp_extra(i % (ramp_steps + 20), ramp_steps, 2.5f, ramp_cruise);
+}
+
+static void run_ramp_table_extra(uint32_t i) {
+    sink += ramp_table_extra(&ramp_table, i % (ramp_steps + 20));
+}
+
+// A stream of valid RVC packets with changing angles; one call per byte.
+#define RVC_STREAM_PACKETS 8
+static uint8_t rvc_stream[RVC_STREAM_PACKETS * RVC_PACKET_SIZE];
+static ImuState rvc_state;
+
+static void setup_rvc(void) {
+    memset(&rvc_state, 0, sizeof(rvc_state));
+    for (int p = 0; p < RVC_STREAM_PACKETS; p++) {
+        uint8_t *pkt = &rvc_stream[p * RVC_PACKET_SIZE];
+        memset(pkt, 0, RVC_PACKET_SIZE);
+        pkt[0] = pkt[1] = RVC_HEADER_BYTE;
+        pkt[2] = (uint8_t)p;
+        for (int b = 3; b < 15; b++) {
+            pkt[b] = (uint8_t)(p * 31 + b * 7);
+        }
+        uint8_t sum = 0;
+        for (int b = 2; b < RVC_PACKET_SIZE - 1; b++) {
+            sum += pkt[b];
+        }
+        pkt[RVC_PACKET_SIZE - 1] = sum;
+    }
+}
+
+static void run_rvc_feed_byte(uint32_t i) {
+    sink += rvc_feed_byte(&rvc_state, rvc_stream[i % sizeof(rvc_stream)]);
+}
+
+// Divider voltages across the thermistor's whole range, a few implausible.
+#define VOLTAGE_SWEEP 64
+static float voltage_sweep[VOLTAGE_SWEEP];
+
+static void setup_voltage(void) {
+    for (int k = 0; k < VOLTAGE_SWEEP; k++) {
+        voltage_sweep[k] = (float)k * THERMISTOR_SUPPLY_VOLTS
+                           / (VOLTAGE_SWEEP - 1);
+    }
+}
+
+// The float Steinhart-Hart fit the table is built from, for comparison.
+static void run_voltage_to_temperature(uint32_t i) {
+    float r, t;
+    if (thermistor_voltage_to_temperature(voltage_sweep[i % VOLTAGE_SWEEP],
+                                          &r, &t)) {
+        sink += (uint32_t)t;
+    }
+}
+
+// What temp_sensor_read() does per sample.
+static void setup_lut(void) {
+    setup_voltage();
+    thermistor_lut_build(&thermistor_lut);
+}
+
+static void run_lut_temperature(uint32_t i) {
+    float t;
+    if (thermistor_lut_temperature(&thermistor_lut,
+                                   voltage_sweep[i % VOLTAGE_SWEEP], &t)) {
+        sink += (uint32_t)t;
+    }
+}
+
+// The ADC sampler's DMA IRQ work for one block of the rfswitch's three
+// thermistor inputs (default 256-sample mean), set up by hand so no DMA
+// runs under the other benches.
+static void setup_adc_inputs(uint window, bool median) {
+    input_mask = 0x7;
+    n_inputs = 3;
+    for (uint k = 0; k < n_inputs; k++) {
+        order[k] = (uint8_t)k;
+        filter_reset(&filters[k]);
+        filters[k].window = window;
+        filters[k].median = median;
+    }
+    block_len = n_inputs * ADC_SAMPLER_BLOCK;
+    skip_block = false;
+    for (uint i = 0; i < block_len; i++) {
+        blocks[0][i] = (uint16_t)(1000 + (i * 2654435761u >> 24));
+    }
+}
+
+static void setup_adc_block(void) {
+    setup_adc_inputs(ADC_SAMPLER_AVG_BLOCKS, false);
+}
+
+// The same with tempctrl's filter: a median over 1024 samples.
+static void setup_adc_median(void) {
+    setup_adc_inputs(ADC_SAMPLER_MAX_BLOCKS, true);
+}
+
+static void run_adc_sampler_block(uint32_t i) {
+    (void)i;
+    block_done(blocks[0]);
+    sink += (uint32_t)filters[0].total;
+}
+
+// One channel under PI control, T_now wandering in and out of the
+// deadband; dt comes from the virtual clock (main() below).
+static TempControl pi_tc;
+
+static void setup_pi(void) {
+    memset(&pi_tc, 0, sizeof(pi_tc));
+    pi_tc.dir_pin1 = PELTIER_LNA_DIR_PIN1;
+    pi_tc.dir_pin2 = PELTIER_LNA_DIR_PIN2;
+    pi_tc.pwm_pin = PELTIER_LNA_PWM_PIN;
+    pi_tc.T_target = 30.0f;
+    pi_tc.Kp = 0.2f;
+    pi_tc.Ki = 0.01f;
+    pi_tc.clamp = 0.2f;
+    pi_tc.hysteresis = 0.5f;
+    pi_tc.cooling_enabled = true;
+}
+
+static void run_tempctrl_pi_drive(uint32_t i) {
+    pi_tc.T_now = 27.0f + (float)(i % 64) * 0.1f;
+    tempctrl_pi_drive(&pi_tc);
+}
+
+// A line of PicoPeltier.on_reconnect()'s replay, as main() handles it:
+// one parse into the command pool, then tempctrl_server()'s table
+// dispatch.
+static const char *replay_line =
+    "{\"LNA_Kp\":0.2,\"LNA_Ki\":0.01,\"LOAD_Kp\":0.2,\"LOAD_Ki\":0.01}";
+
+static void setup_command(void) {
+    cmd_pool_init();
+    tempctrl_init(APP_TEMPCTRL);
+}
+
+static void run_tempctrl_command(uint32_t i) {
+    (void)i;
+    cJSON *root = cmd_pool_parse(replay_line);
+    tempctrl_server(APP_TEMPCTRL, root);
+    cmd_pool_release(root);
+}
+
+typedef struct {
+    const char *name;
+    int cost;
+    void (*setup)(void);
+    void (*run)(uint32_t i);
+} Bench;
+
+static const Bench benches[] = {
+    { "send_json_motor",  COST_F64,  setup_json,    run_send_json_motor },
+    { "send_json_floats", COST_F64,  setup_json,    run_send_json_floats },
+    { "send_json_binary", COST_INT,  setup_binary,  run_send_json_motor },
+    { "ramp_extra",       COST_F32,  setup_ramp,    run_ramp_extra },
+    { "ramp_table_extra", COST_INT,  setup_ramp,    run_ramp_table_extra },
+    { "rvc_feed_byte",    COST_F32,  setup_rvc,     run_rvc_feed_byte },
+    { "thermistor_voltage_to_temperature",
+                          COST_LIBM, setup_voltage, run_voltage_to_temperature },
+    { "thermistor_lut_temperature",
+                          COST_F32,  setup_lut,     run_lut_temperature },
+    { "tempctrl_pi_drive", COST_F32, setup_pi,      run_tempctrl_pi_drive },
+    { "tempctrl_command", COST_F64,  setup_command, run_tempctrl_command },
+    { "adc_sampler_block", COST_INT, setup_adc_block, run_adc_sampler_block },
+    { "adc_sampler_median", COST_INT, setup_adc_median,
+      run_adc_sampler_block },
+};
+#define N_BENCHES (sizeof(benches) / sizeof(benches[0]))
+
+typedef struct {
+    double ns;
+    double allocs;
+    double m33_cycles;
+    double m0plus_cycles;
+} Result;
+
+/* ------------------------------------------------------------------ */
+/* Harness                                                            */
+/* ------------------------------------------------------------------ */
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Host clock in cycles/ns, timed on a chain of dependent adds, which
+// retire at one per cycle on any core.
+static double host_ghz(void) {
+    const uint32_t n = 1000000u;
+    uint32_t x = 0;
+    double best = 1e30;
+    for (int r = 0; r < 100; r++) {   // short runs: the best dodges preemption
+        double t0 = now_ns();
+        for (uint32_t i = 0; i < n; i++) {
+            __asm__ volatile("" : "+r"(x));
+            x++;
+        }
+        double dt = now_ns() - t0;
+        if (dt < best) best = dt;
+    }
+    sink += x;
+    return n / best;
+}
+
+static Result measure(const Bench *b, uint32_t iters, double ghz) {
+    Result res = { 1e30, 0.0, 0.0, 0.0 };
+    b->setup();
+    for (uint32_t i = 0; i < iters / 10; i++) {
+        b->run(i);   // warm caches and branch predictors
+    }
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        unsigned long allocs0 = alloc_count;
+        double t0 = now_ns();
+        for (uint32_t i = 0; i < iters; i++) {
+            b->run(i);
+        }
+        double ns = (now_ns() - t0) / iters;
+        if (ns < res.ns) res.ns = ns;
+        res.allocs = (double)(alloc_count - allocs0) / iters;
+    }
+    res.m33_cycles = res.ns * ghz * cycle_scale[b->cost].m33;
+    res.m0plus_cycles = res.ns * ghz * cycle_scale[b->cost].m0plus;
+    return res;
+}
+
+// Reference line for `name` in a --tsv file; false if missing.
+static bool load_reference(FILE *f, const char *name, Result *ref) {
+    char line[256], key[128];
+    rewind(f);
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%127s %lf %lf %lf %lf", key, &ref->ns,
+                   &ref->allocs, &ref->m33_cycles, &ref->m0plus_cycles) == 5
+            && strcmp(key, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [--tsv | --compare FILE] [--iters N]\n",
+            argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    bool tsv = false;
+    const char *compare = NULL;
+    uint32_t iters = BENCH_ITERS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tsv") == 0) {
+            tsv = true;
+        } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            compare = argv[++i];
+        } else if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = (uint32_t)strtoul(argv[++i], NULL, 10);
+            if (iters == 0) usage(argv[0]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    FILE *ref_file = NULL;
+    if (compare) {
+        ref_file = fopen(compare, "r");
+        if (!ref_file) {
+            perror(compare);
+            return 2;
+        }
+    }
+
+    // Every time query moves the clock 1 ms, so the PI step sees dt > 0.
+    hal_clock_virtual(1000);
+    double ghz = host_ghz();
+    int status = 0;
+
+    if (tsv) {
+        printf("# host %.2f GHz\n", ghz);
+        printf("# name\tns_per_call\tallocs_per_call\tm33_cycles"
+               "\tm0plus_cycles\n");
+    } else {
+        printf("host %.2f GHz, %u calls x %d runs%s\n", ghz, iters,
+               BENCH_REPEATS, ALLOCS_COUNTED ? "" : ", allocations not counted");
+        printf("%-36s %10s %8s %10s %10s\n", "", "ns/call", "allocs",
+               "M33 cyc", "M0+ cyc");
+    }
+    for (size_t k = 0; k < N_BENCHES; k++) {
+        const Bench *b = &benches[k];
+        Result res = measure(b, iters, ghz);
+        if (tsv) {
+            printf("%s\t%.2f\t%.2f\t%.0f\t%.0f\n", b->name, res.ns,
+                   res.allocs, res.m33_cycles, res.m0plus_cycles);
+            continue;
+        }
+        printf("%-36s %10.2f %8.2f %10.0f %10.0f", b->name, res.ns,
+               res.allocs, res.m33_cycles, res.m0plus_cycles);
+        Result ref;
+        if (ref_file && load_reference(ref_file, b->name, &ref)) {
+            double ratio = res.ns / ref.ns;
+            printf("  %+5.0f%%%s", (ratio - 1.0) * 100.0,
+                   ratio > SLOWER_FLAG ? " SLOWER" : "");
+            if (ALLOCS_COUNTED && res.allocs != ref.allocs) {
+                printf("  ALLOCS %.2f -> %.2f", ref.allocs, res.allocs);
+                status = 1;
+            }
+        } else if (ref_file) {
+            printf("  (new)");
+        }
+        printf("\n");
+    }
+    if (ref_file) fclose(ref_file);
+    return status;
+}
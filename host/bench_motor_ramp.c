@@ -0,0 +1,46 @@
+// Host benchmark: per-step cost of ramp_extra() vs ramp_table_extra().
+//
+// Walks the default firmware profile (RAMP_STEPS=100, F=2.5, 1200 us
+// cruise) the way stepper_op() does and reports ns per call. Host numbers
+// only show the relative cost; on the pico the float path is slower still.
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <time.h>
+#include "motor_ramp.h"
+
+#define BENCH_ITERS 2000000u
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main(void) {
+    const uint32_t ramp_steps = 100, cruise = 1200;
+    const float factor = 2.5f;
+    static RampTable t;
+    volatile uint32_t sink = 0;
+
+    double t0 = now_ns();
+    ramp_table_build(&t, RAMP_PROFILE_LINEAR, ramp_steps, factor, cruise);
+    double build_ns = now_ns() - t0;
+
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERS; i++) {
+        sink += ramp_extra(i % (ramp_steps + 20), ramp_steps, factor, cruise);
+    }
+    double analytic_ns = (now_ns() - t0) / BENCH_ITERS;
+
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_ITERS; i++) {
+        sink += ramp_table_extra(&t, i % (ramp_steps + 20));
+    }
+    double table_ns = (now_ns() - t0) / BENCH_ITERS;
+
+    printf("ramp_table_build: %.0f ns\n", build_ns);
+    printf("ramp_extra:       %.2f ns/call\n", analytic_ns);
+    printf("ramp_table_extra: %.2f ns/call\n", table_ns);
+    return sink == 0xffffffffu;  // keep the loops live
+}
@@ -0,0 +1,1198 @@
+#define _POSIX_C_SOURCE 200809L
+#include "hal.h"
+#include "pico/bootrom.h"
+#include "pico/rand.h"
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pwm.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "hardware/watchdog.h"
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SYS_CLK_HZ      150000000u   // RP2350 default clk_sys
+#define NUM_IRQS        32
+#define NUM_PWM_SLICES  8
+#define NUM_ADC_INPUTS  5
+#define ADC_VREF        3.3f
+#define ADC_CLK_MHZ     48u          // clk_adc
+#define ADC_CONV_CYCLES 96u          // fastest conversion, 500 ksps
+#define NUM_DMA_CHANNELS 12
+#define UART_FIFO_LEN   32
+#define I2C_TARGETS     4
+#define CDC_RX_SIZE     256          // tinyusb CFG_TUD_CDC_RX_BUFSIZE
+#define USB_FRAME_US    1000
+#define PIO_INSTR_MEM   32
+#define PIO_FIFO_LEN    4
+#define MAX_PERIODIC    8
+
+/* ------------------------------------------------------------------ */
+/* Clock                                                               */
+/* ------------------------------------------------------------------ */
+
+static uint64_t boot_host_us;
+static double   clock_rate = 1.0;    // hal_clock_scale()
+static bool     clock_virtual;       // hal_clock_virtual()
+static uint32_t virtual_step_us;
+static uint64_t virtual_us;
+static bool     clock_held;          // while an event's IRQs run
+static uint64_t held_us;
+static uint64_t run_limit_us;
+
+static uint64_t host_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static uint64_t clock_us(void) {
+    if (clock_held) {
+        return held_us;
+    }
+    if (clock_virtual) {
+        return virtual_us;
+    }
+    if (boot_host_us == 0) {
+        boot_host_us = host_us();
+    }
+    return (uint64_t)((double)(host_us() - boot_host_us) * clock_rate);
+}
+
+static void host_nap_us(uint64_t us) {
+    struct timespec ts = { (time_t)(us / 1000000u),
+                           (long)(us % 1000000u) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+/* Let `us` of firmware time go by while waiting on something. */
+static void idle_us(uint64_t us) {
+    if (clock_virtual) {
+        virtual_us += us;
+    } else {
+        host_nap_us((uint64_t)((double)us / clock_rate));
+    }
+}
+
+/* A time query costs virtual_step_us of virtual time, standing in for
+ * the code run between two of them. */
+static void clock_tick(void) {
+    if (clock_virtual && !clock_held) {
+        virtual_us += virtual_step_us;
+    }
+}
+
+void hal_clock_scale(double rate) {
+    if (rate > 0.0) {
+        clock_rate = rate;
+    }
+}
+
+void hal_clock_virtual(uint32_t step_us) {
+    clock_virtual = true;
+    virtual_step_us = step_us ? step_us : 1;
+}
+
+/* ------------------------------------------------------------------ */
+/* Interrupt model state                                               */
+/* ------------------------------------------------------------------ */
+
+static bool irq_masked;
+static bool in_irq;
+static irq_handler_t irq_handlers[NUM_IRQS];
+static bool irq_enabled[NUM_IRQS];
+
+static void hal_service(void);
+
+/* ------------------------------------------------------------------ */
+/* GPIO                                                                */
+/* ------------------------------------------------------------------ */
+
+static struct {
+    uint8_t fn;
+    bool    is_out;
+    bool    out;
+    bool    pull_up;
+    bool    pull_down;
+    bool    driven;       // held by the bench (hal_gpio_drive)
+    bool    drive_level;
+} pins[NUM_BANK0_GPIOS];
+
+void gpio_init(uint gpio) {
+    if (gpio >= NUM_BANK0_GPIOS) return;
+    pins[gpio].fn = GPIO_FUNC_SIO;
+    pins[gpio].is_out = false;
+    pins[gpio].out = false;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    if (gpio < NUM_BANK0_GPIOS) pins[gpio].fn = (uint8_t)fn;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    if (gpio < NUM_BANK0_GPIOS) pins[gpio].is_out = out;
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio < NUM_BANK0_GPIOS) pins[gpio].out = value;
+}
+
+void gpio_put_masked(uint32_t mask, uint32_t value) {
+    for (uint gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        if (mask & (1u << gpio)) pins[gpio].out = (value >> gpio) & 1u;
+    }
+}
+
+bool gpio_get(uint gpio) {
+    if (gpio >= NUM_BANK0_GPIOS) return false;
+    if (pins[gpio].fn == GPIO_FUNC_SIO && pins[gpio].is_out) {
+        return pins[gpio].out;
+    }
+    if (pins[gpio].driven) return pins[gpio].drive_level;
+    return pins[gpio].pull_up;
+}
+
+void gpio_pull_up(uint gpio) {
+    if (gpio >= NUM_BANK0_GPIOS) return;
+    pins[gpio].pull_up = true;
+    pins[gpio].pull_down = false;
+}
+
+void gpio_pull_down(uint gpio) {
+    if (gpio >= NUM_BANK0_GPIOS) return;
+    pins[gpio].pull_up = false;
+    pins[gpio].pull_down = true;
+}
+
+void gpio_disable_pulls(uint gpio) {
+    if (gpio >= NUM_BANK0_GPIOS) return;
+    pins[gpio].pull_up = false;
+    pins[gpio].pull_down = false;
+}
+
+void hal_gpio_drive(uint gpio, int level) {
+    if (gpio >= NUM_BANK0_GPIOS) return;
+    pins[gpio].driven = level != HAL_GPIO_FLOAT;
+    pins[gpio].drive_level = level > 0;
+}
+
+bool hal_gpio_out(uint gpio) {
+    return gpio < NUM_BANK0_GPIOS && pins[gpio].is_out && pins[gpio].out;
+}
+
+/* ------------------------------------------------------------------ */
+/* PWM                                                                 */
+/* ------------------------------------------------------------------ */
+
+static pwm_config pwm_slices[NUM_PWM_SLICES];
+static bool pwm_running[NUM_PWM_SLICES];
+static uint16_t pwm_levels[NUM_PWM_SLICES][2];
+
+pwm_config pwm_get_default_config(void) {
+    pwm_config c = { .csr = 0, .div = 1u << 4, .top = 0xffff };
+    return c;
+}
+
+void pwm_config_set_clkdiv(pwm_config *c, float div) {
+    c->div = (uint32_t)(div * 16.0f);
+}
+
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap) {
+    c->top = wrap;
+}
+
+void pwm_init(uint slice_num, pwm_config *c, bool start) {
+    if (slice_num >= NUM_PWM_SLICES) return;
+    pwm_slices[slice_num] = *c;
+    pwm_levels[slice_num][0] = 0;
+    pwm_levels[slice_num][1] = 0;
+    pwm_running[slice_num] = start;
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level) {
+    pwm_levels[pwm_gpio_to_slice_num(gpio)][gpio & 1u] = level;
+}
+
+float hal_pwm_duty(uint gpio) {
+    uint slice = pwm_gpio_to_slice_num(gpio);
+    if (!pwm_running[slice]) return 0.0f;
+    float duty = (float)pwm_levels[slice][gpio & 1u] /
+                 ((float)pwm_slices[slice].top + 1.0f);
+    return duty > 1.0f ? 1.0f : duty;
+}
+
+/* ------------------------------------------------------------------ */
+/* ADC                                                                 */
+/* ------------------------------------------------------------------ */
+
+static float adc_volts[NUM_ADC_INPUTS] = { 1.65f, 1.65f, 1.65f, 1.65f, 1.65f };
+static uint adc_input;
+static uint adc_rr_mask;
+static bool adc_dreq;
+static bool adc_running;
+static uint32_t adc_period_cycles = ADC_CONV_CYCLES;
+static adc_hw_t adc_block;
+adc_hw_t *const adc_hw_inst = &adc_block;
+
+static void dma_adc_run(bool run);
+
+void adc_init(void) {
+    adc_input = 0;
+    adc_rr_mask = 0;
+    adc_dreq = false;
+    adc_running = false;
+}
+
+void adc_gpio_init(uint gpio) {
+    gpio_set_function(gpio, GPIO_FUNC_NULL);
+}
+
+void adc_select_input(uint input) {
+    if (input < NUM_ADC_INPUTS) adc_input = input;
+}
+
+uint adc_get_selected_input(void) {
+    return adc_input;
+}
+
+/* One conversion of the selected input; round robin then moves the mux
+ * on to the next enabled input, as the hardware does. */
+uint16_t adc_read(void) {
+    uint16_t counts =
+        (uint16_t)lroundf(adc_volts[adc_input] / ADC_VREF * 4095.0f);
+    if (adc_rr_mask != 0) {
+        do {
+            adc_input = (adc_input + 1) % NUM_ADC_INPUTS;
+        } while (!(adc_rr_mask & (1u << adc_input)));
+    }
+    return counts;
+}
+
+void adc_set_round_robin(uint input_mask) {
+    adc_rr_mask = input_mask & ((1u << NUM_ADC_INPUTS) - 1);
+}
+
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh,
+                    bool err_in_fifo, bool byte_shift) {
+    (void)dreq_thresh;
+    (void)err_in_fifo;
+    (void)byte_shift;
+    adc_dreq = en && dreq_en;
+}
+
+void adc_set_clkdiv(float clkdiv) {
+    uint32_t cycles = 1u + (uint32_t)clkdiv;
+    adc_period_cycles = cycles > ADC_CONV_CYCLES ? cycles : ADC_CONV_CYCLES;
+}
+
+void adc_run(bool run) {
+    adc_running = run;
+    dma_adc_run(run && adc_dreq);
+}
+
+void adc_fifo_drain(void) {
+}
+
+void hal_adc_set_voltage(uint input, float volts) {
+    if (input >= NUM_ADC_INPUTS) return;
+    adc_volts[input] = fminf(ADC_VREF, fmaxf(0.0f, volts));
+}
+
+/* ------------------------------------------------------------------ */
+/* DMA                                                                 */
+/*                                                                     */
+/* Only transfers paced by the free-running ADC are modelled. A        */
+/* channel's whole transfer lands at once, when the ADC would have     */
+/* made its last conversion, then raises its IRQ and triggers its      */
+/* chain_to channel.                                                   */
+/* ------------------------------------------------------------------ */
+
+static struct dma_sim {
+    bool                claimed;
+    dma_channel_config  cfg;
+    volatile void      *write;
+    const volatile void *read;
+    uint32_t            count;
+    bool                busy;
+    uint64_t            done_at;     // UINT64_MAX while the ADC is stopped
+    bool                irq0_enabled;
+    bool                irq0_status;
+} dma_chans[NUM_DMA_CHANNELS];
+
+static uint64_t dma_adc_duration_us(uint32_t count) {
+    return ((uint64_t)count * adc_period_cycles + ADC_CLK_MHZ - 1)
+           / ADC_CLK_MHZ;
+}
+
+static void dma_trigger(uint ch, uint64_t now) {
+    struct dma_sim *d = &dma_chans[ch];
+    if (d->read != &adc_hw->fifo || d->cfg.dreq != DREQ_ADC) {
+        fprintf(stderr, "pico_sim: only ADC-paced DMA is modelled\n");
+        abort();
+    }
+    d->busy = true;
+    d->done_at = adc_running && adc_dreq
+                     ? now + dma_adc_duration_us(d->count) : UINT64_MAX;
+}
+
+static void dma_adc_run(bool run) {
+    uint64_t now = clock_us();
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        struct dma_sim *d = &dma_chans[ch];
+        if (!d->busy) continue;
+        d->done_at = run ? now + dma_adc_duration_us(d->count) : UINT64_MAX;
+    }
+}
+
+static void dma_complete(uint ch, uint64_t now) {
+    struct dma_sim *d = &dma_chans[ch];
+    uint32_t size = 1u << d->cfg.size;
+    uint8_t *dst = (uint8_t *)d->write;
+    for (uint32_t i = 0; i < d->count; i++) {
+        uint16_t counts = adc_read();
+        if (size == 2) {
+            memcpy(dst, &counts, 2);
+        } else if (size == 4) {
+            uint32_t word = counts;
+            memcpy(dst, &word, 4);
+        } else {
+            *dst = (uint8_t)(counts >> 4);
+        }
+        if (d->cfg.write_incr) dst += size;
+    }
+    d->write = dst;
+    d->busy = false;
+    d->done_at = UINT64_MAX;
+    d->irq0_status = true;
+    if (d->cfg.chain_to != ch) {
+        dma_trigger(d->cfg.chain_to, now);
+    }
+}
+
+int dma_claim_unused_channel(bool required) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (!dma_chans[ch].claimed) {
+            dma_chans[ch].claimed = true;
+            return (int)ch;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "pico_sim: no free DMA channel\n");
+        abort();
+    }
+    return -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    dma_channel_config c = {
+        .size = DMA_SIZE_32, .read_incr = true, .write_incr = false,
+        .dreq = 0x3f, .chain_to = (uint8_t)channel,
+    };
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c,
+                                           enum dma_channel_transfer_size size) {
+    c->size = (uint8_t)size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    c->read_incr = incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    c->write_incr = incr;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    c->dreq = (uint8_t)dreq;
+}
+
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to) {
+    c->chain_to = (uint8_t)chain_to;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config,
+                           volatile void *write_addr,
+                           const volatile void *read_addr,
+                           uint transfer_count, bool trigger) {
+    struct dma_sim *d = &dma_chans[channel];
+    d->cfg = *config;
+    d->write = write_addr;
+    d->read = read_addr;
+    d->count = transfer_count;
+    if (trigger) dma_trigger(channel, clock_us());
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr,
+                                bool trigger) {
+    dma_chans[channel].write = write_addr;
+    if (trigger) dma_trigger(channel, clock_us());
+}
+
+void dma_channel_start(uint channel) {
+    dma_trigger(channel, clock_us());
+}
+
+void dma_channel_abort(uint channel) {
+    dma_chans[channel].busy = false;
+    dma_chans[channel].done_at = UINT64_MAX;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    dma_chans[channel].irq0_enabled = enabled;
+}
+
+bool dma_channel_get_irq0_status(uint channel) {
+    return dma_chans[channel].irq0_enabled && dma_chans[channel].irq0_status;
+}
+
+void dma_channel_acknowledge_irq0(uint channel) {
+    dma_chans[channel].irq0_status = false;
+}
+
+/* ------------------------------------------------------------------ */
+/* Timer alarms                                                        */
+/*                                                                     */
+/* The hardware_alarm API of the 64-bit microsecond timer. An alarm    */
+/* fires as an event at its target and its callback runs as that       */
+/* alarm's TIMER_IRQ, ahead of the other IRQs.                         */
+/* ------------------------------------------------------------------ */
+
+static struct alarm_sim {
+    bool                      claimed;
+    hardware_alarm_callback_t callback;
+    bool                      armed;
+    uint64_t                  target;
+    bool                      pending;   // fired, callback not yet run
+} alarms[NUM_ALARMS];
+
+int hardware_alarm_claim_unused(bool required) {
+    for (uint a = 0; a < NUM_ALARMS; a++) {
+        if (!alarms[a].claimed) {
+            alarms[a].claimed = true;
+            return (int)a;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "pico_sim: no free hardware alarm\n");
+        abort();
+    }
+    return -1;
+}
+
+void hardware_alarm_unclaim(uint alarm_num) {
+    alarms[alarm_num] = (struct alarm_sim){ 0 };
+}
+
+void hardware_alarm_set_callback(uint alarm_num,
+                                 hardware_alarm_callback_t callback) {
+    alarms[alarm_num].callback = callback;
+    if (callback == NULL) {
+        alarms[alarm_num].armed = false;
+        alarms[alarm_num].pending = false;
+    }
+}
+
+/* As on hardware: true, arming nothing, for a target already past. */
+bool hardware_alarm_set_target(uint alarm_num, absolute_time_t t) {
+    struct alarm_sim *a = &alarms[alarm_num];
+    if (to_us_since_boot(t) <= clock_us()) {
+        a->armed = false;
+        return true;
+    }
+    a->armed = true;
+    a->target = to_us_since_boot(t);
+    return false;
+}
+
+void hardware_alarm_cancel(uint alarm_num) {
+    alarms[alarm_num].armed = false;
+    alarms[alarm_num].pending = false;
+}
+
+/* ------------------------------------------------------------------ */
+/* UART (RX only)                                                      */
+/* ------------------------------------------------------------------ */
+
+struct uart_inst {
+    uart_hw_t hw;
+    bool     enabled;
+    bool     rx_irq;     // uart_set_irq_enables(rx_has_data)
+    uint8_t  fifo[UART_FIFO_LEN];
+    uint32_t head;
+    uint32_t count;
+};
+
+static struct uart_inst uart_blocks[2];
+uart_inst_t *const uart0_inst = &uart_blocks[0];
+uart_inst_t *const uart1_inst = &uart_blocks[1];
+
+uint uart_init(uart_inst_t *uart, uint baudrate) {
+    uart->enabled = true;
+    uart->rx_irq = false;
+    uart->hw.rsr = 0;
+    uart->head = 0;
+    uart->count = 0;
+    return baudrate;
+}
+
+void uart_deinit(uart_inst_t *uart) {
+    uart->enabled = false;
+    uart->rx_irq = false;
+}
+
+uart_hw_t *uart_get_hw(uart_inst_t *uart) {
+    return &uart->hw;
+}
+
+void uart_set_irq_enables(uart_inst_t *uart, bool rx_has_data,
+                          bool tx_needs_data) {
+    (void)tx_needs_data;   // RX only
+    uart->rx_irq = rx_has_data;
+}
+
+bool uart_is_readable(uart_inst_t *uart) {
+    return uart->count > 0;
+}
+
+char uart_getc(uart_inst_t *uart) {
+    while (uart->count == 0) {   // blocks, as on the device
+        hal_service();
+        idle_us(10);
+    }
+    char c = (char)uart->fifo[uart->head];
+    uart->head = (uart->head + 1) % UART_FIFO_LEN;
+    uart->count--;
+    return c;
+}
+
+size_t hal_uart_rx_push(uart_inst_t *uart, const uint8_t *src, size_t len) {
+    size_t n = 0;
+    if (!uart->enabled) return 0;
+    while (n < len && uart->count < UART_FIFO_LEN) {
+        uart->fifo[(uart->head + uart->count) % UART_FIFO_LEN] = src[n++];
+        uart->count++;
+    }
+    if (n < len) {
+        uart->hw.rsr |= UART_UARTRSR_OE_BITS;
+    }
+    return n;
+}
+
+/* ------------------------------------------------------------------ */
+/* I2C (controller reads)                                              */
+/* ------------------------------------------------------------------ */
+
+struct i2c_inst {
+    bool enabled;
+    struct {
+        uint8_t         addr;
+        hal_i2c_read_fn  read;
+        hal_i2c_write_fn write;
+        void            *ctx;
+    } targets[I2C_TARGETS];
+    uint n_targets;
+};
+
+static struct i2c_inst i2c_blocks[2];
+i2c_inst_t *const i2c0_inst = &i2c_blocks[0];
+i2c_inst_t *const i2c1_inst = &i2c_blocks[1];
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    i2c->enabled = true;
+    return baudrate;
+}
+
+void i2c_deinit(i2c_inst_t *i2c) {
+    i2c->enabled = false;
+}
+
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst,
+                        size_t len, bool nostop, uint timeout_us) {
+    (void)nostop;
+    (void)timeout_us;
+    if (!i2c->enabled) return PICO_ERROR_GENERIC;
+    for (uint i = 0; i < i2c->n_targets; i++) {
+        if (i2c->targets[i].addr == addr) {
+            return i2c->targets[i].read(i2c->targets[i].ctx, dst, len);
+        }
+    }
+    return PICO_ERROR_GENERIC;   // address NAK
+}
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src,
+                         size_t len, bool nostop, uint timeout_us) {
+    (void)nostop;
+    (void)timeout_us;
+    if (!i2c->enabled) return PICO_ERROR_GENERIC;
+    for (uint i = 0; i < i2c->n_targets; i++) {
+        if (i2c->targets[i].addr == addr) {
+            if (i2c->targets[i].write == NULL) return (int)len;
+            return i2c->targets[i].write(i2c->targets[i].ctx, src, len);
+        }
+    }
+    return PICO_ERROR_GENERIC;
+}
+
+void hal_i2c_attach(i2c_inst_t *i2c, uint8_t addr, hal_i2c_read_fn read,
+                    hal_i2c_write_fn write, void *ctx) {
+    if (i2c->n_targets >= I2C_TARGETS) return;
+    i2c->targets[i2c->n_targets].addr = addr;
+    i2c->targets[i2c->n_targets].read = read;
+    i2c->targets[i2c->n_targets].write = write;
+    i2c->targets[i2c->n_targets].ctx = ctx;
+    i2c->n_targets++;
+}
+
+/* ------------------------------------------------------------------ */
+/* PIO                                                                 */
+/*                                                                     */
+/* The only program the firmware loads is stepper.pio, so a state      */
+/* machine is modelled as that program: each TX word is pulled as soon */
+/* as the SM is free, raises IRQ flag sm ("irq 0 rel") on its rising   */
+/* edge, and frees the SM (x + 3) + (y + 5) us later. The few ticks    */
+/* between pull and edge are not modelled.                             */
+/* ------------------------------------------------------------------ */
+
+struct pio_sm_sim {
+    bool     claimed;
+    bool     enabled;
+    uint32_t depth;            // 8 with the TX FIFO joined
+    uint32_t fifo[2 * PIO_FIFO_LEN];
+    uint64_t put_at[2 * PIO_FIFO_LEN];
+    uint32_t head;
+    uint32_t count;
+    uint64_t free_at;          // SM back at `pull`
+    uint64_t disabled_at;
+    uint64_t steps;
+};
+
+struct pio_hw {
+    uint32_t          instr_used;
+    uint32_t          irq_flags;
+    uint32_t          inte0;
+    struct pio_sm_sim sm[NUM_PIO_STATE_MACHINES];
+};
+
+static pio_hw_t pio_blocks[2];
+pio_hw_t *const pio0_inst = &pio_blocks[0];
+pio_hw_t *const pio1_inst = &pio_blocks[1];
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    if (pio->instr_used + program->length > PIO_INSTR_MEM) {
+        fprintf(stderr, "pico_sim: PIO instruction memory full\n");
+        abort();
+    }
+    uint offset = pio->instr_used;
+    pio->instr_used += program->length;
+    return offset;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    for (int sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+        if (!pio->sm[sm].claimed) {
+            pio->sm[sm].claimed = true;
+            return sm;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "pico_sim: no free PIO state machine\n");
+        abort();
+    }
+    return -1;
+}
+
+void pio_gpio_init(PIO pio, uint pin) {
+    gpio_set_function(pin, pio == pio0 ? GPIO_FUNC_PIO0 : GPIO_FUNC_PIO1);
+}
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc,
+                 const pio_sm_config *config) {
+    (void)initial_pc;
+    struct pio_sm_sim *s = &pio->sm[sm];
+    s->enabled = false;
+    s->depth = (config->shiftctrl >> 30) == PIO_FIFO_JOIN_TX
+                   ? 2 * PIO_FIFO_LEN : PIO_FIFO_LEN;
+    s->head = 0;
+    s->count = 0;
+    s->free_at = 0;
+    s->disabled_at = 0;
+}
+
+/* A paused SM resumes mid-phase, so its pending edge moves out by the
+ * time it spent disabled. */
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+    struct pio_sm_sim *s = &pio->sm[sm];
+    uint64_t now = clock_us();
+    if (enabled && !s->enabled) {
+        if (s->free_at > s->disabled_at) {
+            s->free_at += now - s->disabled_at;
+        }
+    } else if (!enabled && s->enabled) {
+        s->disabled_at = now;
+    }
+    s->enabled = enabled;
+}
+
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values,
+                               uint32_t pin_mask) {
+    (void)pio;
+    (void)sm;
+    (void)pin_values;
+    (void)pin_mask;
+}
+
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base,
+                                    uint pin_count, bool is_out) {
+    (void)pio;
+    (void)sm;
+    (void)pin_base;
+    (void)pin_count;
+    (void)is_out;
+}
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data) {
+    struct pio_sm_sim *s = &pio->sm[sm];
+    if (s->count >= s->depth) return;   // TXOVER: the write is lost
+    uint32_t at = (s->head + s->count) % s->depth;
+    s->fifo[at] = data;
+    s->put_at[at] = clock_us();
+    s->count++;
+}
+
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm) {
+    return pio->sm[sm].count >= pio->sm[sm].depth;
+}
+
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm) {
+    return pio->sm[sm].count;
+}
+
+void pio_sm_clear_fifos(PIO pio, uint sm) {
+    pio->sm[sm].count = 0;
+}
+
+void pio_set_irq0_source_enabled(PIO pio, pio_interrupt_source_t source,
+                                 bool enabled) {
+    if (enabled) {
+        pio->inte0 |= 1u << source;
+    } else {
+        pio->inte0 &= ~(1u << source);
+    }
+}
+
+bool pio_interrupt_get(PIO pio, uint pio_interrupt_num) {
+    return (pio->irq_flags >> pio_interrupt_num) & 1u;
+}
+
+void pio_interrupt_clear(PIO pio, uint pio_interrupt_num) {
+    pio->irq_flags &= ~(1u << pio_interrupt_num);
+}
+
+uint64_t hal_pio_steps(PIO pio, uint sm) {
+    return pio->sm[sm].steps;
+}
+
+/* When the SM next pulls a word (and puts out its edge). */
+static uint64_t pio_sm_next_edge(const struct pio_sm_sim *s) {
+    if (!s->enabled || s->count == 0) return UINT64_MAX;
+    uint64_t put = s->put_at[s->head];
+    return put > s->free_at ? put : s->free_at;
+}
+
+static void pio_sm_edge(PIO pio, uint sm, uint64_t t) {
+    struct pio_sm_sim *s = &pio->sm[sm];
+    uint32_t word = s->fifo[s->head];
+    s->head = (s->head + 1) % s->depth;
+    s->count--;
+    s->free_at = t + (word & 0xffffu) + 3 + (word >> 16) + 5;
+    s->steps++;
+    pio->irq_flags |= 1u << (sm % 4);
+}
+
+/* ------------------------------------------------------------------ */
+/* USB CDC stdio                                                       */
+/* ------------------------------------------------------------------ */
+
+static uint8_t  cdc_rx[CDC_RX_SIZE];
+static uint32_t cdc_head;
+static uint32_t cdc_count;
+static int      usb_in_fd = -1;
+static char    *usb_injected;
+static size_t   usb_injected_len;
+static size_t   usb_injected_off;
+static uint64_t usb_next_frame = USB_FRAME_US;
+static struct usb_timed {
+    uint64_t at_us;
+    char    *data;       // NULL once released
+    size_t   len;
+} *usb_timed;
+static size_t   n_usb_timed;
+static bool     usb_irq_pending;
+static void   (*chars_available)(void *);
+static void    *chars_available_param;
+
+bool stdio_init_all(void) {
+    return true;
+}
+
+void stdio_set_chars_available_callback(void (*fn)(void *), void *param) {
+    chars_available = fn;
+    chars_available_param = param;
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    uint64_t deadline = clock_us() + timeout_us;
+    while (cdc_count == 0) {
+        if (timeout_us == 0 || clock_us() >= deadline) {
+            return PICO_ERROR_TIMEOUT;
+        }
+        hal_service();
+        idle_us(10);
+    }
+    int c = cdc_rx[cdc_head];
+    cdc_head = (cdc_head + 1) % CDC_RX_SIZE;
+    cdc_count--;
+    return c;
+}
+
+void hal_usb_set_input(int in_fd) {
+    usb_in_fd = in_fd;
+}
+
+void hal_usb_inject(uint64_t at_us, const char *src, size_t len) {
+    struct usb_timed *grown = realloc(usb_timed,
+                                      (n_usb_timed + 1) * sizeof(*grown));
+    char *copy = malloc(len);
+    if (grown == NULL || copy == NULL) {
+        free(copy);
+        return;
+    }
+    usb_timed = grown;
+    memcpy(copy, src, len);
+    usb_timed[n_usb_timed].at_us = at_us;
+    usb_timed[n_usb_timed].data = copy;
+    usb_timed[n_usb_timed].len = len;
+    n_usb_timed++;
+}
+
+/* Move injected input that is due onto the host side of the link. */
+static void usb_release_timed(uint64_t now) {
+    for (size_t i = 0; i < n_usb_timed; i++) {
+        if (usb_timed[i].data == NULL || usb_timed[i].at_us > now) continue;
+        char *grown = realloc(usb_injected,
+                              usb_injected_len + usb_timed[i].len);
+        if (grown == NULL) return;
+        usb_injected = grown;
+        memcpy(usb_injected + usb_injected_len, usb_timed[i].data,
+               usb_timed[i].len);
+        usb_injected_len += usb_timed[i].len;
+        free(usb_timed[i].data);
+        usb_timed[i].data = NULL;
+    }
+}
+
+static void cdc_rx_put(const uint8_t *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        cdc_rx[(cdc_head + cdc_count) % CDC_RX_SIZE] = src[i];
+        cdc_count++;
+    }
+}
+
+/* One USB frame: take what fits in the CDC FIFO (the rest stays with the
+ * host, as USB flow control would hold it) and raise the callback. */
+static void usb_frame(uint64_t now) {
+    usb_release_timed(now);
+    size_t room = CDC_RX_SIZE - cdc_count;
+    if (room > 0 && usb_injected_off < usb_injected_len) {
+        size_t n = usb_injected_len - usb_injected_off;
+        if (n > room) n = room;
+        cdc_rx_put((const uint8_t *)usb_injected + usb_injected_off, n);
+        usb_injected_off += n;
+        room -= n;
+    }
+    if (room > 0 && usb_in_fd >= 0) {
+        struct pollfd pfd = { .fd = usb_in_fd, .events = POLLIN };
+        if (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) {
+            uint8_t buf[CDC_RX_SIZE];
+            ssize_t n = read(usb_in_fd, buf, room);
+            if (n > 0) cdc_rx_put(buf, (size_t)n);
+        }
+    }
+    if (cdc_count > 0 && chars_available != NULL) {
+        usb_irq_pending = true;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/* Device models                                                       */
+/* ------------------------------------------------------------------ */
+
+static struct {
+    uint32_t        period_us;
+    uint64_t        next_us;
+    hal_periodic_fn fn;
+    void           *ctx;
+} periodic[MAX_PERIODIC];
+static uint n_periodic;
+
+bool hal_every_us(uint32_t period_us, hal_periodic_fn fn, void *ctx) {
+    if (n_periodic >= MAX_PERIODIC || period_us == 0) return false;
+    periodic[n_periodic].period_us = period_us;
+    periodic[n_periodic].next_us = clock_us() + period_us;
+    periodic[n_periodic].fn = fn;
+    periodic[n_periodic].ctx = ctx;
+    n_periodic++;
+    return true;
+}
+
+/* ------------------------------------------------------------------ */
+/* Interrupts and the event loop                                       */
+/* ------------------------------------------------------------------ */
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    if (num < NUM_IRQS) irq_handlers[num] = handler;
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    if (num < NUM_IRQS) irq_enabled[num] = enabled;
+}
+
+static void dma_irq0(void) {
+    if (!irq_enabled[DMA_IRQ_0] || irq_handlers[DMA_IRQ_0] == NULL) return;
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (dma_channel_get_irq0_status(ch)) {
+            irq_handlers[DMA_IRQ_0]();
+            return;
+        }
+    }
+}
+
+static void timer_irqs(void) {
+    for (uint a = 0; a < NUM_ALARMS; a++) {
+        if (alarms[a].pending) {
+            alarms[a].pending = false;
+            alarms[a].callback(a);
+        }
+    }
+}
+
+static void uart_rx_irq(uint num, uart_inst_t *uart) {
+    if (irq_enabled[num] && irq_handlers[num] != NULL && uart->rx_irq &&
+            (uart->count > 0 || (uart->hw.rsr & UART_UARTRSR_OE_BITS))) {
+        irq_handlers[num]();
+    }
+}
+
+static void pio_irq0(uint num, PIO pio) {
+    if (irq_enabled[num] && irq_handlers[num] != NULL &&
+            ((pio->irq_flags << 8) & pio->inte0)) {
+        irq_handlers[num]();
+    }
+}
+
+/* One pass over the pending sources, lowest IRQ number first. A level
+ * source its handler leaves set is not re-entered until the next event. */
+static void deliver_irqs(void) {
+    if (irq_masked || in_irq) return;
+    in_irq = true;
+    timer_irqs();
+    pio_irq0(PIO0_IRQ_0, pio0);
+    pio_irq0(PIO1_IRQ_0, pio1);
+    dma_irq0();
+    if (usb_irq_pending) {
+        usb_irq_pending = false;
+        chars_available(chars_available_param);
+    }
+    uart_rx_irq(UART0_IRQ, uart0);
+    uart_rx_irq(UART1_IRQ, uart1);
+    in_irq = false;
+}
+
+/* Run every event due by `now`, oldest first. */
+static void run_events(uint64_t now) {
+    for (;;) {
+        uint64_t t = usb_next_frame;
+        int kind = 0;   // 0 USB frame, 1 periodic, 2 PIO edge, 3 DMA,
+                        // 4 timer alarm
+        uint index = 0;
+        PIO pio = NULL;
+        for (uint i = 0; i < n_periodic; i++) {
+            if (periodic[i].next_us < t) {
+                t = periodic[i].next_us;
+                kind = 1;
+                index = i;
+            }
+        }
+        for (uint p = 0; p < 2; p++) {
+            for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+                uint64_t edge = pio_sm_next_edge(&pio_blocks[p].sm[sm]);
+                if (edge < t) {
+                    t = edge;
+                    kind = 2;
+                    pio = &pio_blocks[p];
+                    index = sm;
+                }
+            }
+        }
+        for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+            if (dma_chans[ch].busy && dma_chans[ch].done_at < t) {
+                t = dma_chans[ch].done_at;
+                kind = 3;
+                index = ch;
+            }
+        }
+        for (uint a = 0; a < NUM_ALARMS; a++) {
+            if (alarms[a].armed && alarms[a].target < t) {
+                t = alarms[a].target;
+                kind = 4;
+                index = a;
+            }
+        }
+        if (t > now) {
+            return;
+        }
+        held_us = t;
+        clock_held = true;
+        switch (kind) {
+            case 0:
+                usb_frame(t);
+                usb_next_frame += USB_FRAME_US;
+                break;
+            case 1:
+                periodic[index].next_us += periodic[index].period_us;
+                periodic[index].fn(t, periodic[index].ctx);
+                break;
+            case 2:
+                pio_sm_edge(pio, index, t);
+                break;
+            case 3:
+                dma_complete(index, t);
+                break;
+            default:
+                alarms[index].armed = false;
+                alarms[index].pending = alarms[index].callback != NULL;
+                break;
+        }
+        deliver_irqs();
+        clock_held = false;
+    }
+}
+
+/* Interrupt point (see hal.h). */
+static void hal_service(void) {
+    if (clock_held) return;
+    uint64_t now = clock_us();
+    if (run_limit_us != 0 && now >= run_limit_us) {
+        fflush(stdout);
+        exit(0);
+    }
+    if (irq_masked || in_irq) return;
+    run_events(now);
+}
+
+uint32_t save_and_disable_interrupts(void) {
+    uint32_t status = irq_masked ? 1u : 0u;
+    irq_masked = true;
+    return status;
+}
+
+void restore_interrupts(uint32_t status) {
+    irq_masked = status & 1u;
+    if (!irq_masked) hal_service();
+}
+
+void tight_loop_contents(void) {
+    clock_tick();
+    hal_service();
+}
+
+/* ------------------------------------------------------------------ */
+/* Time                                                                */
+/* ------------------------------------------------------------------ */
+
+absolute_time_t get_absolute_time(void) {
+    clock_tick();
+    hal_service();
+    return clock_us();
+}
+
+uint64_t time_us_64(void) {
+    clock_tick();
+    hal_service();
+    return clock_us();
+}
+
+/* Sleeps wake at USB-frame granularity at most, so input and device
+ * events keep their timing; in virtual time they jump straight through. */
+void sleep_us(uint64_t us) {
+    uint64_t until = clock_us() + us;
+    for (;;) {
+        hal_service();
+        uint64_t now = clock_us();
+        if (now >= until) return;
+        if (clock_virtual && !clock_held) {
+            virtual_us = until;
+            continue;
+        }
+        idle_us(until - now < USB_FRAME_US ? until - now : USB_FRAME_US);
+    }
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000);
+}
+
+void hal_set_run_limit_us(uint64_t run_us) {
+    run_limit_us = run_us;
+}
+
+/* ------------------------------------------------------------------ */
+/* Everything else                                                     */
+/* ------------------------------------------------------------------ */
+
+static uint64_t rand_state;
+
+void hal_set_seed(uint64_t seed) {
+    rand_state = seed ? seed : 1;
+}
+
+uint32_t get_rand_32(void) {
+    if (rand_state == 0) {
+        hal_set_seed(host_us() ^ ((uint64_t)getpid() << 32));
+    }
+    rand_state ^= rand_state >> 12;   // xorshift64*
+    rand_state ^= rand_state << 25;
+    rand_state ^= rand_state >> 27;
+    return (uint32_t)((rand_state * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+uint32_t clock_get_hz(enum clock_index clk) {
+    (void)clk;
+    return SYS_CLK_HZ;
+}
+
+void reset_usb_boot(uint32_t gpio_activity_pin_mask,
+                    uint32_t disable_interface_mask) {
+    (void)gpio_activity_pin_mask;
+    (void)disable_interface_mask;
+    fflush(stdout);
+    fprintf(stderr, "pico_sim: reset_usb_boot, exiting\n");
+    exit(0);
+}
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug) {
+    (void)delay_ms;
+    (void)pause_on_debug;
+}
+
+void watchdog_update(void) {
+}
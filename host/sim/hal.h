@@ -0,0 +1,79 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/pio.h"
+
+/* Simulated board behind the host pico-sdk headers in include/, so the
+ * real firmware sources run on a workstation (see pico_sim.c).
+ *
+ * Interrupts are modelled without threads. Peripherals post timestamped
+ * events (PIO step edges, USB frames, periodic device callbacks), and the
+ * HAL runs every event due at an interrupt point: any time query, sleep,
+ * tight_loop_contents() or restore_interrupts() that unmasks, outside IRQ
+ * context. Each event's IRQ handlers run straight after it with the clock
+ * held at the event's timestamp, as if the core had taken the interrupt
+ * on time. Nothing is delivered while interrupts are masked.
+ *
+ * The functions below are the bench side of the board: what the firmware
+ * would see from its wiring and sensors. */
+
+#define HAL_GPIO_FLOAT (-1)
+
+/* Drive an input pin from outside (0, 1 or HAL_GPIO_FLOAT, which leaves it
+ * to its pull). The DIP switches are three of these. */
+void hal_gpio_drive(uint gpio, int level);
+/* Level the firmware is driving on an output pin. */
+bool hal_gpio_out(uint gpio);
+/* Duty cycle (0..1) of a PWM pin, 0 while its slice is stopped. */
+float hal_pwm_duty(uint gpio);
+
+/* Voltage at ADC input 0-4; clamps to 0..3.3 V. Inputs start at 1.65 V. */
+void hal_adc_set_voltage(uint input, float volts);
+
+/* Bytes arriving on a UART's RX pin, raising its RX IRQ if enabled. A full
+ * FIFO drops the rest and sets the overrun flag (UARTRSR.OE), as the
+ * hardware does; returns how many were accepted. */
+size_t hal_uart_rx_push(uart_inst_t *uart, const uint8_t *src, size_t len);
+
+/* An I2C target at `addr`. read() fills up to `len` bytes and returns the
+ * count, or a PICO_ERROR_* code; write() takes what the controller sends
+ * and returns the same, and may be NULL to accept anything. Unattached
+ * addresses NAK. */
+typedef int (*hal_i2c_read_fn)(void *ctx, uint8_t *dst, size_t len);
+typedef int (*hal_i2c_write_fn)(void *ctx, const uint8_t *src, size_t len);
+void hal_i2c_attach(i2c_inst_t *i2c, uint8_t addr, hal_i2c_read_fn read,
+                    hal_i2c_write_fn write, void *ctx);
+
+/* Run fn every period_us, starting one period from now, as a device
+ * model (e.g. a sensor streaming on a UART). */
+typedef void (*hal_periodic_fn)(uint64_t now_us, void *ctx);
+bool hal_every_us(uint32_t period_us, hal_periodic_fn fn, void *ctx);
+
+/* USB CDC link. Bytes are read from in_fd (injected ones first) once per
+ * 1 ms USB frame into the 256-byte CDC RX FIFO, which raises the
+ * chars-available callback; stdout is the TX side. Injected bytes are
+ * sent from the first frame at or after at_us, so a scripted session
+ * keeps its timing in virtual time. */
+void hal_usb_set_input(int in_fd);
+void hal_usb_inject(uint64_t at_us, const char *src, size_t len);
+
+/* Rising edges a PIO state machine has put out since boot. */
+uint64_t hal_pio_steps(PIO pio, uint sm);
+
+/* Firmware time runs off the host's monotonic clock by default. Call one
+ * of these before the firmware starts: hal_clock_scale() runs it `rate`
+ * times faster, and hal_clock_virtual() detaches it from the host. In
+ * virtual time every time query costs step_us, sleeps and waits jump
+ * straight to their end, and events run at their exact timestamps, so a
+ * run with a fixed seed and injected input is deterministic and goes as
+ * fast as the host can execute it. */
+void hal_clock_scale(double rate);
+void hal_clock_virtual(uint32_t step_us);
+
+/* Exit cleanly (status 0) once the clock reaches run_us; 0 never exits. */
+void hal_set_run_limit_us(uint64_t run_us);
+void hal_set_seed(uint64_t seed);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef _HARDWARE_IRQ_H
+#define _HARDWARE_IRQ_H
+
+#include "pico/types.h"
+
+#define PIO0_IRQ_0  7
+#define PIO0_IRQ_1  8
+#define PIO1_IRQ_0  9
+#define PIO1_IRQ_1 10
+#define DMA_IRQ_0  11
+#define DMA_IRQ_1  12
+#define UART0_IRQ  20
+#define UART1_IRQ  21
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef _HARDWARE_PIO_H
+#define _HARDWARE_PIO_H
+
+#include "pico/types.h"
+
+#define NUM_PIO_STATE_MACHINES 4
+
+typedef struct pio_hw pio_hw_t;
+typedef pio_hw_t *PIO;
+extern pio_hw_t *const pio0_inst;
+extern pio_hw_t *const pio1_inst;
+#define pio0 pio0_inst
+#define pio1 pio1_inst
+
+typedef struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+typedef struct {
+    uint32_t clkdiv;
+    uint32_t execctrl;
+    uint32_t shiftctrl;
+    uint32_t pinctrl;
+} pio_sm_config;
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0,
+    PIO_FIFO_JOIN_TX   = 1,
+    PIO_FIFO_JOIN_RX   = 2,
+};
+
+typedef enum pio_interrupt_source {
+    pis_interrupt0 = 8,
+    pis_interrupt1,
+    pis_interrupt2,
+    pis_interrupt3,
+} pio_interrupt_source_t;
+
+static inline pio_sm_config pio_get_default_sm_config(void) {
+    pio_sm_config c = {0};
+    return c;
+}
+
+static inline void sm_config_set_wrap(pio_sm_config *c, uint wrap_target,
+                                      uint wrap) {
+    c->execctrl = (wrap_target << 7) | (wrap << 12);
+}
+
+static inline void sm_config_set_set_pins(pio_sm_config *c, uint base,
+                                          uint count) {
+    c->pinctrl = (count << 26) | (base << 5);
+}
+
+static inline void sm_config_set_out_shift(pio_sm_config *c, bool right,
+                                           bool autopull, uint threshold) {
+    c->shiftctrl = (right ? 1u << 19 : 0) | (autopull ? 1u << 17 : 0) |
+                   ((threshold & 31u) << 25);
+}
+
+static inline void sm_config_set_fifo_join(pio_sm_config *c,
+                                           enum pio_fifo_join join) {
+    c->shiftctrl |= (uint32_t)join << 30;
+}
+
+static inline void sm_config_set_clkdiv(pio_sm_config *c, float div) {
+    c->clkdiv = (uint32_t)(div * 256.0f) << 8;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_gpio_init(PIO pio, uint pin);
+void pio_sm_init(PIO pio, uint sm, uint initial_pc,
+                 const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+void pio_sm_set_pins_with_mask(PIO pio, uint sm, uint32_t pin_values,
+                               uint32_t pin_mask);
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base,
+                                    uint pin_count, bool is_out);
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm);
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm);
+void pio_sm_clear_fifos(PIO pio, uint sm);
+void pio_set_irq0_source_enabled(PIO pio, pio_interrupt_source_t source,
+                                 bool enabled);
+bool pio_interrupt_get(PIO pio, uint pio_interrupt_num);
+void pio_interrupt_clear(PIO pio, uint pio_interrupt_num);
+
+#endif
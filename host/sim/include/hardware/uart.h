@@ -0,0 +1,27 @@
+#ifndef _HARDWARE_UART_H
+#define _HARDWARE_UART_H
+
+#include "pico/types.h"
+
+typedef struct uart_inst uart_inst_t;
+extern uart_inst_t *const uart0_inst;
+extern uart_inst_t *const uart1_inst;
+#define uart0 uart0_inst
+#define uart1 uart1_inst
+
+// The registers the firmware touches directly.
+typedef struct {
+    volatile uint32_t rsr;   // error flags; any write clears them
+} uart_hw_t;
+
+#define UART_UARTRSR_OE_BITS 0x00000008u
+
+uint uart_init(uart_inst_t *uart, uint baudrate);
+void uart_deinit(uart_inst_t *uart);
+uart_hw_t *uart_get_hw(uart_inst_t *uart);
+void uart_set_irq_enables(uart_inst_t *uart, bool rx_has_data,
+                          bool tx_needs_data);
+bool uart_is_readable(uart_inst_t *uart);
+char uart_getc(uart_inst_t *uart);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef _PICO_BOOTROM_H
+#define _PICO_BOOTROM_H
+
+#include "pico/types.h"
+
+/* Ends the simulation (there is no BOOTSEL to drop into). */
+void reset_usb_boot(uint32_t gpio_activity_pin_mask,
+                    uint32_t disable_interface_mask);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef _PICO_STDLIB_H
+#define _PICO_STDLIB_H
+
+#include <stdio.h>
+#include "pico/types.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+#include "hardware/uart.h"
+
+#define PICO_DEFAULT_LED_PIN 25
+
+bool stdio_init_all(void);
+int getchar_timeout_us(uint32_t timeout_us);
+void stdio_set_chars_available_callback(void (*fn)(void *), void *param);
+
+/* A no-op on the device. Here it is an interrupt point (see hal.c), so a
+ * spin-wait on IRQ-side state can make progress. */
+void tight_loop_contents(void);
+
+#endif
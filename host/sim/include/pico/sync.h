@@ -0,0 +1,6 @@
+#ifndef _PICO_SYNC_H
+#define _PICO_SYNC_H
+
+#include "hardware/sync.h"
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef _PICO_TYPES_H
+#define _PICO_TYPES_H
+
+/* Host stand-ins for the pico-sdk headers the firmware includes, declaring
+ * only what src/ uses. The behaviour lives in host/sim/hal.c. */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;   // microseconds since boot
+
+#define PICO_OK             0
+#define PICO_ERROR_TIMEOUT -1
+#define PICO_ERROR_GENERIC -2
+
+#define __not_in_flash_func(f)    f
+#define __time_critical_func(f)   f
+
+#endif
@@ -0,0 +1,54 @@
+// Host stand-in for the header pioasm generates from src/stepper.pio
+// (pioasm is not part of the host build). Keep the program and the c-sdk
+// block in step with the .pio source. hal.c models this program's step
+// timing rather than executing the instructions.
+
+#pragma once
+
+#include "hardware/pio.h"
+
+#define stepper_wrap_target 0
+#define stepper_wrap 7
+
+static const uint16_t stepper_program_instructions[] = {
+            //     .wrap_target
+    0x80a0, //  0: pull   block
+    0x6030, //  1: out    x, 16
+    0x6050, //  2: out    y, 16
+    0xe001, //  3: set    pins, 1
+    0xc010, //  4: irq    nowait 0 rel
+    0x0045, //  5: jmp    x--, 5
+    0xe000, //  6: set    pins, 0
+    0x0087, //  7: jmp    y--, 7
+            //     .wrap
+};
+
+static const struct pio_program stepper_program = {
+    .instructions = stepper_program_instructions,
+    .length = 8,
+    .origin = -1,
+};
+
+static inline pio_sm_config stepper_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + stepper_wrap_target, offset + stepper_wrap);
+    return c;
+}
+
+#include "hardware/clocks.h"
+
+// Configure `sm` to emit pulses on `pin`, one tick per microsecond, and
+// start it. The TX FIFO is joined (8 words deep) since nothing is read back.
+static inline void stepper_program_init(PIO pio, uint sm, uint offset,
+                                        uint pin) {
+    pio_sm_config c = stepper_program_get_default_config(offset);
+    sm_config_set_set_pins(&c, pin, 1);
+    sm_config_set_out_shift(&c, true, false, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&c, (float)clock_get_hz(clk_sys) / 1e6f);
+    pio_gpio_init(pio, pin);
+    pio_sm_set_pins_with_mask(pio, sm, 0, 1u << pin);
+    pio_sm_set_consecutive_pindirs(pio, sm, pin, 1, true);
+    pio_sm_init(pio, sm, offset, &c);
+    pio_sm_set_enabled(pio, sm, true);
+}
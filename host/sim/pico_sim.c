@@ -0,0 +1,312 @@
+#define _GNU_SOURCE
+#include "hal.h"
+#include "pico_multi.h"
+#include "imu.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* Runs the real firmware (src/main.c and the apps) on the host HAL.
+ * stdin/stdout stand in for the USB CDC port, or --pty opens a pseudo
+ * terminal and prints its path first, so picohost can connect to it as
+ * it would to a board. The bench behind the chosen app is simulated well
+ * enough for the app to report "update": a level BNO08x streaming RVC
+ * for the IMUs (or, with --imu-shtp, serving SH-2 reports on I2C) and a
+ * lidar returning a fixed range; ADC inputs sit at 1.65 V unless --adc
+ * says otherwise.
+ *
+ * --virtual runs on virtual time (see hal.h), so a long scenario, e.g. a
+ * tempctrl watchdog trip, takes seconds and gives the same output every
+ * run given --seed and scripted input.
+ *
+ *   pico_sim --app 0 --cmd '{"az_set_target_pos":200}' --run-ms 2000
+ *   pico_sim --app 1 --virtual --run-ms 60000 --cmd-at 20000 '{...}'
+ */
+
+int firmware_main(void);   // src/main.c, renamed for this build
+
+#define RVC_PERIOD_US   10000   // BNO08x RVC output rate, 100 Hz
+#define SHTP_TICK_US    2500    // BNO08x SH-2 report clock, 400 Hz
+#define LIDAR_I2C_ADDR  0x66    // lidar.c I2C_ADDR
+#define LIDAR_RANGE_CM  250
+#define VIRTUAL_STEP_US 10      // about one short main-loop stretch on an M33
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [--app N] [--pty] [--cmd LINE]... [--cmd-at MS LINE]...\n"
+        "          [--run-ms MS] [--speed X | --virtual [--step-us US]]\n"
+        "          [--adc INPUT=VOLTS]... [--seed N] [--imu-shtp]\n"
+        "  --app N          DIP switch code (app id) to boot, default 7\n"
+        "  --pty            serve the CDC port on a pseudo terminal\n"
+        "  --cmd LINE       send LINE over USB at boot\n"
+        "  --cmd-at MS LINE send LINE over USB at MS ms\n"
+        "  --run-ms MS      exit after MS ms of firmware time\n"
+        "  --speed X        run the clock X times faster than real time\n"
+        "  --virtual        run on virtual time, as fast as possible\n"
+        "  --step-us US     virtual time per clock read, default %u\n"
+        "  --adc IN=VOLTS   hold ADC input IN (0-4) at VOLTS\n"
+        "  --seed N         seed get_rand_32() (boot_id)\n"
+        "  --imu-shtp       wire the IMU for SH-2 on I2C instead of RVC\n",
+        argv0, VIRTUAL_STEP_US);
+    exit(2);
+}
+
+/* Stationary and level: zero angles, 1 g on z. */
+static void rvc_stream(uint64_t now_us, void *ctx) {
+    (void)now_us;
+    uint8_t *index = ctx;
+    uint8_t pkt[RVC_PACKET_SIZE] = { RVC_HEADER_BYTE, RVC_HEADER_BYTE };
+    pkt[2] = (*index)++;
+    pkt[13] = 1000 & 0xff;   // accel z, milli-g, little endian
+    pkt[14] = 1000 >> 8;
+    uint8_t sum = 0;
+    for (int i = 2; i < RVC_PACKET_SIZE - 1; i++) {
+        sum += pkt[i];
+    }
+    pkt[RVC_PACKET_SIZE - 1] = sum;
+    hal_uart_rx_push(IMU_UART, pkt, sizeof(pkt));
+}
+
+/* The same sensor strapped for SHTP on I2C: it announces its boot, takes
+ * Set Feature commands, and reports each enabled sensor at its interval
+ * with no delay. A read of the header alone leaves the packet pending. */
+static const uint8_t bno_ids[] = {
+    SH2_ROTATION_VECTOR, SH2_ACCELEROMETER, SH2_GRAVITY
+};
+#define BNO_REPORTS (sizeof(bno_ids) / sizeof(bno_ids[0]))
+
+static struct {
+    uint64_t now_us;
+    uint32_t interval_us[BNO_REPORTS];
+    uint64_t next_us[BNO_REPORTS];
+    bool     due[BNO_REPORTS];
+    bool     announced;
+    uint8_t  seq;
+    uint8_t  pkt[64];
+    size_t   pkt_len;   // pending packet, 0 for none
+} bno;
+
+static void bno_tick(uint64_t now_us, void *ctx) {
+    (void)ctx;
+    bno.now_us = now_us;
+    for (size_t k = 0; k < BNO_REPORTS; k++) {
+        if (bno.interval_us[k] && now_us >= bno.next_us[k]) {
+            bno.due[k] = true;
+            bno.next_us[k] += bno.interval_us[k];
+            if (bno.next_us[k] <= now_us) {
+                bno.next_us[k] = now_us + bno.interval_us[k];
+            }
+        }
+    }
+}
+
+static size_t bno_put16(uint8_t *p, int16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)((uint16_t)v >> 8);
+    return 2;
+}
+
+/* One input report: id, sequence, status (accuracy high, no delay). */
+static size_t bno_report(uint8_t *p, uint8_t id) {
+    const int16_t g_q8 = 2511;   // 9.80665 m/s^2
+    size_t n = 0;
+    p[n++] = id;
+    p[n++] = bno.seq++;
+    p[n++] = 3;
+    p[n++] = 0;
+    switch (id) {
+        case SH2_ROTATION_VECTOR:   // identity, 2 degree heading error
+            n += bno_put16(&p[n], 0);
+            n += bno_put16(&p[n], 0);
+            n += bno_put16(&p[n], 0);
+            n += bno_put16(&p[n], 1 << 14);
+            n += bno_put16(&p[n], 143);
+            break;
+        default:                    // 1 g on z
+            n += bno_put16(&p[n], 0);
+            n += bno_put16(&p[n], 0);
+            n += bno_put16(&p[n], g_q8);
+            break;
+    }
+    return n;
+}
+
+static void bno_next_packet(void) {
+    uint8_t *payload = &bno.pkt[SHTP_HEADER_LEN];
+    size_t n = 0;
+    uint8_t channel = SHTP_CHAN_REPORTS;
+    if (!bno.announced) {
+        channel = SHTP_CHAN_EXECUTABLE;
+        payload[n++] = SH2_EXEC_RESET_DONE;
+        bno.announced = true;
+    } else {
+        for (size_t k = 0; k < BNO_REPORTS; k++) {
+            if (!bno.due[k]) continue;
+            if (n == 0) {
+                payload[n++] = SH2_BASE_TIMESTAMP;
+                memset(&payload[n], 0, 4);
+                n += 4;
+            }
+            n += bno_report(&payload[n], bno_ids[k]);
+            bno.due[k] = false;
+        }
+    }
+    bno.pkt_len = n ? SHTP_HEADER_LEN + n : 0;
+    if (n) {
+        shtp_header(bno.pkt, n, channel, 0);
+    }
+}
+
+static int bno_read(void *ctx, uint8_t *dst, size_t len) {
+    (void)ctx;
+    if (bno.pkt_len == 0) {
+        bno_next_packet();
+    }
+    memset(dst, 0, len);   // an empty header when there is nothing
+    memcpy(dst, bno.pkt, len < bno.pkt_len ? len : bno.pkt_len);
+    if (len > SHTP_HEADER_LEN) {
+        bno.pkt_len = 0;
+    }
+    return (int)len;
+}
+
+static int bno_write(void *ctx, const uint8_t *src, size_t len) {
+    (void)ctx;
+    const uint8_t *cmd = &src[SHTP_HEADER_LEN];
+    if (len >= SHTP_HEADER_LEN + SH2_SET_FEATURE_LEN &&
+            src[2] == SHTP_CHAN_CONTROL && cmd[0] == SH2_SET_FEATURE) {
+        uint32_t interval = (uint32_t)cmd[5] | (uint32_t)cmd[6] << 8 |
+                            (uint32_t)cmd[7] << 16 | (uint32_t)cmd[8] << 24;
+        for (size_t k = 0; k < BNO_REPORTS; k++) {
+            if (bno_ids[k] == cmd[1]) {
+                bno.interval_us[k] = interval;
+                bno.next_us[k] = bno.now_us + interval;
+                bno.due[k] = false;
+            }
+        }
+    }
+    return (int)len;
+}
+
+static int lidar_read(void *ctx, uint8_t *dst, size_t len) {
+    (void)ctx;
+    uint8_t range[2] = { LIDAR_RANGE_CM >> 8, LIDAR_RANGE_CM & 0xff };
+    if (len > sizeof(range)) len = sizeof(range);
+    memcpy(dst, range, len);
+    return (int)len;
+}
+
+static void send_line(uint64_t at_us, const char *line) {
+    hal_usb_inject(at_us, line, strlen(line));
+    hal_usb_inject(at_us, "\n", 1);
+}
+
+static void open_pty(void) {
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+        perror("pico_sim: pty");
+        exit(1);
+    }
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);   // a CDC port neither echoes nor translates
+    tcsetattr(fd, TCSANOW, &tio);
+    printf("%s\n", ptsname(fd));
+    fflush(stdout);
+    // Like stdio_usb, drop output while nobody is reading it.
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    dup2(fd, STDOUT_FILENO);
+    hal_usb_set_input(fd);
+}
+
+int main(int argc, char **argv) {
+    static uint8_t rvc_index;
+    int app_id = 7;
+    bool pty = false;
+    bool imu_shtp = false;
+    bool virtual_time = false;
+    uint32_t step_us = VIRTUAL_STEP_US;
+    double speed = 1.0;
+
+    hal_usb_set_input(STDIN_FILENO);
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--pty") == 0) {
+            pty = true;
+        } else if (strcmp(arg, "--virtual") == 0) {
+            virtual_time = true;
+        } else if (strcmp(arg, "--imu-shtp") == 0) {
+            imu_shtp = true;
+        } else if (val == NULL) {
+            usage(argv[0]);
+        } else if (strcmp(arg, "--app") == 0) {
+            app_id = atoi(val);
+            i++;
+        } else if (strcmp(arg, "--cmd") == 0) {
+            send_line(0, val);
+            i++;
+        } else if (strcmp(arg, "--cmd-at") == 0) {
+            if (i + 2 >= argc) usage(argv[0]);
+            send_line(strtoull(val, NULL, 10) * 1000, argv[i + 2]);
+            i += 2;
+        } else if (strcmp(arg, "--run-ms") == 0) {
+            hal_set_run_limit_us(strtoull(val, NULL, 10) * 1000);
+            i++;
+        } else if (strcmp(arg, "--speed") == 0) {
+            speed = strtod(val, NULL);
+            if (!(speed > 0.0)) usage(argv[0]);
+            i++;
+        } else if (strcmp(arg, "--step-us") == 0) {
+            step_us = (uint32_t)strtoul(val, NULL, 10);
+            i++;
+        } else if (strcmp(arg, "--adc") == 0) {
+            char *eq;
+            unsigned long input = strtoul(val, &eq, 10);
+            if (*eq != '=') usage(argv[0]);
+            hal_adc_set_voltage((uint)input, strtof(eq + 1, NULL));
+            i++;
+        } else if (strcmp(arg, "--seed") == 0) {
+            hal_set_seed(strtoull(val, NULL, 0));
+            i++;
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (app_id < 0 || app_id > 7) usage(argv[0]);
+    if (virtual_time) {
+        hal_clock_virtual(step_us);
+    } else {
+        hal_clock_scale(speed);
+    }
+
+    // A closed DIP switch pulls its pin to ground.
+    hal_gpio_drive(DIP0_PIN, app_id & 1);
+    hal_gpio_drive(DIP1_PIN, (app_id >> 1) & 1);
+    hal_gpio_drive(DIP2_PIN, (app_id >> 2) & 1);
+
+    switch (app_id) {
+        case APP_IMU_EL:
+        case APP_IMU_AZ:
+            if (imu_shtp) {
+                hal_i2c_attach(IMU_I2C, IMU_I2C_ADDR, bno_read, bno_write,
+                               NULL);
+                hal_every_us(SHTP_TICK_US, bno_tick, NULL);
+            } else {
+                hal_every_us(RVC_PERIOD_US, rvc_stream, &rvc_index);
+            }
+            break;
+        case APP_LIDAR:
+            hal_i2c_attach(i2c0, LIDAR_I2C_ADDR, lidar_read, NULL, NULL);
+            break;
+        default:
+            break;
+    }
+    if (pty) {
+        open_pty();
+    }
+    return firmware_main();
+}
@@ -0,0 +1,143 @@
+// Host unit test: the command pool parses the worst lines that fit in
+// BUFFER_SIZE (deepest nesting, most nodes, most strings) without running
+// out, counts a parse that does run out, and hands arenas back for reuse.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmd_pool.h"
+
+static int failures = 0;
+
+#define LINE_MAX_LEN (BUFFER_SIZE - 1)
+
+// "[[[...]]]", as deep as a line goes.
+static void nested(char *line) {
+    int depth = LINE_MAX_LEN / 2;
+    memset(line, '[', depth);
+    memset(line + depth, ']', depth);
+    line[2 * depth] = '\0';
+}
+
+// "[<item>,<item>,...]" up to the line length.
+static void list(char *line, const char *item) {
+    size_t n = strlen(item), len = 1;
+    line[0] = '[';
+    while (len + n + 2 <= LINE_MAX_LEN) {
+        memcpy(line + len, item, n);
+        len += n;
+        line[len++] = ',';
+    }
+    line[len - 1] = ']';
+    line[len] = '\0';
+}
+
+// {"":"","":"",...}: two strings per node.
+static void pairs(char *line) {
+    size_t len = 1;
+    line[0] = '{';
+    while (len + 6 <= LINE_MAX_LEN) {
+        memcpy(line + len, "\"\":\"\",", 6);
+        len += 6;
+    }
+    line[len - 1] = '}';
+    line[len] = '\0';
+}
+
+// One string filling the line.
+static void long_string(char *line) {
+    memset(line, 'x', LINE_MAX_LEN);
+    line[0] = line[LINE_MAX_LEN - 1] = '"';
+    line[LINE_MAX_LEN] = '\0';
+}
+
+static void check_fits(const char *name, const char *line) {
+    uint32_t failed = cmd_pool_failures();
+    cJSON *root = cmd_pool_parse(line);
+    if (root == NULL || cmd_pool_failures() != failed) {
+        printf("FAIL %s (%zu bytes) did not parse\n", name, strlen(line));
+        failures++;
+    }
+    cmd_pool_release(root);
+}
+
+static void check_worst_cases(void) {
+    char line[BUFFER_SIZE];
+    nested(line);
+    check_fits("nested", line);
+    list(line, "1");
+    check_fits("numbers", line);
+    list(line, "\"\"");
+    check_fits("empty strings", line);
+    list(line, "{}");
+    check_fits("objects", line);
+    list(line, "\"\\u00e9\"");
+    check_fits("escapes", line);
+    pairs(line);
+    check_fits("pairs", line);
+    long_string(line);
+    check_fits("long string", line);
+    if (cmd_pool_max() > CMD_POOL_BYTES) {
+        printf("FAIL high water %u > %zu\n", cmd_pool_max(),
+               (size_t)CMD_POOL_BYTES);
+        failures++;
+    }
+    printf("worst case %u of %zu bytes\n", cmd_pool_max(),
+           (size_t)CMD_POOL_BYTES);
+}
+
+static void check_run_out(void) {
+    // Far longer than any line cmd_rx passes on.
+    static char big[8 * CMD_POOL_BYTES];
+    const char *item = "[]";
+    size_t len = 1;
+    big[0] = '[';
+    while (len + 4 < sizeof(big)) {
+        memcpy(big + len, item, 2);
+        len += 2;
+        big[len++] = ',';
+    }
+    big[len - 1] = ']';
+    big[len] = '\0';
+
+    uint32_t failed = cmd_pool_failures();
+    if (cmd_pool_parse(big) != NULL || cmd_pool_failures() != failed + 1) {
+        printf("FAIL an oversized tree was not refused and counted\n");
+        failures++;
+    }
+    // Not JSON is not a pool failure.
+    if (cmd_pool_parse("{\"a\":") != NULL ||
+        cmd_pool_failures() != failed + 1) {
+        printf("FAIL bad JSON counted as a pool failure\n");
+        failures++;
+    }
+    // The arena is free again.
+    cJSON *root = cmd_pool_parse("{\"sw_state\":3}");
+    cJSON *item_json = cJSON_GetObjectItem(root, "sw_state");
+    if (!cJSON_IsNumber(item_json) || item_json->valueint != 3) {
+        printf("FAIL no parse after a refused one\n");
+        failures++;
+    }
+    cmd_pool_release(root);
+}
+
+static void check_reuse(void) {
+    for (int i = 0; i < 1000; i++) {
+        cJSON *root = cmd_pool_parse("{\"LNA_Kp\":0.2,\"LOAD_Ki\":0.01}");
+        if (cJSON_GetArraySize(root) != 2) {
+            printf("FAIL parse %d\n", i);
+            failures++;
+            break;
+        }
+        cmd_pool_release(root);
+    }
+}
+
+int main(void) {
+    cmd_pool_init();
+    check_worst_cases();
+    check_run_out();
+    check_reuse();
+    printf("command pool checked, %d failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
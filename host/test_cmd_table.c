@@ -0,0 +1,159 @@
+// Host unit test: cmd_table_dispatch() applies the keys of a command that
+// are in a table, converting and range-checking each value by its type,
+// and skips the rest; and the apps' tables are sorted, as its binary
+// search needs.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "cmd_table.h"
+#include "tempctrl.h"
+#include "imu.h"
+#include "motor.h"
+#include "rfswitch.h"
+#include "potmon.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                        \
+    do {                                        \
+        if (!(cond)) {                          \
+            printf("FAIL " __VA_ARGS__);        \
+            printf("\n");                       \
+            failures++;                         \
+        }                                       \
+    } while (0)
+
+static double seen[5];
+static int calls[5];
+
+static void record(void *ctx, double value) {
+    int slot = (int)(size_t)ctx;
+    seen[slot] = value;
+    calls[slot]++;
+}
+
+static const CmdKey keys[] = {
+    { "a_bool", CMD_BOOL, CMD_CLAMP, 0, 1, record, (void *)0 },
+    { "b_int", CMD_INT, CMD_REJECT, 64, 1024, record, (void *)1 },
+    { "c_float", CMD_FLOAT, CMD_CLAMP, -1.5, 2.5, record, (void *)2 },
+    { "d_int", CMD_INT, CMD_CLAMP, 0, 100, record, (void *)3 },
+    { "e_enum", CMD_ENUM, CMD_CLAMP, 0, 3, record, (void *)4 },
+};
+
+// Dispatch `json` and check it applied `applied` keys.
+static void dispatch(const char *json, int applied) {
+    for (int i = 0; i < 5; i++) {
+        seen[i] = -99;
+        calls[i] = 0;
+    }
+    cJSON *root = cJSON_Parse(json);
+    int n = cmd_table_dispatch(keys, CMD_TABLE_LEN(keys), root);
+    CHECK(n == applied, "%s: applied %d keys, want %d", json, n, applied);
+    cJSON_Delete(root);
+}
+
+static void expect(const char *json, int slot, int ncalls, double value) {
+    CHECK(calls[slot] == ncalls && (ncalls == 0 || seen[slot] == value),
+          "%s: key %d set %d times to %g, want %d times to %g", json, slot,
+          calls[slot], seen[slot], ncalls, value);
+}
+
+static void check_types(void) {
+    const char *j;
+
+    j = "{\"a_bool\":true,\"b_int\":128,\"c_float\":0.25,\"d_int\":7}";
+    dispatch(j, 4);
+    expect(j, 0, 1, 1);
+    expect(j, 1, 1, 128);
+    expect(j, 2, 1, 0.25);
+    expect(j, 3, 1, 7);
+
+    // Bools: numbers by non-zero; anything else is false, like valueint.
+    j = "{\"a_bool\":2}";
+    dispatch(j, 1);
+    expect(j, 0, 1, 1);
+    j = "{\"a_bool\":\"true\"}";
+    dispatch(j, 1);
+    expect(j, 0, 1, 0);
+    j = "{\"a_bool\":null}";
+    dispatch(j, 1);
+    expect(j, 0, 1, 0);
+
+    // Numbers only; ints truncate.
+    j = "{\"b_int\":\"128\",\"c_float\":true,\"d_int\":[1]}";
+    dispatch(j, 0);
+    j = "{\"b_int\":128.9,\"d_int\":-0.5}";
+    dispatch(j, 2);
+    expect(j, 1, 1, 128);
+    expect(j, 3, 1, 0);
+
+    // Enums: whole numbers only, never truncated.
+    j = "{\"e_enum\":2}";
+    dispatch(j, 1);
+    expect(j, 4, 1, 2);
+    dispatch("{\"e_enum\":2.5}", 0);
+    dispatch("{\"e_enum\":true}", 0);
+    dispatch("{\"e_enum\":\"2\"}", 0);
+}
+
+static void check_ranges(void) {
+    const char *j;
+
+    j = "{\"b_int\":63}";
+    dispatch(j, 0);
+    j = "{\"b_int\":1025}";
+    dispatch(j, 0);
+    j = "{\"c_float\":-7,\"d_int\":1e9}";
+    dispatch(j, 2);
+    expect(j, 2, 1, -1.5);
+    expect(j, 3, 1, 100);
+    j = "{\"c_float\":1e999}";
+    dispatch(j, 1);
+    expect(j, 2, 1, 2.5);
+
+    // An enum out of range is rejected, even under CMD_CLAMP.
+    j = "{\"e_enum\":0,\"e_enum\":3}";
+    dispatch(j, 2);
+    expect(j, 4, 2, 3);
+    dispatch("{\"e_enum\":4}", 0);
+    dispatch("{\"e_enum\":-1}", 0);
+    dispatch("{\"e_enum\":1e999}", 0);
+}
+
+static void check_keys(void) {
+    const char *j;
+
+    // Unknown keys are skipped; keys apply in the line's order.
+    j = "{\"cadence_ms\":100,\"zz\":1,\"d_int\":5,\"a\":1,\"d_int\":6}";
+    dispatch(j, 2);
+    expect(j, 3, 2, 6);
+    dispatch("{}", 0);
+    dispatch("[1,2]", 0);
+    dispatch("not json", 0);
+}
+
+static void check_sorted(void) {
+    CHECK(cmd_table_sorted(keys, CMD_TABLE_LEN(keys)), "test table");
+    CHECK(cmd_table_sorted(tempctrl_keys, tempctrl_keys_len),
+          "tempctrl_keys is not sorted");
+    CHECK(cmd_table_sorted(imu_keys, imu_keys_len), "imu_keys is not sorted");
+    CHECK(cmd_table_sorted(motor_keys, motor_keys_len),
+          "motor_keys is not sorted");
+    CHECK(cmd_table_sorted(rfswitch_keys, rfswitch_keys_len),
+          "rfswitch_keys is not sorted");
+    CHECK(cmd_table_sorted(potmon_keys, potmon_keys_len),
+          "potmon_keys is not sorted");
+    const CmdKey twice[] = { keys[0], keys[0] };
+    CHECK(!cmd_table_sorted(twice, 2), "a repeated key passed");
+    const CmdKey swapped[] = { keys[1], keys[0] };
+    CHECK(!cmd_table_sorted(swapped, 2), "unsorted keys passed");
+}
+
+int main(void) {
+    check_types();
+    check_ranges();
+    check_keys();
+    check_sorted();
+    printf("command tables checked, %d failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+// Host unit test: the IMU window statistics give the mean, sample variance,
+// min and max of a run of samples, NaN before there are enough, and average
+// angles on the circle so a yaw cluster straddling +/-180 stays there.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "imu_stats.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                        \
+    do {                                        \
+        if (!(cond)) {                          \
+            printf("FAIL " __VA_ARGS__);        \
+            printf("\n");                       \
+            failures++;                         \
+        }                                       \
+    } while (0)
+
+static bool near(float a, float b) {
+    return fabsf(a - b) < 1e-3f;
+}
+
+static void check_empty(void) {
+    AxisStats a;
+    AngleStats g;
+    memset(&a, 0, sizeof(a));
+    memset(&g, 0, sizeof(g));
+    CHECK(isnan(axis_stats_mean(&a)) && isnan(axis_stats_var(&a)) &&
+          isnan(axis_stats_min(&a)) && isnan(axis_stats_max(&a)),
+          "empty axis not NaN");
+    CHECK(isnan(angle_stats_mean(&g)) && isnan(angle_stats_var(&g)) &&
+          isnan(angle_stats_min(&g)) && isnan(angle_stats_max(&g)),
+          "empty angle not NaN");
+
+    axis_stats_add(&a, 3.0f);
+    CHECK(near(axis_stats_mean(&a), 3.0f) && isnan(axis_stats_var(&a)),
+          "one sample: mean %f var %f", axis_stats_mean(&a),
+          axis_stats_var(&a));
+}
+
+static void check_axis(void) {
+    static const float xs[] = {2, 4, 4, 4, 5, 5, 7, 9};
+    AxisStats a;
+    memset(&a, 0, sizeof(a));
+    for (size_t i = 0; i < sizeof(xs) / sizeof(xs[0]); i++) {
+        axis_stats_add(&a, xs[i]);
+    }
+    CHECK(a.n == 8, "n %u", a.n);
+    CHECK(near(axis_stats_mean(&a), 5.0f), "mean %f", axis_stats_mean(&a));
+    CHECK(near(axis_stats_var(&a), 32.0f / 7.0f), "var %f",
+          axis_stats_var(&a));
+    CHECK(axis_stats_min(&a) == 2.0f && axis_stats_max(&a) == 9.0f,
+          "min %f max %f", axis_stats_min(&a), axis_stats_max(&a));
+
+    // Gravity on one axis with a little noise: no cancellation.
+    memset(&a, 0, sizeof(a));
+    for (int i = 0; i < 1000; i++) {
+        axis_stats_add(&a, 9.81f + ((i & 1) ? 0.01f : -0.01f));
+    }
+    CHECK(near(axis_stats_mean(&a), 9.81f), "g mean %f", axis_stats_mean(&a));
+    CHECK(fabsf(axis_stats_var(&a) - 1e-4f) < 1e-6f, "g var %g",
+          axis_stats_var(&a));
+}
+
+static void check_angle(void) {
+    AngleStats g;
+    memset(&g, 0, sizeof(g));
+    angle_stats_add(&g, 179.0f);
+    angle_stats_add(&g, -179.0f);
+    angle_stats_add(&g, 180.0f);
+    CHECK(near(fabsf(angle_stats_mean(&g)), 180.0f), "wrap mean %f",
+          angle_stats_mean(&g));
+    CHECK(near(angle_stats_min(&g), 179.0f), "wrap min %f",
+          angle_stats_min(&g));
+    CHECK(near(angle_stats_max(&g), -179.0f), "wrap max %f",
+          angle_stats_max(&g));
+    // Offsets -0, +2, +1 about 179.
+    CHECK(near(angle_stats_var(&g), 1.0f), "wrap var %f",
+          angle_stats_var(&g));
+
+    memset(&g, 0, sizeof(g));
+    angle_stats_add(&g, 10.0f);
+    angle_stats_add(&g, 20.0f);
+    angle_stats_add(&g, 30.0f);
+    CHECK(near(angle_stats_mean(&g), 20.0f), "mean %f",
+          angle_stats_mean(&g));
+    CHECK(near(angle_stats_var(&g), 100.0f), "var %f", angle_stats_var(&g));
+    CHECK(near(angle_stats_min(&g), 10.0f) && near(angle_stats_max(&g), 30.0f),
+          "min %f max %f", angle_stats_min(&g), angle_stats_max(&g));
+}
+
+int main(void) {
+    check_empty();
+    check_axis();
+    check_angle();
+    printf("imu stats checked, %d failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
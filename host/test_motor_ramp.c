@@ -0,0 +1,186 @@
+// Host unit test: RampTable lookups match the analytic ramp_extra() /
+// scurve_extra() curves within 1 us at every step (including past the end
+// of the ramp), across ramp lengths up to RAMP_TABLE_LEN, start factors,
+// and cruise periods from the fastest the PIO can emit to the 16-bit phase
+// limit. Checks built tables against values worked out by hand, that a
+// ramp longer than RAMP_TABLE_LEN is fitted into it, and the S-curve's
+// shape: same endpoints as the linear ramp, monotonic, and acceleration
+// tapering to ~0 at both ends.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "motor_ramp.h"
+
+static int failures = 0;
+
+static uint32_t profile_extra(uint8_t profile, uint32_t k,
+                              uint32_t ramp_steps, float start_factor,
+                              uint32_t cruise_period) {
+    return profile == RAMP_PROFILE_SCURVE
+        ? scurve_extra(k, ramp_steps, start_factor, cruise_period)
+        : ramp_extra(k, ramp_steps, start_factor, cruise_period);
+}
+
+static void check_profile(uint8_t profile, uint32_t ramp_steps,
+                          float start_factor, uint32_t cruise_period) {
+    static RampTable t;
+    ramp_table_build(&t, profile, ramp_steps, start_factor, cruise_period);
+    uint32_t worst = 0, worst_k = 0;
+    for (uint32_t k = 0; k <= ramp_steps + 2; k++) {
+        uint32_t want = profile_extra(profile, k, ramp_steps, start_factor,
+                                      cruise_period);
+        uint32_t got = ramp_table_extra(&t, k);
+        uint32_t err = got > want ? got - want : want - got;
+        if (err > worst) {
+            worst = err;
+            worst_k = k;
+        }
+    }
+    if (worst > 1) {
+        printf("FAIL profile=%u ramp_steps=%u F=%.2f cruise=%u: "
+               "|err|=%u us at k=%u\n", profile, ramp_steps, start_factor,
+               cruise_period, worst, worst_k);
+        failures++;
+    }
+}
+
+// Tables for F = 2 over 100 steps at a 1000 us cruise, against values
+// from the closed form rather than from the functions that built them:
+//   k = 0:  v = v_cruise / 2, so the first step is twice cruise: +1000 us.
+//   k = 50: linear v^2 = 1/4 + 3/4 * 1/2 = 0.625, period 1000 / sqrt(0.625)
+//           = 1264.9 us: +265 us. The S-curve's s(1/2) = 1/2 gives the same.
+//   k = 75: linear v^2 = 1/4 + 3/4 * 3/4 = 0.8125, 1109.4 us: +109 us.
+//           S-curve s(3/4) = 27/32, v^2 = 0.8828, 1064.3 us: +64 us.
+//   k >= 100: cruise, +0.
+// Every table must also fall monotonically from its first entry to 0 (not
+// strictly: the S-curve's last few entries all round to 0 us).
+static void check_known_values(void) {
+    static const struct {
+        uint8_t  profile;
+        uint32_t k;
+        uint32_t want;
+    } cases[] = {
+        {RAMP_PROFILE_LINEAR, 0, 1000},  {RAMP_PROFILE_SCURVE, 0, 1000},
+        {RAMP_PROFILE_LINEAR, 50, 265},  {RAMP_PROFILE_SCURVE, 50, 265},
+        {RAMP_PROFILE_LINEAR, 75, 109},  {RAMP_PROFILE_SCURVE, 75, 64},
+        {RAMP_PROFILE_LINEAR, 100, 0},   {RAMP_PROFILE_SCURVE, 100, 0},
+        {RAMP_PROFILE_LINEAR, 1000, 0},  {RAMP_PROFILE_SCURVE, 1000, 0},
+    };
+    static RampTable t;
+    for (unsigned i = 0; i < sizeof cases / sizeof cases[0]; i++) {
+        ramp_table_build(&t, cases[i].profile, 100, 2.0f, 1000);
+        uint32_t got = ramp_table_extra(&t, cases[i].k);
+        if (got != cases[i].want) {
+            printf("FAIL profile=%u k=%u: %u us, want %u\n",
+                   cases[i].profile, cases[i].k, got, cases[i].want);
+            failures++;
+        }
+    }
+    for (uint8_t profile = RAMP_PROFILE_LINEAR;
+         profile <= RAMP_PROFILE_SCURVE; profile++) {
+        ramp_table_build(&t, profile, 100, 2.0f, 1000);
+        for (uint32_t k = 1; k <= 100; k++) {
+            if (ramp_table_extra(&t, k) > ramp_table_extra(&t, k - 1)) {
+                printf("FAIL profile=%u table rises at k=%u\n",
+                       profile, k);
+                failures++;
+                break;
+            }
+        }
+    }
+}
+
+// A longer ramp than the table holds bakes the RAMP_TABLE_LEN-step ramp,
+// rather than the first RAMP_TABLE_LEN steps of the long one, whose
+// period would jump to cruise at the end of the table.
+static void check_long_ramp(uint8_t profile) {
+    static RampTable want, got;
+    ramp_table_build(&want, profile, RAMP_TABLE_LEN, 2.5f, 1000);
+    ramp_table_build(&got, profile, 4 * RAMP_TABLE_LEN, 2.5f, 1000);
+    for (uint32_t k = 0; k <= RAMP_TABLE_LEN; k++) {
+        if (ramp_table_extra(&got, k) != ramp_table_extra(&want, k)) {
+            printf("FAIL profile=%u long ramp at k=%u: %u us, want %u\n",
+                   profile, k, ramp_table_extra(&got, k),
+                   ramp_table_extra(&want, k));
+            failures++;
+            return;
+        }
+    }
+}
+
+// v^2 relative to cruise, recovered from the integer extra delay. A long
+// cruise period keeps the 1 us rounding negligible.
+static double v2_rel(uint32_t extra, uint32_t cruise_period) {
+    double v = (double)cruise_period / (double)(cruise_period + extra);
+    return v * v;
+}
+
+static void check_scurve_shape(uint32_t ramp_steps, float start_factor) {
+    const uint32_t cruise = 1000000;
+    uint32_t first = scurve_extra(0, ramp_steps, start_factor, cruise);
+    if (first != ramp_extra(0, ramp_steps, start_factor, cruise) ||
+        scurve_extra(ramp_steps, ramp_steps, start_factor, cruise) != 0) {
+        printf("FAIL scurve endpoints ramp_steps=%u F=%.2f\n",
+               ramp_steps, start_factor);
+        failures++;
+        return;
+    }
+    uint32_t prev = first;
+    for (uint32_t k = 1; k <= ramp_steps; k++) {
+        uint32_t e = scurve_extra(k, ramp_steps, start_factor, cruise);
+        if (e > prev) {
+            printf("FAIL scurve not monotonic ramp_steps=%u F=%.2f k=%u\n",
+                   ramp_steps, start_factor, k);
+            failures++;
+            return;
+        }
+        prev = e;
+    }
+    // Acceleration ~ d(v^2)/dk. The linear ramp's is constant (the full
+    // v^2 span over D steps); the S-curve's first and last steps must
+    // carry only a small fraction of that.
+    double span = 1.0 - v2_rel(first, cruise);
+    double mean = span / ramp_steps;
+    double a0 = v2_rel(scurve_extra(1, ramp_steps, start_factor, cruise),
+                       cruise) - v2_rel(first, cruise);
+    double a1 = 1.0 - v2_rel(scurve_extra(ramp_steps - 1, ramp_steps,
+                                          start_factor, cruise), cruise);
+    if (a0 > 0.1 * mean || a1 > 0.1 * mean) {
+        printf("FAIL scurve end accel ramp_steps=%u F=%.2f: "
+               "%.3f / %.3f of linear\n", ramp_steps, start_factor,
+               a0 / mean, a1 / mean);
+        failures++;
+    }
+}
+
+int main(void) {
+    static const uint8_t profiles[] = {RAMP_PROFILE_LINEAR,
+                                       RAMP_PROFILE_SCURVE};
+    static const float factors[] = {1.0f, 1.5f, 2.5f, 4.0f};
+    static const uint32_t steps[] = {0, 1, 10, 100, 255, RAMP_TABLE_LEN};
+    static const uint32_t cruise[] = {8, 50, 600, 1200, 5000, 20000, 131070};
+    unsigned n = 0;
+
+    for (unsigned p = 0; p < sizeof profiles / sizeof profiles[0]; p++) {
+        for (unsigned f = 0; f < sizeof factors / sizeof factors[0]; f++) {
+            for (unsigned s = 0; s < sizeof steps / sizeof steps[0]; s++) {
+                for (unsigned c = 0; c < sizeof cruise / sizeof cruise[0];
+                     c++) {
+                    check_profile(profiles[p], steps[s], factors[f],
+                                  cruise[c]);
+                    n++;
+                }
+            }
+        }
+    }
+    check_known_values();
+    check_long_ramp(RAMP_PROFILE_LINEAR);
+    check_long_ramp(RAMP_PROFILE_SCURVE);
+    for (unsigned f = 1; f < sizeof factors / sizeof factors[0]; f++) {
+        check_scurve_shape(100, factors[f]);
+        check_scurve_shape(RAMP_TABLE_LEN, factors[f]);
+        n += 2;
+    }
+    printf("%u profiles checked, %d failed\n", n, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
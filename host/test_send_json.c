@@ -0,0 +1,289 @@
+// Host unit test: send_json() output bytes. Golden lines pin the cJSON
+// print rules it reproduces (number formatting, NaN/inf -> null, string
+// escapes, dropped NULL fields) and a line longer than its buffer. With
+// the lib/cJSON submodule checked out, random values are also printed
+// through cJSON_PrintUnformatted() and compared byte for byte. Binary
+// status frames are unframed here (XOR, COBS, CRC) and checked field by
+// field, including when schema frames are sent.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "eigsep_command.h"
+#ifdef HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+static int failures = 0;
+static unsigned checks = 0;
+static char captured[8192];
+static FILE *cap_file;
+static int saved_stdout;
+
+static void begin_capture(void) {
+    fflush(stdout);
+    cap_file = tmpfile();
+    saved_stdout = dup(STDOUT_FILENO);
+    dup2(fileno(cap_file), STDOUT_FILENO);
+}
+
+static size_t captured_len;
+
+static const char *end_capture(void) {
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+    rewind(cap_file);
+    captured_len = fread(captured, 1, sizeof(captured) - 1, cap_file);
+    captured[captured_len] = '\0';
+    fclose(cap_file);
+    return captured;
+}
+
+#define CAPTURE(...) (begin_capture(), send_json(__VA_ARGS__), end_capture())
+
+static void expect(const char *name, const char *got, const char *want) {
+    checks++;
+    if (strcmp(got, want) != 0) {
+        printf("FAIL %s:\n  got  %s  want %s", name, got, want);
+        failures++;
+    }
+}
+
+static void test_golden(void) {
+    expect("mixed", CAPTURE(4,
+        KV_STR, "sensor_name", "motor",
+        KV_INT, "app_id", 0,
+        KV_INT, "az_pos", -22600,
+        KV_BOOL, "ok", 1),
+        "{\"sensor_name\":\"motor\",\"app_id\":0,\"az_pos\":-22600,"
+        "\"ok\":true}\n");
+    expect("empty", CAPTURE(0), "{}\n");
+    expect("non-finite", CAPTURE(3,
+        KV_FLOAT, "a", (double)NAN,
+        KV_FLOAT, "b", (double)INFINITY,
+        KV_FLOAT, "c", -(double)INFINITY),
+        "{\"a\":null,\"b\":null,\"c\":null}\n");
+    expect("integral floats", CAPTURE(5,
+        KV_FLOAT, "a", 30.0,
+        KV_FLOAT, "b", -0.0,
+        KV_FLOAT, "c", 2147483647.0,
+        KV_FLOAT, "d", -2147483648.0,
+        KV_FLOAT, "e", 2147483648.0),
+        "{\"a\":30,\"b\":0,\"c\":2147483647,\"d\":-2147483648,"
+        "\"e\":2147483648}\n");
+    expect("fractions", CAPTURE(5,
+        KV_FLOAT, "a", 0.5,
+        KV_FLOAT, "b", 0.1,
+        KV_FLOAT, "c", (double)30.1f,
+        KV_FLOAT, "d", 1e300,
+        KV_FLOAT, "e", -1.25e-7),
+        "{\"a\":0.5,\"b\":0.1,\"c\":30.100000381469727,\"d\":1e+300,"
+        "\"e\":-1.25e-07}\n");
+    expect("escapes", CAPTURE(1,
+        KV_STR, "k\"ey", "a\"b\\c/\b\f\n\r\t\x01\x1f\x7f\xc3\xa9"),
+        "{\"k\\\"ey\":\"a\\\"b\\\\c/\\b\\f\\n\\r\\t\\u0001\\u001f\x7f"
+        "\xc3\xa9\"}\n");
+    expect("null string dropped", CAPTURE(3,
+        KV_STR, "a", (const char *)NULL,
+        KV_INT, "b", 1,
+        KV_BYTES, "c", (const char *)NULL),
+        "{\"b\":1}\n");
+}
+
+// 60 fields of ~40 bytes: several times the output buffer.
+static void test_long_line(void) {
+    static const char *v = "0123456789012345678901234567890123456789";
+    char want[4096];
+    size_t n = 0;
+    want[n++] = '{';
+    for (int i = 0; i < 60; i++) {
+        n += (size_t)snprintf(want + n, sizeof(want) - n, "%s\"k%02d\":\"%s\"",
+                              i ? "," : "", i, v);
+    }
+    snprintf(want + n, sizeof(want) - n, "}\n");
+#define F(i) KV_STR, "k" #i, v
+    expect("long line", CAPTURE(60,
+        F(00), F(01), F(02), F(03), F(04), F(05), F(06), F(07), F(08), F(09),
+        F(10), F(11), F(12), F(13), F(14), F(15), F(16), F(17), F(18), F(19),
+        F(20), F(21), F(22), F(23), F(24), F(25), F(26), F(27), F(28), F(29),
+        F(30), F(31), F(32), F(33), F(34), F(35), F(36), F(37), F(38), F(39),
+        F(40), F(41), F(42), F(43), F(44), F(45), F(46), F(47), F(48), F(49),
+        F(50), F(51), F(52), F(53), F(54), F(55), F(56), F(57), F(58), F(59)),
+        want);
+#undef F
+}
+
+static void check(const char *name, int ok) {
+    checks++;
+    if (!ok) {
+        printf("FAIL %s\n", name);
+        failures++;
+    }
+}
+
+static uint16_t crc16(const uint8_t *p, size_t n) {
+    uint16_t crc = 0xffff;
+    while (n--) {
+        crc ^= (uint16_t)(*p++ << 8);
+        for (int i = 0; i < 8; i++) {
+            crc = (uint16_t)(crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Split the captured output into frames and undo the framing of frame
+// `which`: 0x00 mark, XOR 0x0a, COBS, CRC. Returns the payload length
+// (CRC stripped), or -1 if the frame is malformed.
+static int unframe(int which, uint8_t *out) {
+    const char *line = captured;
+    for (int i = 0; i < which; i++) {
+        line = memchr(line, '\n', captured_len - (size_t)(line - captured));
+        if (!line) return -1;
+        line++;
+    }
+    const char *end = memchr(line, '\n', captured_len - (size_t)(line - captured));
+    if (!end || end - line < 3 || line[0] != 0 || end[-1] != 0) return -1;
+    int n = 0;
+    for (const char *p = line + 1; p < end - 1;) {
+        uint8_t code = (uint8_t)*p++ ^ 0x0a;
+        if (code == 0) return -1;
+        for (int i = 1; i < code; i++) {
+            if (p >= end - 1) return -1;
+            out[n++] = (uint8_t)*p++ ^ 0x0a;
+        }
+        if (code != 0xff && p < end - 1) out[n++] = 0;
+    }
+    if (n < 6) return -1;
+    uint16_t crc = (uint16_t)(out[n - 2] | out[n - 1] << 8);
+    return crc16(out, (size_t)n - 2) == crc ? n - 2 : -1;
+}
+
+static int count_frames(void) {
+    int n = 0;
+    for (size_t i = 0; i < captured_len; i++) n += captured[i] == '\n';
+    return n;
+}
+
+static int32_t le32(const uint8_t *p) {
+    return (int32_t)((uint32_t)p[0] | (uint32_t)p[1] << 8 |
+                     (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+}
+
+#define STATUS_ARGS(pos) 6,                                   \
+    KV_STR, "sensor_name", "motor",                           \
+    KV_INT, "az_pos", (pos),                                  \
+    KV_FLOAT, "T_now", (double)NAN,                           \
+    KV_FLOAT, "drive", 0.25,                                  \
+    KV_BOOL, "ok", 1,                                         \
+    KV_STR, "note", (const char *)NULL
+
+static void test_binary(void) {
+    uint8_t p[4096];
+    set_status_format(STATUS_FORMAT_BINARY);
+
+    CAPTURE(STATUS_ARGS(-22600));
+    check("schema + data frames", count_frames() == 2);
+    int n = unframe(0, p);
+    check("schema frame", n > 5 && p[0] == BIN_STATUS_VERSION && p[1] == 'S'
+                          && p[4] == 6);
+    uint16_t layout = (uint16_t)(p[2] | p[3] << 8);
+    // first schema entry: KV_STR "sensor_name"
+    check("schema entry", n > 17 && p[5] == KV_STR && p[6] == 11 &&
+                          memcmp(p + 7, "sensor_name", 11) == 0);
+
+    n = unframe(1, p);
+    const uint8_t *v = p + 4;
+    float drive;
+    memcpy(&drive, v + 6 + 4 + 4, sizeof(drive));
+    uint32_t nan_bits;
+    memcpy(&nan_bits, v + 6 + 4, sizeof(nan_bits));
+    check("data frame", n == 4 + 6 + 4 + 4 + 4 + 1 + 1 && p[1] == 'D' &&
+                        (uint16_t)(p[2] | p[3] << 8) == layout);
+    check("data values",
+          v[0] == 5 && memcmp(v + 1, "motor", 5) == 0 &&
+          le32(v + 6) == -22600 &&
+          (nan_bits & 0x7f800000u) == 0x7f800000u && (nan_bits & 0x7fffff) &&
+          drive == 0.25f && v[18] == 1 && v[19] == 0xff);
+
+    // Same layout again: data only, until the schema repeat is due.
+    for (int i = 1; i < BIN_SCHEMA_REPEAT; i++) {
+        CAPTURE(STATUS_ARGS(i));
+        if (count_frames() != 1) break;
+    }
+    check("data only between schemas", count_frames() == 1 &&
+                                       unframe(0, p) > 0 && p[1] == 'D');
+    CAPTURE(STATUS_ARGS(0));
+    check("schema repeated", count_frames() == 2 && unframe(0, p) > 0 &&
+                             p[1] == 'S');
+
+    // A different layout is announced on first use.
+    CAPTURE(1, KV_INT, "other", 7);
+    check("new layout announced", count_frames() == 2 &&
+                                  unframe(1, p) == 8 && le32(p + 4) == 7);
+
+    // Strings past one COBS block; its 0x0a bytes must not end the line.
+    char big[400];
+    memset(big, '\n', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    CAPTURE(1, KV_STR, "big", big);
+    n = unframe(1, p);
+    check("long string frame", count_frames() == 2 && n == 4 + 1 + 254 && p[4] == 254 &&
+                               p[5] == '\n' && p[4 + 254] == '\n');
+
+    set_status_format(STATUS_FORMAT_JSON);
+    expect("back to json", CAPTURE(1, KV_INT, "a", 1), "{\"a\":1}\n");
+}
+
+#ifdef HAVE_CJSON
+// Random doubles (from float and full-double bit patterns, so both the
+// %1.15g and %1.17g paths are hit) and ints, against cJSON itself.
+static void test_against_cjson(void) {
+    srand(12345);
+    for (int i = 0; i < 20000; i++) {
+        double d;
+        if (i % 2) {
+            uint32_t bits = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            d = f;
+        } else {
+            uint64_t bits = ((uint64_t)rand() << 42) ^
+                            ((uint64_t)rand() << 21) ^ (uint64_t)rand();
+            memcpy(&d, &bits, sizeof(d));
+        }
+        int n = rand() - RAND_MAX / 2;
+
+        cJSON *ref = cJSON_CreateObject();
+        cJSON_AddNumberToObject(ref, "d", d);
+        cJSON_AddNumberToObject(ref, "n", n);
+        char *out = cJSON_PrintUnformatted(ref);
+        char want[128];
+        snprintf(want, sizeof(want), "%s\n", out);
+        cJSON_free(out);
+        cJSON_Delete(ref);
+
+        expect("cjson", CAPTURE(2, KV_FLOAT, "d", d, KV_INT, "n", n), want);
+        if (failures > 10) {
+            return;
+        }
+    }
+}
+#endif
+
+int main(void) {
+    test_golden();
+    test_long_line();
+    test_binary();
+#ifdef HAVE_CJSON
+    test_against_cjson();
+#else
+    printf("lib/cJSON not checked out; skipping the cJSON cross-check\n");
+#endif
+    printf("%u lines checked, %d failed\n", checks, failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
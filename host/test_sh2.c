@@ -0,0 +1,98 @@
+// Host unit test: the SH-2 codec encodes SHTP headers and Set Feature
+// commands as the BNO08x expects, and decodes a reports packet into
+// values, accuracies and sample ages, stopping at a report it cannot
+// size.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sh2.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                        \
+    do {                                        \
+        if (!(cond)) {                          \
+            printf("FAIL " __VA_ARGS__);        \
+            printf("\n");                       \
+            failures++;                         \
+        }                                       \
+    } while (0)
+
+static bool near(float a, float b) {
+    return fabsf(a - b) < 1e-4f;
+}
+
+static void check_encode(void) {
+    uint8_t hdr[SHTP_HEADER_LEN];
+    shtp_header(hdr, SH2_SET_FEATURE_LEN, SHTP_CHAN_CONTROL, 7);
+    CHECK(hdr[0] == 21 && hdr[1] == 0 && hdr[2] == 2 && hdr[3] == 7,
+          "header %02x %02x %02x %02x", hdr[0], hdr[1], hdr[2], hdr[3]);
+    CHECK(shtp_length(hdr) == 21, "length %zu", shtp_length(hdr));
+    const uint8_t cont[] = { 0x10, 0x81, 0, 0 };
+    CHECK(shtp_length(cont) == 0x110, "continuation bit not masked");
+
+    uint8_t cmd[SH2_SET_FEATURE_LEN];
+    memset(cmd, 0xee, sizeof(cmd));
+    size_t n = sh2_set_feature(cmd, SH2_ROTATION_VECTOR,
+                               sh2_interval_us(400));
+    const uint8_t want[SH2_SET_FEATURE_LEN] = {
+        0xFD, 0x05, 0, 0, 0, 0xC4, 0x09, 0, 0,   // 2500 us
+    };
+    CHECK(n == SH2_SET_FEATURE_LEN && memcmp(cmd, want, n) == 0,
+          "set feature encoding");
+    CHECK(sh2_interval_us(0) == 0, "rate 0 is not off");
+    CHECK(sh2_interval_us(100) == 10000, "100 Hz interval");
+}
+
+static void check_decode(void) {
+    const uint8_t pkt[] = {
+        SH2_BASE_TIMESTAMP, 50, 0, 0, 0,              // 5 ms before arrival
+        // rotation vector, accuracy 2, delay 10 ticks: (0.5, 0, 0, -0.5)
+        SH2_ROTATION_VECTOR, 1, (0 << 2) | 2, 10,
+        0x00, 0x20, 0, 0, 0, 0, 0x00, 0xE0, 0x00, 0x02,   // err 0.125
+        // accelerometer, accuracy 3, delay 0x102 ticks (past the base)
+        SH2_ACCELEROMETER, 2, (1 << 2) | 3, 0x02,
+        0x80, 0xFF, 0x00, 0x01, 0x11, 0x09,          // -0.5, 1, 9.07
+        SH2_TIMESTAMP_REBASE, 0xEC, 0xFF, 0xFF, 0xFF, // base 2 ms earlier
+        SH2_GRAVITY, 3, 1, 0,
+        0, 0, 0, 0, 0x00, 0x0A,                       // 10 on z
+        0x7E, 1, 2, 3,                                // unknown: stop
+        SH2_GRAVITY, 4, 0, 0, 0, 0, 0, 0, 0, 0,
+    };
+    Sh2Reports r;
+    memset(&r, 0, sizeof(r));
+    int n = sh2_parse_reports(pkt, sizeof(pkt), &r);
+    CHECK(n == 3, "parsed %d reports, want 3", n);
+
+    CHECK(near(r.quat.v[0], 0.5f) && r.quat.v[1] == 0 && r.quat.v[2] == 0 &&
+          near(r.quat.v[3], -0.5f), "quaternion %g %g %g %g", r.quat.v[0],
+          r.quat.v[1], r.quat.v[2], r.quat.v[3]);
+    CHECK(near(r.quat.error_rad, 0.125f), "error %g", r.quat.error_rad);
+    CHECK(r.quat.accuracy == 2 && r.quat.fresh, "quat accuracy/fresh");
+    CHECK(r.quat.age_us == 4000, "quat age %u", r.quat.age_us);
+
+    CHECK(near(r.accel.v[0], -0.5f) && near(r.accel.v[1], 1.0f) &&
+          near(r.accel.v[2], 0x911 / 256.0f), "accel %g %g %g",
+          r.accel.v[0], r.accel.v[1], r.accel.v[2]);
+    CHECK(r.accel.accuracy == 3, "accel accuracy %u", r.accel.accuracy);
+    CHECK(r.accel.age_us == 0, "accel age %u (delay past the base)",
+          r.accel.age_us);
+
+    CHECK(near(r.gravity.v[2], 10.0f), "gravity z %g", r.gravity.v[2]);
+    CHECK(r.gravity.age_us == 7000, "gravity age %u after rebase",
+          r.gravity.age_us);
+
+    // A report cut short by the packet end is not read.
+    memset(&r, 0, sizeof(r));
+    n = sh2_parse_reports(pkt, 20, &r);
+    CHECK(n == 1 && r.quat.fresh && !r.accel.fresh, "truncated packet");
+}
+
+int main(void) {
+    check_encode();
+    check_decode();
+    printf("sh2 codec checked, %d failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
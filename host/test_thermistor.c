@@ -0,0 +1,85 @@
+// Host unit test: the thermistor lookup table matches the float
+// Steinhart-Hart path within 0.07 C from -40 to +125 C, at every 1/64 of
+// an ADC count, and agrees with it on which voltages are plausible except
+// within that tolerance of the range limits. Also checks the rails (open
+// and shorted thermistor), NaN, and a known point: 10 kOhm is 25 C.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "thermistor.h"
+
+#define TOLERANCE_C  0.07f
+
+static int failures = 0;
+
+static bool near_limit(float temp_c) {
+    return fabsf(temp_c - THERMISTOR_MIN_C) <= TOLERANCE_C ||
+           fabsf(temp_c - THERMISTOR_MAX_C) <= TOLERANCE_C;
+}
+
+static void check_sweep(const ThermistorLut *t) {
+    float worst = 0.0f, worst_v = 0.0f;
+    uint32_t compared = 0;
+    for (uint32_t q = 0; q <= 4095u * 64u; q++) {
+        float v = (float)q * THERMISTOR_SUPPLY_VOLTS / (4095.0f * 64.0f);
+        float want_r, want = NAN, got = NAN;
+        bool ok_want = thermistor_voltage_to_temperature(v, &want_r, &want);
+        bool ok_got = thermistor_lut_temperature(t, v, &got);
+        if (ok_want != ok_got) {
+            float seen = ok_want ? want : got;
+            if (!near_limit(seen)) {
+                printf("FAIL v=%.6f: float %s (%.3f C), table %s (%.3f C)\n",
+                       v, ok_want ? "ok" : "rejects", want,
+                       ok_got ? "ok" : "rejects", got);
+                failures++;
+            }
+            continue;
+        }
+        if (!ok_want) {
+            continue;
+        }
+        compared++;
+        float err = fabsf(got - want);
+        if (err > worst) {
+            worst = err;
+            worst_v = v;
+        }
+    }
+    if (worst > TOLERANCE_C) {
+        printf("FAIL |err|=%.4f C at v=%.6f\n", worst, worst_v);
+        failures++;
+    }
+    // The sweep must actually cover the range: ~3700 counts of it.
+    if (compared < 3600u * 64u) {
+        printf("FAIL only %u plausible points\n", compared);
+        failures++;
+    }
+}
+
+static void check_points(const ThermistorLut *t) {
+    float temp = 0.0f;
+    const float bad[] = { -0.1f, 0.0f, THERMISTOR_SUPPLY_VOLTS,
+                          THERMISTOR_SUPPLY_VOLTS + 0.1f, NAN };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        if (thermistor_lut_temperature(t, bad[i], &temp)) {
+            printf("FAIL v=%.3f accepted (%.3f C)\n", bad[i], temp);
+            failures++;
+        }
+    }
+    float v25 = THERMISTOR_SUPPLY_VOLTS * THERMISTOR_REF_OHMS
+        / (THERMISTOR_TOP_OHMS + THERMISTOR_REF_OHMS);
+    if (!thermistor_lut_temperature(t, v25, &temp) ||
+        fabsf(temp - 25.0f) > TOLERANCE_C) {
+        printf("FAIL 10 kOhm -> %.3f C, want 25\n", temp);
+        failures++;
+    }
+}
+
+int main(void) {
+    static ThermistorLut t;
+    thermistor_lut_build(&t);
+    check_sweep(&t);
+    check_points(&t);
+    printf("thermistor table checked, %d failed\n", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,64 +1,414 @@
 #include "eigsep_command.h"
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
 
-void send_json(unsigned count, ...)
+/* send_json() formats each line straight into this buffer and writes it
+ * out whenever it fills (and at the end of the line), so a status packet
+ * costs no heap allocations however many fields it has. Sized so that
+ * every app's status line normally goes out in a single write. */
+#define SEND_JSON_BUF_SIZE 1024
+static char out_buf[SEND_JSON_BUF_SIZE];
+static size_t out_len;
+
+/* set_status_format() only posts the request; the next send_json()
+ * applies it. In the dual-core build the two run on different cores, and
+ * this keeps the layout cache owned by the one that encodes. */
+static status_format_t status_format = STATUS_FORMAT_JSON;
+static volatile status_format_t format_req = STATUS_FORMAT_JSON;
+static volatile uint32_t format_seq;
+static uint32_t format_applied;
+
+static send_json_writer_t out_writer;
+
+/* fwrite rather than printf: binary frames contain NUL bytes. */
+static void out_flush(void)
 {
-    va_list ap;
-    va_start(ap, count);
+    if (out_writer) {
+        out_writer(out_buf, out_len);
+    } else {
+        fwrite(out_buf, 1, out_len, stdout);
+    }
+    out_len = 0;
+}
 
-    cJSON *reply = cJSON_CreateObject();
-    for(unsigned i = 0; i < count; ++i) {
-        /* retrieve the tag as an int, then cast */
-        int tag_i = va_arg(ap, int);
-        kv_type_t tag = (kv_type_t)tag_i;
+static void out_putc(char c)
+{
+    if (out_len == sizeof(out_buf)) {
+        out_flush();
+    }
+    out_buf[out_len++] = c;
+}
 
-        const char *key = va_arg(ap, const char *);
-        char buf[64];
-        size_t len = sizeof(buf);
-        const char *str = NULL;
+static void out_puts(const char *s)
+{
+    while (*s) {
+        out_putc(*s++);
+    }
+}
 
-        switch(tag) {
-            case KV_STR:
-                str = va_arg(ap, const char *);
-                break;
+/* One send_json() argument triple. */
+typedef struct {
+    kv_type_t   tag;
+    const char *key;
+    const char *str;    /* KV_STR / KV_BYTES; may be NULL */
+    double      num;    /* KV_INT / KV_FLOAT */
+    int         bool_val;
+} kv_field_t;
 
-            case KV_INT: 
-                {
-                    int int_val = va_arg(ap, int);
-                    cJSON_AddNumberToObject(reply, key, int_val);
-                    str = NULL; /* Skip the string addition */
-                }
-                break;
+/* Pull the next field off `ap`; false for an unknown tag. */
+static bool kv_next(va_list *ap, kv_field_t *f)
+{
+    /* retrieve the tag as an int, then cast */
+    f->tag = (kv_type_t)va_arg(*ap, int);
+    f->key = va_arg(*ap, const char *);
+    switch (f->tag) {
+        case KV_STR:
+        case KV_BYTES: f->str = va_arg(*ap, const char *); return true;
+        case KV_INT:   f->num = va_arg(*ap, int);          return true;
+        case KV_FLOAT: f->num = va_arg(*ap, double);       return true;
+        case KV_BOOL:  f->bool_val = va_arg(*ap, int);     return true;
+    }
+    return false;
+}
 
-            case KV_FLOAT:
-                {
-                    double float_val = va_arg(ap, double);
-                    cJSON_AddNumberToObject(reply, key, float_val);
-                    str = NULL; /* Skip the string addition */
-                }
-                break;
+/* ---- JSON text ---------------------------------------------------- */
 
-            case KV_BOOL:
-                {
-                    int bool_val = va_arg(ap, int);
-                    cJSON_AddBoolToObject(reply, key, bool_val);
-                    str = NULL; /* Skip the string addition */
+/* Quoted, escaped string, byte-for-byte as cJSON's print_string_ptr():
+   the two-character escapes for " \ \b \f \n \r \t, \u00XX for other
+   control characters, everything else (UTF-8 included) copied as is. */
+static void out_string(const char *s)
+{
+    out_putc('"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        switch (c) {
+            case '"':  out_puts("\\\""); break;
+            case '\\': out_puts("\\\\"); break;
+            case '\b': out_puts("\\b");  break;
+            case '\f': out_puts("\\f");  break;
+            case '\n': out_puts("\\n");  break;
+            case '\r': out_puts("\\r");  break;
+            case '\t': out_puts("\\t");  break;
+            default:
+                if (c < 32) {
+                    char esc[7];
+                    snprintf(esc, sizeof(esc), "\\u%04x", c);
+                    out_puts(esc);
+                } else {
+                    out_putc((char)c);
                 }
-                break;
+        }
+    }
+    out_putc('"');
+}
+
+/* cJSON's compare_double(): equal to within DBL_EPSILON, relative. */
+static bool same_double(double a, double b)
+{
+    double max_abs = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return fabs(a - b) <= max_abs * DBL_EPSILON;
+}
+
+/* Number, byte-for-byte as cJSON's print_number(): null for NaN/inf,
+   %d when the value is exactly its (saturated) int, otherwise the
+   shortest of %1.15g / %1.17g that reads back as the same double. */
+static void out_number(double d)
+{
+    char num[26];
+
+    if (isnan(d) || isinf(d)) {
+        out_puts("null");
+        return;
+    }
+    int valueint = d >= INT_MAX ? INT_MAX
+                 : d <= (double)INT_MIN ? INT_MIN
+                 : (int)d;
+    if (d == (double)valueint) {
+        snprintf(num, sizeof(num), "%d", valueint);
+    } else {
+        double test = 0.0;
+        snprintf(num, sizeof(num), "%1.15g", d);
+        if (sscanf(num, "%lg", &test) != 1 || !same_double(test, d)) {
+            snprintf(num, sizeof(num), "%1.17g", d);
+        }
+    }
+    out_puts(num);
+}
+
+static void send_text(unsigned count, va_list *ap)
+{
+    bool first = true;
+    kv_field_t f = {0};
+
+    out_putc('{');
+    for (unsigned i = 0; i < count; ++i) {
+        if (!kv_next(ap, &f)) {
+            continue;
+        }
+        /* cJSON dropped a field without a key or a NULL string */
+        if (f.key == NULL ||
+            ((f.tag == KV_STR || f.tag == KV_BYTES) && f.str == NULL)) {
+            continue;
+        }
+        if (!first) {
+            out_putc(',');
+        }
+        first = false;
+        out_string(f.key);
+        out_putc(':');
+        switch (f.tag) {
+            case KV_STR:
+            case KV_BYTES: out_string(f.str); break;
+            case KV_BOOL:  out_puts(f.bool_val ? "true" : "false"); break;
+            default:       out_number(f.num); break;
+        }
+    }
+    out_putc('}');
+    out_putc('\n');
+    out_flush();
+}
+
+/* ---- Binary frames (layout in eigsep_command.h) ------------------- */
+
+#define BIN_MARK  0x00
+#define BIN_XOR   0x0a
+#define BIN_NULL_STR 0xff
+#define BIN_LAYOUT_SLOTS 8
+
+/* Layouts a schema frame has been sent for since the format was set. */
+static struct {
+    bool     used;
+    uint16_t id;
+    uint16_t frames;    /* data frames since its last schema frame */
+} bin_layouts[BIN_LAYOUT_SLOTS];
+static unsigned bin_evict;
+
+static uint16_t bin_crc;
+static uint8_t  cobs_block[254];
+static uint8_t  cobs_n;
+
+/* CRC-16/CCITT-FALSE, a nibble at a time. */
+static uint16_t crc16_update(uint16_t crc, uint8_t b)
+{
+    static const uint16_t table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+        0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+    };
+    crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (b >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (b & 0x0f)]);
+    return crc;
+}
+
+static uint16_t crc16_str(uint16_t crc, const char *s)
+{
+    while (*s) {
+        crc = crc16_update(crc, (uint8_t)*s++);
+    }
+    return crc;
+}
+
+/* Streaming COBS: close the current block with `code` and write it. */
+static void cobs_emit(uint8_t code)
+{
+    out_putc((char)(code ^ BIN_XOR));
+    for (uint8_t i = 0; i < cobs_n; i++) {
+        out_putc((char)(cobs_block[i] ^ BIN_XOR));
+    }
+    cobs_n = 0;
+}
+
+static void cobs_put(uint8_t b)
+{
+    if (b == 0) {
+        cobs_emit((uint8_t)(cobs_n + 1));
+        return;
+    }
+    cobs_block[cobs_n++] = b;
+    if (cobs_n == sizeof(cobs_block)) {
+        cobs_emit(0xff);
+    }
+}
+
+static void bin_u8(uint8_t b)
+{
+    bin_crc = crc16_update(bin_crc, b);
+    cobs_put(b);
+}
+
+static void bin_u16(uint16_t v)
+{
+    bin_u8((uint8_t)v);
+    bin_u8((uint8_t)(v >> 8));
+}
+
+static void bin_u32(uint32_t v)
+{
+    bin_u16((uint16_t)v);
+    bin_u16((uint16_t)(v >> 16));
+}
+
+/* Length-prefixed, truncated to 254 bytes; NULL is len 0xff. */
+static void bin_str(const char *s)
+{
+    if (s == NULL) {
+        bin_u8(BIN_NULL_STR);
+        return;
+    }
+    size_t len = strlen(s);
+    if (len >= BIN_NULL_STR) {
+        len = BIN_NULL_STR - 1;
+    }
+    bin_u8((uint8_t)len);
+    for (size_t i = 0; i < len; i++) {
+        bin_u8((uint8_t)s[i]);
+    }
+}
+
+static void bin_begin(uint8_t kind, uint16_t layout)
+{
+    out_putc((char)BIN_MARK);
+    cobs_n = 0;
+    bin_crc = 0xffff;
+    bin_u8(BIN_STATUS_VERSION);
+    bin_u8(kind);
+    bin_u16(layout);
+}
+
+static void bin_end(void)
+{
+    uint16_t crc = bin_crc;
+    cobs_put((uint8_t)crc);
+    cobs_put((uint8_t)(crc >> 8));
+    cobs_emit((uint8_t)(cobs_n + 1));
+    out_putc((char)BIN_MARK);
+    out_putc('\n');
+    out_flush();
+}
+
+/* Fields without a key are dropped, as in the JSON encoding. */
+static uint16_t bin_layout_id(unsigned count, va_list *ap, uint8_t *n)
+{
+    uint16_t crc = 0xffff;
+    kv_field_t f = {0};
+
+    *n = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        if (!kv_next(ap, &f) || f.key == NULL) {
+            continue;
+        }
+        crc = crc16_update(crc, (uint8_t)f.tag);
+        crc = crc16_str(crc, f.key);
+        crc = crc16_update(crc, 0);
+        (*n)++;
+    }
+    return crc;
+}
+
+static void bin_schema(uint16_t layout, uint8_t n, unsigned count,
+                       va_list *ap)
+{
+    kv_field_t f = {0};
+
+    bin_begin('S', layout);
+    bin_u8(n);
+    for (unsigned i = 0; i < count; ++i) {
+        if (!kv_next(ap, &f) || f.key == NULL) {
+            continue;
+        }
+        bin_u8((uint8_t)f.tag);
+        bin_str(f.key);
+    }
+    bin_end();
+}
+
+static void bin_data(uint16_t layout, unsigned count, va_list *ap)
+{
+    kv_field_t f = {0};
 
-            case KV_BYTES:
-                /* For bytes, we expect a pointer to data and length */
-                str = va_arg(ap, const char *);
+    bin_begin('D', layout);
+    for (unsigned i = 0; i < count; ++i) {
+        if (!kv_next(ap, &f) || f.key == NULL) {
+            continue;
+        }
+        switch (f.tag) {
+            case KV_STR:
+            case KV_BYTES: bin_str(f.str); break;
+            case KV_BOOL:  bin_u8(f.bool_val ? 1 : 0); break;
+            case KV_INT:   bin_u32((uint32_t)(int32_t)f.num); break;
+            case KV_FLOAT: {
+                float v = (float)f.num;
+                uint32_t bits;
+                memcpy(&bits, &v, sizeof(bits));
+                bin_u32(bits);
                 break;
+            }
         }
+    }
+    bin_end();
+}
+
+static void send_binary(unsigned count, va_list *ap)
+{
+    va_list pass;
+    uint8_t n;
+
+    va_copy(pass, *ap);
+    uint16_t layout = bin_layout_id(count, &pass, &n);
+    va_end(pass);
 
-        if (str != NULL) {
-            cJSON_AddStringToObject(reply, key, str);
+    unsigned slot = BIN_LAYOUT_SLOTS;
+    for (unsigned i = 0; i < BIN_LAYOUT_SLOTS; i++) {
+        if (bin_layouts[i].used && bin_layouts[i].id == layout) {
+            slot = i;
+            break;
         }
     }
-    va_end(ap);
+    if (slot == BIN_LAYOUT_SLOTS) {
+        slot = bin_evict++ % BIN_LAYOUT_SLOTS;
+        bin_layouts[slot].used = true;
+        bin_layouts[slot].id = layout;
+        bin_layouts[slot].frames = BIN_SCHEMA_REPEAT;
+    }
+    if (bin_layouts[slot].frames >= BIN_SCHEMA_REPEAT) {
+        va_copy(pass, *ap);
+        bin_schema(layout, n, count, &pass);
+        va_end(pass);
+        bin_layouts[slot].frames = 0;
+    }
+    bin_data(layout, count, ap);
+    bin_layouts[slot].frames++;
+}
+
+void set_status_format(status_format_t format)
+{
+    format_req = format;
+    format_seq++;
+}
+
+void send_json_set_writer(send_json_writer_t writer)
+{
+    out_writer = writer;
+}
 
-    char *out = cJSON_PrintUnformatted(reply);
-    printf("%s\n", out);
-    cJSON_free(out);
-    cJSON_Delete(reply);
+void send_json(unsigned count, ...)
+{
+    va_list ap;
+    if (format_applied != format_seq) {
+        format_applied = format_seq;
+        status_format = format_req;
+        /* (Re)announce every layout in the new stream. */
+        memset(bin_layouts, 0, sizeof(bin_layouts));
+    }
+    va_start(ap, count);
+    if (status_format == STATUS_FORMAT_BINARY) {
+        send_binary(count, &ap);
+    } else {
+        send_text(count, &ap);
+    }
+    va_end(ap);
+    if (!out_writer) {
+        fflush(stdout);
+    }
 }
@@ -5,7 +5,6 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
-#include "cJSON.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,7 +16,7 @@ typedef enum {
     KV_STR,
     KV_INT,
     /* A NaN (or infinite) KV_FLOAT value is emitted as JSON null —
-       cJSON's print_number substitutes "null" for non-finite doubles.
+       send_json() prints numbers exactly as cJSON's print_number does.
        Apps use this to report "no valid reading" for a numeric field
        (e.g. tempctrl T_now while the sensor data is invalid). */
     KV_FLOAT,
@@ -25,8 +24,41 @@ typedef enum {
     KV_BOOL
 } kv_type_t;
 
-void handle_json_command(const char *line, uint32_t *cadence_ms);
+/* Encoding of everything send_json() emits. JSON text lines are the
+   default after boot; the host opts into binary frames with the universal
+   {"status_format":"binary"} command (main.c).
+
+   Binary frames: one line per send_json() call,
+       0x00, COBS(payload, crc16) with each byte XOR 0x0a, 0x00, '\n'
+   XOR-ing the COBS output with '\n' keeps the newline out of the frame,
+   so the host still splits the stream with readline(). Payload, all
+   little-endian:
+       u8 version (BIN_STATUS_VERSION), u8 kind, u16 layout, body
+   kind 'S' (schema): u8 n, then n x (u8 kv_type_t, u8 key_len, key)
+   kind 'D' (data):   the values in schema order --
+       KV_INT i32, KV_FLOAT f32 (NaN/inf = null), KV_BOOL u8,
+       KV_STR/KV_BYTES u8 len + bytes (len 0xff: NULL, field omitted)
+   crc16 is CRC-16/CCITT-FALSE over the payload. `layout` is the same
+   CRC over the (type, key) list, so keys are sent once per layout in a
+   schema frame instead of in every packet: a schema frame precedes the
+   first data frame of each layout after the format is selected and is
+   repeated every BIN_SCHEMA_REPEAT data frames for a host that attaches
+   mid-stream. */
+typedef enum {
+    STATUS_FORMAT_JSON,
+    STATUS_FORMAT_BINARY
+} status_format_t;
+
+#define BIN_STATUS_VERSION 1
+#define BIN_SCHEMA_REPEAT  50
+
+/* Where send_json() output goes: stdout by default (NULL). The dual-core
+   build points core 1's output at the core-0 mailbox instead. */
+typedef void (*send_json_writer_t)(const char *buf, size_t len);
+
 void send_json(unsigned count, ...);
+void send_json_set_writer(send_json_writer_t writer);
+void set_status_format(status_format_t format);
 
 #ifdef __cplusplus
 }
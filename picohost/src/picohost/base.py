@@ -13,6 +13,7 @@ from serial import Serial
 from serial.tools import list_ports
 
 from .flash_picos import find_pico_ports
+from . import binframe
 from . import imu_geometry as ig
 
 logger = logging.getLogger(__name__)
@@ -22,6 +23,10 @@ PICO_VID = 0x2E8A
 PICO_PID_CDC = 0x0009  # CDC mode (serial)
 PICO_PID_BOOTSEL = 0x000F  # RP2350 BOOTSEL mode (RP2040 was 0x0003)
 
+#: Longest command line the firmware accepts, newline excluded
+#: (BUFFER_SIZE - 1 in lib/eigsep_command/eigsep_command.h).
+MAX_COMMAND_LEN = 255
+
 
 def redis_handler(writer, float_fields=()):
     """
@@ -136,8 +141,13 @@ class PicoDevice:
         self._write_lock = threading.Lock()
         self._response_handler = None
         self._raw_handler = None
+        self.status_format = "json"
+        self.cadence_ms = None  # firmware default (STATUS_CADENCE_MS)
+        self._bin_decoder = binframe.BinaryStatusDecoder()
         self.last_status = {}
         self.last_status_time = None
+        self.last_perf = None  # latest {"cmd":"perf"} record
+        self._perf_event = threading.Event()
         if name is None:
             self.name = port.split("/")[-1] if "/" in port else port
         else:
@@ -250,6 +260,10 @@ class PicoDevice:
             self._rediscover_port()
         if not self._open_serial():
             return False
+        # A rebooted board comes back in JSON at its default cadence;
+        # ask again for whatever the host chose.
+        if self.status_format != "json" or self.cadence_ms is not None:
+            self._send_universal()
         self.on_reconnect()
         return True
 
@@ -280,6 +294,14 @@ class PicoDevice:
         """
         pass
 
+    def on_status(self, data: Dict[str, Any]) -> None:
+        """
+        Hook invoked by the reader thread for every JSON status line,
+        after ``last_status`` is updated and before Redis publication.
+        Default is a no-op.
+        """
+        pass
+
     def send_command(self, cmd_dict: Dict[str, Any]) -> None:
         """
         Send a JSON command to the device.
@@ -303,18 +325,94 @@ class PicoDevice:
         except Exception as e:
             raise ConnectionError(f"{self.name} write failed: {e}") from e
 
-    def read_line(self) -> Optional[str]:
+    def set_status_format(self, fmt: str) -> None:
+        """
+        Select how the firmware encodes status lines.
+
+        Args:
+            fmt: ``"json"`` (the boot default) or ``"binary"`` for the
+                compact framing in :mod:`picohost.binframe`. Status
+                dicts reach the handlers the same way in either mode.
+
+        The choice is re-sent after every reconnect.
+        """
+        if fmt not in ("json", "binary"):
+            raise ValueError(f"unknown status format {fmt!r}")
+        self.status_format = fmt
+        self._send_universal()
+
+    def set_cadence(self, cadence_ms: int) -> None:
+        """
+        Set the firmware's status reporting period.
+
+        Args:
+            cadence_ms: Period in milliseconds. The firmware clamps it to
+                per-app bounds (``CADENCE_*`` in ``src/pico_multi.h``:
+                20 ms for the IMU and lidar, 200 ms for tempctrl, at
+                most 5000 ms for every app).
+
+        The choice is re-sent after every reconnect.
+        """
+        cadence_ms = int(cadence_ms)
+        if cadence_ms <= 0:
+            raise ValueError(f"cadence_ms must be positive: {cadence_ms}")
+        self.cadence_ms = cadence_ms
+        self._send_universal()
+
+    def request_perf(
+        self, reset: bool = False, timeout: float = 2.0
+    ) -> Optional[Dict[str, Any]]:
+        """
+        Ask the firmware for its main-loop timing record.
+
+        Args:
+            reset: start a new measurement window after this record.
+            timeout: seconds to wait for the record.
+
+        Returns:
+            The ``"perf"`` record (see ``src/loop_perf.h``): per-phase
+            ``*_n``, ``*_min_us``, ``*_mean_us``, ``*_max_us`` and
+            ``*_p99_us`` for dispatch, op, status, usb_write and loop,
+            plus ``loop_hz``, ``dispatch_capped`` and ``usb_stalls``.
+            ``None`` if none arrived in time.
+        """
+        cmd = {"cmd": "perf"}
+        if reset:
+            cmd["reset"] = True
+        self._perf_event.clear()
+        self.send_command(cmd)
+        if not self._perf_event.wait(timeout):
+            return None
+        return self.last_perf
+
+    def _send_universal(self):
+        """Send the host's status_format and cadence_ms choices."""
+        cmd = {"status_format": self.status_format}
+        if self.cadence_ms is not None:
+            cmd["cadence_ms"] = self.cadence_ms
+        # The firmware re-announces every layout on a status_format
+        # command, so start the decoder afresh too.
+        self._bin_decoder.reset()
+        try:
+            self.send_command(cmd)
+        except ConnectionError as e:
+            self.logger.warning(f"{self.name}: {cmd} not sent: {e}")
+
+    def read_line(self):
         """
         Read a line from the serial port.
 
         Returns:
-            Decoded string without newline, or None if no data/error
+            Decoded string without newline, the raw bytes of a binary
+            status frame (newline stripped), or None if no data/error
         """
         if not self.is_connected:
             return None
 
         try:
             line = self.ser.readline()
+            if line and line[:1] == b"\x00":
+                return line.rstrip(b"\n").rstrip(b"\r")
             if line:
                 return line.decode("utf-8", errors="ignore").strip()
         except Exception:
@@ -330,16 +428,23 @@ class PicoDevice:
             self.ser = None
         return None
 
-    def parse_response(self, line: str) -> Optional[Dict[str, Any]]:
+    def parse_response(self, line) -> Optional[Dict[str, Any]]:
         """
-        Parse JSON response from device.
+        Parse JSON response (or binary status frame) from device.
 
         Args:
-            line: Raw string from serial port
+            line: Raw string from serial port, or frame bytes
 
         Returns:
-            Parsed JSON as dictionary, or None if parsing fails
+            Parsed JSON as dictionary, or None if parsing fails (and for
+            binary schema frames, which carry no values)
         """
+        if binframe.is_frame(line):
+            try:
+                return self._bin_decoder.feed(line)
+            except ValueError as e:
+                self.logger.debug(f"{self.name}: bad status frame: {e}")
+                return None
         try:
             return json.loads(line)
         except json.JSONDecodeError:
@@ -364,9 +469,16 @@ class PicoDevice:
             if line:
                 # Try to parse as JSON
                 data = self.parse_response(line)
-                if data:  # is json
+                if data and data.get("sensor_name") == "perf":
+                    # Loop timing asked for by request_perf(): kept off
+                    # the status path and out of Redis.
+                    self.last_perf = data
+                    self.last_status_time = time.time()
+                    self._perf_event.set()
+                elif data:  # is json
                     self.last_status = data
                     self.last_status_time = time.time()
+                    self.on_status(data)
                     if self.verbose:
                         self.logger.debug(json.dumps(data, sort_keys=True))
                     # upload to redis
@@ -379,7 +491,7 @@ class PicoDevice:
                     if self._response_handler:
                         self._response_handler(data)
                 # Call raw handler on non-json if set
-                elif self._raw_handler:
+                elif self._raw_handler and not binframe.is_frame(line):
                     self._raw_handler(line)
 
     def set_response_handler(self, handler: Callable[[Dict[str, Any]], None]):
@@ -482,7 +594,11 @@ class PicoRFSwitch(PicoDevice):
 
     # Firmware KV_FLOAT fields (src/rfswitch.c status tick); the
     # host-derived temp_therm* are float-or-None already.
-    _REDIS_FLOAT_FIELDS = ("volt_therm0", "volt_therm1", "volt_therm2")
+    _REDIS_FLOAT_FIELDS = (
+        "volt_therm0",
+        "volt_therm1",
+        "volt_therm2",
+    )
 
     # --- PCB thermistor conversion (host-side) --------------------------
     # Three 10k NTC thermistors on the RF switch PCB (ADC0-2). Wiring:
@@ -565,6 +681,8 @@ class PicoRFSwitch(PicoDevice):
         return dict(self.PATHS)
 
     def __init__(self, *args, **kwargs):
+        # Before super().__init__(): the reader thread starts there.
+        self._sw_cond = threading.Condition()
         super().__init__(*args, **kwargs)
         self._name_by_state = {v: k for k, v in self.paths.items()}
         if self.redis_handler is not None:
@@ -605,21 +723,34 @@ class PicoRFSwitch(PicoDevice):
                 therm[f"temp_therm{i}"] = self._therm_temp_c(v)
             self._base_redis_handler(therm)
 
-    def switch(self, state: str) -> None:
+    def on_status(self, data):
+        """Wake :meth:`switch` callers waiting on a settle."""
+        with self._sw_cond:
+            self._sw_cond.notify_all()
+
+    def switch(
+        self, state: str, wait: bool = False, timeout: float = 1.0
+    ) -> None:
         """
         Set RF switch state.
 
-        The call returns as soon as the command has been delivered to
-        the firmware. The firmware holds its reported ``sw_state`` at
+        The firmware holds its reported ``sw_state`` at
         :attr:`SW_STATE_UNKNOWN` until the physical switch is trusted
-        to have settled, so callers that need closed-loop confirmation
-        should poll for the expected state name (e.g. via Redis) rather
-        than time.sleep here.
+        to have settled (a hardware alarm, SWITCH_SETTLE_US after the
+        command), then sends a status line at once rather than at the
+        next status tick; ``settled_s`` and ``settled_us`` in it give
+        the alarm time since boot.
 
         Parameters
         ----------
         state: str
             Switch state path, see self.PATHS for valid keys
+        wait: bool
+            Return only once a status line reports ``state`` settled.
+            Without it the call returns as soon as the command has been
+            delivered to the firmware.
+        timeout: float
+            Seconds to wait for the settle when ``wait`` is set.
 
         Raises
         -------
@@ -627,6 +758,8 @@ class PicoRFSwitch(PicoDevice):
             If an invalid switch state is provided
         ConnectionError
             If the device is not connected or the write failed.
+        TimeoutError
+            If ``wait`` is set and no settled status arrived in time.
 
         """
         try:
@@ -638,6 +771,95 @@ class PicoRFSwitch(PicoDevice):
             ) from e
         self.send_command({"sw_state": s})
         self.logger.info(f"Switched to {state}.")
+        if not wait:
+            return
+        # Any other state reads UNKNOWN until the firmware settles at
+        # ``s``; a command for the state it is already in is a no-op
+        # and the current status already answers it.
+        with self._sw_cond:
+            settled = self._sw_cond.wait_for(
+                lambda: self.last_status.get("sw_state") == s, timeout
+            )
+        if not settled:
+            raise TimeoutError(
+                f"RF switch did not report {state} within {timeout} s"
+            )
+
+    # Firmware sequencer bounds (RFSWITCH_SEQ_* in src/rfswitch.h). The
+    # minimum is 2x the 20 ms settle; an RFSWITCH_FAST_SETTLE build
+    # takes 1.0, which a subclass can set.
+    SEQ_LEN = 16
+    SEQ_MIN_DWELL_MS = 40.0
+    SEQ_MAX_DWELL_MS = 3_600_000
+
+    def run_sequence(self, steps, repeat: int = 1) -> None:
+        """
+        Have the firmware step the switch through a timed sequence.
+
+        The firmware starts each step on its own hardware timer, on a
+        grid from the moment the command arrives, so step timing does
+        not depend on USB, Redis or this process. Every step sends a
+        status line with ``seq_step``, ``seq_pass`` and the step's
+        ``settled_s`` / ``settled_us``; a line with ``seq_step`` -1
+        follows the last.
+        The switch stays on the last step's path. Replaces any running
+        sequence; :meth:`switch` or :meth:`stop_sequence` ends one.
+
+        Parameters
+        ----------
+        steps: list of (str, float)
+            ``(path, dwell_ms)`` pairs, see self.PATHS for valid paths.
+            A dwell runs from the step's switch command, settle
+            included, with microsecond resolution.
+        repeat: int
+            Passes through ``steps``; 0 repeats until stopped.
+
+        Raises
+        -------
+        ValueError
+            On an unknown path, a dwell out of range, more than
+            SEQ_LEN steps, a negative repeat, or a command too long for
+            the firmware's line buffer.
+        ConnectionError
+            If the device is not connected or the write failed.
+        """
+        if not steps or len(steps) > self.SEQ_LEN:
+            raise ValueError(
+                f"a sequence takes 1 to {self.SEQ_LEN} steps, "
+                f"got {len(steps)}"
+            )
+        if isinstance(repeat, bool) or not isinstance(repeat, int):
+            raise ValueError(f"repeat must be an int, got {repeat!r}")
+        if repeat < 0:
+            raise ValueError(f"repeat must be >= 0, got {repeat}")
+        seq = []
+        for state, dwell_ms in steps:
+            if state not in self.paths:
+                raise ValueError(
+                    f"Invalid switch state '{state}'. Valid states: "
+                    f"{list(self.paths.keys())}"
+                )
+            if not (
+                self.SEQ_MIN_DWELL_MS <= dwell_ms <= self.SEQ_MAX_DWELL_MS
+            ):
+                raise ValueError(
+                    f"dwell_ms must be in [{self.SEQ_MIN_DWELL_MS}, "
+                    f"{self.SEQ_MAX_DWELL_MS}], got {dwell_ms}"
+                )
+            seq.append([self.paths[state], dwell_ms])
+        cmd = {"sw_sequence": seq, "sw_repeat": repeat}
+        if len(json.dumps(cmd, separators=(",", ":"))) > MAX_COMMAND_LEN:
+            raise ValueError(
+                f"sequence command exceeds {MAX_COMMAND_LEN} characters"
+            )
+        self.send_command(cmd)
+        self.logger.info(
+            f"Started a {len(seq)}-step switch sequence, repeat={repeat}."
+        )
+
+    def stop_sequence(self) -> None:
+        """Stop a running sequence, leaving the switch where it is."""
+        self.send_command({"sw_sequence": []})
 
 
 class PicoPeltier(PicoDevice):
@@ -683,6 +905,7 @@ class PicoPeltier(PicoDevice):
         self._keepalive_interval = keepalive_interval
         self._last_watchdog_timeout_ms = None
         self._last_installed = {}
+        self._last_adc_filter = {}
         self._last_clamp = {}
         self._last_cooling = {}
         self._last_gains = {}
@@ -720,6 +943,8 @@ class PicoPeltier(PicoDevice):
         "Kp",
         "Ki",
         "integral",
+        "adc_oversample",
+        "adc_median",
     )
     _PELTIER_STREAMS = (("LNA", "tempctrl_lna"), ("LOAD", "tempctrl_load"))
 
@@ -826,11 +1051,13 @@ class PicoPeltier(PicoDevice):
         (hard watchdog, brownout, picotool re-flash via BOOTSEL) drops
         USB CDC, so reader-thread reconnect coincides with the firmware
         coming up at defaults. Replay whatever the host most recently
-        pushed in a safe order: watchdog → installed → clamp →
-        cooling_enabled → gains → temperature → enable. installed lands
-        right after the watchdog so a descoped channel is gated (no
+        pushed in a safe order: watchdog → installed → adc_filter →
+        clamp → cooling_enabled → gains → temperature → enable. installed
+        lands right after the watchdog so a descoped channel is gated (no
         sampling, no drive) before any drive-producing config arrives —
-        the firmware reboots to installed=true defaults. cooling_enabled
+        the firmware reboots to installed=true defaults. The ADC filter
+        follows, so the samples control runs on are filtered as asked
+        from the first one. cooling_enabled
         lands between clamp and gains so the asymmetric-clamp safety
         setting is in place before any drive can result from the next
         setpoint. Gains land before temperature so the channel is fully
@@ -843,6 +1070,8 @@ class PicoPeltier(PicoDevice):
             )
         if self._last_installed:
             self.send_command(dict(self._last_installed))
+        if self._last_adc_filter:
+            self.send_command(dict(self._last_adc_filter))
         if self._last_clamp:
             self.send_command(dict(self._last_clamp))
         if self._last_cooling:
@@ -882,7 +1111,7 @@ class PicoPeltier(PicoDevice):
         """Mark a channel's hardware module present/absent.
 
         ``False`` descopes the channel: firmware never samples its
-        thermistor (the ADC input is never mux-selected, so it cannot
+        thermistor (the ADC input leaves the round robin, so it cannot
         crosstalk into the other channel) and never drives it, and the
         redis fan-out suppresses its stream entirely — clean absence
         downstream instead of a permanent ``status="error"`` stream
@@ -905,6 +1134,47 @@ class PicoPeltier(PicoDevice):
             self.send_command(cmd)
             self._last_installed.update(cmd)
 
+    def set_adc_filter(
+        self,
+        LNA_oversample=None,
+        LNA_median=None,
+        LOAD_oversample=None,
+        LOAD_median=None,
+    ):
+        """Set the thermistor decimation filter per channel.
+
+        ``*_oversample`` is the ADC samples behind each reading: a
+        multiple of 64 from 64 to 1024 (firmware default 1024; each 4x
+        halves the noise). ``*_median`` reports the median of the
+        reading's 64-sample block means instead of their mean (firmware
+        default ``True``), which keeps a burst of mux crosstalk out of
+        T_now. Cached for replay on reconnect.
+        """
+        cmd = {}
+        for prefix, oversample, median in (
+            ("LNA", LNA_oversample, LNA_median),
+            ("LOAD", LOAD_oversample, LOAD_median),
+        ):
+            if oversample is not None:
+                if (
+                    isinstance(oversample, bool)
+                    or not isinstance(oversample, int)
+                    or not 64 <= oversample <= 1024
+                    or oversample % 64
+                ):
+                    raise ValueError(
+                        f"{prefix}_oversample must be a multiple of 64 "
+                        "in 64..1024"
+                    )
+                cmd[f"{prefix}_adc_oversample"] = oversample
+            if median is not None:
+                if not isinstance(median, bool):
+                    raise TypeError(f"{prefix}_median must be a bool or None")
+                cmd[f"{prefix}_adc_median"] = median
+        if cmd:
+            self.send_command(cmd)
+            self._last_adc_filter.update(cmd)
+
     def set_temperature(
         self, T_LNA=None, LNA_hyst=0.5, T_LOAD=None, LOAD_hyst=0.5
     ):
@@ -1011,8 +1281,9 @@ class PicoIMU(PicoDevice):
     difference.
     """
 
-    # Firmware KV_FLOAT fields (src/imu.c status tick); the derived
-    # angle fields are host-computed floats or None already.
+    # Firmware KV_FLOAT fields (src/imu.c status tick, RVC and SHTP
+    # modes); the derived angle fields are host-computed floats or None
+    # already.
     _REDIS_FLOAT_FIELDS = (
         "yaw",
         "pitch",
@@ -1020,12 +1291,31 @@ class PicoIMU(PicoDevice):
         "accel_x",
         "accel_y",
         "accel_z",
+        "rvc_rate_hz",
+        "quat_i",
+        "quat_j",
+        "quat_k",
+        "quat_real",
+        "quat_error_rad",
+        "gravity_x",
+        "gravity_y",
+        "gravity_z",
+        "quat_age_ms",
+        "accel_age_ms",
+        "gravity_age_ms",
+    ) + tuple(
+        # Window statistics since the previous tick (imu_stats.h)
+        f"{axis}_{stat}"
+        for axis in ("yaw", "pitch", "roll", "accel_x", "accel_y", "accel_z")
+        for stat in ("mean", "var", "min", "max")
     )
 
     def __init__(self, *args, imu_cal_store=None, **kwargs):
         # {"imu_el": {...}, "imu_az": {...}} — only loaded sections present.
         self._imu_cal = {}
         self._imu_derive_warned = set()
+        # Last report rates sent, replayed on reconnect.
+        self._last_rates = {}
         super().__init__(*args, **kwargs)
         if imu_cal_store is not None:
             cal = imu_cal_store.get()
@@ -1037,6 +1327,30 @@ class PicoIMU(PicoDevice):
             self._base_redis_handler = self.redis_handler
             self.redis_handler = self._imu_redis_handler
 
+    def set_report_rates(self, quat_hz=None, accel_hz=None, gravity_hz=None):
+        """Set the BNO08x report rates in Hz (SHTP wiring only).
+
+        The firmware clamps each to [0, 400]; 0 turns that report off.
+        A sensor wired for UART-RVC streams at a fixed 100 Hz and ignores
+        them. The rates are re-sent after every reconnect.
+        """
+        cmd = {}
+        for key, hz in (
+            ("quat_hz", quat_hz),
+            ("accel_hz", accel_hz),
+            ("gravity_hz", gravity_hz),
+        ):
+            if hz is not None:
+                cmd[key] = int(hz)
+        if cmd:
+            self.send_command(cmd)
+            self._last_rates.update(cmd)
+
+    def on_reconnect(self):
+        """Replay the report rates to a firmware that may have rebooted."""
+        if self._last_rates:
+            self.send_command(dict(self._last_rates))
+
     def set_calibration(self, imu_el=None, imu_az=None):
         """Merge per-IMU calibration sections (live push from calibrate_imu)."""
         if imu_el is not None:
@@ -0,0 +1,249 @@
+"""Binary status framing, the opt-in alternative to JSON status lines.
+
+The host sends ``{"status_format": "binary"}`` and every later status
+line from the firmware is a frame instead of a JSON object (see
+``lib/eigsep_command/eigsep_command.h`` for the C side)::
+
+    0x00, COBS(payload + crc16) with each byte XOR 0x0a, 0x00, '\\n'
+
+COBS removes every 0x00 and the XOR turns that into "no 0x0a", so a
+frame never contains the newline that ends it and ``readline()`` keeps
+working. The leading 0x00 tells frames apart from text lines.
+
+The payload is ``u8 version, u8 kind, u16 layout`` and then a body.
+``kind`` is ``S`` (schema: the tag and key of each field) or ``D``
+(data: just the values, in schema order). Keys are therefore sent once
+per layout, and again every ``SCHEMA_REPEAT`` data frames, so a reader
+that joins mid-stream (or drops a frame) picks the layout back up.
+All multi-byte values are little-endian.
+"""
+
+import math
+import struct
+
+VERSION = 1
+MARK = 0x00
+XOR = 0x0A
+SCHEMA_REPEAT = 50
+
+KIND_SCHEMA = ord("S")
+KIND_DATA = ord("D")
+
+# send_json() tags (kv_type_t)
+KV_STR = 0
+KV_INT = 1
+KV_FLOAT = 2
+KV_BYTES = 3
+KV_BOOL = 4
+
+NULL_STR = 0xFF
+MAX_STR = 254
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE (poly 0x1021), as crc16_update() in firmware."""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    """Consistent Overhead Byte Stuffing; the result has no 0x00."""
+    out = bytearray()
+    block = bytearray()
+    for b in data:
+        if b == 0:
+            out.append(len(block) + 1)
+            out += block
+            block.clear()
+            continue
+        block.append(b)
+        if len(block) == 254:
+            out.append(0xFF)
+            out += block
+            block.clear()
+    out.append(len(block) + 1)
+    out += block
+    return bytes(out)
+
+
+def cobs_decode(data):
+    """Inverse of cobs_encode(); ValueError on a malformed block."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError("bad COBS block")
+        out += data[i + 1 : i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def is_frame(line):
+    """True for a raw status line that is a binary frame."""
+    return isinstance(line, (bytes, bytearray)) and line[:1] == b"\x00"
+
+
+def encode_frame(payload):
+    """Wrap *payload* as one status line, trailing newline included."""
+    crc = crc16(payload)
+    body = cobs_encode(bytes(payload) + struct.pack("<H", crc))
+    return b"\x00" + bytes(b ^ XOR for b in body) + b"\x00\n"
+
+
+def decode_frame(line):
+    """Payload of one frame (newline stripped), or ValueError."""
+    if len(line) < 3 or line[0] != MARK or line[-1] != MARK:
+        raise ValueError("not a binary status frame")
+    raw = cobs_decode(bytes(b ^ XOR for b in line[1:-1]))
+    if len(raw) < 6:
+        raise ValueError("short frame")
+    payload, (crc,) = raw[:-2], struct.unpack("<H", raw[-2:])
+    if crc16(payload) != crc:
+        raise ValueError("frame CRC mismatch")
+    return payload
+
+
+def layout_id(fields):
+    """Layout id of a ``[(tag, key), ...]`` list, as bin_layout_id()."""
+    crc = 0xFFFF
+    for tag, key in fields:
+        crc = crc16(bytes([tag]) + key.encode("utf-8") + b"\x00", crc)
+    return crc
+
+
+def _tag_for(value):
+    if isinstance(value, bool):
+        return KV_BOOL
+    if isinstance(value, int):
+        return KV_INT
+    if isinstance(value, str):
+        return KV_STR
+    return KV_FLOAT
+
+
+def _pack_str(s):
+    if s is None:
+        return bytes([NULL_STR])
+    raw = s.encode("utf-8")[:MAX_STR]
+    return bytes([len(raw)]) + raw
+
+
+class BinaryStatusEncoder:
+    """Turns status dicts into frames, the way send_json() does.
+
+    Tags are inferred from the Python types (the emulators already keep
+    ints and floats apart to match the firmware's KV_INT/KV_FLOAT); a
+    ``None`` value is sent as a float NaN, which decodes back to None.
+    """
+
+    def __init__(self, schema_repeat=SCHEMA_REPEAT):
+        self.schema_repeat = schema_repeat
+        self._frames = {}
+
+    def reset(self):
+        """Forget the layouts sent so far (on a status_format change)."""
+        self._frames.clear()
+
+    def encode(self, data):
+        fields = [(_tag_for(v), k) for k, v in data.items()]
+        layout = layout_id(fields)
+        head = struct.pack("<BBH", VERSION, KIND_DATA, layout)
+        out = b""
+        sent = self._frames.get(layout, self.schema_repeat)
+        if sent >= self.schema_repeat:
+            schema = bytearray(
+                struct.pack("<BBHB", VERSION, KIND_SCHEMA, layout, len(fields))
+            )
+            for tag, key in fields:
+                schema += bytes([tag]) + _pack_str(key)
+            out += encode_frame(schema)
+            self._frames[layout] = 0
+        body = bytearray(head)
+        for (tag, _), value in zip(fields, data.values()):
+            if tag == KV_BOOL:
+                body.append(1 if value else 0)
+            elif tag == KV_INT:
+                body += struct.pack("<i", value)
+            elif tag == KV_STR:
+                body += _pack_str(value)
+            else:
+                body += struct.pack(
+                    "<f", math.nan if value is None else float(value)
+                )
+        out += encode_frame(body)
+        self._frames[layout] += 1
+        return out
+
+
+class BinaryStatusDecoder:
+    """Rebuilds status dicts from frames.
+
+    ``feed()`` returns the dict for a data frame and None for a schema
+    frame or for a data frame whose layout has not been announced yet.
+    The dict matches what the JSON line would have parsed to: NaN/inf
+    floats become None and NULL strings are left out.
+    """
+
+    def __init__(self):
+        self._layouts = {}
+
+    def reset(self):
+        self._layouts.clear()
+
+    def feed(self, line):
+        payload = decode_frame(line)
+        if payload[0] != VERSION:
+            raise ValueError(f"unknown frame version {payload[0]}")
+        kind, layout = payload[1], struct.unpack_from("<H", payload, 2)[0]
+        if kind == KIND_SCHEMA:
+            self._layouts[layout] = self._parse_schema(payload)
+            return None
+        if kind != KIND_DATA:
+            raise ValueError(f"unknown frame kind {kind}")
+        fields = self._layouts.get(layout)
+        if fields is None:
+            return None
+        return self._parse_data(payload, fields)
+
+    @staticmethod
+    def _parse_schema(payload):
+        n, pos = payload[4], 5
+        fields = []
+        for _ in range(n):
+            tag, klen = payload[pos], payload[pos + 1]
+            key = payload[pos + 2 : pos + 2 + klen].decode("utf-8")
+            fields.append((tag, key))
+            pos += 2 + klen
+        return fields
+
+    @staticmethod
+    def _parse_data(payload, fields):
+        out = {}
+        pos = 4
+        for tag, key in fields:
+            if tag == KV_BOOL:
+                out[key] = bool(payload[pos])
+                pos += 1
+            elif tag == KV_INT:
+                out[key] = struct.unpack_from("<i", payload, pos)[0]
+                pos += 4
+            elif tag == KV_FLOAT:
+                v = struct.unpack_from("<f", payload, pos)[0]
+                out[key] = v if math.isfinite(v) else None
+                pos += 4
+            else:
+                n = payload[pos]
+                pos += 1
+                if n == NULL_STR:
+                    continue
+                raw = payload[pos : pos + n]
+                out[key] = raw.decode("utf-8", errors="replace")
+                pos += n
+        return out
@@ -1,4 +1,5 @@
 from .base import PicoEmulator
+from .clock import RealClock, VirtualClock
 from .motor import MotorEmulator
 from .tempctrl import TempCtrlEmulator
 from .imu import ImuEmulator
@@ -8,6 +9,8 @@ from .rfswitch import RFSwitchEmulator
 
 __all__ = [
     "PicoEmulator",
+    "RealClock",
+    "VirtualClock",
     "MotorEmulator",
     "TempCtrlEmulator",
     "ImuEmulator",
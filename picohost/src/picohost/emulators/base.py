@@ -1,12 +1,45 @@
 import json
 import math
 import threading
-import time
 import logging
 
+from ..binframe import BinaryStatusEncoder
+from .clock import RealClock
+from .loop_perf import LoopPerf, now_us
+
 logger = logging.getLogger(__name__)
 
 
+# Status cadence bounds per app_id, mirroring CADENCE_* in
+# src/pico_multi.h: {"cadence_ms": N} is clamped to [min, CADENCE_MAX_MS].
+CADENCE_MIN_MS = {0: 50, 1: 200, 2: 50, 3: 20, 4: 20, 5: 100, 6: 20}
+CADENCE_MAX_MS = 5000
+DEFAULT_CADENCE_MS = 200
+
+# Complete command lines the firmware queues between main-loop passes
+# (CMD_RX_QUEUE_LEN in src/cmd_rx.h); more than that wait for the next
+# pass, held back by USB flow control.
+CMD_RX_QUEUE_LEN = 16
+# Longest line the firmware keeps (BUFFER_SIZE - 1 in eigsep_command.h);
+# longer ones are truncated there and counted in cmd_overflow. The
+# emulator counts them but keeps them whole, so its parse-pool model can
+# still be driven past CMD_POOL_BYTES.
+CMD_LINE_MAX = 255
+
+# Command parse pool (src/cmd_pool.h), sized for the RP2's 32-bit cJSON
+# nodes: 40 bytes each, every allocation rounded up to 8.
+CMD_POOL_ALIGN = 8
+CMD_POOL_NODE = 40
+CMD_POOL_BYTES = 128 * (CMD_POOL_NODE + 2 * CMD_POOL_ALIGN) + 256
+
+# Emulator time per main-loop pass (the yield between passes).
+LOOP_PERIOD_S = 0.001
+
+# cJSON's valueint saturates to the firmware's int range.
+INT32_MIN = -(2**31)
+INT32_MAX = 2**31 - 1
+
+
 def _safe_int(val, default=0):
     """Convert to int, returning *default* on failure.
 
@@ -21,6 +54,27 @@ def _safe_int(val, default=0):
         return default
 
 
+def _cmd_number(val, lo, hi):
+    """Mirror cmd_table.c for a CMD_FLOAT / CMD_CLAMP key: a JSON number
+    (not a bool) clamped to [lo, hi], or None for anything else, which
+    leaves the setting alone.
+    """
+    if isinstance(val, bool) or not isinstance(val, (int, float)):
+        return None
+    if math.isnan(val):
+        return None
+    return min(hi, max(lo, float(val)))
+
+
+def _cmd_int(val, lo=INT32_MIN, hi=INT32_MAX):
+    """Mirror cmd_table.c for a CMD_INT / CMD_CLAMP key: a JSON number
+    (not a bool) clamped to [lo, hi] and truncated toward zero, or None
+    for anything else, which leaves the setting alone.
+    """
+    val = _cmd_number(val, lo, hi)
+    return None if val is None else int(val)
+
+
 def _cjson_number(value):
     """Reshape one JSON value the way firmware cJSON prints it.
 
@@ -55,20 +109,56 @@ def _safe_float(val, default=0.0):
         return default
 
 
+def _cmd_pool_bytes(value, key=None):
+    """Arena bytes cJSON_Parse takes for `value` in the command pool.
+
+    One node per value, plus its key and any string value with their
+    terminators. Exact for ASCII without escapes; cJSON sizes an
+    escaped string by its raw text, a little over this.
+    """
+
+    def align(n):
+        return -(-n // CMD_POOL_ALIGN) * CMD_POOL_ALIGN
+
+    n = CMD_POOL_NODE
+    if key is not None:
+        n += align(len(key.encode()) + 1)
+    if isinstance(value, str):
+        n += align(len(value.encode()) + 1)
+    elif isinstance(value, dict):
+        n += sum(_cmd_pool_bytes(v, k) for k, v in value.items())
+    elif isinstance(value, list):
+        n += sum(_cmd_pool_bytes(v) for v in value)
+    return n
+
+
 class PicoEmulator:
     """Models the C firmware's four-phase execution loop.
 
     Each subclass implements init(), server(), op(), and get_status()
-    to match the corresponding C firmware app.
+    to match the corresponding C firmware app, reading time from
+    ``self.clock`` (see clock.py; real time unless one is passed in).
     """
 
-    def __init__(self, app_id=0, status_cadence_ms=200.0):
+    def __init__(self, app_id=0, status_cadence_ms=200.0, clock=None):
+        self.clock = RealClock() if clock is None else clock
         self.app_id = app_id
         self.status_cadence_ms = status_cadence_ms
         self._peer = None
         self._running = False
         self._thread = None
         self._cmd_buffer = ""
+        self._next_status = self.clock.now() + status_cadence_ms / 1000.0
+        # main.c receive-queue and parse-pool counters: live across app
+        # init() (reboot is a new emulator), reported by every app's
+        # status.
+        self.cmd_queue_max = 0
+        self.cmd_overflow = 0
+        self.cmd_pool_max = 0
+        self.cmd_pool_fail = 0
+        self.perf = LoopPerf()
+        self.status_format = "json"
+        self._bin_encoder = BinaryStatusEncoder()
         self.init()
 
     def attach(self, serial_peer):
@@ -110,24 +200,53 @@ class PicoEmulator:
             self._thread.join(timeout=2.0)
             self._thread = None
 
-    def _run_loop(self):
-        """Main emulator loop mirroring the C main() loop."""
-        next_status = time.monotonic() + self.status_cadence_ms / 1000.0
+    def step(self, n=1):
+        """Run ``n`` main-loop passes on the calling thread.
 
-        while self._running:
-            # 1. Non-blocking read from peer serial (check for host commands)
-            self._read_commands()
+        For deterministic tests on a VirtualClock, without start(): each
+        pass advances the clock by LOOP_PERIOD_S.
+        """
+        for _ in range(n):
+            self._loop_pass()
 
-            # 2. Advance state
-            self.op()
+    def run_for(self, seconds):
+        """Run main-loop passes until ``seconds`` of clock time pass."""
+        end = self.clock.now() + seconds
+        while self.clock.now() < end:
+            self._loop_pass()
 
-            # 3. Send status at cadence interval
-            now = time.monotonic()
-            if now >= next_status:
-                self._send_status()
-                next_status = now + self.status_cadence_ms / 1000.0
+    def _run_loop(self):
+        """Main emulator loop mirroring the C main() loop."""
+        self._next_status = (
+            self.clock.now() + self.status_cadence_ms / 1000.0
+        )
 
-            time.sleep(0.001)  # yield
+        while self._running:
+            self._loop_pass()
+
+    def _loop_pass(self):
+        """One pass of the C main() loop, then a yield."""
+        pass_start = now_us()
+        # 1. Non-blocking read from peer serial (check for host commands)
+        self._read_commands()
+
+        # 2. Advance state
+        t = now_us()
+        self.op()
+        self.perf.record("op", t)
+        if self.perf.request is not None:
+            self._send_perf()
+
+        # 3. Send status at cadence interval
+        now = self.clock.now()
+        if now >= self._next_status:
+            t = now_us()
+            self._send_status()
+            self.perf.record("status", t)
+            self._next_status = now + self.status_cadence_ms / 1000.0
+
+        self.perf.record("loop", pass_start)
+        self.clock.sleep(LOOP_PERIOD_S)
 
     def _read_commands(self):
         """Non-blocking read of commands from the peer serial."""
@@ -143,17 +262,75 @@ class PicoEmulator:
         except Exception:
             return
 
-        # Process complete lines
-        while "\n" in self._cmd_buffer:
+        # Queue the complete lines, as the firmware's USB receive
+        # callback does between two passes of the main loop. Past a full
+        # queue the rest stays in the buffer for the next pass.
+        lines = []
+        while "\n" in self._cmd_buffer and len(lines) < CMD_RX_QUEUE_LEN:
             line, self._cmd_buffer = self._cmd_buffer.split("\n", 1)
+            if len(line) > CMD_LINE_MAX:
+                self.cmd_overflow += 1
+            lines.append(line)
+        self.cmd_queue_max = max(self.cmd_queue_max, len(lines))
+        if len(lines) == CMD_RX_QUEUE_LEN:
+            self.perf.dispatch_capped += 1
+
+        t = now_us()
+        for line in lines:
             line = line.strip()
             if not line:
                 continue
             try:
                 cmd = json.loads(line)
-                self.server(cmd)
             except json.JSONDecodeError:
-                pass
+                continue
+            used = _cmd_pool_bytes(cmd)
+            self.cmd_pool_max = max(
+                self.cmd_pool_max, min(used, CMD_POOL_BYTES)
+            )
+            if used > CMD_POOL_BYTES:
+                # Refused like a line that is not JSON.
+                self.cmd_pool_fail += 1
+                continue
+            self._universal_command(cmd)
+            self.server(cmd)
+        if lines:
+            self.perf.record("dispatch", t)
+
+    def _universal_command(self, cmd):
+        """Keys main.c handles for every app, before app dispatch.
+
+        Mirrors handle_universal_command(): the line is still passed on
+        to server(), whose apps ignore keys they do not know.
+        """
+        if not isinstance(cmd, dict):
+            return
+        if cmd.get("cmd") == "perf":
+            self.perf.request = cmd.get("reset") is True
+        fmt = cmd.get("status_format")
+        if fmt in ("json", "binary"):
+            self.status_format = fmt
+            self._bin_encoder.reset()
+        cadence = cmd.get("cadence_ms")
+        if isinstance(cadence, (int, float)) and not isinstance(
+            cadence, bool
+        ):
+            lo = CADENCE_MIN_MS.get(self.app_id, DEFAULT_CADENCE_MS)
+            ms = int(min(CADENCE_MAX_MS, max(lo, cadence)))
+            if ms < self.status_cadence_ms:
+                self._next_status = min(
+                    self._next_status, self.clock.now() + ms / 1000.0
+                )
+            self.status_cadence_ms = ms
+
+    def _cmd_rx_status(self):
+        """CMD_RX_STATUS fields every firmware app appends to its status."""
+        return {
+            "cmd_queue_max": self.cmd_queue_max,
+            "cmd_overflow": self.cmd_overflow,
+            "cmd_pool_max": self.cmd_pool_max,
+            "cmd_pool_fail": self.cmd_pool_fail,
+        }
 
     def _send_status(self):
         """Write status JSON to the peer serial."""
@@ -177,16 +354,29 @@ class PicoEmulator:
         if not data or self._peer is None:
             return
         try:
-            # Serialize numbers the way firmware cJSON does, so tests
-            # driving devices through emulators see the same shapes as
-            # real hardware (whole-valued floats arrive as JSON ints).
-            line = (
-                json.dumps(
-                    {k: _cjson_number(v) for k, v in data.items()},
-                    separators=(",", ":"),
+            if self.status_format == "binary":
+                payload = self._bin_encoder.encode(data)
+            else:
+                # Serialize numbers the way firmware cJSON does, so tests
+                # driving devices through emulators see the same shapes
+                # as real hardware (whole-valued floats arrive as ints).
+                line = (
+                    json.dumps(
+                        {k: _cjson_number(v) for k, v in data.items()},
+                        separators=(",", ":"),
+                    )
+                    + "\n"
                 )
-                + "\n"
-            )
-            self._peer.write(line.encode("utf-8"))
+                payload = line.encode("utf-8")
+            t = now_us()
+            self._peer.write(payload)
+            self.perf.record("usb_write", t)
         except Exception as e:
             logger.debug(f"Emulator write error: {e}")
+
+    def _send_perf(self):
+        """Answer {"cmd":"perf"} as loop_perf_report() does."""
+        reset, self.perf.request = self.perf.request, None
+        self._write_json(self.perf.report(self.app_id))
+        if reset:
+            self.perf.reset()
@@ -0,0 +1,61 @@
+"""
+Clocks for the emulators.
+
+Emulator time (status cadence, settle and dwell timers, the tempctrl
+watchdog and stall windows) is read from a clock object instead of the
+time module, so a long scenario need not take its real duration:
+
+- ``RealClock(rate=1.0)`` follows ``time.monotonic()``, ``rate`` times
+  faster. A threaded emulator on ``RealClock(rate=50)`` behaves as on
+  hardware, only 50x sooner.
+- ``VirtualClock()`` moves only when advanced. Driven by
+  ``PicoEmulator.step()`` / ``run_for()`` from the test thread, the model
+  runs as fast as Python can and the same way every time.
+
+The C apps have the same two modes in the host simulator (``pico_sim
+--speed`` / ``--virtual``).
+"""
+
+import threading
+import time
+
+
+class RealClock:
+    """``time.monotonic()``, optionally scaled by ``rate``."""
+
+    def __init__(self, rate=1.0):
+        if rate <= 0:
+            raise ValueError(f"rate must be positive, got {rate}")
+        self.rate = float(rate)
+        self._origin = time.monotonic()
+
+    def now(self):
+        """Seconds; only differences are meaningful."""
+        elapsed = time.monotonic() - self._origin
+        return self._origin + elapsed * self.rate
+
+    def sleep(self, seconds):
+        if seconds > 0:
+            time.sleep(seconds / self.rate)
+
+
+class VirtualClock:
+    """Time that passes only through ``advance()`` or ``sleep()``."""
+
+    def __init__(self, start=0.0):
+        self._now = float(start)
+        self._lock = threading.Lock()
+
+    def now(self):
+        return self._now
+
+    def advance(self, seconds):
+        if seconds < 0:
+            raise ValueError(f"cannot go back in time ({seconds} s)")
+        with self._lock:
+            self._now += seconds
+
+    def sleep(self, seconds):
+        """Advance at once; still yields so other threads can run."""
+        self.advance(max(0.0, seconds))
+        time.sleep(0)
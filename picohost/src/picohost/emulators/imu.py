@@ -1,12 +1,63 @@
-import time
-
 import numpy as np
 
 from .. import imu_geometry as ig
-from .base import PicoEmulator
+from .base import PicoEmulator, _cmd_number
 
 NOISE_STDDEV = 0.001
 IMU_EVENT_TIMEOUT_S = 5.0  # matches IMU_EVENT_TIMEOUT_MS in imu.h
+RVC_RATE_HZ = 100.0  # BNO08x RVC output rate
+SH2_MAX_RATE_HZ = 400  # src/sh2.h
+IMU_DEFAULT_RATE_HZ = 100  # src/imu.h
+# Rate key -> SH-2 report it sets (imu_keys in imu.c)
+RATE_KEYS = {"quat_hz": "quat", "accel_hz": "accel", "gravity_hz": "gravity"}
+QUAT_ERROR_RAD = 0.0349  # heading accuracy estimate reported (2 degrees)
+# Window statistics (imu_stats.h): RVC fills every key, SHTP the accel ones
+WINDOW_KEYS = ("yaw", "pitch", "roll", "accel_x", "accel_y", "accel_z")
+ANGLE_KEYS = ("yaw", "roll")
+
+
+def _wrap_deg(deg):
+    """deg wrapped into (-180, 180]."""
+    return 180.0 - (180.0 - deg) % 360.0
+
+
+def _axis_stats(name, xs):
+    """<name>_mean/_var/_min/_max of a window, as AXIS_STATS_KV sends
+    them (imu_stats.c): None until there are samples enough."""
+    return {
+        f"{name}_mean": float(np.mean(xs)) if xs else None,
+        f"{name}_var": float(np.var(xs, ddof=1)) if len(xs) > 1 else None,
+        f"{name}_min": float(min(xs)) if xs else None,
+        f"{name}_max": float(max(xs)) if xs else None,
+    }
+
+
+def _angle_stats(name, degs):
+    """ANGLE_STATS_KV: circular mean; variance, min and max of the
+    offsets from the first sample, wrapped to +/-180."""
+    if not degs:
+        return _axis_stats(name, [])
+    rad = np.radians(degs)
+    offs = [_wrap_deg(d - degs[0]) for d in degs]
+    stats = _axis_stats(name, offs)
+    stats[f"{name}_mean"] = float(
+        np.degrees(np.arctan2(np.sin(rad).sum(), np.cos(rad).sum()))
+    )
+    stats[f"{name}_min"] = _wrap_deg(degs[0] + min(offs))
+    stats[f"{name}_max"] = _wrap_deg(degs[0] + max(offs))
+    return stats
+
+
+def _quat_from_R(R):
+    """Unit quaternion (i, j, k, real) of rotation matrix R."""
+    w = np.sqrt(max(0.0, 1.0 + R[0, 0] + R[1, 1] + R[2, 2])) / 2
+    x = np.sqrt(max(0.0, 1.0 + R[0, 0] - R[1, 1] - R[2, 2])) / 2
+    y = np.sqrt(max(0.0, 1.0 - R[0, 0] + R[1, 1] - R[2, 2])) / 2
+    z = np.sqrt(max(0.0, 1.0 - R[0, 0] - R[1, 1] + R[2, 2])) / 2
+    x = np.copysign(x, R[2, 1] - R[1, 2])
+    y = np.copysign(y, R[0, 2] - R[2, 0])
+    z = np.copysign(z, R[1, 0] - R[0, 1])
+    return float(x), float(y), float(z), float(w)
 
 
 class ImuEmulator(PicoEmulator):
@@ -17,9 +68,14 @@ class ImuEmulator(PicoEmulator):
     The BNO08x in RVC mode outputs euler angles and acceleration;
     this emulator produces matching values via the same forward model
     that imu_geometry inverts.
+
+    ``shtp=True`` models a sensor strapped for SH-2 on I2C, which
+    imu_init() detects: the status then carries the rotation-vector
+    quaternion, calibrated accel and gravity at the rates set by the
+    ``quat_hz`` / ``accel_hz`` / ``gravity_hz`` commands.
     """
 
-    def __init__(self, app_id=3, **kwargs):
+    def __init__(self, app_id=3, shtp=False, **kwargs):
         # Forward-model state (set before super().__init__() in case
         # super triggers init paths that reference these).
         self._mount = np.eye(3)
@@ -38,11 +94,21 @@ class ImuEmulator(PicoEmulator):
         self.accel_y = 0.0
         self.accel_z = 9.81
         self.is_initialized = True
-        self._last_event_time = time.monotonic()
         self._sensor_failed = False  # set via simulate_sensor_failure()
         # Per-cycle freshness flag: True iff a packet was produced since
         # the last get_status() call. Drives the "status" field.
         self.got_packet_this_cycle = False
+        # UART ring / RVC counters (imu.c); tests may set the first two.
+        self.rx_dropped = 0
+        self.rvc_checksum_fail = 0
+        # SHTP mode: report rates (kept across re-inits, as in imu.c) and
+        # each report's latest sample and sample time (None before one).
+        self.shtp = shtp
+        self.rates = {key: IMU_DEFAULT_RATE_HZ for key in RATE_KEYS}
+        self._reset_reports()
+        # Samples since the last status (ImuWindow in imu.h), one per
+        # op() that produced a packet.
+        self.window = {key: [] for key in WINDOW_KEYS}
         # Name depends on app_id: mirrors imu.cpp init_eigsep_imu()
         APP_IMU_EL, APP_IMU_AZ = 3, 6
         if app_id == APP_IMU_EL:
@@ -56,14 +122,29 @@ class ImuEmulator(PicoEmulator):
         super().__init__(app_id=app_id, **kwargs)
 
     def init(self):
-        pass  # state set in __init__
+        # Needs self.clock, which exists only once __init__ is done.
+        self._last_event_time = self.clock.now()
 
     def inject_init_failure(self):
         """Simulate a BNO08x initialization failure."""
         self.is_initialized = False
 
+    def _reset_reports(self):
+        # Mirrors the memset(&imu.sh2, 0) in imu_init.
+        self.reports = {
+            "quat": (0.0, 0.0, 0.0, 0.0),
+            "accel": (0.0, 0.0, 0.0),
+            "gravity": (0.0, 0.0, 0.0),
+        }
+        self.report_times = {name: None for name in self.reports}
+
     def server(self, cmd):
-        pass  # RVC mode: no commands supported
+        # Report rates (CMD_INT, clamped); RVC mode takes them but its
+        # stream stays at 100 Hz.
+        for key in RATE_KEYS:
+            val = _cmd_number(cmd.get(key), 0, SH2_MAX_RATE_HZ)
+            if val is not None:
+                self.rates[key] = int(val)
 
     def simulate_sensor_failure(self):
         """Simulate BNO08x crash / power loss (no more events)."""
@@ -104,13 +185,19 @@ class ImuEmulator(PicoEmulator):
         self.pitch = float(np.degrees(-np.arcsin(np.clip(R[2, 0], -1, 1))))
         self.roll = float(np.degrees(np.arctan2(R[2, 1], R[2, 2])))
         self.yaw = float(np.degrees(np.arctan2(R[1, 0], R[0, 0])))
+        self._quat = _quat_from_R(R)
+        self._gravity = tuple(float(v) for v in R[2, :] * ig.GRAVITY)
+
+    def _expects_packets(self):
+        # With every SHTP report off, silence is expected (imu_op).
+        return not self.shtp or any(self.rates.values())
 
     def op(self):
         # Mirrors imu_op -> imu_init, including the memset(&imu.data, 0)
         # at imu.c:109 that zeros sensor data on every (re-)init.
         if not self.is_initialized:
             self.is_initialized = True
-            self._last_event_time = time.monotonic()
+            self._last_event_time = self.clock.now()
             self.az_angle = 0.0
             self.el_angle = 0.0
             self.yaw = 0.0
@@ -119,25 +206,99 @@ class ImuEmulator(PicoEmulator):
             self.accel_x = 0.0
             self.accel_y = 0.0
             self.accel_z = 0.0
+            self._reset_reports()
+
+        if not self._expects_packets():
+            self._last_event_time = self.clock.now()
+            return
 
         if self._sensor_failed:
             if (
-                time.monotonic() - self._last_event_time
+                self.clock.now() - self._last_event_time
             ) > IMU_EVENT_TIMEOUT_S:
                 self.is_initialized = False
             return
 
         # Normal operation: sensor produces events
-        self._last_event_time = time.monotonic()
+        self._last_event_time = self.clock.now()
         if not self._hold:
             # idle: gentle mean-reverting drift (matches prior behaviour)
             self.az_angle = 0.99 * self.az_angle + np.random.normal(0, 0.001)
             self.el_angle = 0.99 * self.el_angle + np.random.normal(0, 0.001)
         self._render()
         self.got_packet_this_cycle = True
+        if not self.shtp or self.rates["accel_hz"]:
+            for key in WINDOW_KEYS:
+                if not self.shtp or key.startswith("accel"):
+                    self.window[key].append(getattr(self, key))
+        if self.shtp:
+            now = self.clock.now()
+            rendered = {
+                "quat": self._quat,
+                "accel": (self.accel_x, self.accel_y, self.accel_z),
+                "gravity": self._gravity,
+            }
+            for key, name in RATE_KEYS.items():
+                if self.rates[key]:
+                    self.reports[name] = rendered[name]
+                    self.report_times[name] = now
+
+    def _age_ms(self, name):
+        t = self.report_times[name]
+        return None if t is None else (self.clock.now() - t) * 1000.0
+
+    def _window_status(self, keys):
+        """n_samples and each key's window statistics; clears the
+        window, as imu_status() does after sending."""
+        stats = {"n_samples": len(self.window["accel_x"])}
+        for key in keys:
+            xs = self.window[key]
+            if key in ANGLE_KEYS:
+                stats.update(_angle_stats(key, xs))
+            else:
+                stats.update(_axis_stats(key, xs))
+        self.window = {key: [] for key in WINDOW_KEYS}
+        return stats
+
+    def _shtp_status(self, status):
+        qi, qj, qk, qr = self.reports["quat"]
+        ax, ay, az = self.reports["accel"]
+        gx, gy, gz = self.reports["gravity"]
+        return {
+            "sensor_name": self.name,
+            "status": status,
+            "app_id": self.app_id,
+            "quat_i": qi,
+            "quat_j": qj,
+            "quat_k": qk,
+            "quat_real": qr,
+            "quat_accuracy": 3,
+            "quat_error_rad": QUAT_ERROR_RAD,
+            "accel_x": ax,
+            "accel_y": ay,
+            "accel_z": az,
+            "accel_accuracy": 3,
+            "gravity_x": gx,
+            "gravity_y": gy,
+            "gravity_z": gz,
+            "quat_age_ms": self._age_ms("quat"),
+            "accel_age_ms": self._age_ms("accel"),
+            "gravity_age_ms": self._age_ms("gravity"),
+            "quat_hz": self.rates["quat_hz"],
+            "accel_hz": self.rates["accel_hz"],
+            "gravity_hz": self.rates["gravity_hz"],
+            **self._window_status(("accel_x", "accel_y", "accel_z")),
+            **self._cmd_rx_status(),
+        }
 
     def get_status(self):
         status = "update" if self.got_packet_this_cycle else "error"
+        if self.shtp:
+            self.got_packet_this_cycle = False
+            return self._shtp_status(status)
+        # The stream runs at its own rate, not once per op(): report the
+        # nominal rate while packets arrive.
+        rate = RVC_RATE_HZ if self.got_packet_this_cycle else 0.0
         self.got_packet_this_cycle = False
         return {
             "sensor_name": self.name,
@@ -149,4 +310,9 @@ class ImuEmulator(PicoEmulator):
             "accel_x": self.accel_x,
             "accel_y": self.accel_y,
             "accel_z": self.accel_z,
+            "rx_dropped": self.rx_dropped,
+            "rvc_checksum_fail": self.rvc_checksum_fail,
+            "rvc_rate_hz": rate,
+            **self._window_status(WINDOW_KEYS),
+            **self._cmd_rx_status(),
         }
@@ -73,4 +73,5 @@ class LidarEmulator(PicoEmulator):
             "app_id": self.app_id,
             "distance_m": self.distance,
             "current_voltage": self.current_voltage,
+            **self._cmd_rx_status(),
         }
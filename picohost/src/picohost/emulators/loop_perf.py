@@ -0,0 +1,94 @@
+"""
+Main-loop timing for the emulators, mirroring src/loop_perf.c.
+
+Durations are the emulator's own execution times (host wall clock, in
+microseconds), not emulated ones: the record has the firmware's keys and
+bucketing so host code that reads {"cmd":"perf"} can be tested, but the
+numbers describe Python, not the RP2350.
+"""
+
+import time
+
+PHASES = ("dispatch", "op", "status", "usb_write", "loop")
+
+# Power-of-two histogram, as loop_perf.h: bucket 0 holds 0 us, bucket b
+# holds [2**(b-1), 2**b) us, and the last bucket is open-ended.
+BUCKETS = 24
+STALL_US = 5000
+
+
+def now_us():
+    return time.perf_counter_ns() // 1000
+
+
+def _bucket(us):
+    return min(int(us).bit_length(), BUCKETS - 1)
+
+
+class _PhaseStats:
+    def __init__(self):
+        self.n = 0
+        self.min_us = 0
+        self.max_us = 0
+        self.total_us = 0
+        self.hist = [0] * BUCKETS
+
+    def record(self, us):
+        if self.n == 0 or us < self.min_us:
+            self.min_us = us
+        self.max_us = max(self.max_us, us)
+        self.n += 1
+        self.total_us += us
+        self.hist[_bucket(us)] += 1
+
+    def p99_us(self):
+        """Top of the bucket holding the 99th percentile, capped at max."""
+        want = self.n - self.n // 100
+        seen = 0
+        for b, count in enumerate(self.hist):
+            seen += count
+            if seen >= want:
+                top = 0 if b == 0 else (1 << b) - 1
+                return min(top, self.max_us)
+        return 0
+
+
+class LoopPerf:
+    """Per-phase timing plus the dispatch-cap and USB-stall counters."""
+
+    def __init__(self):
+        self.reset()
+        self.request = None  # None, or the "reset" flag of a pending ask
+
+    def reset(self):
+        self.phases = {name: _PhaseStats() for name in PHASES}
+        self.dispatch_capped = 0
+        self.usb_stalls = 0
+        self.window_start_us = now_us()
+
+    def record(self, phase, start_us):
+        us = now_us() - start_us
+        self.phases[phase].record(us)
+        if phase == "usb_write" and us >= STALL_US:
+            self.usb_stalls += 1
+
+    def report(self, app_id):
+        """The "perf" record loop_perf_report() sends."""
+        window_us = now_us() - self.window_start_us
+        loop_n = self.phases["loop"].n
+        data = {
+            "sensor_name": "perf",
+            "app_id": app_id,
+            "window_s": (window_us // 1000) / 1000.0,
+            "loop_hz": loop_n * 1e6 / window_us if window_us else 0.0,
+            "dispatch_capped": self.dispatch_capped,
+            "usb_stalls": self.usb_stalls,
+        }
+        for name, st in self.phases.items():
+            # Counts go out as floats, as in C (KV_FLOAT: 64-bit counters).
+            data[f"{name}_n"] = float(st.n)
+            data[f"{name}_min_us"] = st.min_us
+            data[f"{name}_mean_us"] = st.total_us // st.n if st.n else 0
+            data[f"{name}_max_us"] = st.max_us
+            data[f"{name}_p99_us"] = st.p99_us()
+        return data
@@ -1,10 +1,13 @@
 import random
 
-from .base import PicoEmulator, _safe_int
+from .base import PicoEmulator, _cmd_int
 
 DEFAULT_DELAY_US = 600
 RAMP_STEPS = 100
 RAMP_START_FACTOR = 4.0
+RAMP_PROFILE_LINEAR = 0
+RAMP_PROFILE_SCURVE = 1
+WAYPOINT_QUEUE_LEN = 32
 
 
 class StepperState:
@@ -22,14 +25,49 @@ class StepperState:
         # carried but unused here.
         self.ramp_steps = RAMP_STEPS
         self.ramp_start_factor = RAMP_START_FACTOR
+        self.ramp_profile = RAMP_PROFILE_LINEAR
+        self.through_steps = 0
+        # Emulator-only time step: the firmware emits pulses from PIO
+        # independent of the main loop, so there is no per-op batch
+        # on hardware. The emulator collapses that into a fixed number of
+        # steps per op() pass to keep tests deterministic and fast.
         self.max_pulses = 60
 
 
+def _is_number(v):
+    """cJSON_IsNumber: JSON numbers only, not booleans."""
+    return isinstance(v, (int, float)) and not isinstance(v, bool)
+
+
+def _parse_waypoint(entry):
+    """One wp_add entry -> (az, el, dwell_ms), or None if malformed."""
+    if not isinstance(entry, list) or len(entry) not in (2, 3):
+        return None
+    if not all(_is_number(v) for v in entry):
+        return None
+    dwell = entry[2] if len(entry) == 3 else 0
+    if dwell < 0:
+        return None
+    return (int(entry[0]), int(entry[1]), int(dwell))
+
+
+def _waypoint_through(start, to, nxt):
+    """Steps past `to` an axis keeps going toward `nxt`; 0 to stop."""
+    d1 = to - start
+    d2 = nxt - to
+    if d1 == 0 or d2 == 0 or (d1 > 0) != (d2 > 0):
+        return 0
+    return abs(d2)
+
+
 def stepper_op(m):
-    """Pure position model of stepper_op() from motor.c.
+    """Pure position model of the step engine in motor.c.
 
-    Moves min(max_pulses, abs(remaining)) steps per call.
-    No timing delays in emulation.
+    On hardware stepper_op() only queues ramped steps and a PIO state
+    machine per axis emits them asynchronously (both axes at once); here
+    the queue and the state machine collapse into moving
+    min(max_pulses, abs(remaining)) steps per call. No timing delays in
+    emulation.
     """
     remaining = m.target_pos - m.position
     abs_steps = abs(remaining)
@@ -61,11 +99,88 @@ class MotorEmulator(PicoEmulator):
     def __init__(self, app_id=0, **kwargs):
         self.azimuth = StepperState()
         self.elevation = StepperState()
+        self._waypoint_reset()
+        self.wp_rejected = 0  # wp_add lists refused since boot
         super().__init__(app_id=app_id, **kwargs)
 
+    def _waypoint_reset(self):
+        # wp_count: waypoints accepted since the last clear (wp_head in C);
+        # wp_started: waypoints started (wp_tail); the active one is
+        # wp_started - 1 while wp_active.
+        self.waypoints = []
+        self.wp_count = 0
+        self.wp_started = 0
+        self.wp_active = False
+        self.wp_blend = False
+        self.wp_dwell_until = None
+
+    def _waypoint_clear(self):
+        """waypoint_clear() in motor.c (no step queue to flush here)."""
+        self._waypoint_reset()
+        self.azimuth.through_steps = 0
+        self.elevation.through_steps = 0
+
+    def _waypoint_add(self, entries):
+        """waypoint_add(): all-or-nothing append; False if rejected."""
+        if not isinstance(entries, list):
+            return False
+        room = WAYPOINT_QUEUE_LEN - (self.wp_count - self.wp_started)
+        if len(entries) > room:
+            return False
+        parsed = [_parse_waypoint(e) for e in entries]
+        if any(p is None for p in parsed):
+            return False
+        self.waypoints.extend(parsed)
+        self.wp_count += len(parsed)
+        return True
+
+    def _waypoint_op(self):
+        """waypoint_op(): advance the queue before stepping.
+
+        The emulator has no step queue, so "planned" and "stopped" both
+        collapse to position == target; through_steps is carried for
+        parity but does not change the position model.
+        """
+        az, el = self.azimuth, self.elevation
+        if self.wp_active:
+            arrived = (
+                az.position == az.target_pos and el.position == el.target_pos
+            )
+            if not arrived:
+                return
+            dwell_ms = self.waypoints[self.wp_started - 1][2]
+            if not self.wp_blend and dwell_ms:
+                if self.wp_dwell_until is None:
+                    self.wp_dwell_until = (
+                        self.clock.now() + dwell_ms / 1000
+                    )
+                if self.clock.now() < self.wp_dwell_until:
+                    return
+            self.wp_active = self.wp_blend = False
+            self.wp_dwell_until = None
+            az.through_steps = el.through_steps = 0
+        if self.wp_started == self.wp_count:
+            return
+        w_az, w_el, dwell_ms = self.waypoints[self.wp_started]
+        self.wp_started += 1
+        self.wp_active = True
+        if dwell_ms == 0 and self.wp_started != self.wp_count:
+            n_az, n_el, _ = self.waypoints[self.wp_started]
+            az_moves = w_az != az.target_pos
+            el_moves = w_el != el.target_pos
+            if az_moves != el_moves:
+                m, to, nxt = (
+                    (az, w_az, n_az) if az_moves else (el, w_el, n_el)
+                )
+                m.through_steps = _waypoint_through(m.target_pos, to, nxt)
+                self.wp_blend = m.through_steps != 0
+        az.target_pos = w_az
+        el.target_pos = w_el
+
     def init(self):
         self.azimuth = StepperState()
         self.elevation = StepperState()
+        self._waypoint_reset()
         # Mirrors motor_init() in motor.c: positions zeroed and a fresh
         # random 30-bit boot id drawn. Re-calling init() on a running
         # emulator therefore models a firmware power cycle.
@@ -75,36 +190,55 @@ class MotorEmulator(PicoEmulator):
         az = self.azimuth
         el = self.elevation
 
+        # Numeric keys take numbers only (_cmd_int, like motor_keys in
+        # motor.c); anything else leaves the setting alone.
         # az_set_pos resets both position and target (matching C behavior)
-        if "az_set_pos" in cmd:
-            az.position = _safe_int(cmd["az_set_pos"], az.position)
-            az.target_pos = az.position
-        if "el_set_pos" in cmd:
-            el.position = _safe_int(cmd["el_set_pos"], el.position)
-            el.target_pos = el.position
+        # set_pos, set_target_pos and halt each take the axes back from the
+        # waypoint queue, as in motor.c
+        for key, m in (("az_set_pos", az), ("el_set_pos", el)):
+            val = _cmd_int(cmd.get(key))
+            if val is not None:
+                self._waypoint_clear()
+                m.position = val
+                m.target_pos = m.position
 
         # target overrides (processed after set_pos, matching C order)
-        if "az_set_target_pos" in cmd:
-            az.target_pos = _safe_int(cmd["az_set_target_pos"], az.target_pos)
-        if "el_set_target_pos" in cmd:
-            el.target_pos = _safe_int(cmd["el_set_target_pos"], el.target_pos)
+        for key, m in (("az_set_target_pos", az), ("el_set_target_pos", el)):
+            val = _cmd_int(cmd.get(key))
+            if val is not None:
+                self._waypoint_clear()
+                m.target_pos = val
 
-        # halt sets target = current position
+        # halt sets target = current position, whatever its value
         if "halt" in cmd:
+            self._waypoint_clear()
             az.target_pos = az.position
             el.target_pos = el.position
 
         # delay settings
-        if "az_up_delay_us" in cmd:
-            az.up_delay_us = _safe_int(cmd["az_up_delay_us"], az.up_delay_us)
-        if "az_dn_delay_us" in cmd:
-            az.dn_delay_us = _safe_int(cmd["az_dn_delay_us"], az.dn_delay_us)
-        if "el_up_delay_us" in cmd:
-            el.up_delay_us = _safe_int(cmd["el_up_delay_us"], el.up_delay_us)
-        if "el_dn_delay_us" in cmd:
-            el.dn_delay_us = _safe_int(cmd["el_dn_delay_us"], el.dn_delay_us)
+        for prefix, m in (("az", az), ("el", el)):
+            for attr in ("up_delay_us", "dn_delay_us"):
+                val = _cmd_int(cmd.get(f"{prefix}_{attr}"))
+                if val is not None:
+                    setattr(m, attr, val)
+
+        # ramp shape: exact 0/1 numbers only (cJSON_IsNumber in C, so
+        # JSON booleans are ignored like any other non-number)
+        for key, m in (("az_ramp_profile", az), ("el_ramp_profile", el)):
+            v = cmd.get(key)
+            if _is_number(v):
+                if v in (RAMP_PROFILE_LINEAR, RAMP_PROFILE_SCURVE):
+                    m.ramp_profile = int(v)
+
+        # waypoints: clear first, so clear + add replaces the program
+        if "wp_clear" in cmd:
+            self._waypoint_clear()
+        if "wp_add" in cmd:
+            if not self._waypoint_add(cmd["wp_add"]):
+                self.wp_rejected += 1
 
     def op(self):
+        self._waypoint_op()
         stepper_op(self.elevation)
         stepper_op(self.azimuth)
 
@@ -118,4 +252,10 @@ class MotorEmulator(PicoEmulator):
             "az_target_pos": self.azimuth.target_pos,
             "el_pos": self.elevation.position,
             "el_target_pos": self.elevation.target_pos,
+            "az_ramp_profile": self.azimuth.ramp_profile,
+            "el_ramp_profile": self.elevation.ramp_profile,
+            "wp_index": self.wp_started - 1 if self.wp_active else -1,
+            "wp_count": self.wp_count,
+            "wp_rejected": self.wp_rejected,
+            **self._cmd_rx_status(),
         }
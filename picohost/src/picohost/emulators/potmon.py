@@ -55,4 +55,5 @@ class PotMonEmulator(PicoEmulator):
             "status": "update",
             "pot_az_voltage": self.voltage_az,
             "sp1_term": self.sp1_term,
+            **self._cmd_rx_status(),
         }
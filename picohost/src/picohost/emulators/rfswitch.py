@@ -1,5 +1,4 @@
 import math
-import time
 
 from .base import PicoEmulator
 
@@ -14,10 +13,13 @@ class RFSwitchEmulator(PicoEmulator):
     input closed, noise diode on) and are rejected, mirroring the
     firmware guard.
 
-    Mirrors the firmware's settle-timer behavior: after a commanded
+    Mirrors the firmware's settle-alarm behavior: after a commanded
     state change, ``sw_state`` is reported as
     :attr:`SW_STATE_UNKNOWN` (-1) until ``settle_ms`` has elapsed, at
-    which point the new commanded state becomes the reported state.
+    which point the new commanded state becomes the reported state and
+    a status line goes out at once, off the cadence. ``settled_s`` and
+    ``settled_us`` give the settle time since the emulator booted, in
+    whole seconds plus microseconds (both -1 while in a transition).
     Boot also starts in a transition so the very first reported state
     is UNKNOWN until settle.
 
@@ -25,6 +27,12 @@ class RFSwitchEmulator(PicoEmulator):
     settle, no boot transition). Tests that do not care about the
     transition path use this to keep behavior as-if settled.
 
+    ``sw_sequence`` / ``sw_repeat`` run the firmware sequencer: steps
+    start on the dwell grid from the command, each reported by its own
+    line, with ``seq_step`` / ``seq_pass`` (-1 when no sequence runs).
+    Time advances between main-loop passes here, so a step lands on the
+    first pass after its slot rather than on the microsecond.
+
     Status also carries volt_therm0/1/2, the raw averaged ADC voltages
     of the three PCB thermistors (conversion to temperature happens
     host-side).
@@ -35,7 +43,12 @@ class RFSwitchEmulator(PicoEmulator):
     NUM_PATHS = 16
     # Mirrors RFSWITCH_NUM_THERM in src/rfswitch.h.
     NUM_THERM = 3
+    # Mirrors SWITCH_SETTLE_US in src/rfswitch.h.
     DEFAULT_SETTLE_MS = 20
+    # Mirror RFSWITCH_SEQ_* in src/rfswitch.h.
+    SEQ_LEN = 16
+    SEQ_MIN_DWELL_US = 40_000  # 2 * SWITCH_SETTLE_US
+    SEQ_MAX_DWELL_MS = 3_600_000
     # 2.5 V over the 5.0 V / 10k-pullup divider inverts to R = 10k = R0,
     # i.e. exactly 25 C at the emulator's default, so tests read a clean
     # midpoint. (Was 1.65, chosen for a 3.3 V midpoint before the 5 V rail
@@ -49,43 +62,141 @@ class RFSwitchEmulator(PicoEmulator):
         super().__init__(app_id=app_id, **kwargs)
 
     def init(self):
+        self._boot = self.clock.now()
         self.volt_therm = [self.DEFAULT_THERM_VOLTS] * self.NUM_THERM
         self.commanded_state = 0
         self.reported_state = 0
+        self._settled_event = False
+        self._seq = []
+        self._seq_repeat = 1
+        self._seq_running = False
+        self._seq_step = -1
+        self._seq_pass = 0
+        self._seq_next = 0.0
         if self.settle_ms > 0:
             self.in_transition = True
-            self._transition_end = time.monotonic() + self.settle_ms / 1000.0
+            self._transition_end = (
+                self.clock.now() + self.settle_ms / 1000.0
+            )
         else:
             self.in_transition = False
-            self._transition_end = time.monotonic()
+            self._transition_end = self.clock.now()
 
-    def server(self, cmd):
-        if "sw_state" not in cmd:
-            return
-        raw = cmd["sw_state"]
+    @classmethod
+    def _path(cls, raw):
+        """rfswitch_path(): a burned path address, or None."""
         # cJSON_IsNumber matches only real JSON numbers; bools parse as
         # cJSON_True/cJSON_False and must be rejected here too.
         if isinstance(raw, bool) or not isinstance(raw, (int, float)):
-            return
+            return None
         if not math.isfinite(raw) or raw != int(raw):
+            return None
+        if raw < 0 or raw >= cls.NUM_PATHS:
+            return None
+        return int(raw)
+
+    def _begin(self, state, at):
+        """rfswitch_begin(): drive ``state`` at ``at``, settle from there."""
+        if state == self.commanded_state and not self.in_transition:
+            self._transition_end = at
+            self._settled_event = True
+            return
+        self.commanded_state = state
+        self._transition_end = at + self.settle_ms / 1000.0
+        self.in_transition = True
+        if self.settle_ms <= 0:
+            self._settle()
+
+    def _settle(self):
+        self.reported_state = self.commanded_state
+        self.in_transition = False
+        self._settled_event = True
+
+    def _seq_advance(self):
+        """rfswitch_seq_advance(): the next step, on the dwell grid."""
+        at = self._seq_next
+        step = self._seq_step + 1
+        if step == len(self._seq):
+            step = 0
+            self._seq_pass += 1
+            if self._seq_repeat and self._seq_pass >= self._seq_repeat:
+                self._seq_running = False
+                self._settled_event = True
+                return
+        self._seq_step = step
+        state, dwell_ms = self._seq[step]
+        self._begin(state, at)
+        self._seq_next = at + dwell_ms / 1000.0
+
+    def _seq_load(self, steps, repeat):
+        """rfswitch_seq_load(): all or nothing; [] stops the sequence."""
+        if not isinstance(steps, list) or len(steps) > self.SEQ_LEN:
             return
-        new_state = int(raw)
-        if new_state < 0 or new_state >= self.NUM_PATHS:
+        if repeat is None:
+            repeat = 1
+        if (
+            isinstance(repeat, bool)
+            or not isinstance(repeat, (int, float))
+            or not math.isfinite(repeat)
+            or repeat < 0
+            or repeat > 0xFFFFFFFF
+            or repeat != int(repeat)
+        ):
+            return
+        seq = []
+        for entry in steps:
+            if not isinstance(entry, list) or len(entry) != 2:
+                return
+            state = self._path(entry[0])
+            dwell = entry[1]
+            if state is None:
+                return
+            if isinstance(dwell, bool) or not isinstance(
+                dwell, (int, float)
+            ):
+                return
+            if not (
+                dwell * 1000.0 >= self.SEQ_MIN_DWELL_US
+                and dwell <= self.SEQ_MAX_DWELL_MS
+            ):
+                return
+            seq.append((state, round(dwell * 1000.0) / 1000.0))
+        self._seq_running = False
+        if seq:
+            self._seq = seq
+            self._seq_repeat = int(repeat)
+            self._seq_step = -1
+            self._seq_pass = 0
+            self._seq_next = self.clock.now()
+            self._seq_running = True
+            self._service()
+
+    def _service(self):
+        """rfswitch_service(): run whatever is due, in time order."""
+        while True:
+            now = self.clock.now()
+            if self.in_transition and now >= self._transition_end:
+                self._settle()
+            if self._seq_running and now >= self._seq_next:
+                self._seq_advance()
+                continue
             return
-        if new_state != self.commanded_state:
-            self.commanded_state = new_state
-            if self.settle_ms > 0:
-                self._transition_end = (
-                    time.monotonic() + self.settle_ms / 1000.0
-                )
-                self.in_transition = True
-            else:
-                self.reported_state = new_state
+
+    def server(self, cmd):
+        new_state = self._path(cmd.get("sw_state"))
+        if new_state is not None:
+            # A manual switch ends any running sequence.
+            self._seq_running = False
+            if new_state != self.commanded_state:
+                self._begin(new_state, self.clock.now())
+        if "sw_sequence" in cmd:
+            self._seq_load(cmd["sw_sequence"], cmd.get("sw_repeat"))
 
     def op(self):
-        if self.in_transition and time.monotonic() >= self._transition_end:
-            self.reported_state = self.commanded_state
-            self.in_transition = False
+        self._service()
+        if self._settled_event:
+            self._settled_event = False
+            self._write_json(self.get_status())
 
     def get_status(self):
         sw_state = (
@@ -93,12 +204,23 @@ class RFSwitchEmulator(PicoEmulator):
             if self.in_transition
             else self.reported_state
         )
+        seq_step = self._seq_step if self._seq_running else -1
+        seq_pass = self._seq_pass if self._seq_running else -1
+        settled_s = settled_us = -1
+        if not self.in_transition:
+            t = round((self._transition_end - self._boot) * 1e6)
+            settled_s, settled_us = divmod(t, 1_000_000)
         return {
             "sensor_name": "rfswitch",
             "status": "update",
             "app_id": self.app_id,
             "sw_state": sw_state,
+            "settled_s": settled_s,
+            "settled_us": settled_us,
+            "seq_step": seq_step,
+            "seq_pass": seq_pass,
             "volt_therm0": float(self.volt_therm[0]),
             "volt_therm1": float(self.volt_therm[1]),
             "volt_therm2": float(self.volt_therm[2]),
+            **self._cmd_rx_status(),
         }
@@ -1,7 +1,6 @@
 import math
-import time
 
-from .base import PicoEmulator, _safe_int
+from .base import PicoEmulator, _cmd_number, _safe_int
 
 
 # Mirror the firmware's fixed sampling cadence: sampling, the rate guard,
@@ -16,7 +15,7 @@ DT_PER_SAMPLE_S = 0.2
 # what determines convergence speed.
 THERMAL_DRIFT_PER_OP = 0.05
 
-# Thermistor divider constants, mirroring temp_simple.h.
+# Thermistor divider constants, mirroring thermistor.h.
 THERMISTOR_SUPPLY_VOLTS = 3.3
 THERMISTOR_FIXED_OHMS = 10680.0
 THERMISTOR_BOARD_PULLUP_OHMS = 4700.0
@@ -28,8 +27,9 @@ THERMISTOR_TOP_OHMS = (
 # Vishay NTCLE100E3103 NTC, 10 kOhm at 25 C, B25/85 = 3977 K (datasheet
 # document 29049, "Mat A" coefficient row). The firmware converts
 # resistance -> temperature with the datasheet's extended Steinhart-Hart
-# fit (A1..D1, mirroring temp_simple.h); the emulator generates
-# resistance from temperature with the paired forward fit
+# fit (A1..D1, mirroring thermistor.h; on the pico through a table built
+# from it, within 0.07 C); the emulator generates resistance from
+# temperature with the paired forward fit
 #   R(T) = Rref * exp(A + B/T + C/T^2 + D/T^3),  T in kelvin.
 # Vishay states the two fits are interchangeable within 0.015 C over
 # the part's -40..+125 C range, so emulator-generated resistances decode
@@ -43,6 +43,23 @@ THERMISTOR_RT_A = -14.6337
 THERMISTOR_RT_B = 4791.842
 THERMISTOR_RT_C = -115334.0
 THERMISTOR_RT_D = -3.730535e6
+THERMISTOR_MIN_C = -40.0
+THERMISTOR_MAX_C = 125.0
+
+# Thermistor decimation filter, mirroring tempctrl.h / adc_sampler.h. The
+# emulator's readings are noiseless, so the filter is configuration only:
+# parsed, validated and reported like the firmware's.
+ADC_SAMPLER_BLOCK = 64
+ADC_SAMPLER_MAX_BLOCKS = 16
+TEMPCTRL_ADC_OVERSAMPLE = 1024
+TEMPCTRL_ADC_MEDIAN = True
+
+# Command ranges, mirroring tempctrl.h / tempctrl_keys in tempctrl.c: a
+# value outside one is clamped to it.
+FLT_MAX = 3.4028234663852886e38
+TEMPCTRL_TARGET_MIN_C = THERMISTOR_MIN_C
+TEMPCTRL_TARGET_MAX_C = THERMISTOR_MAX_C
+TEMPCTRL_HYSTERESIS_MAX_C = THERMISTOR_MAX_C - THERMISTOR_MIN_C
 
 
 def _thermistor_resistance(temp_c):
@@ -82,21 +99,6 @@ def _set_thermistor_diagnostics(tc, temp_c):
     tc.voltage = _thermistor_voltage(tc.resistance)
 
 
-def _coerce_float(val):
-    """Mirror cJSON ``valuedouble``: non-numeric JSON yields 0.0.
-
-    Unlike ``_safe_float`` (which preserves a caller-supplied default on
-    bad input), the firmware assigns ``item_json->valuedouble`` directly
-    — which cJSON sets to 0.0 for strings/null/arrays/objects.
-    """
-    if isinstance(val, (str, bytes, list, dict)):
-        return 0.0
-    try:
-        return float(val)
-    except (ValueError, TypeError):
-        return 0.0
-
-
 class TempControlState:
     """Models the TempControl struct from tempctrl.h."""
 
@@ -123,9 +125,10 @@ class TempControlState:
         # Module physically present (host config knob, mirrors `installed`
         # in tempctrl.h). Distinct from `enabled` (drive intent) and
         # `cooling_enabled` (drive-polarity guard): an uninstalled channel
-        # is never sampled — its ADC input is never mux-selected — and
-        # never driven. Default true so a rebooted pico behaves exactly
-        # as before the flag existed until the host replays config.
+        # is never sampled — its ADC input leaves the sampler's round
+        # robin — and never driven. Default true so a rebooted pico
+        # behaves exactly as before the flag existed until the host
+        # replays config.
         self.installed = True
         # Per-cycle data validity (NOT a latch, mirrors data_invalid in
         # tempctrl.h): True when the most recent sample cycle produced no
@@ -140,6 +143,9 @@ class TempControlState:
         # original symmetric drive range; False forbids drive<0 so the
         # PI loop saturates at [0, +clamp] instead of [-clamp, +clamp].
         self.cooling_enabled = True
+        # ADC decimation filter (*_adc_oversample / *_adc_median).
+        self.adc_oversample = TEMPCTRL_ADC_OVERSAMPLE
+        self.adc_median = TEMPCTRL_ADC_MEDIAN
         self.timestamp = 0.0
         # Stall guard mirror (see tempctrl_check_stall in tempctrl.c).
         # stall_tripped = drive did nothing for a full window;
@@ -273,12 +279,6 @@ class TempCtrlEmulator(PicoEmulator):
         self.load = TempControlState()
         self.watchdog_timeout_ms = 30000
         self.watchdog_tripped = False
-        self._last_cmd_time = time.time()
-        # Boot reference for the *_timestamp field. Firmware sends
-        # temp_sensor_get_sample_time() — uint32_t ms since boot, cast
-        # to double in the KV_FLOAT slot. monotonic() so the value cannot
-        # jump under NTP adjustments.
-        self._boot_monotonic = time.monotonic()
         super().__init__(app_id=app_id, **kwargs)
 
     def init(self):
@@ -286,25 +286,32 @@ class TempCtrlEmulator(PicoEmulator):
         self.load = TempControlState()
         self.watchdog_timeout_ms = 30000
         self.watchdog_tripped = False
-        self._last_cmd_time = time.time()
-        self._boot_monotonic = time.monotonic()
+        self._last_cmd_time = self.clock.now()
+        # Boot reference for the *_timestamp field. Firmware sends
+        # temp_sensor_get_sample_time() — uint32_t ms since boot, cast
+        # to double in the KV_FLOAT slot. The clock is monotonic, so the
+        # value cannot jump under NTP adjustments.
+        self._boot_time = self.clock.now()
 
     def _ms_since_boot(self):
-        return float(int((time.monotonic() - self._boot_monotonic) * 1000))
+        return float(int((self.clock.now() - self._boot_time) * 1000))
 
     def server(self, cmd):
         # Any valid command refreshes the watchdog timer, but the trip flag
         # is sticky: the host clears it by explicitly sending *_enable=true
         # (see firmware tempctrl_apply_enable).
-        self._last_cmd_time = time.time()
+        self._last_cmd_time = self.clock.now()
 
         for prefix, tc in [("LNA", self.lna), ("LOAD", self.load)]:
-            # Numeric fields use _coerce_float (not _safe_float): cJSON
-            # writes valuedouble=0.0 for non-numeric JSON, and firmware
-            # assigns that directly into the struct.
-            key = f"{prefix}_temp_target"
-            if key in cmd:
-                tc.T_target = _coerce_float(cmd[key])
+            # Numeric fields take numbers only, clamped to their range
+            # (_cmd_number); anything else leaves the setting alone.
+            val = _cmd_number(
+                cmd.get(f"{prefix}_temp_target"),
+                TEMPCTRL_TARGET_MIN_C,
+                TEMPCTRL_TARGET_MAX_C,
+            )
+            if val is not None:
+                tc.T_target = val
 
             key = f"{prefix}_installed"
             if key in cmd:
@@ -335,21 +342,22 @@ class TempCtrlEmulator(PicoEmulator):
                     self.watchdog_tripped = False
                 tc.enabled = new_enabled
 
-            key = f"{prefix}_hysteresis"
-            if key in cmd:
-                tc.hysteresis = _coerce_float(cmd[key])
+            val = _cmd_number(
+                cmd.get(f"{prefix}_hysteresis"), 0.0, TEMPCTRL_HYSTERESIS_MAX_C
+            )
+            if val is not None:
+                tc.hysteresis = val
 
-            key = f"{prefix}_clamp"
-            if key in cmd:
-                tc.clamp = min(1.0, max(0.0, _coerce_float(cmd[key])))
+            val = _cmd_number(cmd.get(f"{prefix}_clamp"), 0.0, 1.0)
+            if val is not None:
+                tc.clamp = val
 
-            key = f"{prefix}_Kp"
-            if key in cmd:
-                tc.Kp = _coerce_float(cmd[key])
+            val = _cmd_number(cmd.get(f"{prefix}_Kp"), 0.0, FLT_MAX)
+            if val is not None:
+                tc.Kp = val
 
-            key = f"{prefix}_Ki"
-            if key in cmd:
-                new_ki = _coerce_float(cmd[key])
+            new_ki = _cmd_number(cmd.get(f"{prefix}_Ki"), 0.0, FLT_MAX)
+            if new_ki is not None:
                 if new_ki != tc.Ki:
                     # Bumpless retune: drop the accumulator so the next PI
                     # step does not multiply a stale integral by a freshly
@@ -370,12 +378,30 @@ class TempCtrlEmulator(PicoEmulator):
                 # non-numeric JSON, so a string like "false" disables.
                 tc.cooling_enabled = bool(_safe_int(cmd[key], 0))
 
-        if "watchdog_timeout_ms" in cmd:
-            val = _safe_int(
-                cmd["watchdog_timeout_ms"], self.watchdog_timeout_ms
-            )
-            # Firmware clamps negatives to 0 (see tempctrl.c watchdog parse).
-            self.watchdog_timeout_ms = 0 if val < 0 else val
+            key = f"{prefix}_adc_oversample"
+            val = cmd.get(key)
+            # Firmware takes numbers only (cJSON_IsNumber; JSON true is
+            # not one), truncates like valueint, and ignores a value the
+            # sampler cannot do: not a multiple of 64 in 64..1024.
+            if isinstance(val, (int, float)) and not isinstance(val, bool):
+                if math.isfinite(val):
+                    n = int(val)
+                    if (
+                        ADC_SAMPLER_BLOCK
+                        <= n
+                        <= ADC_SAMPLER_MAX_BLOCKS * ADC_SAMPLER_BLOCK
+                        and n % ADC_SAMPLER_BLOCK == 0
+                    ):
+                        tc.adc_oversample = n
+
+            key = f"{prefix}_adc_median"
+            if key in cmd:
+                tc.adc_median = bool(_safe_int(cmd[key], 0))
+
+        # A number, truncated like valueint; negatives clamp to 0.
+        val = _cmd_number(cmd.get("watchdog_timeout_ms"), 0.0, 2**31 - 1)
+        if val is not None:
+            self.watchdog_timeout_ms = int(val)
 
     def inject_sensor_error(self, channel, error=True):
         """Simulate a plausibility failure on channel "LNA" or "LOAD".
@@ -468,11 +494,12 @@ class TempCtrlEmulator(PicoEmulator):
         return True, False
 
     def _update_channel(self, tc):
-        # Channel hardware not present: return before the sensor read so
-        # the ADC input is never mux-selected (the potmon crosstalk
-        # lesson — a dead divider must not share the mux with a live
-        # one) and force drive off. data_invalid every cycle; the rate
-        # anchor drops so a later re-install re-seeds two-to-anchor.
+        # Channel hardware not present: its ADC input is out of the
+        # sampler's round robin (the potmon crosstalk lesson — a dead
+        # divider must not share the mux with a live one), so return
+        # before the sensor read and force drive off. data_invalid every
+        # cycle; the rate anchor drops so a later re-install re-seeds
+        # two-to-anchor.
         # Mirrors the !installed early return in
         # tempctrl_update_sensor_drive (tempctrl.c).
         if not tc.installed:
@@ -550,7 +577,7 @@ class TempCtrlEmulator(PicoEmulator):
             tc.stall_window_active = False
             tc.runaway_strikes = 0
             return
-        now = time.time()
+        now = self.clock.now()
         if not tc.stall_window_active:
             tc.stall_check_T = tc.T_now
             tc.stall_check_drive = tc.drive
@@ -595,7 +622,7 @@ class TempCtrlEmulator(PicoEmulator):
         # arrived within the timeout. `enabled` is host intent and stays
         # untouched; the trip flag is the runtime gate.
         if self.watchdog_timeout_ms > 0 and not self.watchdog_tripped:
-            elapsed_ms = (time.time() - self._last_cmd_time) * 1000
+            elapsed_ms = (self.clock.now() - self._last_cmd_time) * 1000
             if elapsed_ms > self.watchdog_timeout_ms:
                 self.watchdog_tripped = True
 
@@ -644,6 +671,8 @@ class TempCtrlEmulator(PicoEmulator):
             "LNA_Kp": self.lna.Kp,
             "LNA_Ki": self.lna.Ki,
             "LNA_integral": self.lna.integral,
+            "LNA_adc_oversample": self.lna.adc_oversample,
+            "LNA_adc_median": self.lna.adc_median,
             "LOAD_status": load_status,
             "LOAD_T_now": (
                 None if self.load.data_invalid else self.load.temperature
@@ -668,4 +697,7 @@ class TempCtrlEmulator(PicoEmulator):
             "LOAD_Kp": self.load.Kp,
             "LOAD_Ki": self.load.Ki,
             "LOAD_integral": self.load.integral,
+            "LOAD_adc_oversample": self.load.adc_oversample,
+            "LOAD_adc_median": self.load.adc_median,
+            **self._cmd_rx_status(),
         }
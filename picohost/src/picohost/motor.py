@@ -3,10 +3,11 @@ Base class for Pico device communication.
 Provides common functionality for serial communication with Pico devices.
 """
 
+import json
 import logging
 import time
 import numpy as np
-from .base import PicoDevice
+from .base import MAX_COMMAND_LEN, PicoDevice
 
 logger = logging.getLogger(__name__)
 
@@ -20,6 +21,13 @@ STEP_ANGLE_DEG = 1.8
 GEAR_TEETH = 113
 MICROSTEP = 1
 
+#: Ramp shapes accepted by ``az_ramp_profile`` / ``el_ramp_profile``
+#: (RAMP_PROFILE_* in src/motor_ramp.h).
+RAMP_PROFILES = {"linear": 0, "scurve": 1}
+
+#: Firmware waypoint queue depth (WAYPOINT_QUEUE_LEN in src/motor.h).
+WAYPOINT_QUEUE_LEN = 32
+
 
 def steps_to_deg(steps, *, step_angle_deg, gear_teeth, microstep):
     """Convert motor pulses to degrees (pure; no device state).
@@ -65,8 +73,13 @@ class PicoMotor(PicoDevice):
             "az_dn_delay_us": int,
             "el_up_delay_us": int,
             "el_dn_delay_us": int,
+            "az_ramp_profile": int,
+            "el_ramp_profile": int,
+            "wp_add": list,
+            "wp_clear": int,
         }
         self._delay_kwargs = None
+        self._ramp_profile_kwargs = None
         # Position checkpoint / boot-detection state. Touched only by
         # _checkpoint_and_seed, which runs on the reader thread; set up
         # before super().__init__ because the reader may start in there.
@@ -228,9 +241,11 @@ class PicoMotor(PicoDevice):
         self._seen_boot_id = boot_id
 
     def on_reconnect(self):
-        """Re-apply delay configuration after a serial reconnect."""
+        """Re-apply delay and ramp configuration after a serial reconnect."""
         if self._delay_kwargs is not None:
             self.set_delay(**self._delay_kwargs)
+        if self._ramp_profile_kwargs is not None:
+            self.set_ramp_profile(**self._ramp_profile_kwargs)
 
     def deg_to_steps(self, degrees: float) -> int:
         """Convert degrees to motor pulses."""
@@ -286,10 +301,135 @@ class PicoMotor(PicoDevice):
         }
         self.motor_command(**self._delay_kwargs)
 
+    def set_ramp_profile(self, az=None, el=None):
+        """Select the accel/decel ramp shape per axis.
+
+        ``"linear"`` is the constant-acceleration ramp (firmware
+        default); ``"scurve"`` is jerk-limited, easing acceleration in
+        and out so the driver holds position at shorter step delays.
+        ``None`` leaves an axis unchanged. The choice is replayed on
+        reconnect like :meth:`set_delay`.
+        """
+        cmd = {}
+        for axis, profile in (("az", az), ("el", el)):
+            if profile is None:
+                continue
+            if profile not in RAMP_PROFILES:
+                raise ValueError(
+                    f"ramp profile {profile!r} not in "
+                    f"{sorted(RAMP_PROFILES)}"
+                )
+            cmd[f"{axis}_ramp_profile"] = RAMP_PROFILES[profile]
+        if not cmd:
+            return
+        kwargs = dict(self._ramp_profile_kwargs or {})
+        kwargs.update(
+            {k: v for k, v in (("az", az), ("el", el)) if v is not None}
+        )
+        self._ramp_profile_kwargs = kwargs
+        self.motor_command(**cmd)
+
     def halt(self):
         """Hard stop on both motors."""
         self.motor_command(halt=0)
 
+    def _waypoint_chunk(self, waypoints, room):
+        """Longest prefix of ``waypoints`` that fits in ``room`` queue
+        slots and one firmware command line."""
+        chunk = []
+        for w in waypoints[:room]:
+            line = json.dumps({"wp_add": chunk + [w]}, separators=(",", ":"))
+            if len(line) > MAX_COMMAND_LEN:
+                break
+            chunk.append(w)
+        return chunk
+
+    def run_waypoints(self, waypoints, stall_timeout=30, poll_s=0.1):
+        """Execute a list of step-space waypoints on the firmware.
+
+        The firmware queues waypoints and moves between them without a
+        host round trip per point, running straight through collinear
+        single-axis points at cruise speed. This replaces any program
+        already queued, streams the list in line-sized chunks as the
+        firmware queue drains, and returns once the last waypoint
+        (including its dwell) has finished.
+
+        Parameters
+        ----------
+        waypoints : iterable
+            ``(az_steps, el_steps)`` or ``(az_steps, el_steps, dwell_ms)``.
+        stall_timeout : float
+            Seconds without progress (position or waypoint index) before
+            raising TimeoutError; the active waypoint's dwell is added on
+            top.
+        poll_s : float
+            Status polling interval.
+
+        Raises
+        ------
+        RuntimeError
+            If the firmware refuses a chunk (its ``wp_rejected`` count
+            rises), e.g. for a full queue.
+        """
+        wps = []
+        for w in waypoints:
+            if len(w) not in (2, 3) or (len(w) == 3 and w[2] < 0):
+                raise ValueError(f"waypoint {w!r} is not (az, el[, dwell])")
+            wps.append([int(v) for v in w])
+        self._require_status()
+        # Start from an empty queue so wp_count counts only this list.
+        self.motor_command(wp_clear=0)
+        self._wait_status(
+            lambda st: st.get("wp_count") == 0 and st.get("wp_index") == -1,
+            stall_timeout,
+            poll_s,
+        )
+        rejected = self.last_status.get("wp_rejected", 0)
+        sent = 0
+        last = None
+        t = time.time()
+        while True:
+            st = self.last_status
+            if st.get("wp_rejected", rejected) != rejected:
+                raise RuntimeError(
+                    f"{self.name}: firmware rejected a wp_add chunk "
+                    f"after {sent} waypoints sent"
+                )
+            index = st.get("wp_index", -1)
+            # wp_count lags a sent chunk until the next status packet;
+            # only trust the queue state once the firmware has caught up.
+            if st.get("wp_count") == sent:
+                if index == -1 and sent == len(wps):
+                    return
+                started = index + 1 if index >= 0 else sent
+                room = WAYPOINT_QUEUE_LEN - (sent - started)
+                chunk = self._waypoint_chunk(wps[sent:], room)
+                if chunk:
+                    self.motor_command(wp_add=chunk)
+                    sent += len(chunk)
+            progress = (st.get("az_pos"), st.get("el_pos"), index)
+            dwell_s = 0
+            if 0 <= index < len(wps) and len(wps[index]) == 3:
+                dwell_s = wps[index][2] / 1000
+            if progress != last:
+                last = progress
+                t = time.time()
+            elif time.time() - t >= stall_timeout + dwell_s:
+                raise TimeoutError(
+                    f"Waypoints stalled for {stall_timeout}s without progress"
+                )
+            time.sleep(poll_s)
+
+    def _wait_status(self, predicate, timeout, poll_s):
+        """Poll ``last_status`` until ``predicate`` holds."""
+        t = time.time()
+        while not predicate(self.last_status):
+            if time.time() - t >= timeout:
+                raise TimeoutError(
+                    f"{self.name}: status condition not met in {timeout}s"
+                )
+            time.sleep(poll_s)
+
     def _do_wait(self, wait_for_start, wait_for_stop):
         if wait_for_start:
             self.wait_for_start()
@@ -434,40 +574,43 @@ class PicoMotor(PicoDevice):
         # home before scanning
         self.az_target_steps(0, wait_for_stop=True)
         self.el_target_steps(0, wait_for_stop=True)
-        # set order of scanning
+        # set order of scanning: axis 1 steps between sweeps of axis 2
         if el_first:
-            mv_axis1, mv_axis2 = self.az_target_deg, self.el_target_deg
             axis1_rng, axis2_rng = az_range_deg.copy(), el_range_deg.copy()
         else:
-            mv_axis2, mv_axis1 = self.az_target_deg, self.el_target_deg
             axis2_rng, axis1_rng = az_range_deg.copy(), el_range_deg.copy()
+        dwell = () if pause_s is None else (int(pause_s * 1000),)
+
+        def point(val1, val2):
+            az, el = (val1, val2) if el_first else (val2, val1)
+            return (self.deg_to_steps(az), self.deg_to_steps(el)) + dwell
 
+        # Each pass runs as one firmware waypoint program, so the motors
+        # move point to point without a host round trip in between.
+        val2 = 0.0  # homed above
         i = 0
         try:
             while True:
                 if repeat_count is not None and i >= repeat_count:
                     break
+                waypoints = []
                 for val1 in axis1_rng:
-                    if self.verbose:
-                        logger.info("MOVE AXIS 1 TO %s", val1)
-                    mv_axis1(val1, wait_for_stop=True)
+                    waypoints.append(point(val1, val2)[:2])
                     if pause_s is None:
-                        if self.verbose:
-                            logger.info(
-                                "MOVE AXIS 2 FROM %s TO %s",
-                                axis2_rng[0],
-                                axis2_rng[-1],
-                            )
                         # continuous motion
-                        mv_axis2(axis2_rng[0], wait_for_stop=True)
-                        mv_axis2(axis2_rng[-1], wait_for_stop=True)
+                        sweep = (axis2_rng[0], axis2_rng[-1])
                     else:
                         # pause at each position
-                        for val2 in axis2_rng:
-                            mv_axis2(val2, wait_for_stop=True)
-                            time.sleep(pause_s)
+                        sweep = axis2_rng
+                    waypoints.extend(point(val1, v) for v in sweep)
+                    val2 = axis2_rng[-1]
                     axis2_rng = axis2_rng[::-1]  # reverse direction each time
                 axis1_rng = axis1_rng[::-1]  # reverse direction each time
+                if self.verbose:
+                    logger.info(
+                        "SCAN PASS %d: %d waypoints", i, len(waypoints)
+                    )
+                self.run_waypoints(waypoints)
                 i += 1
                 if sleep_between is not None:
                     if self.verbose:
@@ -23,11 +23,18 @@ class DummyPicoDevice(PicoDevice):
     EMULATOR_CLASS = None
     EMULATOR_CADENCE_MS = 200.0
 
+    def __init__(self, *args, emulator_clock=None, **kwargs):
+        # Clock for the emulator (emulators/clock.py), e.g. RealClock(20)
+        # to run its settle and watchdog timers 20x faster. None: real time.
+        self.emulator_clock = emulator_clock
+        super().__init__(*args, **kwargs)
+
     def _make_emulator(self):
         if self.EMULATOR_CLASS is None:
             return None
         return self.EMULATOR_CLASS(
             status_cadence_ms=self.EMULATOR_CADENCE_MS,
+            clock=self.emulator_clock,
         )
 
     def connect(self):
@@ -69,14 +76,15 @@ class DummyPicoMotor(DummyPicoDevice, PicoMotor):
 class DummyPicoRFSwitch(DummyPicoDevice, PicoRFSwitch):
     EMULATOR_CLASS = RFSwitchEmulator
     EMULATOR_CADENCE_MS = 50.0
-    # Firmware default is 200 ms; tests use a short settle so integration
-    # tests do not spend seconds waiting for the emulator to "settle."
-    EMULATOR_SETTLE_MS = 20
+    # The firmware's settle (SWITCH_SETTLE_US); a subclass can lengthen
+    # it to watch the UNKNOWN window.
+    EMULATOR_SETTLE_MS = RFSwitchEmulator.DEFAULT_SETTLE_MS
 
     def _make_emulator(self):
         return RFSwitchEmulator(
             status_cadence_ms=self.EMULATOR_CADENCE_MS,
             settle_ms=self.EMULATOR_SETTLE_MS,
+            clock=self.emulator_clock,
         )
 
 
@@ -88,6 +96,15 @@ class DummyPicoPeltier(DummyPicoDevice, PicoPeltier):
 class DummyPicoIMU(DummyPicoDevice, PicoIMU):
     EMULATOR_CLASS = ImuEmulator
     EMULATOR_CADENCE_MS = 50.0
+    # True: a BNO08x wired for SH-2 on I2C instead of UART-RVC.
+    EMULATOR_SHTP = False
+
+    def _make_emulator(self):
+        return ImuEmulator(
+            status_cadence_ms=self.EMULATOR_CADENCE_MS,
+            shtp=self.EMULATOR_SHTP,
+            clock=self.emulator_clock,
+        )
 
 
 class DummyPicoLidar(DummyPicoDevice, PicoLidar):
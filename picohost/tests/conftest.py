@@ -1,10 +1,38 @@
 """Shared test helpers for picohost test suite."""
 
+import json
 import time
 
 _SENTINEL = object()
 
 
+class NullPeer:
+    """Emulator peer with nothing to read: lets _read_commands() run the
+    lines already in the emulator's _cmd_buffer. Writes are dropped."""
+
+    in_waiting = 0
+
+    def write(self, data):
+        pass
+
+
+class LinePeer(NullPeer):
+    """NullPeer that keeps what the emulator writes, as status lines."""
+
+    def __init__(self):
+        self.data = b""
+
+    def write(self, data):
+        self.data += data
+
+    def lines(self):
+        return self.data.decode().splitlines()
+
+    def records(self):
+        """The lines written so far, parsed as JSON."""
+        return [json.loads(line) for line in self.lines()]
+
+
 def wait_for_settle(
     getter,
     *,
@@ -121,6 +121,33 @@ class TestPicoDevice:
         finally:
             device.disconnect()
 
+    def test_set_cadence_sends_universal_command(self):
+        device = DummyPicoDevice("/dev/dummy")
+        try:
+            device.set_cadence(25)
+            sent = device.ser.peer._read_buffer.decode().splitlines()
+            assert json.loads(sent[-1]) == {
+                "status_format": "json",
+                "cadence_ms": 25,
+            }
+            with pytest.raises(ValueError):
+                device.set_cadence(0)
+        finally:
+            device.disconnect()
+
+    def test_attempt_reopen_replays_cadence(self):
+        """A rebooted board is back at STATUS_CADENCE_MS; re-send ours."""
+        device = DummyPicoDevice("/dev/dummy")
+        try:
+            device.set_cadence(40)
+            before = len(device.ser.peer._read_buffer)
+            device._open_serial = lambda: True  # type: ignore[method-assign]
+            assert device._attempt_reopen() is True
+            sent = bytes(device.ser.peer._read_buffer[before:]).decode()
+            assert json.loads(sent)["cadence_ms"] == 40
+        finally:
+            device.disconnect()
+
     def test_redis_handler_is_bound_before_connect(self):
         """__init__ binds redis_handler before connect() is invoked."""
 
@@ -231,6 +258,42 @@ class TestPicoRFSwitch:
             switch.switch("INVALID")
         switch.disconnect()
 
+    def test_run_sequence_sends_addresses(self):
+        """run_sequence() maps path names to addresses on the wire."""
+        switch = DummyPicoRFSwitch("/dev/dummy")
+        try:
+            sent = []
+            switch.send_command = sent.append
+            switch.run_sequence([("RFANT", 50), ("RFNON", 42.5)], repeat=3)
+            switch.stop_sequence()
+            assert sent == [
+                {"sw_sequence": [[0x00, 50], [0x0B, 42.5]], "sw_repeat": 3},
+                {"sw_sequence": []},
+            ]
+        finally:
+            switch.disconnect()
+
+    @pytest.mark.parametrize(
+        "steps, repeat",
+        [
+            ([], 1),
+            ([("RFANT", 50)] * 17, 1),
+            ([("NOPE", 50)], 1),
+            ([("RFANT", 30)], 1),
+            ([("RFANT", 3_600_001)], 1),
+            ([("RFANT", 50)], -1),
+            ([("RFANT", 50)], 1.5),
+            ([("RFANT", 3_599_999.123456)] * 16, 1),  # too long a line
+        ],
+    )
+    def test_run_sequence_rejects(self, steps, repeat):
+        switch = DummyPicoRFSwitch("/dev/dummy")
+        try:
+            with pytest.raises(ValueError):
+                switch.run_sequence(steps, repeat=repeat)
+        finally:
+            switch.disconnect()
+
     def test_paths_dict_values(self):
         """paths property maps names to the burned EEPROM addresses."""
         switch = DummyPicoRFSwitch("/dev/dummy")
@@ -824,6 +887,7 @@ class TestPicoPeltierReconnectReplay:
         try:
             assert peltier._last_watchdog_timeout_ms is None
             assert peltier._last_installed == {}
+            assert peltier._last_adc_filter == {}
             assert peltier._last_clamp == {}
             assert peltier._last_cooling == {}
             assert peltier._last_gains == {}
@@ -898,17 +962,18 @@ class TestPicoPeltierReconnectReplay:
             peltier.disconnect()
 
     def test_on_reconnect_replays_in_safe_order(self):
-        """watchdog → installed → clamp → cooling_enabled → gains →
-        temperature → enable.
+        """watchdog → installed → adc_filter → clamp → cooling_enabled →
+        gains → temperature → enable.
 
         installed lands right after the watchdog so an uninstalled
         channel is gated (no sampling, no drive) before any
         drive-producing config arrives — firmware reboots to
-        installed=true defaults. cooling_enabled lands between clamp
-        and gains so the asymmetric-clamp safety setting is in place
-        before any drive can result from the next setpoint. Gains land
-        before temperature so the channel is fully tuned the instant it
-        goes active. Disables keepalive so the spy only sees replay
+        installed=true defaults. The ADC filter follows so control runs
+        on filtered samples from the first one. cooling_enabled lands
+        between clamp and gains so the asymmetric-clamp safety setting
+        is in place before any drive can result from the next setpoint.
+        Gains land before temperature so the channel is fully tuned the
+        instant it goes active. Disables keepalive so the spy only sees replay
         traffic — the background ``{}`` keepalive is tested
         independently.
         """
@@ -916,6 +981,7 @@ class TestPicoPeltierReconnectReplay:
         try:
             peltier.set_watchdog_timeout(15000)
             peltier.set_installed(LNA=False, LOAD=True)
+            peltier.set_adc_filter(LOAD_oversample=256, LOAD_median=False)
             peltier.set_clamp(LNA=0.5, LOAD=0.6)
             peltier.set_cooling_enabled(LNA=False, LOAD=True)
             peltier.set_gains(LNA_Kp=0.25, LNA_Ki=0.01)
@@ -937,6 +1003,7 @@ class TestPicoPeltierReconnectReplay:
             assert sent == [
                 {"watchdog_timeout_ms": 15000},
                 {"LNA_installed": False, "LOAD_installed": True},
+                {"LOAD_adc_oversample": 256, "LOAD_adc_median": False},
                 {"LNA_clamp": 0.5, "LOAD_clamp": 0.6},
                 {
                     "LNA_cooling_enabled": False,
@@ -954,6 +1021,42 @@ class TestPicoPeltierReconnectReplay:
         finally:
             peltier.disconnect()
 
+    def test_set_adc_filter_round_trip(self):
+        """The filter reaches the emulator's status and merges per
+        channel into the replay cache."""
+        peltier = DummyPicoPeltier("/dev/dummy")
+        cadence = peltier.EMULATOR_CADENCE_MS
+        try:
+            peltier.set_adc_filter(LNA_oversample=128)
+            peltier.set_adc_filter(LOAD_median=False)
+            wait_for_condition(
+                lambda: peltier.last_status.get("LNA_adc_oversample") == 128
+                and peltier.last_status.get("LOAD_adc_median") is False,
+                cadence_ms=cadence,
+            )
+            assert peltier.last_status["LNA_adc_median"] is True
+            assert peltier.last_status["LOAD_adc_oversample"] == 1024
+            assert peltier._last_adc_filter == {
+                "LNA_adc_oversample": 128,
+                "LOAD_adc_median": False,
+            }
+        finally:
+            peltier.disconnect()
+
+    def test_set_adc_filter_validates(self):
+        """Oversample the sampler cannot do raises before anything is
+        sent or cached; median must be a bool."""
+        peltier = DummyPicoPeltier("/dev/dummy", keepalive_interval=0)
+        try:
+            for bad in (0, 100, 2048, 256.0, True):
+                with pytest.raises(ValueError):
+                    peltier.set_adc_filter(LNA_oversample=bad)
+            with pytest.raises(TypeError):
+                peltier.set_adc_filter(LOAD_median=1)
+            assert peltier._last_adc_filter == {}
+        finally:
+            peltier.disconnect()
+
     def test_set_cooling_enabled_partial_no_command(self):
         """``set_cooling_enabled()`` with both args None must not touch
         the wire or the replay cache — matches the shape shared by
@@ -1098,6 +1201,8 @@ class TestPicoPeltierRedisHandler:
         "LNA_Kp": 0.2,
         "LNA_Ki": 0.01,
         "LNA_integral": 1.25,
+        "LNA_adc_oversample": 1024,
+        "LNA_adc_median": True,
         # LOAD models an invalid-data cycle (railed divider): status error,
         # null T_now/resistance, voltage live at the rail for open-vs-short
         # diagnosis. Trip flags stay False — data validity is not a latch.
@@ -1120,6 +1225,8 @@ class TestPicoPeltierRedisHandler:
         "LOAD_Kp": 0.25,
         "LOAD_Ki": 0.0,
         "LOAD_integral": 0.0,
+        "LOAD_adc_oversample": 256,
+        "LOAD_adc_median": False,
     }
 
     _EXPECTED_KEYS = {
@@ -1146,6 +1253,8 @@ class TestPicoPeltierRedisHandler:
         "Kp",
         "Ki",
         "integral",
+        "adc_oversample",
+        "adc_median",
     }
 
     def _capture_all(self, peltier, data):
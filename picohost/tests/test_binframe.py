@@ -0,0 +1,124 @@
+"""
+Tests for the binary status framing (picohost.binframe) and the
+status_format switch on devices and emulators.
+"""
+
+import pytest
+
+from conftest import wait_for_condition
+from picohost import binframe
+from picohost.testing import DummyPicoMotor
+
+# Output of the firmware's send_json() in binary mode for
+#   send_json(5, KV_STR, "sensor_name", "motor", KV_INT, "az_pos", -22600,
+#             KV_FLOAT, "T_now", NAN, KV_BOOL, "ok", 1,
+#             KV_STR, "note", NULL)
+# (built on the host against lib/eigsep_command): a schema frame, then
+# the data frame.
+FIRMWARE_FRAMES = bytes.fromhex(
+    "000c0b5934aa0f2a01796f6479657855646b676f0b0c6b70557a6579080f5e5564"
+    "657d0e086561020e64657e6f7295000a"
+    "00050b4e34aa0f67657e6578b2adf5f50b0dca750bf5d6f4000a"
+)
+
+
+def _lines(data):
+    return [line for line in data.split(b"\n") if line]
+
+
+class TestFraming:
+    def test_crc16_check_value(self):
+        """CRC-16/CCITT-FALSE check value."""
+        assert binframe.crc16(b"123456789") == 0x29B1
+
+    @pytest.mark.parametrize("n", [0, 1, 253, 254, 255, 600])
+    def test_cobs_round_trip(self, n):
+        data = bytes((i * 7) % 256 for i in range(n))
+        enc = binframe.cobs_encode(data)
+        assert 0 not in enc
+        assert binframe.cobs_decode(enc) == data
+
+    def test_frame_has_no_newline_inside(self):
+        payload = bytes(range(256)) * 2
+        frame = binframe.encode_frame(payload)
+        assert frame.endswith(b"\x00\n")
+        assert b"\n" not in frame[:-1]
+        assert binframe.decode_frame(frame[:-1]) == payload
+
+    def test_corrupt_frame_rejected(self):
+        frame = bytearray(binframe.encode_frame(b"\x01D\x00\x00abc")[:-1])
+        frame[3] ^= 0x01
+        with pytest.raises(ValueError):
+            binframe.decode_frame(bytes(frame))
+
+
+class TestDecoder:
+    def test_decodes_firmware_frames(self):
+        """Frames from the C encoder decode to the JSON-equivalent dict."""
+        dec = binframe.BinaryStatusDecoder()
+        schema, data = _lines(FIRMWARE_FRAMES)
+        assert dec.feed(schema) is None
+        assert dec.feed(data) == {
+            "sensor_name": "motor",
+            "az_pos": -22600,
+            "T_now": None,
+            "ok": True,
+        }
+
+    def test_layout_id_matches_firmware(self):
+        fw_schema = binframe.decode_frame(_lines(FIRMWARE_FRAMES)[0])
+        fields = [
+            (binframe.KV_STR, "sensor_name"),
+            (binframe.KV_INT, "az_pos"),
+            (binframe.KV_FLOAT, "T_now"),
+            (binframe.KV_BOOL, "ok"),
+            (binframe.KV_STR, "note"),
+        ]
+        layout = fw_schema[2] | fw_schema[3] << 8
+        assert binframe.layout_id(fields) == layout
+
+    def test_data_before_schema_is_dropped(self):
+        enc = binframe.BinaryStatusEncoder()
+        schema, data = _lines(enc.encode({"a": 1, "b": 2.5}))
+        dec = binframe.BinaryStatusDecoder()
+        assert dec.feed(data) is None
+        dec.feed(schema)
+        assert dec.feed(data) == {"a": 1, "b": 2.5}
+
+    def test_schema_repeats(self):
+        enc = binframe.BinaryStatusEncoder(schema_repeat=3)
+        counts = [len(_lines(enc.encode({"a": i}))) for i in range(7)]
+        assert counts == [2, 1, 1, 2, 1, 1, 2]
+
+
+class TestDeviceBinaryMode:
+    def test_status_round_trips_through_binary_frames(self):
+        """A device in binary mode sees the same status dicts as JSON."""
+        device = DummyPicoMotor("/dev/dummy")
+        try:
+            wait_for_condition(
+                lambda: "az_pos" in device.last_status,
+                cadence_ms=device.EMULATOR_CADENCE_MS,
+            )
+            json_keys = set(device.last_status)
+            device.set_status_format("binary")
+            wait_for_condition(
+                lambda: device._emulator.status_format == "binary",
+                cadence_ms=device.EMULATOR_CADENCE_MS,
+            )
+            device.last_status = {}
+            wait_for_condition(
+                lambda: "az_pos" in device.last_status,
+                cadence_ms=device.EMULATOR_CADENCE_MS,
+            )
+            assert set(device.last_status) == json_keys
+        finally:
+            device.disconnect()
+
+    def test_unknown_format_rejected(self):
+        device = DummyPicoMotor("/dev/dummy")
+        try:
+            with pytest.raises(ValueError):
+                device.set_status_format("xml")
+        finally:
+            device.disconnect()
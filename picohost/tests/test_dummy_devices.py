@@ -16,6 +16,7 @@ import pytest
 import mockserial
 
 from conftest import wait_for_condition, wait_for_settle
+from picohost.motor import MAX_COMMAND_LEN, WAYPOINT_QUEUE_LEN
 from picohost.testing import (
     DummyPicoDevice,
     DummyPicoMotor,
@@ -170,6 +171,20 @@ class TestDummyPicoMotor:
         assert motor.last_status["el_target_pos"] == 500
         motor.disconnect()
 
+    def test_set_ramp_profile_reaches_emulator(self):
+        """set_ramp_profile() maps names to firmware values per axis."""
+        motor = DummyPicoMotor(port="/dev/ttyUSB0")
+        motor.set_ramp_profile(az="scurve")
+        wait_for_condition(
+            lambda: motor.last_status.get("az_ramp_profile") == 1,
+            cadence_ms=motor.EMULATOR_CADENCE_MS,
+        )
+        assert motor.last_status["el_ramp_profile"] == 0
+        assert motor._ramp_profile_kwargs == {"az": "scurve"}
+        with pytest.raises(ValueError):
+            motor.set_ramp_profile(el="trapezoid")
+        motor.disconnect()
+
     def test_halt_sets_target_to_current(self):
         """After halt, target_pos should equal current pos."""
         motor = DummyPicoMotor(port="/dev/ttyUSB0")
@@ -203,6 +218,53 @@ class TestDummyPicoMotor:
         assert "boot_id" in motor.last_status
         motor.disconnect()
 
+    def test_run_waypoints_visits_all_points(self):
+        """run_waypoints() streams a list longer than the firmware queue
+        and returns once the last point is reached."""
+        motor = DummyPicoMotor(port="/dev/ttyUSB0")
+        wait_for_condition(
+            lambda: "wp_index" in motor.last_status,
+            cadence_ms=motor.EMULATOR_CADENCE_MS,
+        )
+        n = WAYPOINT_QUEUE_LEN + 8
+        motor.run_waypoints(
+            [(10 * (k + 1), 0) for k in range(n)], poll_s=0.01
+        )
+        wait_for_condition(
+            lambda: motor.last_status.get("az_pos") == 10 * n,
+            cadence_ms=motor.EMULATOR_CADENCE_MS,
+        )
+        assert motor.last_status["wp_count"] == n
+        assert motor.last_status["wp_index"] == -1
+        motor.disconnect()
+
+    def test_run_waypoints_raises_on_rejection(self):
+        """A chunk the firmware refuses raises at once instead of
+        waiting out the stall timeout."""
+        motor = DummyPicoMotor(port="/dev/ttyUSB0")
+        wait_for_condition(
+            lambda: "wp_rejected" in motor.last_status,
+            cadence_ms=motor.EMULATOR_CADENCE_MS,
+        )
+        # A malformed entry: waypoint_add() rejects the whole list
+        motor._waypoint_chunk = lambda wps, room: [[1]]
+        with pytest.raises(RuntimeError, match="rejected"):
+            motor.run_waypoints([(10, 0)], stall_timeout=30, poll_s=0.01)
+        assert motor.last_status["wp_rejected"] == 1
+        assert motor.last_status["wp_count"] == 0
+        motor.disconnect()
+
+    def test_waypoint_chunks_fit_one_line(self):
+        """Each wp_add command fits the firmware's line buffer."""
+        motor = DummyPicoMotor(port="/dev/ttyUSB0")
+        wps = [[-2000000, 2000000, 100000]] * WAYPOINT_QUEUE_LEN
+        chunk = motor._waypoint_chunk(wps, WAYPOINT_QUEUE_LEN)
+        line = json.dumps({"wp_add": chunk}, separators=(",", ":"))
+        assert 0 < len(chunk) < WAYPOINT_QUEUE_LEN
+        assert len(line) <= MAX_COMMAND_LEN
+        assert motor._waypoint_chunk(wps, 2) == wps[:2]
+        motor.disconnect()
+
     def test_scan_homes_after_normal_completion(self):
         """scan() returns motors to (0, 0) one at a time after finishing."""
         motor = DummyPicoMotor(port="/dev/ttyUSB0")
@@ -235,24 +297,28 @@ class TestDummyPicoMotor:
             lambda: "az_target_pos" in motor.last_status,
             cadence_ms=motor.EMULATOR_CADENCE_MS,
         )
-        # patch wait_for_stop to raise after the initial homing
-        # (2 calls for home-az + home-el, then interrupt during scan)
-        real_wait = motor.wait_for_stop
-        call_count = 0
-
-        def interrupt_after_homing(*a, **kw):
-            nonlocal call_count
-            call_count += 1
-            real_wait(*a, **kw)
-            if call_count > 2:
-                raise KeyboardInterrupt
-
-        motor.wait_for_stop = interrupt_after_homing
+        # patch run_waypoints to start the first pass's program, then
+        # interrupt while it is running
+        def interrupt_scan(waypoints, **kw):
+            motor.motor_command(
+                wp_clear=0, wp_add=[list(w) for w in waypoints[:2]]
+            )
+            wait_for_condition(
+                lambda: motor.last_status.get("wp_index", -1) >= 0,
+                cadence_ms=motor.EMULATOR_CADENCE_MS,
+            )
+            raise KeyboardInterrupt
+
+        motor.run_waypoints = interrupt_scan
         with pytest.raises(KeyboardInterrupt):
             motor.scan(
                 az_range_deg=np.array([-10.0, 0.0, 10.0]),
                 el_range_deg=np.array([-10.0, 0.0, 10.0]),
             )
+        wait_for_condition(
+            lambda: motor.last_status.get("wp_index") == -1,
+            cadence_ms=motor.EMULATOR_CADENCE_MS,
+        )
         # halt was called, but post-scan homing did not run
         assert (
             motor.last_status["az_target_pos"] == motor.last_status["az_pos"]
@@ -305,6 +371,21 @@ class TestDummyPicoRFSwitch:
             switch.switch("INVALID_STATE")
         switch.disconnect()
 
+    def test_request_perf_returns_record_off_status_path(self):
+        """request_perf() gets the "perf" record without it replacing
+        last_status."""
+        switch = DummyPicoRFSwitch(port="/dev/ttyUSB0")
+        wait_for_condition(
+            lambda: switch.last_status.get("sensor_name") == "rfswitch",
+            cadence_ms=switch.EMULATOR_CADENCE_MS,
+        )
+        perf = switch.request_perf(reset=True)
+        assert perf["sensor_name"] == "perf"
+        assert perf["loop_n"] > 0
+        assert "op_p99_us" in perf
+        assert switch.last_status["sensor_name"] == "rfswitch"
+        switch.disconnect()
+
 
 # ---------------------------------------------------------------------------
 # DummyPicoPeltier (emulator-backed)
@@ -21,8 +21,16 @@ from picohost.testing import (
     DummyPicoLidar,
 )
 
-# Expected field sets from C firmware send_json calls
-MOTOR_FIELDS = {
+# Expected field sets from C firmware send_json calls. CMD_RX_STATUS
+# (src/cmd_rx.h) is appended to every app's status.
+CMD_RX_FIELDS = {
+    "cmd_queue_max",
+    "cmd_overflow",
+    "cmd_pool_max",
+    "cmd_pool_fail",
+}
+
+MOTOR_FIELDS = CMD_RX_FIELDS | {
     "sensor_name",
     "status",
     "app_id",
@@ -31,9 +39,14 @@ MOTOR_FIELDS = {
     "az_target_pos",
     "el_pos",
     "el_target_pos",
+    "az_ramp_profile",
+    "el_ramp_profile",
+    "wp_index",
+    "wp_count",
+    "wp_rejected",
 }
 
-TEMPCTRL_FIELDS = {
+TEMPCTRL_FIELDS = CMD_RX_FIELDS | {
     "sensor_name",
     "app_id",
     "watchdog_tripped",
@@ -58,6 +71,8 @@ TEMPCTRL_FIELDS = {
     "LNA_Kp",
     "LNA_Ki",
     "LNA_integral",
+    "LNA_adc_oversample",
+    "LNA_adc_median",
     "LOAD_status",
     "LOAD_T_now",
     "LOAD_voltage",
@@ -78,9 +93,19 @@ TEMPCTRL_FIELDS = {
     "LOAD_Kp",
     "LOAD_Ki",
     "LOAD_integral",
+    "LOAD_adc_oversample",
+    "LOAD_adc_median",
+}
+
+# Window statistics for each of these, and the field set they make
+IMU_STATS_AXES = ("yaw", "pitch", "roll", "accel_x", "accel_y", "accel_z")
+IMU_STATS_FIELDS = {
+    f"{axis}_{stat}"
+    for axis in IMU_STATS_AXES
+    for stat in ("mean", "var", "min", "max")
 }
 
-IMU_FIELDS = {
+IMU_FIELDS = CMD_RX_FIELDS | {
     "sensor_name",
     "status",
     "app_id",
@@ -90,9 +115,39 @@ IMU_FIELDS = {
     "accel_x",
     "accel_y",
     "accel_z",
-}
+    "rx_dropped",
+    "rvc_checksum_fail",
+    "rvc_rate_hz",
+    "n_samples",
+} | IMU_STATS_FIELDS
 
-LIDAR_FIELDS = {
+IMU_SHTP_FIELDS = CMD_RX_FIELDS | {
+    "sensor_name",
+    "status",
+    "app_id",
+    "quat_i",
+    "quat_j",
+    "quat_k",
+    "quat_real",
+    "quat_accuracy",
+    "quat_error_rad",
+    "accel_x",
+    "accel_y",
+    "accel_z",
+    "accel_accuracy",
+    "gravity_x",
+    "gravity_y",
+    "gravity_z",
+    "quat_age_ms",
+    "accel_age_ms",
+    "gravity_age_ms",
+    "quat_hz",
+    "accel_hz",
+    "gravity_hz",
+    "n_samples",
+} | {field for field in IMU_STATS_FIELDS if field.startswith("accel")}
+
+LIDAR_FIELDS = CMD_RX_FIELDS | {
     "sensor_name",
     "status",
     "app_id",
@@ -100,11 +155,15 @@ LIDAR_FIELDS = {
     "current_voltage",
 }
 
-RFSWITCH_FIELDS = {
+RFSWITCH_FIELDS = CMD_RX_FIELDS | {
     "sensor_name",
     "status",
     "app_id",
     "sw_state",
+    "settled_s",
+    "settled_us",
+    "seq_step",
+    "seq_pass",
     "volt_therm0",
     "volt_therm1",
     "volt_therm2",
@@ -228,6 +287,12 @@ class TestRFSwitchIntegration:
             == rfswitch.paths["VNAO"]
         )
 
+    def test_switch_wait_returns_on_settle(self, rfswitch):
+        """switch(wait=True) returns once the settle line is in."""
+        rfswitch.switch("VNAS", wait=True)
+        assert rfswitch.last_status["sw_state"] == rfswitch.paths["VNAS"]
+        assert rfswitch.last_status["settled_s"] >= 0
+
 
 # --- Peltier ---
 
@@ -295,6 +360,42 @@ class TestIMUIntegration:
         assert isinstance(s["status"], str)
 
 
+class _ShtpIMU(DummyPicoIMU):
+    EMULATOR_SHTP = True
+
+
+class TestIMUShtpIntegration:
+    def test_report_rates_round_trip(self):
+        """set_report_rates() reaches the emulator; its status follows."""
+        imu = _ShtpIMU("/dev/dummy")
+        try:
+            cadence = imu.EMULATOR_CADENCE_MS
+            _wait_for_first_status(imu)
+            assert set(imu.last_status.keys()) == IMU_SHTP_FIELDS
+            imu.set_report_rates(quat_hz=400, gravity_hz=0)
+            wait_for_condition(
+                lambda: imu.last_status.get("quat_hz") == 400,
+                cadence_ms=cadence,
+            )
+            s = imu.last_status
+            assert s["accel_hz"] == 100
+            assert s["gravity_hz"] == 0
+            assert s["quat_real"] == pytest.approx(1.0, abs=0.01)
+        finally:
+            imu.disconnect()
+
+    def test_rates_replayed_on_reconnect(self):
+        imu = _ShtpIMU("/dev/dummy")
+        try:
+            imu.set_report_rates(accel_hz=250)
+            sent = []
+            imu.send_command = sent.append
+            imu.on_reconnect()
+            assert sent == [{"accel_hz": 250}]
+        finally:
+            imu.disconnect()
+
+
 # --- Motor ---
 
 
@@ -309,6 +410,10 @@ class TestMotorIntegrationTypes:
         assert isinstance(s["az_target_pos"], int)
         assert isinstance(s["el_pos"], int)
         assert isinstance(s["el_target_pos"], int)
+        assert isinstance(s["az_ramp_profile"], int)
+        assert isinstance(s["el_ramp_profile"], int)
+        assert isinstance(s["wp_index"], int)
+        assert isinstance(s["wp_count"], int)
 
 
 # --- Peltier ---
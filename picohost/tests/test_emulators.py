@@ -7,6 +7,7 @@ import time
 
 import numpy as np
 import pytest
+from conftest import LinePeer
 from picohost.emulators import (
     MotorEmulator,
     TempCtrlEmulator,
@@ -14,6 +15,8 @@ from picohost.emulators import (
     LidarEmulator,
     PotMonEmulator,
     RFSwitchEmulator,
+    RealClock,
+    VirtualClock,
 )
 
 
@@ -144,6 +147,15 @@ class TestMotorEmulator:
             "az_target_pos",
             "el_pos",
             "el_target_pos",
+            "az_ramp_profile",
+            "el_ramp_profile",
+            "wp_index",
+            "wp_count",
+            "wp_rejected",
+            "cmd_queue_max",
+            "cmd_overflow",
+            "cmd_pool_max",
+            "cmd_pool_fail",
         }
         assert set(status.keys()) == expected_keys
 
@@ -262,6 +274,8 @@ class TestTempCtrlEmulator:
             "LNA_Kp",
             "LNA_Ki",
             "LNA_integral",
+            "LNA_adc_oversample",
+            "LNA_adc_median",
             "LOAD_status",
             "LOAD_T_now",
             "LOAD_voltage",
@@ -282,6 +296,12 @@ class TestTempCtrlEmulator:
             "LOAD_Kp",
             "LOAD_Ki",
             "LOAD_integral",
+            "LOAD_adc_oversample",
+            "LOAD_adc_median",
+            "cmd_queue_max",
+            "cmd_overflow",
+            "cmd_pool_max",
+            "cmd_pool_fail",
         }
         assert set(status.keys()) == expected_keys
         assert status["LNA_status"] == "update"
@@ -383,7 +403,9 @@ class TestTempCtrlWatchdog:
         assert emu.lna.enabled is True
         assert emu.load.enabled is True
         # Simulate time passing beyond the watchdog timeout
-        emu._last_cmd_time = time.time() - (emu.watchdog_timeout_ms / 1000 + 1)
+        emu._last_cmd_time = emu.clock.now() - (
+            emu.watchdog_timeout_ms / 1000 + 1
+        )
         emu.op()
         assert emu.watchdog_tripped is True
         # Host intent is preserved.
@@ -397,7 +419,9 @@ class TestTempCtrlWatchdog:
         """A bare keepalive refreshes the timer but the trip flag is sticky."""
         emu = TempCtrlEmulator()
         # Trip the watchdog
-        emu._last_cmd_time = time.time() - (emu.watchdog_timeout_ms / 1000 + 1)
+        emu._last_cmd_time = emu.clock.now() - (
+            emu.watchdog_timeout_ms / 1000 + 1
+        )
         emu.op()
         assert emu.watchdog_tripped is True
         # A non-enable command (e.g. keepalive) must not silently re-engage
@@ -410,7 +434,9 @@ class TestTempCtrlWatchdog:
     def test_enable_true_clears_watchdog_trip(self):
         """*_enable=true is the explicit ack that clears the watchdog flag."""
         emu = TempCtrlEmulator()
-        emu._last_cmd_time = time.time() - (emu.watchdog_timeout_ms / 1000 + 1)
+        emu._last_cmd_time = emu.clock.now() - (
+            emu.watchdog_timeout_ms / 1000 + 1
+        )
         emu.op()
         assert emu.watchdog_tripped is True
         emu.server({"LNA_enable": True})
@@ -420,7 +446,9 @@ class TestTempCtrlWatchdog:
         """Disabling a channel is not an ack — trip stays sticky."""
         emu = TempCtrlEmulator()
         emu.server({"LNA_enable": True})
-        emu._last_cmd_time = time.time() - (emu.watchdog_timeout_ms / 1000 + 1)
+        emu._last_cmd_time = emu.clock.now() - (
+            emu.watchdog_timeout_ms / 1000 + 1
+        )
         emu.op()
         assert emu.watchdog_tripped is True
         emu.server({"LNA_enable": False})
@@ -444,7 +472,7 @@ class TestTempCtrlWatchdog:
         """Setting watchdog_timeout_ms to 0 disables the watchdog."""
         emu = TempCtrlEmulator()
         emu.server({"LNA_enable": True, "watchdog_timeout_ms": 0})
-        emu._last_cmd_time = time.time() - 999
+        emu._last_cmd_time = emu.clock.now() - 999
         emu.op()
         assert emu.watchdog_tripped is False
         assert emu.lna.enabled is True
@@ -453,11 +481,13 @@ class TestTempCtrlWatchdog:
 class TestTempCtrlStallGuard:
     """The stall guard trips when drive is engaged but T_now refuses to move."""
 
-    def _force_window_elapsed(self, tc):
+    def _force_window_elapsed(self, emu, tc):
         # Pretend the stall window opened before the threshold.
         import picohost.emulators.tempctrl as mod
 
-        tc.stall_check_time = time.time() - (mod.STALL_WINDOW_MS / 1000 + 1)
+        tc.stall_check_time = emu.clock.now() - (
+            mod.STALL_WINDOW_MS / 1000 + 1
+        )
 
     def test_stall_trip_gates_drive(self):
         """Stall trip zeroes drive while leaving host-intent `enabled` alone."""
@@ -468,7 +498,7 @@ class TestTempCtrlStallGuard:
         _run_to_drive(emu)  # anchor, then open the stall window (active=True)
         assert emu.lna.active is True
         assert emu.lna.stall_window_active is True
-        self._force_window_elapsed(emu.lna)
+        self._force_window_elapsed(emu, emu.lna)
         emu.op()
         assert emu.lna.stall_tripped is True
         # Host intent preserved; trip flag is the runtime gate.
@@ -484,7 +514,7 @@ class TestTempCtrlStallGuard:
         emu.lna.T_now = 25.0
         emu.server({"LNA_temp_target": 30.0, "LNA_enable": True})
         _run_to_drive(emu)
-        self._force_window_elapsed(emu.lna)
+        self._force_window_elapsed(emu, emu.lna)
         emu.lna.T_now += 1.0  # well above STALL_MIN_DELTA
         emu.op()
         assert emu.lna.stall_tripped is False
@@ -505,7 +535,7 @@ class TestTempCtrlStallGuard:
         _run_to_drive(emu)
         assert emu.lna.active is False
         assert emu.lna.stall_window_active is False
-        self._force_window_elapsed(emu.lna)
+        self._force_window_elapsed(emu, emu.lna)
         emu.op()
         assert emu.lna.stall_tripped is False
 
@@ -516,7 +546,7 @@ class TestTempCtrlStallGuard:
         emu.lna.thermal_frozen = True
         emu.server({"LNA_temp_target": 30.0, "LNA_enable": True})
         _run_to_drive(emu)
-        self._force_window_elapsed(emu.lna)
+        self._force_window_elapsed(emu, emu.lna)
         emu.op()
         assert emu.lna.stall_tripped is True
         assert emu.lna.enabled is True
@@ -531,7 +561,7 @@ class TestTempCtrlStallGuard:
         emu.lna.thermal_frozen = True
         emu.server({"LNA_temp_target": 30.0, "LNA_enable": True})
         _run_to_drive(emu)
-        self._force_window_elapsed(emu.lna)
+        self._force_window_elapsed(emu, emu.lna)
         emu.op()
         assert emu.lna.stall_tripped is True
         emu.server({"LNA_temp_target": 28.0})
@@ -552,7 +582,7 @@ class TestTempCtrlStallGuard:
             }
         )
         _run_to_drive(emu)
-        self._force_window_elapsed(emu.load)
+        self._force_window_elapsed(emu, emu.load)
         emu.op()
         assert emu.load.stall_tripped is True
         # Host intent unchanged on the tripped channel.
@@ -679,7 +709,7 @@ class TestTempCtrlCoolingGuard:
         assert emu.lna.drive == 0.0
         # Force-elapse the stall window and run another op cycle: with
         # drive==0 the guard must not arm, regardless of how long we sit.
-        emu.lna.stall_check_time = time.time() - (
+        emu.lna.stall_check_time = emu.clock.now() - (
             mod.STALL_WINDOW_MS / 1000 + 1
         )
         emu.op()
@@ -697,10 +727,12 @@ class TestTempCtrlRunawayGuard:
     cannot catch (the temperature *is* moving).
     """
 
-    def _force_window_elapsed(self, tc):
+    def _force_window_elapsed(self, emu, tc):
         import picohost.emulators.tempctrl as mod
 
-        tc.stall_check_time = time.time() - (mod.STALL_WINDOW_MS / 1000 + 1)
+        tc.stall_check_time = emu.clock.now() - (
+            mod.STALL_WINDOW_MS / 1000 + 1
+        )
 
     def _setup_cooling(self, emu):
         """Arm LNA cooling so drive saturates negative; open the window."""
@@ -714,7 +746,7 @@ class TestTempCtrlRunawayGuard:
     def _wrong_way_window(self, emu):
         """Force a completed window in which T_now moved *up* while the
         drive is negative (cooling), then evaluate it with one op."""
-        self._force_window_elapsed(emu.lna)
+        self._force_window_elapsed(emu, emu.lna)
         emu.lna.T_now += 1.0
         emu.op()
 
@@ -743,7 +775,7 @@ class TestTempCtrlRunawayGuard:
         self._wrong_way_window(emu)
         assert emu.lna.runaway_strikes == 1
         # A correct-direction window (cooling drive, T_now falls) clears it.
-        self._force_window_elapsed(emu.lna)
+        self._force_window_elapsed(emu, emu.lna)
         emu.lna.T_now -= 1.0
         emu.op()
         assert emu.lna.runaway_strikes == 0
@@ -760,7 +792,7 @@ class TestTempCtrlRunawayGuard:
         _run_to_drive(emu)
         assert emu.lna.drive > 0.0
         for _ in range(mod.RUNAWAY_STRIKES):
-            self._force_window_elapsed(emu.lna)
+            self._force_window_elapsed(emu, emu.lna)
             emu.lna.T_now -= 1.0  # heating drive but cooling → wrong way
             emu.op()
         assert emu.lna.runaway_tripped is True
@@ -770,7 +802,7 @@ class TestTempCtrlRunawayGuard:
     def test_target_crossing_does_not_count_wrong_direction(self):
         emu = TempCtrlEmulator()
         self._setup_cooling(emu)
-        self._force_window_elapsed(emu.lna)
+        self._force_window_elapsed(emu, emu.lna)
         emu.lna.T_now = emu.lna.T_target - 1.0
         emu.lna.thermal_frozen = False
         _run_to_pi_tick(emu)
@@ -1061,7 +1093,7 @@ class TestThermistorCurve:
     B25/85 = 3977 K). Anchors are the R_T table for the 10 kOhm part
     (Vishay document 29049, NTCLE100E3103 column). The firmware inverts
     resistance -> temperature with the datasheet's extended
-    Steinhart-Hart fit (A1..D1, temp_simple.h); the emulator generates
+    Steinhart-Hart fit (A1..D1, thermistor.h); the emulator generates
     resistance from temperature with the paired forward fit, which the
     datasheet states is interchangeable within 0.015 C over -40..125 C.
     """
@@ -1184,6 +1216,52 @@ class TestImuEmulator:
         assert emu.is_initialized is True
         assert emu.get_status()["status"] == "update"
 
+    def test_rate_drops_with_the_stream(self):
+        """rvc_rate_hz is the stream rate while packets arrive, else 0."""
+        import picohost.emulators.imu as imu_mod
+
+        emu = ImuEmulator()
+        emu.op()
+        assert emu.get_status()["rvc_rate_hz"] == imu_mod.RVC_RATE_HZ
+        emu.simulate_sensor_failure()
+        emu.op()
+        assert emu.get_status()["rvc_rate_hz"] == 0.0
+
+    def test_shtp_status_fields(self):
+        emu = ImuEmulator(shtp=True)
+        emu.op()
+        status = emu.get_status()
+        assert {"quat_real", "gravity_z", "quat_age_ms", "quat_hz"} <= set(
+            status
+        )
+        assert "yaw" not in status and "rvc_rate_hz" not in status
+        assert status["quat_real"] == pytest.approx(1.0, abs=0.01)
+        assert status["gravity_z"] == pytest.approx(9.80665, abs=0.01)
+
+    def test_shtp_rates_clamp_and_gate_reports(self):
+        """Rates are CMD_INT keys clamped to [0, 400]; a report at 0
+        keeps its last sample and ages, and is never sampled at all
+        when off from the start."""
+        emu = ImuEmulator(shtp=True)
+        emu.server({"quat_hz": 1000, "accel_hz": -3, "gravity_hz": "x"})
+        assert emu.rates == {"quat_hz": 400, "accel_hz": 0, "gravity_hz": 100}
+        emu.op()
+        status = emu.get_status()
+        assert status["quat_age_ms"] is not None
+        assert status["accel_age_ms"] is None
+        assert status["accel_z"] == 0.0
+
+    def test_shtp_all_reports_off_never_times_out(self):
+        import picohost.emulators.imu as imu_mod
+
+        emu = ImuEmulator(shtp=True)
+        emu.server({"quat_hz": 0, "accel_hz": 0, "gravity_hz": 0})
+        emu.simulate_sensor_failure()
+        emu._last_event_time -= imu_mod.IMU_EVENT_TIMEOUT_S + 1
+        emu.op()
+        assert emu.is_initialized is True
+        assert emu.get_status()["status"] == "error"
+
     def test_sensor_failure_before_timeout_stays_initialized(self):
         """IMU stays initialized if failure is shorter than timeout."""
         emu = ImuEmulator()
@@ -1206,9 +1284,57 @@ class TestImuEmulator:
             "accel_x",
             "accel_y",
             "accel_z",
+            "rx_dropped",
+            "rvc_checksum_fail",
+            "rvc_rate_hz",
+            "n_samples",
+            "cmd_queue_max",
+            "cmd_overflow",
+            "cmd_pool_max",
+            "cmd_pool_fail",
+        }
+        import picohost.emulators.imu as imu_mod
+
+        expected_keys |= {
+            f"{axis}_{stat}"
+            for axis in imu_mod.WINDOW_KEYS
+            for stat in ("mean", "var", "min", "max")
         }
         assert set(status.keys()) == expected_keys
 
+    def test_window_stats(self):
+        """Each status summarises the samples since the last one, then
+        starts over; yaw averages on the circle across +/-180."""
+        emu = ImuEmulator()
+        status = emu.get_status()
+        assert status["n_samples"] == 0
+        assert status["yaw_mean"] is None and status["accel_z_var"] is None
+        for yaw in (179.0, -179.0, 180.0):
+            emu.set_orientation(0.0, 0.0)
+            emu.op()
+            emu.window["yaw"][-1] = yaw
+        status = emu.get_status()
+        assert status["n_samples"] == 3
+        assert abs(status["yaw_mean"]) == pytest.approx(180.0)
+        assert status["yaw_var"] == pytest.approx(1.0)
+        assert status["yaw_min"] == pytest.approx(179.0)
+        assert status["yaw_max"] == pytest.approx(-179.0)
+        assert status["accel_z_mean"] == pytest.approx(status["accel_z"])
+        assert status["accel_z_var"] == pytest.approx(0.0)
+        assert emu.get_status()["n_samples"] == 0
+
+    def test_shtp_window_stats_accel_only(self):
+        emu = ImuEmulator(shtp=True)
+        emu.op()
+        emu.op()
+        status = emu.get_status()
+        assert status["n_samples"] == 2
+        assert "yaw_mean" not in status
+        assert status["accel_z_mean"] == pytest.approx(9.80665, abs=0.01)
+        emu.server({"accel_hz": 0})
+        emu.op()
+        assert emu.get_status()["n_samples"] == 0
+
 
 class TestLidarEmulator:
     def test_initial_state(self):
@@ -1233,6 +1359,10 @@ class TestLidarEmulator:
             "app_id",
             "distance_m",
             "current_voltage",
+            "cmd_queue_max",
+            "cmd_overflow",
+            "cmd_pool_max",
+            "cmd_pool_fail",
         }
         assert set(status.keys()) == expected_keys
 
@@ -1267,9 +1397,17 @@ class TestRFSwitchEmulator:
             "status",
             "app_id",
             "sw_state",
+            "settled_s",
+            "settled_us",
+            "seq_step",
+            "seq_pass",
             "volt_therm0",
             "volt_therm1",
             "volt_therm2",
+            "cmd_queue_max",
+            "cmd_overflow",
+            "cmd_pool_max",
+            "cmd_pool_fail",
         }
         assert set(status.keys()) == expected_keys
 
@@ -1384,6 +1522,10 @@ class TestMotorStatusTypes:
         assert isinstance(status["az_target_pos"], int)
         assert isinstance(status["el_pos"], int)
         assert isinstance(status["el_target_pos"], int)
+        assert isinstance(status["az_ramp_profile"], int)
+        assert isinstance(status["el_ramp_profile"], int)
+        assert isinstance(status["wp_index"], int)
+        assert isinstance(status["wp_count"], int)
 
 
 class TestTempCtrlStatusTypes:
@@ -1417,6 +1559,9 @@ class TestImuStatusTypes:
         assert isinstance(status["app_id"], int)
         for key in ("yaw", "pitch", "roll", "accel_x", "accel_y", "accel_z"):
             assert isinstance(status[key], float), f"{key} should be float"
+        assert isinstance(status["rvc_rate_hz"], float)
+        assert isinstance(status["rx_dropped"], int)
+        assert isinstance(status["rvc_checksum_fail"], int)
 
 
 class TestLidarStatusTypes:
@@ -1491,17 +1636,40 @@ class TestMalformedInput:
         assert emu.get_status()["sw_state"] == 0
 
     def test_tempctrl_invalid_type(self):
-        # cJSON valuedouble is 0.0 for non-numeric JSON; firmware writes it
-        # straight into the struct (see tempctrl.c LNA_temp_target parse).
+        # Numeric keys take numbers only (cmd_table.c CMD_FLOAT); anything
+        # else leaves the setting alone.
         emu = TempCtrlEmulator()
         emu.server({"LNA_temp_target": "hot"})
-        assert emu.lna.T_target == 0.0
+        assert emu.lna.T_target == 30.0
 
     def test_tempctrl_null_value(self):
-        # Same cJSON path as above; LNA_clamp is then clamped to [0, 1].
         emu = TempCtrlEmulator()
-        emu.server({"LNA_clamp": None})
-        assert emu.lna.clamp == 0.0
+        emu.server({"LNA_clamp": None, "LNA_Kp": True})
+        assert emu.lna.clamp == pytest.approx(0.2)
+        assert emu.lna.Kp == pytest.approx(0.2)
+
+    def test_tempctrl_out_of_range_clamps(self):
+        # tempctrl_keys ranges: target within the thermistor's range,
+        # non-negative gains and hysteresis, watchdog >= 0.
+        emu = TempCtrlEmulator()
+        emu.server(
+            {
+                "LNA_temp_target": 200,
+                "LOAD_temp_target": -100,
+                "LNA_Kp": -1,
+                "LNA_Ki": -0.5,
+                "LNA_hysteresis": -2,
+                "LOAD_clamp": 3,
+                "watchdog_timeout_ms": -5,
+            }
+        )
+        assert emu.lna.T_target == 125.0
+        assert emu.load.T_target == -40.0
+        assert emu.lna.Kp == 0.0
+        assert emu.lna.Ki == 0.0
+        assert emu.lna.hysteresis == 0.0
+        assert emu.load.clamp == 1.0
+        assert emu.watchdog_timeout_ms == 0
 
 
 # ---------------------------------------------------------------------------
@@ -1672,3 +1840,120 @@ class TestSensorName:
         statuses = result if isinstance(result, list) else [result]
         for status in statuses:
             assert "sensor_name" in status
+
+
+def _settled_ms(status):
+    return status["settled_s"] * 1000.0 + status["settled_us"] / 1000.0
+
+
+class TestEmulatorClock:
+    """Emulator time comes from a clock object (emulators/clock.py)."""
+
+    def test_real_clock_rate(self):
+        clock = RealClock(rate=100)
+        t0, wall0 = clock.now(), time.monotonic()
+        clock.sleep(1.0)
+        assert clock.now() - t0 >= 1.0
+        assert time.monotonic() - wall0 < 0.5
+
+    def test_real_clock_rejects_bad_rate(self):
+        with pytest.raises(ValueError):
+            RealClock(rate=0)
+
+    def test_virtual_clock_moves_only_when_told(self):
+        clock = VirtualClock(start=5.0)
+        assert clock.now() == 5.0
+        clock.advance(1.5)
+        clock.sleep(0.5)
+        assert clock.now() == 7.0
+        with pytest.raises(ValueError):
+            clock.advance(-1)
+
+    def test_step_advances_one_loop_pass(self):
+        clock = VirtualClock()
+        emu = MotorEmulator(clock=clock)
+        emu.step(10)
+        assert clock.now() == pytest.approx(0.010)
+
+    def test_status_cadence_on_virtual_clock(self):
+        """200 ms cadence: 5 status packets per virtual second, every run."""
+        runs = []
+        for _ in range(2):
+            emu = RFSwitchEmulator(
+                settle_ms=0, status_cadence_ms=200, clock=VirtualClock()
+            )
+            emu.attach(LinePeer())
+            emu.run_for(1.0)
+            runs.append(emu._peer.lines())
+        assert len(runs[0]) in (4, 5)
+        assert runs[0] == runs[1]
+
+    def test_tempctrl_watchdog_in_virtual_time(self):
+        """The 30 s watchdog trips after 30 s of emulator time, not wall."""
+        emu = TempCtrlEmulator(clock=VirtualClock())
+        emu.server({"LNA_enable": True})
+        wall0 = time.monotonic()
+        emu.run_for(29.0)
+        assert emu.watchdog_tripped is False
+        emu.run_for(2.0)
+        assert emu.watchdog_tripped is True
+        assert time.monotonic() - wall0 < 30.0
+
+    def test_rfswitch_settle_in_virtual_time(self):
+        emu = RFSwitchEmulator(settle_ms=30, clock=VirtualClock())
+        emu.step(20)
+        assert emu.in_transition is True
+        emu.run_for(0.05)
+        assert emu.in_transition is False
+        assert emu.get_status()["sw_state"] == 0
+
+    def test_rfswitch_sequence_on_dwell_grid(self):
+        """Steps start on the dwell grid from the command and each sends
+        its own line; a same-path step settles at its start."""
+        emu = RFSwitchEmulator(status_cadence_ms=5000, clock=VirtualClock())
+        emu.attach(LinePeer())
+        emu.run_for(0.03)
+        t0 = (emu.clock.now() - emu._boot) * 1000.0
+        emu.server(
+            {"sw_sequence": [[1, 50], [2, 55], [2, 45]], "sw_repeat": 2}
+        )
+        emu.run_for(0.35)
+        lines = emu._peer.records()[1:]
+        got = [(s["sw_state"], s["seq_step"], s["seq_pass"]) for s in lines]
+        assert got == [
+            (1, 0, 0),
+            (2, 1, 0),
+            (2, 2, 0),
+            (1, 0, 1),
+            (2, 1, 1),
+            (2, 2, 1),
+            (2, -1, -1),
+        ]
+        starts = [0.0, 50.0, 105.0, 150.0, 200.0, 255.0]
+        want = [t + 20.0 for t in starts]
+        want[2], want[5] = starts[2], starts[5]  # no move: no settle
+        for s, w in zip(lines, want):
+            assert _settled_ms(s) == pytest.approx(t0 + w)
+
+    def test_rfswitch_sequence_repeat_zero_runs_until_stopped(self):
+        emu = RFSwitchEmulator(clock=VirtualClock())
+        emu.server({"sw_sequence": [[1, 40], [2, 40]], "sw_repeat": 0})
+        emu.run_for(1.0)
+        assert emu.get_status()["seq_pass"] >= 10
+        emu.server({"sw_sequence": []})
+        emu.run_for(0.01)
+        assert emu.get_status()["seq_step"] == -1
+
+    def test_rfswitch_settle_sends_status_at_once(self):
+        """The settle goes out on its own line, not at the next tick."""
+        emu = RFSwitchEmulator(status_cadence_ms=200, clock=VirtualClock())
+        emu.attach(LinePeer())
+        emu.run_for(0.03)
+        boot = emu._peer.records()
+        assert [s["sw_state"] for s in boot] == [0]
+        assert (boot[0]["settled_s"], boot[0]["settled_us"]) == (0, 20000)
+        emu.server({"sw_state": 3})
+        emu.run_for(0.03)
+        lines = emu._peer.records()
+        assert [s["sw_state"] for s in lines] == [0, 3]
+        assert _settled_ms(lines[1]) == pytest.approx(50.0, abs=0.1)
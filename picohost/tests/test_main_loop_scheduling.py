@@ -1,87 +1,81 @@
 """
-Tests for the main loop's op() anti-starvation logic.
-
-The C firmware in src/main.c prioritises draining the serial FIFO (via
-``continue``) so that slow app_op() calls don't block command receipt.
-However, if serial data arrives continuously without a newline terminator,
-app_op() would be starved indefinitely.  The MAX_READ_ONLY_US threshold
-(50 ms) guarantees that the loop will break out of reading and run op()
-within that window.
-
-These tests model the main loop algorithm in Python and verify that:
-  1. Normal commands (terminated by newline) always run op() promptly.
-  2. Continuous input without a newline eventually triggers an op() call.
-  3. Partial commands are preserved across the forced op() call.
+Tests for the main loop's command receive / op() scheduling.
+
+Bytes are collected by the USB chars-available callback (src/cmd_rx.c),
+which assembles lines and queues complete ones (at most
+CMD_RX_QUEUE_LEN; on a full queue it stops reading, leaving the rest in
+the CDC FIFO, and cmd_rx_pop() resumes it). Each pass of the main loop
+in src/main.c dispatches at most one queue's worth of lines and then
+runs op(), so partial or flooding input can no longer hold op() off.
+
+These tests model that algorithm in Python and verify that:
+  1. Queued commands are dispatched in order, and op() runs every pass.
+  2. Unterminated input never delays op() and survives intact.
+  3. A full queue holds input back instead of dropping it.
+  4. Over-long lines are truncated to BUFFER_SIZE - 1 bytes and counted.
 """
 
-import time
 from collections import deque
 
+CMD_RX_QUEUE_LEN = 16  # src/cmd_rx.h
+BUFFER_SIZE = 256  # lib/eigsep_command/eigsep_command.h
+
 
 # ---------------------------------------------------------------------------
-# Minimal Python model of the C main loop scheduling logic
+# Minimal Python model of cmd_rx.c + the main.c loop
 # ---------------------------------------------------------------------------
 
-MAX_READ_ONLY_S = 0.050  # 50 ms, matching MAX_READ_ONLY_US in pico_multi.h
-
 
 class MainLoopModel:
-    """Pure-Python model of the serial-read / op() scheduling in main.c.
+    """Pure-Python model of the receive callback and main loop.
 
-    Instead of real serial I/O, callers push characters into ``input_queue``
-    and the model records when op() and server() are called.
+    ``rx()`` stands in for the USB callback draining the CDC FIFO;
+    ``tick()`` is one pass of the main loop. The model records op() and
+    server() calls.
     """
 
-    def __init__(self, max_read_only_s=MAX_READ_ONLY_S):
-        self.max_read_only_s = max_read_only_s
-        self.input_queue: deque[str] = deque()
-        self.buffer: list[str] = []
-        self.op_call_times: list[float] = []
-        self.server_calls: list[str] = []  # completed commands
-        self._last_op_time = time.monotonic()
-
-    def push_input(self, data: str):
-        """Enqueue characters for the model to read."""
-        self.input_queue.extend(data)
-
-    def _getchar(self):
-        """Non-blocking read of one character (models getchar_timeout_us(0))."""
-        if self.input_queue:
-            return self.input_queue.popleft()
-        return None
-
-    def _app_op(self):
-        """Record an op() call."""
-        self.op_call_times.append(time.monotonic())
-
-    def _app_server(self, line: str):
-        """Record a dispatched command."""
-        self.server_calls.append(line)
-
-    def tick(self):
-        """Execute one iteration of the main loop.
-
-        Returns True if the loop ran op(), False if it ``continue``d back
-        to reading (i.e. op() was skipped this iteration).
-        """
-        c = self._getchar()
-
-        if c is not None:
+    def __init__(self):
+        self.queue: deque[str] = deque()
+        self.fifo: deque[str] = deque()  # CDC FIFO: bytes not yet read
+        self.rx_line: list[str] = []
+        self.rx_truncated = False
+        self.queue_max = 0
+        self.overflow = 0
+        self.op_calls = 0
+        self.server_calls: list[str] = []
+
+    def rx(self, data: str):
+        """Models a USB packet landing in the CDC FIFO, then the
+        rx_chars_available() callback (IRQ context)."""
+        self.fifo.extend(data)
+        self.drain()
+
+    def drain(self):
+        """Models rx_drain(): stops, leaving bytes in the FIFO, while
+        the queue is full."""
+        while self.fifo and len(self.queue) < CMD_RX_QUEUE_LEN:
+            c = self.fifo.popleft()
             if c == "\n":
-                # Complete command — dispatch, then fall through to op()
-                self._app_server("".join(self.buffer))
-                self.buffer.clear()
+                if self.rx_truncated:
+                    self.overflow += 1
+                    self.rx_truncated = False
+                self.queue.append("".join(self.rx_line))
+                self.queue_max = max(self.queue_max, len(self.queue))
+                self.rx_line.clear()
+            elif len(self.rx_line) < BUFFER_SIZE - 1:
+                self.rx_line.append(c)
             else:
-                self.buffer.append(c)
-                # This is the anti-starvation check from main.c lines 105-108
-                elapsed = time.monotonic() - self._last_op_time
-                if elapsed < self.max_read_only_s:
-                    return False  # continue — skip op() this iteration
+                self.rx_truncated = True
 
-        # Fall through: run op()
-        self._app_op()
-        self._last_op_time = time.monotonic()
-        return True
+    def tick(self):
+        """One pass of the main loop; returns the lines dispatched."""
+        n = 0
+        while n < CMD_RX_QUEUE_LEN and self.queue:
+            self.server_calls.append(self.queue.popleft())
+            self.drain()  # cmd_rx_pop() resumes a stalled drain
+            n += 1
+        self.op_calls += 1
+        return n
 
 
 # ---------------------------------------------------------------------------
@@ -89,129 +83,86 @@ class MainLoopModel:
 # ---------------------------------------------------------------------------
 
 
-class TestNormalCommandProcessing:
-    """Newline-terminated commands always let op() run promptly."""
-
-    def test_op_runs_after_complete_command(self):
+class TestCommandDispatch:
+    def test_command_dispatched_then_op(self):
         model = MainLoopModel()
-        model.push_input('{"cmd":"ping"}\n')
-
-        # Drain all characters — the newline triggers server + op
-        ran_op = False
-        for _ in range(50):
-            if model.tick():
-                ran_op = True
-                break
-
-        assert ran_op
+        model.rx('{"cmd":"ping"}\n')
+        assert model.tick() == 1
         assert model.server_calls == ['{"cmd":"ping"}']
-        assert len(model.op_call_times) >= 1
+        assert model.op_calls == 1
 
-    def test_op_runs_between_commands(self):
+    def test_commands_dispatched_in_order(self):
         model = MainLoopModel()
-        model.push_input('{"cmd":"a"}\n{"cmd":"b"}\n')
-
-        op_count = 0
-        for _ in range(100):
-            if model.tick():
-                op_count += 1
-        # op() should have run at least twice (once per command + idle ticks)
-        assert op_count >= 2
+        model.rx('{"cmd":"a"}\n{"cmd":"b"}\n')
+        model.tick()
         assert model.server_calls == ['{"cmd":"a"}', '{"cmd":"b"}']
+        assert model.queue_max == 2
 
+    def test_line_split_across_callbacks(self):
+        """USB packets need not end on a newline."""
+        model = MainLoopModel()
+        model.rx('{"cmd":')
+        model.tick()
+        model.rx('"split"}\n')
+        model.tick()
+        assert model.server_calls == ['{"cmd":"split"}']
 
-class TestAntiStarvation:
-    """Continuous input without newline triggers op() within the threshold."""
-
-    def test_op_forced_during_unterminated_flood(self):
-        """Simulate a flood of characters with no newline.
-
-        Without the MAX_READ_ONLY_US guard, op() would never run.
-        With it, op() must run within the threshold.
-
-        Uses a short threshold (5 ms) so the test completes quickly —
-        the algorithm is identical regardless of the threshold value.
-        """
-        threshold = 0.005  # 5 ms
-        model = MainLoopModel(max_read_only_s=threshold)
-        # Push a large block of data with no newline
-        model.push_input("x" * 100_000)
-
-        start = time.monotonic()
-        op_ran = False
-        for _ in range(100_000):
-            if model.tick():
-                op_ran = True
-                break
-
-        elapsed = time.monotonic() - start
-        assert op_ran, "op() was never called despite exceeding threshold"
-        # op() should have been forced within roughly the threshold window.
-        # Allow generous slack since Python timing is imprecise.
-        assert elapsed < threshold * 5, (
-            f"op() took {elapsed:.3f}s, expected within ~{threshold:.3f}s"
-        )
-
-    def test_buffer_preserved_across_forced_op(self):
-        """Partial command data must survive the forced op() call."""
-        model = MainLoopModel(max_read_only_s=0.005)
-        # Push partial command (no newline), enough to trigger forced op()
-        partial = '{"cmd":"hello'
-        padding = "x" * 100_000  # ensure we exceed the time threshold
-        model.push_input(partial + padding)
-
-        # Run until op() is forced (and beyond)
-        for _ in range(100_000):
-            model.tick()
-
-        assert len(model.op_call_times) >= 1, "op() should have been forced"
 
-        # Now complete the command
-        rest = '"}\n'
-        model.push_input(rest)
+class TestNoStarvation:
+    def test_unterminated_flood_never_delays_op(self):
+        """Bytes without a newline cost op() nothing."""
+        model = MainLoopModel()
         for _ in range(100):
+            model.rx("x" * 64)
             model.tick()
+        assert model.op_calls == 100
+        assert model.server_calls == []
 
-        # The full command should have been dispatched intact
-        assert len(model.server_calls) == 1
-        expected = partial + padding + rest.rstrip("\n")
-        assert model.server_calls[0] == expected
-
-    def test_op_called_multiple_times_during_long_flood(self):
-        """During a very long flood, op() should be called repeatedly."""
-        model = MainLoopModel(max_read_only_s=0.005)
-        model.push_input("x" * 100_000)
-
-        for _ in range(100_000):
+    def test_partial_command_preserved_across_passes(self):
+        model = MainLoopModel()
+        model.rx('{"cmd":"hel')
+        for _ in range(10):
             model.tick()
+        model.rx('lo"}\n')
+        model.tick()
+        assert model.server_calls == ['{"cmd":"hello"}']
 
-        # With 5ms threshold, we should get multiple op() calls
-        assert len(model.op_call_times) >= 2, (
-            f"Expected multiple op() calls, got {len(model.op_call_times)}"
-        )
-
-    def test_no_starvation_without_guard(self):
-        """Demonstrate that removing the guard DOES starve op().
+    def test_dispatch_capped_per_pass(self):
+        """A full queue is dispatched over one pass, then op() runs."""
+        model = MainLoopModel()
+        model.rx("{}\n" * CMD_RX_QUEUE_LEN)
+        assert model.tick() == CMD_RX_QUEUE_LEN
+        assert model.op_calls == 1
 
-        This is the "control" test: with max_read_only_s=infinity,
-        op() never runs during a flood.
-        """
-        model = MainLoopModel(max_read_only_s=float("inf"))
-        model.push_input("x" * 1_000)
 
-        for _ in range(1_000):
-            model.tick()
-
-        # With the guard disabled, op() should never have been called
-        # (all ticks returned False via continue)
-        assert len(model.op_call_times) == 0
+class TestOverflow:
+    def test_full_queue_holds_input_back(self):
+        """A burst longer than the queue arriving in one slow pass is
+        delivered in order, none of it dropped."""
+        model = MainLoopModel()
+        n = CMD_RX_QUEUE_LEN + 3
+        model.rx("".join(f'{{"n":{i}}}\n' for i in range(n)))
+        assert len(model.queue) == CMD_RX_QUEUE_LEN
+        assert model.fifo  # the rest waits in the CDC FIFO
+        model.tick()
+        model.tick()
+        assert model.server_calls == [f'{{"n":{i}}}' for i in range(n)]
+        assert model.overflow == 0
+        assert model.queue_max == CMD_RX_QUEUE_LEN
+
+    def test_overlong_line_truncated(self):
+        model = MainLoopModel()
+        model.rx("y" * (BUFFER_SIZE + 50) + "\n")
+        model.tick()
+        assert model.server_calls == ["y" * (BUFFER_SIZE - 1)]
+        assert model.overflow == 1
 
 
 class TestIdleBehavior:
-    """When no input arrives, op() runs every tick."""
+    """When no input arrives, op() runs every pass."""
 
     def test_op_runs_on_empty_input(self):
         model = MainLoopModel()
         for _ in range(10):
-            assert model.tick() is True
-        assert len(model.op_call_times) == 10
+            assert model.tick() == 0
+        assert model.op_calls == 10
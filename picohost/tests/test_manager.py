@@ -407,6 +407,18 @@ class TestReconnectHook:
         assert len(calls) == 1
         assert calls[0] == motor._delay_kwargs
 
+    def test_motor_on_reconnect_replays_ramp_profile(self, mgr):
+        motor = _attach(mgr, "motor", DummyPicoMotor)
+        assert motor._ramp_profile_kwargs is None
+        motor.set_ramp_profile(el="scurve")
+
+        calls = []
+        motor.set_ramp_profile = (  # type: ignore[method-assign]
+            lambda **kwargs: calls.append(kwargs)
+        )
+        motor.on_reconnect()
+        assert calls == [{"el": "scurve"}]
+
     def test_port_rediscovery_updates_port(self, mgr, monkeypatch):
         """When usb_serial maps to a new port, reconnect uses it."""
         import picohost.base as base_mod
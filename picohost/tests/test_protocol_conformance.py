@@ -12,6 +12,7 @@ import json
 
 import pytest
 
+from conftest import LinePeer, NullPeer
 from picohost.emulators import (
     MotorEmulator,
     TempCtrlEmulator,
@@ -20,6 +21,8 @@ from picohost.emulators import (
     PotMonEmulator,
     RFSwitchEmulator,
 )
+from picohost.emulators.base import CMD_POOL_BYTES, CMD_RX_QUEUE_LEN
+from picohost.emulators.motor import WAYPOINT_QUEUE_LEN
 from picohost.emulators.tempctrl import MAX_REJECTS
 
 # ---------------------------------------------------------------------------
@@ -38,16 +41,8 @@ class TestBaseProtocol:
         real JSONDecodeError path.
         """
 
-        class _NullPeer:
-            """Peer with nothing to read — lets _read_commands() reach the
-            buffer-processing loop without providing new data."""
-
-            @property
-            def in_waiting(self):
-                return 0
-
         emu = MotorEmulator()
-        emu.attach(_NullPeer())
+        emu.attach(NullPeer())
         emu.server({"az_set_target_pos": 500})
         initial_pos = emu.azimuth.target_pos
 
@@ -109,6 +104,133 @@ class TestBaseProtocol:
                         f"{type(emu).__name__}: {key} changed after empty cmd"
                     )
 
+    @pytest.mark.parametrize(
+        "Cls, lo",
+        [
+            (MotorEmulator, 50),
+            (TempCtrlEmulator, 200),
+            (PotMonEmulator, 50),
+            (ImuEmulator, 20),
+            (LidarEmulator, 20),
+            (RFSwitchEmulator, 100),
+        ],
+        ids=lambda v: getattr(v, "__name__", str(v)),
+    )
+    def test_cadence_ms_clamped_to_app_bounds(self, Cls, lo):
+        """main.c: {"cadence_ms":N} clamps to [CADENCE_MIN_MS_<app>,
+        CADENCE_MAX_MS] from pico_multi.h."""
+        kwargs = {"settle_ms": 0} if Cls is RFSwitchEmulator else {}
+        emu = Cls(**kwargs)
+        emu._universal_command({"cadence_ms": 1})
+        assert emu.status_cadence_ms == lo
+        emu._universal_command({"cadence_ms": 60000})
+        assert emu.status_cadence_ms == 5000
+        emu._universal_command({"cadence_ms": 250.7})
+        assert emu.status_cadence_ms == 250
+
+    def test_command_queue_holds_burst(self):
+        """cmd_rx.c: a burst longer than CMD_RX_QUEUE_LEN waits for the
+        next pass instead of being dropped; only an over-long line counts
+        in cmd_overflow. Every app reports cmd_queue_max / cmd_overflow."""
+
+        emu = MotorEmulator()
+        emu.attach(NullPeer())
+        burst = CMD_RX_QUEUE_LEN + 2
+        emu._cmd_buffer = "".join(
+            f'{{"az_set_target_pos": {i}}}\n' for i in range(burst)
+        )
+        emu._read_commands()
+        assert emu.azimuth.target_pos == CMD_RX_QUEUE_LEN - 1
+        emu._read_commands()
+        assert emu.azimuth.target_pos == burst - 1
+        status = emu.get_status()
+        assert status["cmd_queue_max"] == CMD_RX_QUEUE_LEN
+        assert status["cmd_overflow"] == 0
+        emu._cmd_buffer = '{"az_set_target_pos": 1}' + " " * 300 + "\n"
+        emu._read_commands()
+        assert emu.get_status()["cmd_overflow"] == 1
+
+    def test_command_pool_counted(self):
+        """cmd_pool.c: each parse takes one 40-byte node per value plus
+        its strings, 8-byte aligned; every app reports the high water,
+        and a tree too big for the arena is refused and counted."""
+
+        emu = MotorEmulator()
+        emu.attach(NullPeer())
+        # root + node with key "az_set_target_pos" (18 bytes -> 24)
+        emu._cmd_buffer = '{"az_set_target_pos": 5}\n'
+        emu._read_commands()
+        status = emu.get_status()
+        assert status["cmd_pool_max"] == 40 + 40 + 24
+        assert status["cmd_pool_fail"] == 0
+        assert emu.azimuth.target_pos == 5
+
+        big = {"az_set_target_pos": 7, "pad": [[]] * CMD_POOL_BYTES}
+        emu._cmd_buffer = json.dumps(big) + "\n"
+        emu._read_commands()
+        status = emu.get_status()
+        assert status["cmd_pool_max"] == CMD_POOL_BYTES
+        assert status["cmd_pool_fail"] == 1
+        assert emu.azimuth.target_pos == 5
+
+    def test_cadence_ms_non_number_ignored(self):
+        """cJSON_IsNumber gate: bools, strings and null leave it alone."""
+        emu = ImuEmulator()
+        emu._universal_command({"cadence_ms": 40})
+        for bad in (True, "20", None, [20]):
+            emu._universal_command({"cadence_ms": bad})
+            assert emu.status_cadence_ms == 40
+
+    def test_perf_record_on_request(self):
+        """main.c / loop_perf.c: {"cmd":"perf"} sends one "perf" record
+        with per-phase timing; "reset": true (only a JSON true) starts a
+        new window after it."""
+
+        def perf_records(peer):
+            return [r for r in peer.records() if r["sensor_name"] == "perf"]
+
+        emu = RFSwitchEmulator(settle_ms=0)
+        peer = LinePeer()
+        emu.attach(peer)
+        emu.step(5)
+        assert perf_records(peer) == []
+
+        emu._cmd_buffer = '{"cmd":"perf"}\n'
+        emu.step(1)
+        (rec,) = perf_records(peer)
+        assert rec["app_id"] == emu.app_id
+        assert rec["loop_n"] == 5
+        assert rec["op_n"] == 6
+        assert rec["dispatch_n"] == 1
+        assert rec["dispatch_capped"] == 0
+        assert rec["usb_stalls"] >= 0
+        assert rec["op_min_us"] <= rec["op_p99_us"] <= rec["op_max_us"]
+
+        emu._cmd_buffer = '{"cmd":"perf","reset":1}\n'
+        emu.step(1)
+        assert perf_records(peer)[-1]["loop_n"] == 6
+
+        emu._cmd_buffer = '{"cmd":"perf","reset":true}\n'
+        emu.step(1)
+        emu._cmd_buffer = '{"cmd":"perf"}\n'
+        emu.step(1)
+        rec = perf_records(peer)[-1]
+        assert rec["loop_n"] == 1
+        assert rec["dispatch_n"] == 1
+
+    def test_perf_counts_dispatch_cap(self):
+        """A pass that runs a full CMD_RX_QUEUE_LEN lines hit the cap."""
+
+        emu = MotorEmulator()
+        emu.attach(NullPeer())
+        emu._cmd_buffer = '{"az_set_target_pos": 1}\n' * CMD_RX_QUEUE_LEN
+        emu._read_commands()
+        emu._cmd_buffer = '{"az_set_target_pos": 1}\n'
+        emu._read_commands()
+        rep = emu.perf.report(emu.app_id)
+        assert rep["dispatch_capped"] == 1
+        assert rep["dispatch_n"] == 2
+
 
 # ---------------------------------------------------------------------------
 # Motor protocol (src/motor.c)
@@ -118,11 +240,23 @@ class TestBaseProtocol:
 class TestMotorProtocol:
     """Protocol conformance tests for APP_MOTOR (app_id=0).
 
-    Command processing order in motor_server():
+    Command processing order in motor_server(), whatever order the
+    line has the keys in:
       1. az_set_pos / el_set_pos  (resets both position and target)
       2. az_set_target_pos / el_set_target_pos  (overrides target only)
       3. halt  (sets target = current position for both axes)
       4. delay settings
+      5. az_ramp_profile / el_ramp_profile
+      6. wp_clear, then wp_add
+
+    Position, target and delay keys take numbers only (motor_keys);
+    anything else leaves the setting alone.
+
+    set_pos, set_target_pos and halt also clear the waypoint queue.
+
+    Steps 1-3 also flush the axis' queued steps in firmware, so the
+    reported position stops within one step period; the emulator has no
+    queue, so position is already final when server() returns.
     """
 
     def test_sensor_name(self):
@@ -145,6 +279,24 @@ class TestMotorProtocol:
         emu.server({"az_set_pos": 100, "az_set_target_pos": 200})
         assert emu.azimuth.position == 100
         assert emu.azimuth.target_pos == 200
+        emu.server({"az_set_target_pos": 300, "az_set_pos": 50})
+        assert emu.azimuth.position == 50
+        assert emu.azimuth.target_pos == 300
+
+    def test_numeric_keys_take_numbers_only(self):
+        emu = MotorEmulator()
+        emu.server({"az_set_pos": 10, "az_up_delay_us": 300})
+        for bad in (True, "5", None, [1]):
+            emu.server(
+                {
+                    "az_set_pos": bad,
+                    "az_set_target_pos": bad,
+                    "az_up_delay_us": bad,
+                }
+            )
+            assert emu.azimuth.position == 10
+            assert emu.azimuth.target_pos == 10
+            assert emu.azimuth.up_delay_us == 300
 
     def test_halt_checks_key_presence_not_value(self):
         """motor.c line 149: cJSON_GetObjectItem checks existence only."""
@@ -161,7 +313,11 @@ class TestMotorProtocol:
             assert emu.azimuth.target_pos == emu.azimuth.position
 
     def test_stepper_convergence(self):
-        """Motor moves max_pulses=60 steps per op() call toward target."""
+        """Emulator moves max_pulses=60 steps per op() call toward target.
+
+        Firmware emits steps from PIO rather than per op() call;
+        max_pulses is the emulator's stand-in for elapsed time.
+        """
         emu = MotorEmulator()
         emu.server({"az_set_target_pos": 120})
         emu.op()
@@ -182,6 +338,124 @@ class TestMotorProtocol:
         assert emu.azimuth.dir == -1
         assert emu.azimuth.steps_in_direction == 60  # reset and counted
 
+    def test_ramp_profile_default_linear(self):
+        """stepper_init() boots with RAMP_PROFILE (linear)."""
+        status = MotorEmulator().get_status()
+        assert status["az_ramp_profile"] == 0
+        assert status["el_ramp_profile"] == 0
+
+    def test_ramp_profile_per_axis(self):
+        emu = MotorEmulator()
+        emu.server({"az_ramp_profile": 1})
+        assert emu.get_status()["az_ramp_profile"] == 1
+        assert emu.get_status()["el_ramp_profile"] == 0
+        emu.server({"el_ramp_profile": 1.0, "az_ramp_profile": 0})
+        assert emu.get_status()["az_ramp_profile"] == 0
+        assert emu.get_status()["el_ramp_profile"] == 1
+
+    def test_ramp_profile_rejects_invalid(self):
+        """motor.c: cJSON_IsNumber and exact 0/1 only; else ignored."""
+        emu = MotorEmulator()
+        emu.server({"az_ramp_profile": 1})
+        for bad in (2, -1, 0.5, True, False, "0", None):
+            emu.server({"az_ramp_profile": bad})
+            assert emu.azimuth.ramp_profile == 1
+
+    def test_waypoints_run_in_order(self):
+        """waypoint_op() retargets both axes; wp_index tracks the active
+        waypoint and drops to -1 once the last one finishes."""
+        emu = MotorEmulator()
+        assert emu.get_status()["wp_index"] == -1
+        emu.server({"wp_add": [[100, 0], [100, 50], [0, 0]]})
+        assert emu.get_status()["wp_count"] == 3
+        seen = []
+        for _ in range(20):
+            emu.op()
+            s = emu.get_status()
+            seen.append((s["wp_index"], s["az_pos"], s["el_pos"]))
+        indices = [i for i, _, _ in seen]
+        active = indices[: indices.index(-1)]
+        assert active == sorted(active) and active[-1] == 2
+        assert set(indices[len(active) :]) == {-1}
+        assert (1, 100, 50) in seen
+        assert seen[-1] == (-1, 0, 0)
+
+    def test_waypoint_add_all_or_nothing(self):
+        """waypoint_add(): one bad entry rejects the whole list."""
+        emu = MotorEmulator()
+        for bad in (
+            [[1, 2], [3]],
+            [[1, 2], [3, 4, -1]],
+            [[1, True]],
+            [[1, "2"]],
+            [[1, 2, 3, 4]],
+            [1, 2],
+            {"az": 1},
+        ):
+            emu.server({"wp_add": bad})
+            assert emu.get_status()["wp_count"] == 0
+        assert emu.get_status()["wp_rejected"] == 7
+
+    def test_waypoint_queue_room(self):
+        """A list larger than the free queue space is rejected."""
+        emu = MotorEmulator()
+        emu.server({"wp_add": [[k, 0] for k in range(WAYPOINT_QUEUE_LEN)]})
+        assert emu.get_status()["wp_count"] == WAYPOINT_QUEUE_LEN
+        emu.server({"wp_add": [[0, 0]]})
+        status = emu.get_status()
+        assert status["wp_count"] == WAYPOINT_QUEUE_LEN
+        assert status["wp_rejected"] == 1
+        emu.op()  # first waypoint starts, freeing one slot
+        emu.server({"wp_add": [[0, 0]]})
+        status = emu.get_status()
+        assert status["wp_count"] == WAYPOINT_QUEUE_LEN + 1
+        assert status["wp_rejected"] == 1
+
+    def test_waypoint_clear_then_add_replaces(self):
+        emu = MotorEmulator()
+        emu.server({"wp_add": [[100, 0], [200, 0]]})
+        emu.server({"wp_clear": 0, "wp_add": [[-100, 0]]})
+        assert emu.get_status()["wp_count"] == 1
+        for _ in range(5):
+            emu.op()
+        assert emu.azimuth.position == -100
+
+    def test_manual_commands_clear_waypoints(self):
+        for cmd in (
+            {"halt": 0},
+            {"az_set_target_pos": 5},
+            {"el_set_target_pos": 5},
+            {"az_set_pos": 5},
+            {"el_set_pos": 5},
+        ):
+            emu = MotorEmulator()
+            emu.server({"wp_add": [[100, 0], [200, 0]]})
+            emu.op()
+            emu.server(cmd)
+            s = emu.get_status()
+            assert (s["wp_index"], s["wp_count"]) == (-1, 0), cmd
+
+    def test_waypoint_dwell_holds(self):
+        """A waypoint with dwell_ms stays active after arrival."""
+        emu = MotorEmulator()
+        emu.server({"wp_add": [[10, 0, 60000], [0, 0]]})
+        for _ in range(5):
+            emu.op()
+        s = emu.get_status()
+        assert (s["wp_index"], s["az_pos"]) == (0, 10)
+
+    def test_waypoint_blend_through_steps(self):
+        """Collinear single-axis points with no dwell blend: the moving
+        axis carries the distance to the next point as through_steps."""
+        emu = MotorEmulator()
+        emu.server({"wp_add": [[100, 0], [250, 0], [250, 10], [0, 10]]})
+        emu.op()
+        assert emu.wp_blend and emu.azimuth.through_steps == 150
+        while emu.get_status()["wp_index"] == 0:
+            emu.op()
+        # next point moves el instead: stop at 250
+        assert not emu.wp_blend and emu.azimuth.through_steps == 0
+
 
 # ---------------------------------------------------------------------------
 # TempCtrl protocol (src/tempctrl.c)
@@ -204,6 +478,9 @@ class TestTempCtrlProtocol:
         assert emu.lna.clamp == 0.2
         assert emu.lna.hysteresis == 0.5
         assert emu.lna.enabled is False
+        # TEMPCTRL_ADC_OVERSAMPLE / TEMPCTRL_ADC_MEDIAN
+        assert emu.lna.adc_oversample == 1024
+        assert emu.lna.adc_median is True
 
     def test_clamp_validation(self):
         """tempctrl.c line 77: fminf(1.0, fmaxf(0.0, val))."""
@@ -215,6 +492,34 @@ class TestTempCtrlProtocol:
         emu.server({"LNA_clamp": 0.5})
         assert emu.lna.clamp == 0.5
 
+    def test_adc_oversample_validation(self):
+        """adc_sampler_set_oversample: a multiple of 64 in 64..1024,
+        anything else (or a non-number) ignored; valueint truncates."""
+        emu = TempCtrlEmulator()
+        emu.server({"LNA_adc_oversample": 128})
+        assert emu.lna.adc_oversample == 128
+        for bad in (0, 100, 2048, -64, "256", True, None):
+            emu.server({"LNA_adc_oversample": bad})
+            assert emu.lna.adc_oversample == 128
+        emu.server({"LNA_adc_oversample": 256.7})
+        assert emu.lna.adc_oversample == 256
+        assert emu.load.adc_oversample == 1024
+        status = emu.get_status()
+        assert status["LNA_adc_oversample"] == 256
+        assert status["LOAD_adc_oversample"] == 1024
+
+    def test_adc_median_via_int(self):
+        """tempctrl.c: valueint ? true : false, like *_enable."""
+        emu = TempCtrlEmulator()
+        emu.server({"LOAD_adc_median": 0})
+        assert emu.load.adc_median is False
+        assert emu.get_status()["LOAD_adc_median"] is False
+        emu.server({"LOAD_adc_median": "true"})
+        assert emu.load.adc_median is False
+        emu.server({"LOAD_adc_median": 1})
+        assert emu.load.adc_median is True
+        assert emu.lna.adc_median is True
+
     def test_enable_via_int(self):
         """tempctrl.c line 73: valueint ? true : false."""
         emu = TempCtrlEmulator()
@@ -401,7 +706,7 @@ class TestTempCtrlProtocol:
 
     def test_uninstalled_channel_skips_sampling_and_drive(self):
         """tempctrl_update_sensor_drive: an uninstalled channel returns
-        before temp_sensor_read — its ADC input is never mux-selected
+        before temp_sensor_read — its ADC input is out of the round robin
         (the potmon crosstalk lesson) — and never drives: data_invalid
         every cycle, controller state reset, drive forced to 0."""
         emu = TempCtrlEmulator()
@@ -632,3 +937,54 @@ class TestRFSwitchProtocol:
         emu = RFSwitchEmulator(settle_ms=30)
         emu.server({"sw_state": 7})
         assert emu.get_status()["sw_state"] == emu.SW_STATE_UNKNOWN
+
+    def test_sequence_starts_at_once(self):
+        """rfswitch_seq_load() runs step 0 as the command lands."""
+        emu = RFSwitchEmulator(settle_ms=0)
+        emu.server({"sw_sequence": [[4, 50], [5, 50]], "sw_repeat": 2})
+        status = emu.get_status()
+        assert status["sw_state"] == 4
+        assert (status["seq_step"], status["seq_pass"]) == (0, 0)
+
+    def test_idle_sequence_fields(self):
+        status = RFSwitchEmulator(settle_ms=0).get_status()
+        assert (status["seq_step"], status["seq_pass"]) == (-1, -1)
+
+    @pytest.mark.parametrize(
+        "cmd",
+        [
+            {"sw_sequence": [[4, 50], [16, 50]]},  # unburned address
+            {"sw_sequence": [[4, 50], [5, 30]]},  # dwell < 2 x settle
+            {"sw_sequence": [[4, 50], [5, 3_600_001]]},  # dwell > 1 h
+            {"sw_sequence": [[4, 50], [5]]},  # no dwell
+            {"sw_sequence": [[4, 50], [5, True]]},  # bool dwell
+            {"sw_sequence": [[4, 50]] * 17},  # > RFSWITCH_SEQ_LEN
+            {"sw_sequence": {"4": 50}},  # not a list
+            {"sw_sequence": [[4, 50]], "sw_repeat": -1},
+            {"sw_sequence": [[4, 50]], "sw_repeat": 1.5},
+        ],
+    )
+    def test_malformed_sequence_rejected_whole(self, cmd):
+        """All or nothing, like wp_add: nothing runs, nothing moves."""
+        emu = RFSwitchEmulator(settle_ms=0)
+        emu.server({"sw_state": 3})
+        emu.server(cmd)
+        status = emu.get_status()
+        assert status["sw_state"] == 3
+        assert status["seq_step"] == -1
+
+    def test_empty_sequence_stops(self):
+        emu = RFSwitchEmulator(settle_ms=0)
+        emu.server({"sw_sequence": [[4, 50], [5, 50]], "sw_repeat": 0})
+        emu.server({"sw_sequence": []})
+        status = emu.get_status()
+        assert status["seq_step"] == -1
+        assert status["sw_state"] == 4
+
+    def test_manual_switch_stops_sequence(self):
+        emu = RFSwitchEmulator(settle_ms=0)
+        emu.server({"sw_sequence": [[4, 50], [5, 50]], "sw_repeat": 0})
+        emu.server({"sw_state": 9})
+        status = emu.get_status()
+        assert status["seq_step"] == -1
+        assert status["sw_state"] == 9
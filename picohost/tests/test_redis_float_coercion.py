@@ -14,9 +14,7 @@ the fix are pinned here:
    types satisfy the consumer metadata schemas regardless of value.
 """
 
-import json
-
-from conftest import wait_for_condition
+from conftest import LinePeer, wait_for_condition
 
 from picohost.base import redis_handler
 from picohost.emulators.base import PicoEmulator
@@ -68,20 +66,13 @@ class _QuietPotentiometer(DummyPicoPotentiometer):
 # --- 1. Emulator serialization matches cJSON print_number ---
 
 
-class _FakePeer:
-    def __init__(self):
-        self.chunks = []
-
-    def write(self, data):
-        self.chunks.append(data)
-
-
 def _emit(payload):
     emu = PicoEmulator()
-    peer = _FakePeer()
+    peer = LinePeer()
     emu.attach(peer)
     emu._write_json(payload)
-    return json.loads(b"".join(peer.chunks).decode())
+    (parsed,) = peer.records()
+    return parsed
 
 
 class TestEmulatorCJSONNumbers:
@@ -254,6 +245,12 @@ class TestDeviceHandlersCoerce:
                     "accel_x": 0,
                     "accel_y": 0,
                     "accel_z": 1,
+                    "rx_dropped": 0,
+                    "rvc_checksum_fail": 0,
+                    "rvc_rate_hz": 100,
+                    "n_samples": 20,
+                    "yaw_mean": 0,
+                    "accel_z_var": None,
                 }
             )
         finally:
@@ -262,7 +259,12 @@ class TestDeviceHandlersCoerce:
         assert name == "imu_el"
         for key in ("yaw", "pitch", "roll", "accel_x", "accel_y", "accel_z"):
             assert isinstance(data[key], float), key
+        assert isinstance(data["rvc_rate_hz"], float)
         assert isinstance(data["app_id"], int)
+        assert isinstance(data["rx_dropped"], int)
+        assert isinstance(data["yaw_mean"], float)
+        assert data["accel_z_var"] is None
+        assert isinstance(data["n_samples"], int)
 
     def test_lidar_and_system_current_publish_floats(self):
         writer = FakeMetadataWriter()
@@ -0,0 +1,278 @@
+#include "adc_sampler.h"
+#include <math.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+#define ADC_CLK_HZ      48000000.0f
+#define MAX_BLOCK_LEN   (ADC_SAMPLER_INPUTS * ADC_SAMPLER_BLOCK)
+
+/* DMA targets; channel i always writes blocks[i]. */
+static uint16_t blocks[2][MAX_BLOCK_LEN];
+static int dma_chan[2] = { -1, -1 };
+
+static uint32_t input_mask;             // active inputs, in the round robin
+static uint8_t order[ADC_SAMPLER_INPUTS];   // round-robin order, lowest first
+static uint n_inputs;
+static uint block_len;
+static bool skip_block;
+
+/* Per-input filter. The ring holds the last ADC_SAMPLER_MAX_BLOCKS block
+ * sums, `next` being the slot the next one goes in, and `total` the sum
+ * of the newest min(filled, window) of them. Only the IRQ touches it, or
+ * a setter with interrupts off, or a restart with the stream stopped. */
+typedef struct {
+    uint32_t sums[ADC_SAMPLER_MAX_BLOCKS];
+    uint32_t total;
+    uint next;
+    uint filled;
+    uint window;            // blocks per reading, 1..ADC_SAMPLER_MAX_BLOCKS
+    bool median;
+} input_filter_t;
+
+static input_filter_t filters[ADC_SAMPLER_INPUTS];
+static uint32_t added_mask;             // inputs an app has added
+
+static volatile float volts[ADC_SAMPLER_INPUTS] = { NAN, NAN, NAN, NAN };
+
+static void filter_reset(input_filter_t *f)
+{
+    memset(f->sums, 0, sizeof(f->sums));
+    f->total = 0;
+    f->next = 0;
+    f->filled = 0;
+}
+
+static uint filter_count(const input_filter_t *f)
+{
+    return f->filled < f->window ? f->filled : f->window;
+}
+
+// Slot of the block `age` blocks before the newest (age 0 = newest).
+static uint filter_slot(const input_filter_t *f, uint age)
+{
+    return (f->next + 2u * ADC_SAMPLER_MAX_BLOCKS - 1u - age)
+        % ADC_SAMPLER_MAX_BLOCKS;
+}
+
+static float filter_median(const input_filter_t *f, uint n)
+{
+    // Insertion sort of at most ADC_SAMPLER_MAX_BLOCKS sums: a few
+    // hundred cycles, once per block.
+    uint32_t s[ADC_SAMPLER_MAX_BLOCKS];
+    for (uint a = 0; a < n; a++) {
+        uint32_t v = f->sums[filter_slot(f, a)];
+        uint j = a;
+        for (; j > 0 && s[j - 1] > v; j--) {
+            s[j] = s[j - 1];
+        }
+        s[j] = v;
+    }
+    if (n & 1u) {
+        return (float)s[n / 2];
+    }
+    return 0.5f * ((float)s[n / 2 - 1] + (float)s[n / 2]);
+}
+
+static void filter_push(uint in, uint32_t sum)
+{
+    input_filter_t *f = &filters[in];
+    if (f->filled >= f->window) {
+        // The block leaving the window; with a full-length window that
+        // is the slot about to be overwritten.
+        f->total -= f->sums[(f->next + ADC_SAMPLER_MAX_BLOCKS - f->window)
+                            % ADC_SAMPLER_MAX_BLOCKS];
+    }
+    f->sums[f->next] = sum;
+    f->total += sum;
+    f->next = (f->next + 1) % ADC_SAMPLER_MAX_BLOCKS;
+    if (f->filled < ADC_SAMPLER_MAX_BLOCKS) {
+        f->filled++;
+    }
+
+    const float per_count = ADC_SAMPLER_VREF
+        / (ADC_SAMPLER_MAX_COUNTS * (float)ADC_SAMPLER_BLOCK);
+    uint n = filter_count(f);
+    if (f->median) {
+        volts[in] = filter_median(f, n) * per_count;
+    } else {
+        volts[in] = (float)f->total * per_count / (float)n;
+    }
+}
+
+static void block_done(const uint16_t *block)
+{
+    if (skip_block) {
+        skip_block = false;
+        return;
+    }
+    uint32_t sum[ADC_SAMPLER_INPUTS] = { 0 };
+    for (uint i = 0; i < block_len; i += n_inputs) {
+        for (uint k = 0; k < n_inputs; k++) {
+            sum[k] += block[i + k] & 0xfffu;
+        }
+    }
+    for (uint k = 0; k < n_inputs; k++) {
+        filter_push(order[k], sum[k]);
+    }
+}
+
+static void adc_sampler_irq(void)
+{
+    for (uint i = 0; i < 2; i++) {
+        uint ch = (uint)dma_chan[i];
+        if (!dma_channel_get_irq0_status(ch)) {
+            continue;
+        }
+        dma_channel_acknowledge_irq0(ch);
+        // Re-arm for when the other channel chains back here; its block
+        // takes over a millisecond, so this is never late.
+        dma_channel_set_write_addr(ch, blocks[i], false);
+        block_done(blocks[i]);
+    }
+}
+
+static void adc_sampler_start(void)
+{
+    if (dma_chan[0] < 0) {
+        adc_init();
+        dma_chan[0] = dma_claim_unused_channel(true);
+        dma_chan[1] = dma_claim_unused_channel(true);
+        irq_set_exclusive_handler(DMA_IRQ_0, adc_sampler_irq);
+        irq_set_enabled(DMA_IRQ_0, true);
+    } else {
+        adc_run(false);
+        for (uint i = 0; i < 2; i++) {
+            dma_channel_set_irq0_enabled((uint)dma_chan[i], false);
+            dma_channel_abort((uint)dma_chan[i]);
+            dma_channel_acknowledge_irq0((uint)dma_chan[i]);
+        }
+        adc_fifo_drain();
+    }
+
+    // Inputs staying in the round robin keep their filters: a restart
+    // only loses the few ms the stream was stopped.
+    n_inputs = 0;
+    for (uint in = 0; in < ADC_SAMPLER_INPUTS; in++) {
+        if (input_mask & (1u << in)) {
+            order[n_inputs++] = (uint8_t)in;
+        } else {
+            filter_reset(&filters[in]);
+            volts[in] = NAN;
+        }
+    }
+    block_len = n_inputs * ADC_SAMPLER_BLOCK;
+    skip_block = true;
+    if (n_inputs == 0) {
+        return;
+    }
+
+    // Round robin advances from the selected input to the next enabled
+    // one, so starting at the lowest keeps sample k on order[k % n].
+    adc_set_round_robin(input_mask);
+    adc_select_input(order[0]);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv(ADC_CLK_HZ / (float)ADC_SAMPLER_RATE_HZ - 1.0f);
+
+    for (uint i = 0; i < 2; i++) {
+        uint ch = (uint)dma_chan[i];
+        dma_channel_config cfg = dma_channel_get_default_config(ch);
+        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+        channel_config_set_read_increment(&cfg, false);
+        channel_config_set_write_increment(&cfg, true);
+        channel_config_set_dreq(&cfg, DREQ_ADC);
+        channel_config_set_chain_to(&cfg, (uint)dma_chan[i ^ 1]);
+        dma_channel_configure(ch, &cfg, blocks[i], &adc_hw->fifo,
+                              block_len, false);
+        dma_channel_set_irq0_enabled(ch, true);
+    }
+    dma_channel_start((uint)dma_chan[0]);
+    adc_run(true);
+}
+
+bool adc_sampler_add_gpio(uint gpio_pin, uint *adc_input)
+{
+    if (gpio_pin < 26 || gpio_pin > 29) {
+        return false;
+    }
+    *adc_input = gpio_pin - 26;
+    if (added_mask & (1u << *adc_input)) {
+        return true;
+    }
+    adc_gpio_init(gpio_pin);
+    added_mask |= 1u << *adc_input;
+    if (filters[*adc_input].window == 0) {
+        filters[*adc_input].window = ADC_SAMPLER_AVG_BLOCKS;
+    }
+    input_mask |= 1u << *adc_input;
+    adc_sampler_start();
+    return true;
+}
+
+void adc_sampler_set_active(uint adc_input, bool active)
+{
+    if (adc_input >= ADC_SAMPLER_INPUTS
+        || !(added_mask & (1u << adc_input))) {
+        return;
+    }
+    uint32_t mask = active ? input_mask | (1u << adc_input)
+                           : input_mask & ~(1u << adc_input);
+    if (mask != input_mask) {
+        input_mask = mask;
+        adc_sampler_start();
+    }
+}
+
+bool adc_sampler_set_oversample(uint adc_input, int samples)
+{
+    if (adc_input >= ADC_SAMPLER_INPUTS || samples < ADC_SAMPLER_BLOCK
+        || samples > ADC_SAMPLER_MAX_BLOCKS * ADC_SAMPLER_BLOCK
+        || samples % ADC_SAMPLER_BLOCK != 0) {
+        return false;
+    }
+    input_filter_t *f = &filters[adc_input];
+    uint32_t irq = save_and_disable_interrupts();
+    f->window = (uint)samples / ADC_SAMPLER_BLOCK;
+    uint n = filter_count(f);
+    f->total = 0;
+    for (uint a = 0; a < n; a++) {
+        f->total += f->sums[filter_slot(f, a)];
+    }
+    restore_interrupts(irq);
+    return true;
+}
+
+int adc_sampler_oversample(uint adc_input)
+{
+    if (adc_input >= ADC_SAMPLER_INPUTS) {
+        return 0;
+    }
+    uint window = filters[adc_input].window;
+    if (window == 0) {
+        window = ADC_SAMPLER_AVG_BLOCKS;
+    }
+    return (int)(window * ADC_SAMPLER_BLOCK);
+}
+
+void adc_sampler_set_median(uint adc_input, bool median)
+{
+    if (adc_input < ADC_SAMPLER_INPUTS) {
+        filters[adc_input].median = median;
+    }
+}
+
+bool adc_sampler_median(uint adc_input)
+{
+    return adc_input < ADC_SAMPLER_INPUTS && filters[adc_input].median;
+}
+
+float adc_sampler_voltage(uint adc_input)
+{
+    if (adc_input >= ADC_SAMPLER_INPUTS) {
+        return NAN;
+    }
+    return volts[adc_input];
+}
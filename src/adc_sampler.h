@@ -0,0 +1,58 @@
+#ifndef ADC_SAMPLER_H
+#define ADC_SAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/types.h"
+
+/* Shared ADC service. The ADC runs free in round-robin over every active
+ * input an app has added, and two DMA channels ping-pong its FIFO into
+ * two blocks of ADC_SAMPLER_BLOCK samples per input. The DMA IRQ sums
+ * each finished block per input (a first boxcar stage, decimating by
+ * ADC_SAMPLER_BLOCK) and keeps the last ADC_SAMPLER_MAX_BLOCKS block sums
+ * per input. A reading combines the newest `window` of them, as a mean
+ * (a second boxcar) or, with median on, as the median block mean, which
+ * drops a burst of crosstalk the mean would smear into the reading. The
+ * IRQ keeps each reading current, so taking one costs no conversions.
+ *
+ * Mux settling is handled once, here: round robin moves the mux as each
+ * conversion ends and the clock divider leaves ~20 us before the next
+ * one starts, which is the settle time the blocking loops bought by
+ * discarding a conversion per read. The first block after the stream
+ * (re)starts is still thrown away, for whatever sat in the FIFO.
+ *
+ * The IRQ runs on the core that added the first input (the app core);
+ * call the setters below from that core too. */
+#define ADC_SAMPLER_INPUTS      4       // ADC0..3 = GP26..GP29
+#define ADC_SAMPLER_RATE_HZ     48000   // conversions/s, shared by the inputs
+#define ADC_SAMPLER_BLOCK       64      // samples per input per DMA block
+#define ADC_SAMPLER_MAX_BLOCKS  16      // longest window: 1024 samples
+#define ADC_SAMPLER_AVG_BLOCKS  4       // default window: 256 samples, mean
+#define ADC_SAMPLER_VREF        3.3f
+#define ADC_SAMPLER_MAX_COUNTS  4095.0f
+
+/* Validate an ADC-capable pin (GPIO 26-29), map it to its ADC input,
+ * set the pin up and add the input to the round robin, (re)starting the
+ * stream. Meant for app init. Other inputs keep their readings. */
+bool adc_sampler_add_gpio(uint gpio_pin, uint *adc_input);
+
+/* Take an added input out of the round robin (its reading goes NAN and
+ * the mux never visits it) or put it back, restarting the stream. */
+void adc_sampler_set_active(uint adc_input, bool active);
+
+/* Oversampling of an input: samples per reading, a multiple of
+ * ADC_SAMPLER_BLOCK up to ADC_SAMPLER_MAX_BLOCKS * ADC_SAMPLER_BLOCK.
+ * Returns false, changing nothing, for any other value. A longer window
+ * takes effect as soon as enough blocks are in. */
+bool adc_sampler_set_oversample(uint adc_input, int samples);
+int adc_sampler_oversample(uint adc_input);
+/* Median of the window's block means instead of their mean. */
+void adc_sampler_set_median(uint adc_input, bool median);
+bool adc_sampler_median(uint adc_input);
+
+/* Pin voltage of an added input, in volts, filtered as configured; NAN
+ * before its first block has arrived (a few ms after it joined the
+ * round robin) or for an input never added or inactive. */
+float adc_sampler_voltage(uint adc_input);
+
+#endif // ADC_SAMPLER_H
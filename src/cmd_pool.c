@@ -0,0 +1,99 @@
+#include "cmd_pool.h"
+#include "pico/sync.h"
+
+typedef struct {
+    _Alignas(CMD_POOL_ALIGN) uint8_t mem[CMD_POOL_BYTES];
+    uint32_t used;          // core 0, while parsing
+    volatile bool busy;     // set by core 0, cleared by core 1
+} cmd_arena_t;
+
+static cmd_arena_t arenas[CMD_POOL_ARENAS];
+static cmd_arena_t *parsing;    // the arena cJSON allocates from, or NULL
+
+static volatile uint32_t pool_max;
+static volatile uint32_t pool_failures;
+static bool ran_out;
+
+static void *cmd_pool_alloc(size_t size)
+{
+    if (parsing == NULL) {
+        return NULL;
+    }
+    size_t n = (size + CMD_POOL_ALIGN - 1) & ~(size_t)(CMD_POOL_ALIGN - 1);
+    if (n > CMD_POOL_BYTES - parsing->used) {
+        ran_out = true;
+        return NULL;
+    }
+    void *p = &parsing->mem[parsing->used];
+    parsing->used += (uint32_t)n;
+    return p;
+}
+
+static void cmd_pool_free(void *p)
+{
+    (void)p;    // the arena goes back whole in cmd_pool_release()
+}
+
+void cmd_pool_init(void)
+{
+    cJSON_Hooks hooks = { cmd_pool_alloc, cmd_pool_free };
+    cJSON_InitHooks(&hooks);
+}
+
+cJSON *cmd_pool_parse(const char *line)
+{
+    cmd_arena_t *a = NULL;
+    for (size_t i = 0; i < CMD_POOL_ARENAS; i++) {
+        if (!arenas[i].busy) {
+            a = &arenas[i];
+            break;
+        }
+    }
+    if (a == NULL) {
+        // Cannot happen with CMD_POOL_ARENAS sized as in cmd_pool.h.
+        pool_failures++;
+        return NULL;
+    }
+    __mem_fence_acquire();
+    a->used = 0;
+    ran_out = false;
+    parsing = a;
+    cJSON *root = cJSON_Parse(line);
+    parsing = NULL;
+    if (a->used > pool_max) {
+        pool_max = a->used;
+    }
+    if (ran_out) {
+        pool_failures++;
+    }
+    if (root == NULL) {
+        return NULL;
+    }
+    a->busy = true;
+    return root;
+}
+
+void cmd_pool_release(cJSON *root)
+{
+    if (root == NULL) {
+        return;
+    }
+    // The root is the first allocation in its arena.
+    for (size_t i = 0; i < CMD_POOL_ARENAS; i++) {
+        if ((uint8_t *)root == arenas[i].mem) {
+            __mem_fence_release();
+            arenas[i].busy = false;
+            return;
+        }
+    }
+}
+
+uint32_t cmd_pool_max(void)
+{
+    return pool_max;
+}
+
+uint32_t cmd_pool_failures(void)
+{
+    return pool_failures;
+}
@@ -0,0 +1,57 @@
+#ifndef CMD_POOL_H
+#define CMD_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "eigsep_command.h"
+#include "cJSON.h"
+#include "pico_multi.h"
+#if PICO_MULTI_DUAL_CORE
+#include "core_link.h"
+#endif
+
+/* Fixed arenas for the command parse trees, in place of the heap.
+ * cmd_pool_init() points cJSON's allocator hooks here. cmd_pool_parse()
+ * takes a free arena, parses a line into it by bumping an offset, and
+ * cmd_pool_release() hands the arena back whole; cJSON's free is a
+ * no-op. Nothing is ever freed piecemeal, so the heap cannot fragment
+ * however long the board runs, and a parse costs the same every time.
+ *
+ * An arena holds the worst case for a line of BUFFER_SIZE - 1 bytes:
+ * every cJSON node takes at least two bytes of the line (a value and a
+ * separator or bracket), and each has at most two strings (key and
+ * value), whose text comes from the line. A parse that still runs out
+ * fails as if the line were not JSON, and is counted.
+ *
+ * The single-core build parses and applies a line before the next, so
+ * it needs one arena. The dual-core build has up to CORE_LINK_CMD_LEN
+ * trees in the mailbox, one more being applied on core 1, and parses
+ * on core 0 only while the mailbox has room, so CORE_LINK_CMD_LEN + 1
+ * arenas never run short. Core 0 claims an arena and core 1 releases
+ * it, each behind a fence, so neither takes a lock. Only main.c parses
+ * commands; status output (send_json()) does not go through cJSON. */
+#define CMD_POOL_ALIGN  8u
+#define CMD_POOL_NODE   \
+    ((sizeof(cJSON) + CMD_POOL_ALIGN - 1) & ~(size_t)(CMD_POOL_ALIGN - 1))
+#define CMD_POOL_BYTES  \
+    ((BUFFER_SIZE / 2) * (CMD_POOL_NODE + 2 * CMD_POOL_ALIGN) + BUFFER_SIZE)
+#if PICO_MULTI_DUAL_CORE
+#define CMD_POOL_ARENAS (CORE_LINK_CMD_LEN + 1)
+#else
+#define CMD_POOL_ARENAS 1
+#endif
+
+void cmd_pool_init(void);
+
+/* Parse `line` into a free arena (core 0). NULL if the line is not
+ * JSON, or its arena ran out (counted), in which case nothing is held. */
+cJSON *cmd_pool_parse(const char *line);
+
+/* Done with a tree from cmd_pool_parse() (core 1 in the dual-core
+ * build); NULL is ignored. */
+void cmd_pool_release(cJSON *root);
+
+uint32_t cmd_pool_max(void);        // high-water bytes of one parse
+uint32_t cmd_pool_failures(void);   // parses that ran out of arena
+
+#endif
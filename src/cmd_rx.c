@@ -0,0 +1,112 @@
+#include "cmd_rx.h"
+#include "pico/stdlib.h"
+#include "pico/sync.h"
+
+/* Single producer (the chars-available callback) and single consumer
+ * (the main loop): the producer only advances q_head, the consumer only
+ * q_tail, each after its slot access, with a fence in between. */
+static char q_lines[CMD_RX_QUEUE_LEN][BUFFER_SIZE];
+static volatile uint32_t q_head;
+static volatile uint32_t q_tail;
+
+/* Line being assembled; only touched from the callback. */
+static char rx_line[BUFFER_SIZE];
+static uint32_t rx_len;
+
+static bool rx_truncated;
+
+static volatile uint32_t queue_max;
+static volatile uint32_t overflow;
+
+/* Set when a drain stopped on a full queue with bytes still in the CDC
+ * FIFO; cmd_rx_pop() resumes it once a slot is free. */
+static volatile bool rx_stalled;
+
+/* Only called with a free slot. */
+static void rx_push_line(void)
+{
+    uint32_t depth = q_head - q_tail;
+    char *slot = q_lines[q_head % CMD_RX_QUEUE_LEN];
+    memcpy(slot, rx_line, rx_len);
+    slot[rx_len] = '\0';
+    __mem_fence_release();
+    q_head++;
+    if (depth + 1 > queue_max) {
+        queue_max = depth + 1;
+    }
+}
+
+/* Move bytes from the CDC FIFO into lines until it is empty or the
+ * queue is full. On a full queue the rest stays in the FIFO, and once
+ * that fills USB NAKs the host, so a burst longer than the queue is held
+ * back rather than dropped. Runs in the callback, or from cmd_rx_pop()
+ * with interrupts off, so never concurrently with itself. */
+static void rx_drain(void)
+{
+    while (true) {
+        if (q_head - q_tail >= CMD_RX_QUEUE_LEN) {
+            rx_stalled = true;
+            return;
+        }
+        int c = getchar_timeout_us(0);
+        if (c < 0) {
+            rx_stalled = false;
+            return;
+        }
+        if (c == '\n') {
+            if (rx_truncated) {
+                overflow++;
+                rx_truncated = false;
+            }
+            rx_push_line();
+            rx_len = 0;
+        } else if (rx_len < BUFFER_SIZE - 1) {
+            rx_line[rx_len++] = (char)c;
+        } else {
+            rx_truncated = true;
+        }
+    }
+}
+
+/* Called by stdio_usb after each USB task run that leaves bytes in the
+ * CDC FIFO, so whatever this misses (the stdio mutex was held) is picked
+ * up on the next run. */
+static void rx_chars_available(void *param)
+{
+    (void)param;
+    rx_drain();
+}
+
+void cmd_rx_init(void)
+{
+    stdio_set_chars_available_callback(rx_chars_available, NULL);
+}
+
+bool cmd_rx_pop(char line[BUFFER_SIZE])
+{
+    if (q_tail == q_head) {
+        return false;
+    }
+    __mem_fence_acquire();
+    memcpy(line, q_lines[q_tail % CMD_RX_QUEUE_LEN], BUFFER_SIZE);
+    __mem_fence_release();
+    q_tail++;
+    if (rx_stalled) {
+        /* Resume now rather than at the next USB task run. The callback
+           runs in an IRQ on this core, so masking keeps it out. */
+        uint32_t irq = save_and_disable_interrupts();
+        rx_drain();
+        restore_interrupts(irq);
+    }
+    return true;
+}
+
+uint32_t cmd_rx_queue_max(void)
+{
+    return queue_max;
+}
+
+uint32_t cmd_rx_overflow(void)
+{
+    return overflow;
+}
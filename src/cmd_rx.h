@@ -0,0 +1,33 @@
+#ifndef CMD_RX_H
+#define CMD_RX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "eigsep_command.h"
+#include "cmd_pool.h"
+
+/* USB command receiver. The stdio chars-available callback (USB IRQ
+ * context) drains the CDC FIFO, assembles lines and queues complete
+ * ones; the main loop pops them with cmd_rx_pop(). While the queue is
+ * full the callback leaves bytes in the CDC FIFO, so USB flow control
+ * holds the host off as the polled loop did, and cmd_rx_pop() resumes
+ * the drain. Lines longer than BUFFER_SIZE - 1 bytes are truncated, as
+ * the polled loop did, and counted. */
+#define CMD_RX_QUEUE_LEN 16
+
+void cmd_rx_init(void);
+bool cmd_rx_pop(char line[BUFFER_SIZE]);
+
+uint32_t cmd_rx_queue_max(void);   // high-water queue depth since boot
+uint32_t cmd_rx_overflow(void);    // lines truncated to BUFFER_SIZE - 1
+
+/* Appended to every app's *_status() packet, with the command parse
+ * pool's high-water bytes and failed parses (cmd_pool.h). */
+#define CMD_RX_STATUS_FIELDS 4
+#define CMD_RX_STATUS                                       \
+    KV_INT, "cmd_queue_max", (int)cmd_rx_queue_max(),       \
+    KV_INT, "cmd_overflow",  (int)cmd_rx_overflow(),        \
+    KV_INT, "cmd_pool_max",  (int)cmd_pool_max(),           \
+    KV_INT, "cmd_pool_fail", (int)cmd_pool_failures()
+
+#endif
@@ -0,0 +1,88 @@
+#include "cmd_table.h"
+#include <string.h>
+
+static const CmdKey *cmd_table_find(const CmdKey *table, size_t len,
+                                    const char *key) {
+    size_t lo = 0, hi = len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int c = strcmp(key, table[mid].key);
+        if (c == 0) {
+            return &table[mid];
+        }
+        if (c < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+// The value to set for `item`, or false to leave the setting alone.
+static bool cmd_table_value(const CmdKey *k, const cJSON *item,
+                            double *value) {
+    double v;
+    switch (k->type) {
+        case CMD_BOOL:
+            *value = (cJSON_IsTrue(item) ||
+                      (cJSON_IsNumber(item) && item->valueint != 0)) ? 1 : 0;
+            return true;
+        case CMD_INT:
+            if (!cJSON_IsNumber(item)) {
+                return false;
+            }
+            v = (double)item->valueint;
+            break;
+        case CMD_FLOAT:
+            if (!cJSON_IsNumber(item)) {
+                return false;
+            }
+            v = item->valuedouble;
+            break;
+        case CMD_ENUM:
+            // In range first, so the cast below is defined.
+            v = item->valuedouble;
+            if (!cJSON_IsNumber(item) || !(v >= k->lo && v <= k->hi) ||
+                v != (double)(long long)v) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+    if (!(v >= k->lo && v <= k->hi)) {
+        if (k->range == CMD_REJECT || v != v) {
+            return false;
+        }
+        v = v < k->lo ? k->lo : k->hi;
+    }
+    *value = v;
+    return true;
+}
+
+int cmd_table_dispatch(const CmdKey *table, size_t len, const cJSON *root) {
+    int applied = 0;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, root) {
+        if (item->string == NULL) {
+            continue;
+        }
+        const CmdKey *k = cmd_table_find(table, len, item->string);
+        double value;
+        if (k && cmd_table_value(k, item, &value)) {
+            k->set(k->ctx, value);
+            applied++;
+        }
+    }
+    return applied;
+}
+
+bool cmd_table_sorted(const CmdKey *table, size_t len) {
+    for (size_t i = 1; i < len; i++) {
+        if (strcmp(table[i - 1].key, table[i].key) >= 0) {
+            return false;
+        }
+    }
+    return true;
+}
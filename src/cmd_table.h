@@ -0,0 +1,61 @@
+#ifndef CMD_TABLE_H
+#define CMD_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "cJSON.h"
+
+/* Key -> setter dispatch for an app's command keys. main.c parses each
+ * command line once and hands the tree to the app's *_server(), which
+ * passes it here with a const table of its keys. The dispatcher walks
+ * the keys present in the line, finds each by binary search (the table
+ * is sorted by strcmp() of its keys; host/test_cmd_table.c checks the
+ * apps' tables), checks the value's type and range, and calls the
+ * entry's setter. A line costs one parse plus a lookup per key in it,
+ * however many keys the app knows. Keys not in the table (the universal
+ * ones main.c handles, say) are skipped. Free of pico-sdk headers so
+ * the host tests build it. */
+
+typedef enum {
+    CMD_BOOL,   // true/false or a number, non-zero being true
+    CMD_INT,    // a number, truncated like cJSON's valueint
+    CMD_FLOAT,  // a number
+    CMD_ENUM,   // a whole number in [lo, hi] (a mode, an address), exactly
+} CmdType;
+
+/* What CMD_INT and CMD_FLOAT do with a value outside [lo, hi]. CMD_ENUM
+ * always rejects: neither a fraction nor an out-of-range value is
+ * rounded to a valid one. */
+typedef enum {
+    CMD_CLAMP,  // set the nearest limit
+    CMD_REJECT, // leave the setting alone
+} CmdRange;
+
+typedef struct {
+    const char *key;
+    CmdType type;
+    CmdRange range;
+    double lo, hi;
+    // Called with the checked value (0 or 1 for CMD_BOOL, integral for
+    // CMD_INT and CMD_ENUM) and the entry's ctx, e.g. the channel the
+    // key belongs to.
+    void (*set)(void *ctx, double value);
+    void *ctx;
+} CmdKey;
+
+#define CMD_TABLE_LEN(t) (sizeof(t) / sizeof((t)[0]))
+
+/* Apply the keys of `root` found in `table`, in the order the line has
+ * them. Any value of a CMD_BOOL key other than a bool or number reads
+ * as false, as cJSON's valueint does, so {"LNA_enable":"false"} still
+ * turns a channel off. A CMD_BOOL key whose setter ignores the value
+ * thus acts on the key's presence alone. A CMD_INT, CMD_FLOAT or
+ * CMD_ENUM key with anything but a number is ignored. Returns the
+ * number of keys applied. */
+int cmd_table_dispatch(const CmdKey *table, size_t len, const cJSON *root);
+
+/* True if the keys are sorted and unique, as cmd_table_dispatch()
+ * needs. */
+bool cmd_table_sorted(const CmdKey *table, size_t len);
+
+#endif // CMD_TABLE_H
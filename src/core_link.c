@@ -0,0 +1,100 @@
+#include "core_link.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/sync.h"
+
+/* Each ring index is written by one core only and advanced after its slot
+ * access, with a fence in between (as in cmd_rx.c). */
+static cJSON *cmd_roots[CORE_LINK_CMD_LEN];
+static volatile uint32_t cmd_head;   // core 0
+static volatile uint32_t cmd_tail;   // core 1
+
+static volatile uint32_t status_req;   // core 0
+static uint32_t status_done;           // core 1
+
+static char out_ring[CORE_LINK_OUT_SIZE];
+static volatile uint32_t out_head;   // core 1
+static volatile uint32_t out_tail;   // core 0
+
+bool core_link_cmd_full(void)
+{
+    return cmd_head - cmd_tail >= CORE_LINK_CMD_LEN;
+}
+
+/* Callers check core_link_cmd_full() first. */
+void core_link_cmd_push(cJSON *root)
+{
+    cmd_roots[cmd_head % CORE_LINK_CMD_LEN] = root;
+    __mem_fence_release();
+    cmd_head++;
+}
+
+bool core_link_cmd_pop(cJSON **root)
+{
+    if (cmd_tail == cmd_head) {
+        return false;
+    }
+    __mem_fence_acquire();
+    *root = cmd_roots[cmd_tail % CORE_LINK_CMD_LEN];
+    __mem_fence_release();
+    cmd_tail++;
+    return true;
+}
+
+void core_link_request_status(void)
+{
+    status_req++;
+}
+
+/* Requests that pile up while op() runs long collapse into one packet,
+ * as they would on a single core. */
+bool core_link_status_due(void)
+{
+    uint32_t req = status_req;
+    if (req == status_done) {
+        return false;
+    }
+    status_done = req;
+    return true;
+}
+
+/* send_json() writer on core 1. Waits for room rather than dropping, so
+ * status lines stay whole; core 0 drains the ring every loop pass. */
+void core_link_out_write(const char *buf, size_t len)
+{
+    while (len > 0) {
+        uint32_t room = CORE_LINK_OUT_SIZE - (out_head - out_tail);
+        if (room == 0) {
+            tight_loop_contents();
+            continue;
+        }
+        uint32_t at = out_head % CORE_LINK_OUT_SIZE;
+        uint32_t n = CORE_LINK_OUT_SIZE - at;
+        if (n > room) n = room;
+        if (n > len) n = (uint32_t)len;
+        memcpy(&out_ring[at], buf, n);
+        __mem_fence_release();
+        out_head += n;
+        buf += n;
+        len -= n;
+    }
+}
+
+bool core_link_out_flush(void)
+{
+    uint32_t head = out_head;
+    if (head == out_tail) {
+        return false;
+    }
+    __mem_fence_acquire();
+    while (out_tail != head) {
+        uint32_t at = out_tail % CORE_LINK_OUT_SIZE;
+        uint32_t n = CORE_LINK_OUT_SIZE - at;
+        if (n > head - out_tail) n = head - out_tail;
+        fwrite(&out_ring[at], 1, n, stdout);
+        __mem_fence_release();
+        out_tail += n;
+    }
+    fflush(stdout);
+    return true;
+}
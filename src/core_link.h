@@ -0,0 +1,34 @@
+#ifndef CORE_LINK_H
+#define CORE_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "eigsep_command.h"
+#include "cJSON.h"
+
+/* Core 0 <-> core 1 mailbox for the dual-core build (PICO_MULTI_DUAL_CORE
+ * in pico_multi.h). Core 0 owns USB: it parses command lines, queues
+ * the trees and status requests for core 1, and writes core 1's
+ * send_json() output to stdout. Core 1 owns the app: init, server, op
+ * and status all run there, so a status packet is formatted between two
+ * op() calls and always reports one consistent state. Every channel has
+ * exactly one producer and one consumer core, so none of them takes a
+ * lock. Each tree sits in an arena of the command pool (cmd_pool.h),
+ * which core 1 releases once the app has applied it; an arena is ~7 KB,
+ * so the mailbox is kept short and further lines wait in cmd_rx. */
+#define CORE_LINK_CMD_LEN  4      // command trees in flight to core 1
+#define CORE_LINK_OUT_SIZE 4096   // send_json() bytes in flight to core 0
+
+/* core 0 */
+bool core_link_cmd_full(void);
+void core_link_cmd_push(cJSON *root);   // root may be NULL
+void core_link_request_status(void);
+bool core_link_out_flush(void);   // false: nothing to write
+
+/* core 1 */
+bool core_link_cmd_pop(cJSON **root);
+bool core_link_status_due(void);
+void core_link_out_write(const char *buf, size_t len);
+
+#endif
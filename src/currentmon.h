@@ -5,7 +5,8 @@
 // 3.32k/4.64k resistive divider, DMM-measured) on GP26 / ADC0 and exposes the raw ADC-pin
 // voltage. Composed into the lidar app dispatch in main.c because the lidar
 // Pico uses no other ADC channel, so this sensor is the sole occupant of the
-// ADC mux (no adc_select_input swapping → no cross-channel correlation).
+// ADC mux (no round-robin neighbours → no cross-channel correlation).
+// currentmon_op() latches the shared ADC sampler's running average.
 //
 // Firmware stays "dumb": it reports volts only. The voltage->current
 // conversion lives host-side (picohost PicoLidar redis handler).
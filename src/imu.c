@@ -1,17 +1,33 @@
 #include "imu.h"
+#include "cmd_rx.h"
+#include <math.h>
 #include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/uart.h"
+#include "hardware/i2c.h"
 #include "hardware/gpio.h"
+#include "hardware/irq.h"
 #include "pico_multi.h"
 
-static ImuState imu;
+static ImuState imu = {
+    .quat_hz    = IMU_DEFAULT_RATE_HZ,
+    .accel_hz   = IMU_DEFAULT_RATE_HZ,
+    .gravity_hz = IMU_DEFAULT_RATE_HZ,
+};
+
+/* UART RX ring: the IRQ writes at rx_head, imu_op() reads at rx_tail.
+   Both only ever increase; they index modulo IMU_RX_RING_LEN. */
+static uint8_t rx_ring[IMU_RX_RING_LEN];
+static volatile uint32_t rx_head;
+static volatile uint32_t rx_tail;
+static volatile uint32_t rx_dropped;   /* ring full or FIFO overrun */
 
 /* ------------------------------------------------------------------ */
 /* Hardware reset                                                     */
 /* ------------------------------------------------------------------ */
-/* Toggle the RST pin to force the BNO08x into a known state.
-   Required so the sensor reliably enters RVC mode on power-up. */
+/* Toggle the RST pin to force the BNO08x into a known state. Required
+   so the sensor reliably comes up in whichever mode its PS pins strap,
+   RVC on the UART or SHTP on I2C, before imu_init() probes for it. */
 static void imu_hardware_reset(void) {
     gpio_init(IMU_RST_GPIO);
     gpio_set_dir(IMU_RST_GPIO, GPIO_OUT);
@@ -24,12 +40,45 @@ static void imu_hardware_reset(void) {
 /* ------------------------------------------------------------------ */
 /* UART setup                                                         */
 /* ------------------------------------------------------------------ */
+/* Move the hardware FIFO into the ring as bytes arrive, so they wait
+   there rather than in the 32-byte FIFO for imu_op() to come round. */
+static void imu_uart_irq(void) {
+    while (uart_is_readable(IMU_UART)) {
+        uint8_t byte = (uint8_t)uart_getc(IMU_UART);
+        uint32_t head = rx_head;
+        if (head - rx_tail < IMU_RX_RING_LEN) {
+            rx_ring[head % IMU_RX_RING_LEN] = byte;
+            rx_head = head + 1;
+        } else {
+            rx_dropped++;
+        }
+    }
+    /* The FIFO filled before this ran: at least one byte is lost. Any
+       write clears the error flags. */
+    if (uart_get_hw(IMU_UART)->rsr & UART_UARTRSR_OE_BITS) {
+        rx_dropped++;
+        uart_get_hw(IMU_UART)->rsr = 0;
+    }
+}
+
 static void imu_uart_init(void) {
+    static bool irq_installed;
+
+    irq_set_enabled(IMU_UART_IRQ, false);
     uart_init(IMU_UART, IMU_UART_BAUD);
     gpio_set_function(IMU_UART_RX_PIN, GPIO_FUNC_UART);
     /* Drain any stale bytes */
     while (uart_is_readable(IMU_UART))
         uart_getc(IMU_UART);
+    uart_get_hw(IMU_UART)->rsr = 0;
+    rx_tail = rx_head;
+
+    if (!irq_installed) {
+        irq_set_exclusive_handler(IMU_UART_IRQ, imu_uart_irq);
+        irq_installed = true;
+    }
+    uart_set_irq_enables(IMU_UART, true, false);
+    irq_set_enabled(IMU_UART_IRQ, true);
 }
 
 /* ------------------------------------------------------------------ */
@@ -85,13 +134,161 @@ static bool rvc_feed_byte(ImuState *st, uint8_t byte) {
 
     /* Full packet received — validate and parse */
     st->rx_pos = 0;
-    if (!rvc_checksum_ok(st->rx_buf))
+    if (!rvc_checksum_ok(st->rx_buf)) {
+        st->bad_checksum++;
         return false;
+    }
 
     rvc_parse(st->rx_buf, &st->data);
+    st->packets++;
+    angle_stats_add(&st->window.yaw, st->data.yaw);
+    axis_stats_add(&st->window.pitch, st->data.pitch);
+    angle_stats_add(&st->window.roll, st->data.roll);
+    axis_stats_add(&st->window.accel_x, st->data.accel_x);
+    axis_stats_add(&st->window.accel_y, st->data.accel_y);
+    axis_stats_add(&st->window.accel_z, st->data.accel_z);
     return true;
 }
 
+/* ------------------------------------------------------------------ */
+/* SHTP over I2C                                                      */
+/* ------------------------------------------------------------------ */
+
+static uint8_t shtp_rx[IMU_SHTP_RX_LEN];
+
+/* Generous for `len` bytes at IMU_I2C_FREQ (~25 us a byte) */
+static uint imu_i2c_timeout_us(size_t len) {
+    return 1000 + 50 * (uint)len;
+}
+
+/* True if a BNO08x in SHTP mode answers on the I2C bus. */
+static bool imu_shtp_probe(void) {
+    i2c_init(IMU_I2C, IMU_I2C_FREQ);
+    gpio_set_function(IMU_I2C_SDA_PIN, GPIO_FUNC_I2C);
+    gpio_set_function(IMU_I2C_SCL_PIN, GPIO_FUNC_I2C);
+    gpio_pull_up(IMU_I2C_SDA_PIN);
+    gpio_pull_up(IMU_I2C_SCL_PIN);
+    /* A header-only read leaves any pending packet to be read whole */
+    uint8_t hdr[SHTP_HEADER_LEN];
+    if (i2c_read_timeout_us(IMU_I2C, IMU_I2C_ADDR, hdr, sizeof(hdr), false,
+                            imu_i2c_timeout_us(sizeof(hdr)))
+            == SHTP_HEADER_LEN) {
+        return true;
+    }
+    /* No sensor on I2C: leave the pins as they were before the probe */
+    i2c_deinit(IMU_I2C);
+    gpio_set_function(IMU_I2C_SDA_PIN, GPIO_FUNC_NULL);
+    gpio_set_function(IMU_I2C_SCL_PIN, GPIO_FUNC_NULL);
+    gpio_disable_pulls(IMU_I2C_SDA_PIN);
+    gpio_disable_pulls(IMU_I2C_SCL_PIN);
+    return false;
+}
+
+/* Read one packet into shtp_rx. Returns its payload length and channel;
+   0 if the sensor has nothing (or sent a continuation, which is skipped),
+   and -1 on a bus error. */
+static int imu_shtp_read(uint8_t *channel) {
+    uint8_t hdr[SHTP_HEADER_LEN];
+    if (i2c_read_timeout_us(IMU_I2C, IMU_I2C_ADDR, hdr, sizeof(hdr), false,
+                            imu_i2c_timeout_us(sizeof(hdr)))
+            != SHTP_HEADER_LEN) {
+        return -1;
+    }
+    size_t len = shtp_length(hdr);
+    if (len <= SHTP_HEADER_LEN) {
+        return 0;
+    }
+    if (len > sizeof(shtp_rx)) {
+        len = sizeof(shtp_rx);
+    }
+    /* The sensor sends the header again, then the payload */
+    if (i2c_read_timeout_us(IMU_I2C, IMU_I2C_ADDR, shtp_rx, len, false,
+                            imu_i2c_timeout_us(len)) != (int)len) {
+        return -1;
+    }
+    if (shtp_rx[1] & (SHTP_CONTINUATION >> 8)) {
+        return 0;
+    }
+    *channel = shtp_rx[2];
+    return (int)(len - SHTP_HEADER_LEN);
+}
+
+static bool imu_shtp_write(uint8_t channel, const uint8_t *payload,
+                           size_t len) {
+    uint8_t pkt[SHTP_HEADER_LEN + SH2_SET_FEATURE_LEN];
+    if (len > sizeof(pkt) - SHTP_HEADER_LEN) {
+        return false;
+    }
+    shtp_header(pkt, len, channel, imu.shtp_seq[channel]++);
+    memcpy(&pkt[SHTP_HEADER_LEN], payload, len);
+    size_t n = SHTP_HEADER_LEN + len;
+    return i2c_write_timeout_us(IMU_I2C, IMU_I2C_ADDR, pkt, n, false,
+                                imu_i2c_timeout_us(n)) == (int)n;
+}
+
+/* Ask for each report at its rate; false if a command did not go out. */
+static bool imu_shtp_configure(void) {
+    const struct { uint8_t id; uint16_t hz; } features[] = {
+        { SH2_ROTATION_VECTOR, imu.quat_hz },
+        { SH2_ACCELEROMETER,   imu.accel_hz },
+        { SH2_GRAVITY,         imu.gravity_hz },
+    };
+    for (size_t i = 0; i < sizeof(features) / sizeof(features[0]); i++) {
+        uint8_t cmd[SH2_SET_FEATURE_LEN];
+        size_t n = sh2_set_feature(cmd, features[i].id,
+                                   sh2_interval_us(features[i].hz));
+        if (!imu_shtp_write(SHTP_CHAN_CONTROL, cmd, n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Turn a sample fresh from this packet into a sample time. */
+static void imu_stamp(Sh2Sample *s, uint64_t *sample_us, uint64_t rx_us) {
+    if (s->fresh) {
+        *sample_us = rx_us - s->age_us;
+        s->fresh = false;
+    }
+}
+
+/* Read what the sensor has queued; true if it held a sensor report. */
+static bool imu_shtp_op(void) {
+    bool got_report = false;
+
+    if (imu.features_dirty) {
+        imu.features_dirty = !imu_shtp_configure();
+    }
+    for (int i = 0; i < IMU_SHTP_READS_PER_OP; i++) {
+        uint8_t channel;
+        int len = imu_shtp_read(&channel);
+        if (len <= 0) {
+            break;
+        }
+        const uint8_t *payload = &shtp_rx[SHTP_HEADER_LEN];
+        if (channel == SHTP_CHAN_EXECUTABLE &&
+                payload[0] == SH2_EXEC_RESET_DONE) {
+            /* The sensor (re)booted with every report off */
+            imu.features_dirty = true;
+        } else if (channel == SHTP_CHAN_REPORTS) {
+            uint64_t rx_us = time_us_64();
+            if (sh2_parse_reports(payload, (size_t)len, &imu.sh2) > 0) {
+                const Sh2Sample *a = &imu.sh2.accel;
+                if (a->fresh) {
+                    axis_stats_add(&imu.window.accel_x, a->v[0]);
+                    axis_stats_add(&imu.window.accel_y, a->v[1]);
+                    axis_stats_add(&imu.window.accel_z, a->v[2]);
+                }
+                imu_stamp(&imu.sh2.quat, &imu.quat_us, rx_us);
+                imu_stamp(&imu.sh2.accel, &imu.accel_us, rx_us);
+                imu_stamp(&imu.sh2.gravity, &imu.gravity_us, rx_us);
+                got_report = true;
+            }
+        }
+    }
+    return got_report;
+}
+
 /* ------------------------------------------------------------------ */
 /* App interface                                                      */
 /* ------------------------------------------------------------------ */
@@ -107,18 +304,50 @@ void imu_init(uint8_t app_id) {
     imu.name[IMU_NAME_LEN - 1] = '\0';
     imu.rx_pos = 0;
     memset(&imu.data, 0, sizeof(imu.data));
+    memset(&imu.sh2, 0, sizeof(imu.sh2));
+    memset(&imu.window, 0, sizeof(imu.window));
+    imu.quat_us = imu.accel_us = imu.gravity_us = 0;
 
+    /* No bytes from the old session arrive during the reset */
+    irq_set_enabled(IMU_UART_IRQ, false);
     imu_hardware_reset();
-    imu_uart_init();
+    if (imu_shtp_probe()) {
+        imu.mode = IMU_MODE_SHTP;
+        imu.features_dirty = true;
+    } else {
+        imu.mode = IMU_MODE_RVC;
+        imu_uart_init();
+    }
 
     imu.last_event_time = to_ms_since_boot(get_absolute_time());
+    if (imu.status_time_us == 0)
+        imu.status_time_us = time_us_64();
     imu.is_initialized = true;
 }
 
-void imu_server(uint8_t app_id, const char *json_str) {
+/* Report rates: kept across re-inits, sent on the next imu_op() in SHTP
+   mode. RVC mode streams at its fixed 100 Hz whatever they are. */
+static void set_rate(void *ctx, double value) {
+    *(uint16_t *)ctx = (uint16_t)value;
+    imu.features_dirty = true;
+}
+
+const CmdKey imu_keys[] = {
+    { "accel_hz", CMD_INT, CMD_CLAMP, 0, SH2_MAX_RATE_HZ, set_rate,
+      &imu.accel_hz },
+    { "gravity_hz", CMD_INT, CMD_CLAMP, 0, SH2_MAX_RATE_HZ, set_rate,
+      &imu.gravity_hz },
+    { "quat_hz", CMD_INT, CMD_CLAMP, 0, SH2_MAX_RATE_HZ, set_rate,
+      &imu.quat_hz },
+};
+const size_t imu_keys_len = CMD_TABLE_LEN(imu_keys);
+
+void imu_server(uint8_t app_id, const cJSON *root) {
     (void)app_id;
-    (void)json_str;
-    /* RVC mode: no commands supported */
+    if (!cJSON_IsObject(root)) {
+        return;
+    }
+    cmd_table_dispatch(imu_keys, imu_keys_len, root);
 }
 
 void imu_op(uint8_t app_id) {
@@ -130,26 +359,85 @@ void imu_op(uint8_t app_id) {
 
     uint32_t now = to_ms_since_boot(get_absolute_time());
     bool got_packet = false;
+    /* With every SHTP report off, silence is expected */
+    bool expect_packets = true;
 
-    /* Drain all available UART bytes */
-    while (uart_is_readable(IMU_UART)) {
-        uint8_t byte = uart_getc(IMU_UART);
-        if (rvc_feed_byte(&imu, byte))
-            got_packet = true;
+    if (imu.mode == IMU_MODE_SHTP) {
+        got_packet = imu_shtp_op();
+        expect_packets = imu.quat_hz || imu.accel_hz || imu.gravity_hz;
+    } else {
+        /* Drain the bytes the UART IRQ has queued */
+        uint32_t head = rx_head;
+        for (uint32_t tail = rx_tail; tail != head; tail++) {
+            if (rvc_feed_byte(&imu, rx_ring[tail % IMU_RX_RING_LEN]))
+                got_packet = true;
+        }
+        rx_tail = head;
     }
 
-    if (got_packet) {
+    if (got_packet || !expect_packets) {
         imu.last_event_time = now;
-        imu.got_packet_this_cycle = true;
+        imu.got_packet_this_cycle |= got_packet;
     } else if ((now - imu.last_event_time) > IMU_EVENT_TIMEOUT_MS) {
         imu.is_initialized = false;
     }
 }
 
-void imu_status(uint8_t app_id) {
-    const char *status = imu.got_packet_this_cycle ? "update" : "error";
+/* Milliseconds since a sample was taken; NaN (null) before the first. */
+static float imu_age_ms(uint64_t sample_us, uint64_t now) {
+    return sample_us ? (now - sample_us) / 1000.0f : NAN;
+}
+
+static void imu_shtp_status(uint8_t app_id, const char *status) {
+    uint64_t now = time_us_64();
+    const Sh2Reports *r = &imu.sh2;
+
+    const ImuWindow *w = &imu.window;
+
+    send_json(23 + 3 * STATS_FIELDS + CMD_RX_STATUS_FIELDS,
+        KV_STR,   "sensor_name",    imu.name,
+        KV_STR,   "status",         status,
+        KV_INT,   "app_id",         app_id,
+        KV_FLOAT, "quat_i",         r->quat.v[0],
+        KV_FLOAT, "quat_j",         r->quat.v[1],
+        KV_FLOAT, "quat_k",         r->quat.v[2],
+        KV_FLOAT, "quat_real",      r->quat.v[3],
+        KV_INT,   "quat_accuracy",  r->quat.accuracy,
+        KV_FLOAT, "quat_error_rad", r->quat.error_rad,
+        KV_FLOAT, "accel_x",        r->accel.v[0],
+        KV_FLOAT, "accel_y",        r->accel.v[1],
+        KV_FLOAT, "accel_z",        r->accel.v[2],
+        KV_INT,   "accel_accuracy", r->accel.accuracy,
+        KV_FLOAT, "gravity_x",      r->gravity.v[0],
+        KV_FLOAT, "gravity_y",      r->gravity.v[1],
+        KV_FLOAT, "gravity_z",      r->gravity.v[2],
+        KV_FLOAT, "quat_age_ms",    imu_age_ms(imu.quat_us, now),
+        KV_FLOAT, "accel_age_ms",   imu_age_ms(imu.accel_us, now),
+        KV_FLOAT, "gravity_age_ms", imu_age_ms(imu.gravity_us, now),
+        KV_INT,   "quat_hz",        imu.quat_hz,
+        KV_INT,   "accel_hz",       imu.accel_hz,
+        KV_INT,   "gravity_hz",     imu.gravity_hz,
+        KV_INT,   "n_samples",      (int)w->accel_x.n,
+        AXIS_STATS_KV("accel_x", w->accel_x),
+        AXIS_STATS_KV("accel_y", w->accel_y),
+        AXIS_STATS_KV("accel_z", w->accel_z),
+        CMD_RX_STATUS
+    );
+}
 
-    send_json(9,
+static void imu_rvc_status(uint8_t app_id, const char *status) {
+    /* Valid packets per second since the last status tick */
+    uint64_t now = time_us_64();
+    uint64_t elapsed = now - imu.status_time_us;
+    uint32_t packets = imu.packets;
+    float rate = elapsed ? (packets - imu.status_packets) * 1e6f / elapsed
+                         : 0.0f;
+    imu.status_packets = packets;
+    imu.status_time_us = now;
+
+    const ImuWindow *w = &imu.window;
+
+    send_json(13 + 6 * STATS_FIELDS + CMD_RX_STATUS_FIELDS,
         KV_STR,   "sensor_name", imu.name,
         KV_STR,   "status",      status,
         KV_INT,   "app_id",      app_id,
@@ -158,7 +446,30 @@ void imu_status(uint8_t app_id) {
         KV_FLOAT, "roll",        imu.data.roll,
         KV_FLOAT, "accel_x",     imu.data.accel_x,
         KV_FLOAT, "accel_y",     imu.data.accel_y,
-        KV_FLOAT, "accel_z",     imu.data.accel_z
+        KV_FLOAT, "accel_z",     imu.data.accel_z,
+        KV_INT,   "rx_dropped",  (int)rx_dropped,
+        KV_INT,   "rvc_checksum_fail", (int)imu.bad_checksum,
+        KV_FLOAT, "rvc_rate_hz", rate,
+        KV_INT,   "n_samples",   (int)w->accel_x.n,
+        ANGLE_STATS_KV("yaw", w->yaw),
+        AXIS_STATS_KV("pitch", w->pitch),
+        ANGLE_STATS_KV("roll", w->roll),
+        AXIS_STATS_KV("accel_x", w->accel_x),
+        AXIS_STATS_KV("accel_y", w->accel_y),
+        AXIS_STATS_KV("accel_z", w->accel_z),
+        CMD_RX_STATUS
     );
+}
+
+void imu_status(uint8_t app_id) {
+    const char *status = imu.got_packet_this_cycle ? "update" : "error";
+
+    if (imu.mode == IMU_MODE_SHTP) {
+        imu_shtp_status(app_id, status);
+    } else {
+        imu_rvc_status(app_id, status);
+    }
     imu.got_packet_this_cycle = false;
+    /* The next status summarises the samples from here on */
+    memset(&imu.window, 0, sizeof(imu.window));
 }
@@ -4,20 +4,47 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "eigsep_command.h"
+#include "cJSON.h"
+#include "cmd_table.h"
+#include "sh2.h"
+#include "imu_stats.h"
 
 /* ------------------------------------------------------------------ */
 /* Hardware constants                                                  */
 /* ------------------------------------------------------------------ */
 #define IMU_UART        uart0
+#define IMU_UART_IRQ    UART0_IRQ
 #define IMU_UART_RX_PIN 1
 #define IMU_UART_BAUD   115200
 #define IMU_RST_GPIO    13
 #define IMU_NAME_LEN    32
 
+/* SHTP (SH-2) over I2C, with the BNO08x's PS0/PS1 straps low. imu_init()
+   probes for it after each reset and falls back to UART-RVC when nothing
+   answers, so one image serves either wiring. */
+#define IMU_I2C         i2c1
+#define IMU_I2C_SDA_PIN 2
+#define IMU_I2C_SCL_PIN 3
+#define IMU_I2C_FREQ    400000
+#define IMU_I2C_ADDR    0x4A
+/* Packets are read whole up to this; only the boot-time advertisement is
+   longer, and its tail arrives as a continuation that is skipped. */
+#define IMU_SHTP_RX_LEN 256
+/* Packets imu_op() reads per call, so a busy sensor cannot stall the loop */
+#define IMU_SHTP_READS_PER_OP 8
+/* Report rates at boot; the host changes them with accel_hz, gravity_hz
+   and quat_hz (0 turns a report off) */
+#define IMU_DEFAULT_RATE_HZ 100
+
 /* BNO08x RVC packet: 2-byte header + 17 bytes payload */
 #define RVC_PACKET_SIZE 19
 #define RVC_HEADER_BYTE 0xAA
 
+/* Bytes between the UART RX IRQ and imu_op(); a power of two. At 115200
+   baud this is ~90 ms of line time, and ~0.5 s of the 100 Hz RVC stream,
+   so a slow main loop no longer overruns the 32-byte hardware FIFO. */
+#define IMU_RX_RING_LEN 1024
+
 /* If no valid packets arrive within this window, assume the BNO08x has
    crashed or been power-cycled and trigger re-initialization. */
 #define IMU_EVENT_TIMEOUT_MS 5000
@@ -39,8 +66,25 @@ typedef struct {
     float accel_z;
 } RvcData;
 
+/* Every sample since the last status tick. RVC mode fills all of it;
+   SHTP mode only the accel axes, from the accelerometer report. */
+typedef struct {
+    AngleStats yaw;
+    AxisStats  pitch;
+    AngleStats roll;
+    AxisStats  accel_x;
+    AxisStats  accel_y;
+    AxisStats  accel_z;
+} ImuWindow;
+
+typedef enum {
+    IMU_MODE_RVC,
+    IMU_MODE_SHTP,
+} ImuMode;
+
 typedef struct {
     char      name[IMU_NAME_LEN];
+    ImuMode   mode;
     RvcData   data;
     bool      is_initialized;
     uint32_t  last_event_time;    /* ms since boot of last valid packet */
@@ -51,14 +95,36 @@ typedef struct {
     /* Partial-packet receive buffer */
     uint8_t   rx_buf[RVC_PACKET_SIZE];
     uint8_t   rx_pos;
+    /* Counters for the status tick */
+    uint32_t  bad_checksum;       /* full packets failing the checksum */
+    uint32_t  packets;            /* valid packets since boot */
+    uint32_t  status_packets;     /* packets at the last status tick */
+    uint64_t  status_time_us;     /* time of the last status tick */
+    ImuWindow window;
+    /* SHTP mode: latest reports, when each was sampled (0 before the
+       first), and the rates asked of the sensor */
+    Sh2Reports sh2;
+    uint64_t  quat_us;
+    uint64_t  accel_us;
+    uint64_t  gravity_us;
+    uint16_t  quat_hz;
+    uint16_t  accel_hz;
+    uint16_t  gravity_hz;
+    bool      features_dirty;     /* rates not yet sent to the sensor */
+    uint8_t   shtp_seq[SHTP_CHANNELS];
 } ImuState;
 
 /* ------------------------------------------------------------------ */
 /* Function prototypes                                                */
 /* ------------------------------------------------------------------ */
 void imu_init(uint8_t app_id);
-void imu_server(uint8_t app_id, const char *json_str);
+void imu_server(uint8_t app_id, const cJSON *root);
 void imu_op(uint8_t app_id);
 void imu_status(uint8_t app_id);
 
+/* Command keys, sorted for cmd_table_dispatch() (checked by
+   host/test_cmd_table.c) */
+extern const CmdKey imu_keys[];
+extern const size_t imu_keys_len;
+
 #endif /* IMU_H */
@@ -0,0 +1,70 @@
+#include "imu_stats.h"
+#include <math.h>
+
+#define DEG_PER_RAD 57.29577951f
+
+void axis_stats_add(AxisStats *s, float x) {
+    s->n++;
+    float d = x - s->mean;
+    s->mean += d / (float)s->n;
+    s->m2 += d * (x - s->mean);
+    if (s->n == 1 || x < s->min) {
+        s->min = x;
+    }
+    if (s->n == 1 || x > s->max) {
+        s->max = x;
+    }
+}
+
+float axis_stats_mean(const AxisStats *s) {
+    return s->n ? s->mean : NAN;
+}
+
+float axis_stats_var(const AxisStats *s) {
+    return s->n > 1 ? s->m2 / (float)(s->n - 1) : NAN;
+}
+
+float axis_stats_min(const AxisStats *s) {
+    return s->n ? s->min : NAN;
+}
+
+float axis_stats_max(const AxisStats *s) {
+    return s->n ? s->max : NAN;
+}
+
+/* deg wrapped into (-180, 180] */
+static float wrap_deg(float deg) {
+    deg = fmodf(deg, 360.0f);
+    if (deg > 180.0f) {
+        deg -= 360.0f;
+    } else if (deg <= -180.0f) {
+        deg += 360.0f;
+    }
+    return deg;
+}
+
+void angle_stats_add(AngleStats *s, float deg) {
+    float rad = deg / DEG_PER_RAD;
+    s->sin_sum += sinf(rad);
+    s->cos_sum += cosf(rad);
+    if (s->off.n == 0) {
+        s->ref = deg;
+    }
+    axis_stats_add(&s->off, wrap_deg(deg - s->ref));
+}
+
+float angle_stats_mean(const AngleStats *s) {
+    return s->off.n ? atan2f(s->sin_sum, s->cos_sum) * DEG_PER_RAD : NAN;
+}
+
+float angle_stats_var(const AngleStats *s) {
+    return axis_stats_var(&s->off);
+}
+
+float angle_stats_min(const AngleStats *s) {
+    return s->off.n ? wrap_deg(s->ref + s->off.min) : NAN;
+}
+
+float angle_stats_max(const AngleStats *s) {
+    return s->off.n ? wrap_deg(s->ref + s->off.max) : NAN;
+}
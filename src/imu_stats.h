@@ -0,0 +1,63 @@
+#ifndef IMU_STATS_H
+#define IMU_STATS_H
+
+#include <stdint.h>
+#include "eigsep_command.h"
+
+/* Running statistics of the IMU samples between two status ticks, so a
+ * status line summarises every sample rather than only the last. Each
+ * accumulator takes one sample at a time in constant memory and is
+ * zeroed for the next window after it is reported. Free of pico-sdk
+ * headers so the host tests build it.
+ *
+ * Linear axes keep a Welford mean and sum of squared deviations. Angles
+ * that wrap at +/-180 degrees (yaw, and roll, whose RVC range is the
+ * same) are averaged on the unit circle instead: the mean is the
+ * direction of the summed unit vectors. Their variance, min and max are
+ * those of each sample's offset from the window's first, wrapped to
+ * +/-180, so they hold for any cluster narrower than half a turn; one
+ * straddling +/-180 reports e.g. min 179, max -179. */
+
+typedef struct {
+    uint32_t n;
+    float    mean;
+    float    m2;        /* sum of squared deviations from the mean */
+    float    min, max;
+} AxisStats;
+
+typedef struct {
+    float     sin_sum, cos_sum;
+    float     ref;      /* first sample, degrees */
+    AxisStats off;      /* offsets from ref, degrees */
+} AngleStats;
+
+void  axis_stats_add(AxisStats *s, float x);
+float axis_stats_mean(const AxisStats *s);
+float axis_stats_var(const AxisStats *s);   /* sample variance (n - 1) */
+float axis_stats_min(const AxisStats *s);
+float axis_stats_max(const AxisStats *s);
+
+void  angle_stats_add(AngleStats *s, float deg);
+float angle_stats_mean(const AngleStats *s);
+float angle_stats_var(const AngleStats *s);
+float angle_stats_min(const AngleStats *s);
+float angle_stats_max(const AngleStats *s);
+
+/* All are NaN (null in the status) until there are samples enough: one,
+ * or two for a variance. */
+
+/* send_json() fields for one axis or angle: <name>_mean, _var, _min and
+ * _max. */
+#define STATS_FIELDS 4
+#define AXIS_STATS_KV(name, s)                                  \
+    KV_FLOAT, name "_mean", (double)axis_stats_mean(&(s)),      \
+    KV_FLOAT, name "_var",  (double)axis_stats_var(&(s)),       \
+    KV_FLOAT, name "_min",  (double)axis_stats_min(&(s)),       \
+    KV_FLOAT, name "_max",  (double)axis_stats_max(&(s))
+#define ANGLE_STATS_KV(name, s)                                 \
+    KV_FLOAT, name "_mean", (double)angle_stats_mean(&(s)),     \
+    KV_FLOAT, name "_var",  (double)angle_stats_var(&(s)),      \
+    KV_FLOAT, name "_min",  (double)angle_stats_min(&(s)),      \
+    KV_FLOAT, name "_max",  (double)angle_stats_max(&(s))
+
+#endif // IMU_STATS_H
@@ -1,4 +1,5 @@
 #include "lidar.h"
+#include "cmd_rx.h"
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 #include "eigsep_command.h"
@@ -50,25 +51,23 @@ void lidar_init(uint8_t app_id) {
     free_i2c_bus();
 }
 
-void lidar_server(uint8_t app_id, const char *json_str) {
+void lidar_server(uint8_t app_id, const cJSON *root) {
     // lidar does not currently handle commands, but validate anyway
     // so the guard is in place when commands are added in the future.
-    cJSON *root = cJSON_Parse(json_str);
-    if (!root || !cJSON_IsObject(root)) {
-        cJSON_Delete(root);
+    if (!cJSON_IsObject(root)) {
         return;
     }
-    cJSON_Delete(root);
 }
 
 void lidar_status(uint8_t app_id) {
     const char *status = lidar_data.last_op_ok ? "update" : "error";
-    send_json(5,
+    send_json(5 + CMD_RX_STATUS_FIELDS,
         KV_STR, "sensor_name", "lidar",
         KV_STR, "status", status,
         KV_INT, "app_id", app_id,
         KV_FLOAT, "distance_m", lidar_data.distance,
-        KV_FLOAT, "current_voltage", currentmon_voltage()
+        KV_FLOAT, "current_voltage", currentmon_voltage(),
+        CMD_RX_STATUS
     );
     lidar_data.last_op_ok = false;
 }
@@ -2,9 +2,10 @@
 #define LIDAR_H
 
 #include <stdint.h>
+#include "cJSON.h"
 
 void lidar_init(uint8_t app_id);
-void lidar_server(uint8_t app_id, const char *json_str);
+void lidar_server(uint8_t app_id, const cJSON *root);
 void lidar_status(uint8_t app_id);
 void lidar_op(uint8_t app_id);
 void lidar_reset(uint8_t app_id);
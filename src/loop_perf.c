@@ -0,0 +1,167 @@
+#include "loop_perf.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "eigsep_command.h"
+
+typedef struct {
+    uint32_t epoch;     // reset_epoch this window started in
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t events;    // dispatch: cap hits; USB write: stalls
+    uint64_t n;         // 64-bit: a fast loop passes 2^32 within a day
+    uint64_t total_us;
+    uint64_t hist[LOOP_PERF_BUCKETS];
+} PhaseStats;
+
+static PhaseStats phases[PERF_PHASES];
+
+/* Bumped by the reporting core to start a new window; each recording
+ * core clears its own phases when it sees the change. */
+static volatile uint32_t reset_epoch;
+static uint64_t window_start_us;         // app core
+
+static volatile uint32_t report_req;     // core 0
+static volatile bool report_reset;       // core 0
+static uint32_t report_done;             // app core
+
+static PhaseStats *phase_stats(loop_perf_phase_t phase)
+{
+    PhaseStats *st = &phases[phase];
+    uint32_t epoch = reset_epoch;
+    if (st->epoch != epoch) {
+        memset(st, 0, sizeof(*st));
+        st->epoch = epoch;
+    }
+    return st;
+}
+
+/* Bucket 0 holds 0 us, bucket b holds [2^(b-1), 2^b) us. */
+static uint32_t bucket_of(uint32_t us)
+{
+    if (us == 0) {
+        return 0;
+    }
+    uint32_t b = 32 - (uint32_t)__builtin_clz(us);
+    return b < LOOP_PERF_BUCKETS ? b : LOOP_PERF_BUCKETS - 1;
+}
+
+void loop_perf_record(loop_perf_phase_t phase, uint32_t start_us)
+{
+    uint32_t us = time_us_32() - start_us;
+    PhaseStats *st = phase_stats(phase);
+    if (st->n == 0 || us < st->min_us) {
+        st->min_us = us;
+    }
+    if (us > st->max_us) {
+        st->max_us = us;
+    }
+    st->n++;
+    st->total_us += us;
+    st->hist[bucket_of(us)]++;
+}
+
+void loop_perf_dispatch_capped(void)
+{
+    phase_stats(PERF_DISPATCH)->events++;
+}
+
+void loop_perf_usb_write_done(uint32_t start_us)
+{
+    if (time_us_32() - start_us >= LOOP_PERF_STALL_US) {
+        phase_stats(PERF_USB_WRITE)->events++;
+    }
+    loop_perf_record(PERF_USB_WRITE, start_us);
+}
+
+void loop_perf_usb_write(const char *buf, size_t len)
+{
+    uint32_t start = time_us_32();
+    fwrite(buf, 1, len, stdout);
+    fflush(stdout);
+    loop_perf_usb_write_done(start);
+}
+
+void loop_perf_request(bool reset)
+{
+    report_reset = reset;
+    report_req++;
+}
+
+bool loop_perf_report_due(void)
+{
+    uint32_t req = report_req;
+    if (req == report_done) {
+        return false;
+    }
+    report_done = req;
+    return true;
+}
+
+typedef struct {
+    double n;
+    int min_us, mean_us, max_us, p99_us, events;
+} PhaseReport;
+
+/* p99 is the top of the bucket holding the 99th percentile, capped at
+ * the largest duration seen. */
+static PhaseReport phase_report(loop_perf_phase_t phase)
+{
+    PhaseReport r = { 0 };
+    const PhaseStats *st = &phases[phase];
+    if (st->epoch != reset_epoch || st->n == 0) {
+        return r;
+    }
+    r.n = (double)st->n;
+    r.min_us = (int)st->min_us;
+    r.max_us = (int)st->max_us;
+    r.mean_us = (int)(st->total_us / st->n);
+    r.events = (int)st->events;
+    uint64_t want = st->n - st->n / 100;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < LOOP_PERF_BUCKETS; b++) {
+        seen += st->hist[b];
+        if (seen >= want) {
+            uint32_t top = b == 0 ? 0 : (1u << b) - 1;
+            r.p99_us = (int)(top < st->max_us ? top : st->max_us);
+            break;
+        }
+    }
+    return r;
+}
+
+#define PHASE_FIELDS(name, r)                  \
+    KV_FLOAT, name "_n",     (r).n,            \
+    KV_INT, name "_min_us",  (r).min_us,       \
+    KV_INT, name "_mean_us", (r).mean_us,      \
+    KV_INT, name "_max_us",  (r).max_us,       \
+    KV_INT, name "_p99_us",  (r).p99_us
+
+void loop_perf_report(uint8_t app_id)
+{
+    PhaseReport dispatch = phase_report(PERF_DISPATCH);
+    PhaseReport op = phase_report(PERF_OP);
+    PhaseReport status = phase_report(PERF_STATUS);
+    PhaseReport usb = phase_report(PERF_USB_WRITE);
+    PhaseReport loop = phase_report(PERF_LOOP);
+    uint64_t window_us = time_us_64() - window_start_us;
+    double loop_hz = window_us ? loop.n * 1e6 / (double)window_us : 0.0;
+
+    send_json(6 + 5 * PERF_PHASES,
+        KV_STR, "sensor_name", "perf",
+        KV_INT, "app_id", app_id,
+        KV_FLOAT, "window_s", (double)(window_us / 1000) / 1000.0,
+        KV_FLOAT, "loop_hz", loop_hz,
+        KV_INT, "dispatch_capped", dispatch.events,
+        KV_INT, "usb_stalls", usb.events,
+        PHASE_FIELDS("dispatch", dispatch),
+        PHASE_FIELDS("op", op),
+        PHASE_FIELDS("status", status),
+        PHASE_FIELDS("usb_write", usb),
+        PHASE_FIELDS("loop", loop)
+    );
+    if (report_reset) {
+        window_start_us = time_us_64();
+        reset_epoch++;
+    }
+}
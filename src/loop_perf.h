@@ -0,0 +1,48 @@
+#ifndef LOOP_PERF_H
+#define LOOP_PERF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Main-loop timing, accumulated all the time and reported on demand with
+ * the universal {"cmd":"perf"} command (main.c). Each phase keeps count,
+ * min, max, total and a histogram of its duration in power-of-two
+ * microsecond buckets, so p99 is known to within a factor of two.
+ *
+ * Every phase is recorded by one core only (in the dual-core build
+ * dispatch, USB writes and the loop pass on core 0, op and status on
+ * core 1), and a reset is applied lazily by the recording core, so no
+ * locks are taken. A report read from the other core may be a pass out
+ * of date; that is all. */
+typedef enum {
+    PERF_DISPATCH,    // command dispatch, passes that had lines to run
+    PERF_OP,          // app op()
+    PERF_STATUS,      // app status(); single-core, USB write included
+    PERF_USB_WRITE,   // status bytes handed to the CDC port
+    PERF_LOOP,        // one main-loop pass (core 0's, when dual-core)
+    PERF_PHASES
+} loop_perf_phase_t;
+
+#define LOOP_PERF_BUCKETS  24     // last bucket, from 2^22 us (~4 s), is open
+#define LOOP_PERF_STALL_US 5000   // a USB write this slow counts as a stall
+
+/* Record a phase that started at start_us (time_us_32()). */
+void loop_perf_record(loop_perf_phase_t phase, uint32_t start_us);
+/* The dispatch loop ran a full CMD_RX_QUEUE_LEN lines and stopped at its
+ * per-pass cap (the starvation guard for op()). */
+void loop_perf_dispatch_capped(void);
+/* Record a USB write that started at start_us, and count it as a stall
+ * if it took LOOP_PERF_STALL_US or longer. */
+void loop_perf_usb_write_done(uint32_t start_us);
+/* send_json() writer for the single-core build: stdout, timed. */
+void loop_perf_usb_write(const char *buf, size_t len);
+
+/* {"cmd":"perf"} posts a request (core 0); the app loop sends the report
+ * with loop_perf_report() once loop_perf_report_due() says so. reset
+ * starts a new window after that report. */
+void loop_perf_request(bool reset);
+bool loop_perf_report_due(void);
+void loop_perf_report(uint8_t app_id);
+
+#endif
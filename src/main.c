@@ -2,11 +2,20 @@
 #include "pico/bootrom.h"
 #include "hardware/gpio.h"
 #include "hardware/watchdog.h"
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
+#include "cJSON.h"
 
 // App headers
 #include "pico_multi.h"
+#include "cmd_rx.h"
+#include "cmd_pool.h"
+#include "loop_perf.h"
+#if PICO_MULTI_DUAL_CORE
+#include "pico/multicore.h"
+#include "core_link.h"
+#endif
 #include "motor.h"
 #include "rfswitch.h"
 #include "tempctrl.h"
@@ -34,23 +43,69 @@ static void init_dip_switches(void) {
     sleep_ms(10); // allow switches to settle
 }
 
-// Universal command, recognised for every app (and the unknown-app
-// default) before the per-app dispatch: {"cmd":"bootsel"} reboots the
-// Pico into USB BOOTSEL via reset_usb_boot(). A manual recovery hatch
-// for reflashing a single board over USB without the bussed GPIO
-// BOOTSEL/RUN lines — send it over CDC (e.g. from a serial terminal)
-// when the GPIO mass-BOOTSEL path is unavailable or you only want to
-// reflash one board.
-static bool is_bootsel_command(const char *line) {
-    cJSON *root = cJSON_Parse(line);
-    if (!root) {
-        return false;
+// Universal commands, recognised for every app (and the unknown-app
+// default) before the per-app dispatch:
+//
+// {"cmd":"bootsel"} reboots the Pico into USB BOOTSEL via
+// reset_usb_boot(). A manual recovery hatch for reflashing a single board
+// over USB without the bussed GPIO BOOTSEL/RUN lines — send it over CDC
+// (e.g. from a serial terminal) when the GPIO mass-BOOTSEL path is
+// unavailable or you only want to reflash one board.
+//
+// {"cmd":"perf"} sends one "perf" record of main-loop timing (loop_perf.h):
+// per-phase count, min, mean, max and p99 microseconds, the loop rate,
+// how often dispatch hit its per-pass cap, and USB write stalls. The
+// window runs from boot, or from the last {"cmd":"perf","reset":true}.
+//
+// {"status_format":"binary"|"json"} selects how send_json() encodes
+// status (see eigsep_command.h). Boots as "json"; other values are
+// ignored.
+//
+// {"cadence_ms":N} sets the status reporting period, clamped to the
+// app's [cadence_min_ms(), CADENCE_MAX_MS] (pico_multi.h). Non-numeric
+// values are ignored.
+//
+// main() parses each line once; these keys are read from the tree and
+// left in it for the app, which ignores them.
+static uint32_t cadence_min_ms(uint8_t app_id) {
+    switch (app_id) {
+        case APP_MOTOR: return CADENCE_MIN_MS_MOTOR;
+        case APP_TEMPCTRL: return CADENCE_MIN_MS_TEMPCTRL;
+        case APP_POTMON: return CADENCE_MIN_MS_POTMON;
+        case APP_IMU_EL:
+        case APP_IMU_AZ: return CADENCE_MIN_MS_IMU;
+        case APP_LIDAR: return CADENCE_MIN_MS_LIDAR;
+        case APP_RFSWITCH: return CADENCE_MIN_MS_RFSWITCH;
+        default: return STATUS_CADENCE_MS;
     }
+}
+
+static void handle_universal_command(const cJSON *root, uint8_t app_id,
+                                     uint32_t *cadence_ms) {
     cJSON *cmd = cJSON_GetObjectItem(root, "cmd");
-    bool match = cJSON_IsString(cmd) && cmd->valuestring != NULL &&
-                 strcmp(cmd->valuestring, "bootsel") == 0;
-    cJSON_Delete(root);
-    return match;
+    if (cJSON_IsString(cmd) && cmd->valuestring != NULL) {
+        if (strcmp(cmd->valuestring, "bootsel") == 0) {
+            reset_usb_boot(0, 0);  // does not return
+        }
+        if (strcmp(cmd->valuestring, "perf") == 0) {
+            cJSON *reset = cJSON_GetObjectItem(root, "reset");
+            loop_perf_request(cJSON_IsTrue(reset));
+        }
+    }
+    cJSON *format = cJSON_GetObjectItem(root, "status_format");
+    if (cJSON_IsString(format) && format->valuestring != NULL) {
+        if (strcmp(format->valuestring, "binary") == 0) {
+            set_status_format(STATUS_FORMAT_BINARY);
+        } else if (strcmp(format->valuestring, "json") == 0) {
+            set_status_format(STATUS_FORMAT_JSON);
+        }
+    }
+    cJSON *cadence = cJSON_GetObjectItem(root, "cadence_ms");
+    if (cJSON_IsNumber(cadence)) {
+        double ms = cadence->valuedouble;
+        double lo = cadence_min_ms(app_id);
+        *cadence_ms = (uint32_t)fmin(CADENCE_MAX_MS, fmax(lo, ms));
+    }
 }
 
 // Initialize LED GPIO
@@ -61,126 +116,223 @@ static void init_led(void) {
 }
 
 
+// Per-app dispatch: init, command, every-loop op and status. With
+// PICO_MULTI_DUAL_CORE these all run on core 1 (core1_main()). A command
+// is the line's parse tree, NULL if it was not JSON; the apps ignore
+// anything but an object.
+static void app_init(uint8_t app_id) {
+    switch (app_id) {
+        case APP_MOTOR: motor_init(app_id); break;
+        case APP_RFSWITCH: rfswitch_init(app_id); break;
+        case APP_TEMPCTRL: tempctrl_init(app_id); break;
+        case APP_POTMON: potmon_init(app_id); break;
+        case APP_IMU_EL:
+        case APP_IMU_AZ: imu_init(app_id); break;
+        case APP_LIDAR:
+            lidar_init(app_id);
+            currentmon_init();
+            break;
+        default: break;
+    }
+}
+
+static void app_server(uint8_t app_id, const cJSON *root) {
+    switch (app_id) {
+        case APP_MOTOR: motor_server(app_id, root); break;
+        case APP_RFSWITCH: rfswitch_server(app_id, root); break;
+        case APP_TEMPCTRL: tempctrl_server(app_id, root); break;
+        case APP_POTMON: potmon_server(app_id, root); break;
+        case APP_IMU_EL:
+        case APP_IMU_AZ: imu_server(app_id, root); break;
+        case APP_LIDAR: lidar_server(app_id, root); break;
+        default:
+            send_json(2,
+                KV_STR, "status", "error",
+                KV_INT, "app_id", app_id
+            );
+    }
+}
+
+static void app_op(uint8_t app_id) {
+    switch (app_id) {
+        case APP_MOTOR: motor_op(app_id); break;
+        case APP_RFSWITCH: rfswitch_op(app_id); break;
+        case APP_TEMPCTRL: tempctrl_op(app_id); break;
+        case APP_POTMON: potmon_op(app_id); break;
+        case APP_IMU_EL:
+        case APP_IMU_AZ: imu_op(app_id); break;
+        case APP_LIDAR:
+            lidar_op(app_id);
+            // Keep currentmon_op() a SEPARATE dispatch call, not nested in
+            // lidar_op(): lidar_op() early-returns on an I2C failure, so
+            // folding the ADC read inside it would freeze the current
+            // reading during every lidar outage. The current monitor must
+            // keep sampling independent of lidar's I2C health.
+            currentmon_op();
+            break;
+        default:
+            break;
+    }
+}
+
+static void app_status(uint8_t app_id) {
+    switch (app_id) {
+        case APP_MOTOR: motor_status(app_id); break;
+        case APP_RFSWITCH: rfswitch_status(app_id); break;
+        case APP_TEMPCTRL: tempctrl_status(app_id); break;
+        case APP_POTMON: potmon_status(app_id); break;
+        case APP_IMU_EL:
+        case APP_IMU_AZ: imu_status(app_id); break;
+        case APP_LIDAR: lidar_status(app_id); break;
+        default:
+            send_json(2,
+                KV_STR, "status", "error",
+                KV_INT, "app_id", app_id
+            );
+    }
+}
+
+#if PICO_MULTI_DUAL_CORE
+static volatile uint8_t core1_app_id;
+
+// Core 1: the app loop. Its IRQ handlers (set up in app_init()) run
+// here too. Status requests from core 0 are served between op() calls;
+// the output goes back to core 0 through the mailbox.
+static void core1_main(void) {
+    cJSON *root;
+    uint8_t app_id = core1_app_id;
+
+    send_json_set_writer(core_link_out_write);
+    app_init(app_id);
+    while (true) {
+        for (int n = 0; n < CORE_LINK_CMD_LEN && core_link_cmd_pop(&root);
+                n++) {
+            app_server(app_id, root);
+            cmd_pool_release(root);
+        }
+        uint32_t t = time_us_32();
+        app_op(app_id);
+        loop_perf_record(PERF_OP, t);
+        if (core_link_status_due()) {
+            t = time_us_32();
+            app_status(app_id);
+            loop_perf_record(PERF_STATUS, t);
+        }
+        if (loop_perf_report_due()) {
+            loop_perf_report(app_id);
+        }
+    }
+}
+#endif
+
+
 int main(void) {
     char line[BUFFER_SIZE];  // buffer to hold input command
-    int index = 0;
     bool led_state=1;
-    absolute_time_t next_sample = make_timeout_time_ms(STATUS_CADENCE_MS);
-    absolute_time_t last_op_time = get_absolute_time();
+    uint32_t cadence_ms = STATUS_CADENCE_MS;
+    absolute_time_t next_sample = make_timeout_time_ms(cadence_ms);
 
     // 1) Initialize DIP switches before USB init
     init_dip_switches();
     // 2) Initialize LED and turn it on
     init_led();
-    // 3) Bring up USB CDC (stdio)
+    // 3) Bring up USB CDC (stdio) and start queueing command lines
     stdio_init_all();
+    cmd_rx_init();
+    cmd_pool_init();
 
     // Read DIP code early
     uint8_t app_id = read_dip_code();
 
     // Run app-dependent initialization
-    switch (app_id) {
-        case APP_MOTOR: motor_init(app_id); break;
-        case APP_RFSWITCH: rfswitch_init(app_id); break;
-        case APP_TEMPCTRL: tempctrl_init(app_id); break;
-        case APP_POTMON: potmon_init(app_id); break;
-        case APP_IMU_EL:
-        case APP_IMU_AZ: imu_init(app_id); break;
-        case APP_LIDAR:
-            lidar_init(app_id);
-            currentmon_init();
-            break;
-        default: break;
-    }
-   
+#if PICO_MULTI_DUAL_CORE
+    core1_app_id = app_id;
+    multicore_launch_core1(core1_main);
+#else
+    // stdout, with each write timed for the perf record
+    send_json_set_writer(loop_perf_usb_write);
+    app_init(app_id);
+#endif
+
     while (true) {
-        // Process incoming json-formatted commands 
-        int c = getchar_timeout_us(0);
-        if (c != PICO_ERROR_TIMEOUT) {
-            // Dispatch a complete command
-            if (c == '\n') {
-                line[index] = '\0';
-                index = 0;
-                // Universal bootsel command: enter USB BOOTSEL for a
-                // manual single-board reflash. Checked before the
-                // per-app dispatch so it works regardless of app_id.
-                // reset_usb_boot() does not return.
-                if (is_bootsel_command(line)) {
-                    reset_usb_boot(0, 0);
-                }
-                // Dispatch command to appropriate app
-                switch (app_id) {
-                    case APP_MOTOR: motor_server(app_id, line); break;
-                    case APP_RFSWITCH: rfswitch_server(app_id, line); break;
-                    case APP_TEMPCTRL: tempctrl_server(app_id, line); break;
-                    case APP_POTMON: potmon_server(app_id, line); break;
-                    case APP_IMU_EL:
-                    case APP_IMU_AZ: imu_server(app_id, line); break;
-                    case APP_LIDAR: lidar_server(app_id, line); break;
-                    default:
-                        send_json(2,
-                            KV_STR, "status", "error",
-                            KV_INT, "app_id", app_id
-                        );
-                }
-            // Otherwise add incoming character to buffer
-            } else {
-                if (index < BUFFER_SIZE - 1) {
-                    line[index++] = (char)c;
-                }
-                // Prioritize draining the serial FIFO before running op(),
-                // but ensure op() is not indefinitely starved by prolonged
-                // or unterminated serial input. last_op_time records when
-                // op() last completed, so the interval between op() starts
-                // may exceed MAX_READ_ONLY_US by up to the op() runtime.
-                if (absolute_time_diff_us(last_op_time, get_absolute_time())
-                        < MAX_READ_ONLY_US) {
-                    continue;
+        uint32_t pass_start = time_us_32();
+        uint32_t t = pass_start;
+        int n;
+        // Dispatch the complete command lines the USB receive callback
+        // has queued (cmd_rx.c). At most one queue's worth per pass, so
+        // a command flood cannot starve op(); the rest wait for the next
+        // pass. Partial lines never stall the loop. In the dual-core
+        // build a full mailbox leaves lines in the receive queue.
+        for (n = 0; n < CMD_RX_QUEUE_LEN; n++) {
+#if PICO_MULTI_DUAL_CORE
+            if (core_link_cmd_full()) {
+                break;
+            }
+#endif
+            if (!cmd_rx_pop(line)) {
+                break;
+            }
+            // The one parse of the line, into the command pool
+            // (cmd_pool.h): the universal keys and the app both read
+            // this tree.
+            cJSON *root = cmd_pool_parse(line);
+            // Universal commands (bootsel, status_format, cadence_ms),
+            // checked before the per-app dispatch so they work
+            // regardless of app_id.
+            uint32_t prev_cadence_ms = cadence_ms;
+            handle_universal_command(root, app_id, &cadence_ms);
+            // A shorter cadence takes effect now, not after the
+            // remainder of the old (possibly 5 s) period.
+            if (cadence_ms < prev_cadence_ms) {
+                absolute_time_t sooner = make_timeout_time_ms(cadence_ms);
+                if (absolute_time_diff_us(sooner, next_sample) > 0) {
+                    next_sample = sooner;
                 }
             }
+            // Dispatch command to appropriate app
+#if PICO_MULTI_DUAL_CORE
+            core_link_cmd_push(root);   // core 1 releases it
+#else
+            app_server(app_id, root);
+            cmd_pool_release(root);
+#endif
+        }
+        if (n > 0) {
+            loop_perf_record(PERF_DISPATCH, t);
+        }
+        if (n == CMD_RX_QUEUE_LEN) {
+            loop_perf_dispatch_capped();
         }
 
+#if PICO_MULTI_DUAL_CORE
+        // Write out whatever core 1 has printed
+        t = time_us_32();
+        if (core_link_out_flush()) {
+            loop_perf_usb_write_done(t);
+        }
+#else
         // Perform every-loop operations
-        switch (app_id) {
-            case APP_MOTOR: motor_op(app_id); break;
-            case APP_RFSWITCH: rfswitch_op(app_id); break;
-            case APP_TEMPCTRL: tempctrl_op(app_id); break;
-            case APP_POTMON: potmon_op(app_id); break;
-            case APP_IMU_EL:
-            case APP_IMU_AZ: imu_op(app_id); break;
-            case APP_LIDAR:
-                lidar_op(app_id);
-                // Keep currentmon_op() a SEPARATE dispatch call, not nested in
-                // lidar_op(): lidar_op() early-returns on an I2C failure, so
-                // folding the ADC read inside it would freeze the current
-                // reading during every lidar outage. The current monitor must
-                // keep sampling independent of lidar's I2C health.
-                currentmon_op();
-                break;
-            default:
-                break;
+        t = time_us_32();
+        app_op(app_id);
+        loop_perf_record(PERF_OP, t);
+        if (loop_perf_report_due()) {
+            loop_perf_report(app_id);
         }
-        last_op_time = get_absolute_time();
+#endif
 
         // Perform scheduled status reporting
         if (absolute_time_diff_us(get_absolute_time(), next_sample) <= 0) {
             gpio_put(LED_PIN, led_state);
             led_state = !led_state;
-            switch (app_id) {
-                case APP_MOTOR: motor_status(app_id); break;
-                case APP_RFSWITCH: rfswitch_status(app_id); break;
-                case APP_TEMPCTRL: tempctrl_status(app_id); break;
-                case APP_POTMON: potmon_status(app_id); break;
-                case APP_IMU_EL:
-                case APP_IMU_AZ: imu_status(app_id); break;
-                case APP_LIDAR: lidar_status(app_id); break;
-                default:
-                    send_json(2,
-                        KV_STR, "status", "error",
-                        KV_INT, "app_id", app_id
-                    );
-            }
-            next_sample = make_timeout_time_ms(STATUS_CADENCE_MS);
+#if PICO_MULTI_DUAL_CORE
+            core_link_request_status();
+#else
+            t = time_us_32();
+            app_status(app_id);
+            loop_perf_record(PERF_STATUS, t);
+#endif
+            next_sample = make_timeout_time_ms(cadence_ms);
         }
+        loop_perf_record(PERF_LOOP, pass_start);
     }
 }
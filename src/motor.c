@@ -1,7 +1,11 @@
 #include "motor.h"
-#include "motor_ramp.h"
+#include "cmd_rx.h"
 #include "pico/stdlib.h"
 #include "pico/rand.h"
+#include "hardware/sync.h"
+#include "hardware/pio.h"
+#include "hardware/irq.h"
+#include "stepper.pio.h"
 #include "cJSON.h"
 #include <stdlib.h>
 
@@ -22,11 +26,40 @@ static Stepper elevation;
  * int representation. */
 static uint32_t boot_id;
 
+/* Shared PIO program offset; both axes run the same stepper program. */
+static uint stepper_offset;
+
+/* Waypoint queue, as free-running counters like the step queue: wp_head
+ * counts waypoints accepted since the last clear (reported as wp_count),
+ * wp_tail waypoints started. While wp_active, the one at wp_tail - 1 owns
+ * both axes' targets. Main-loop only, so no interrupt masking. */
+static Waypoint wp_buf[WAYPOINT_QUEUE_LEN];
+static uint32_t wp_head;
+static uint32_t wp_tail;
+static bool wp_active;
+static bool wp_blend;     /* active segment hands off without stopping */
+static bool wp_dwelling;
+static absolute_time_t wp_dwell_until;
+static uint32_t wp_rejected;  /* wp_add lists refused since boot */
+
+/**
+ * @brief Rebake the ramp table for the axis' current step timing.
+ *
+ * Called at init and whenever motor_server() changes up/dn delay or the
+ * ramp profile, so the per-step planning in stepper_op() is a table lookup
+ * instead of a sqrtf and two divides.
+ */
+static void stepper_build_ramp(Stepper *m) {
+    ramp_table_build(&m->ramp, m->ramp_profile, m->ramp_steps,
+                     m->ramp_start_factor, m->up_delay_us + m->dn_delay_us);
+}
+
 /**
  * @brief Initialize a stepper motor interface.
  *
- * Configures the GPIO pins for direction, pulse, and enable
- * and sets initial motor state values.
+ * Configures the GPIO pins for direction and enable, hands the pulse pin
+ * to a PIO state machine running the step program, and sets initial motor
+ * state values.
  *
  * @param m Pointer to the Stepper instance to initialize.
  * @param dir_pin GPIO pin number used for direction control.
@@ -45,90 +78,180 @@ void stepper_init(Stepper *m,
     m->dn_delay_us   = DEFAULT_DELAY_US;  // pause between delays 
     m->ramp_steps = RAMP_STEPS; // steps to accel/decel over
     m->ramp_start_factor = RAMP_START_FACTOR; // start/stop slowdown vs cruise
+    m->ramp_profile = RAMP_PROFILE;
+    stepper_build_ramp(m);
     m->position      = 0;
     m->dir           = 0;
     // controlling steps
     m->target_pos    = 0;
-    m->max_pulses    = 60;  // pulses per command, ~1 deg
+    m->through_steps = 0;
     m->steps_in_direction = 0;
+    m->q_head        = 0;
+    m->q_fed         = 0;
+    m->q_tail        = 0;
+    m->running       = false;
+    m->idle_at       = get_absolute_time();
 
     gpio_init(dir_pin);
     gpio_set_dir(dir_pin, GPIO_OUT);
 
-    gpio_init(pulse_pin);
-    gpio_set_dir(pulse_pin, GPIO_OUT);
-
     gpio_init(enable_pin);
     gpio_set_dir(enable_pin, GPIO_OUT);
 
-    /* Disable motor by default and ensure pulse pin is low */
-    gpio_put(m->pulse_pin, 0);
+    /* Disable motor by default; the PIO init drives the pulse pin low */
     stepper_disable(m);
+    m->sm = (uint)pio_claim_unused_sm(STEPPER_PIO, true);
+    stepper_program_init(STEPPER_PIO, m->sm, stepper_offset, pulse_pin);
+    pio_set_irq0_source_enabled(STEPPER_PIO,
+                                (pio_interrupt_source_t)(pis_interrupt0 + m->sm),
+                                true);
+}
+
+/**
+ * @brief Pack one step into a PIO TX word.
+ *
+ * Both phases are in microseconds (one SM tick); the program spends 3 ticks
+ * of fixed overhead in the high phase and 5 in the low phase, and each count
+ * is 16 bits, so phases are clamped to [overhead, overhead + 0xffff].
+ */
+static uint32_t stepper_word(uint32_t high_us, uint32_t low_us) {
+    uint32_t x = high_us > 3 ? MIN(high_us - 3, 0xffffu) : 0;
+    uint32_t y = low_us  > 5 ? MIN(low_us  - 5, 0xffffu) : 0;
+    return x | (y << 16);
+}
+
+/* Move planned steps into the PIO FIFO. Caller holds interrupts off. */
+static void stepper_feed(Stepper *m) {
+    while (m->q_fed != m->q_head &&
+           !pio_sm_is_tx_fifo_full(STEPPER_PIO, m->sm)) {
+        pio_sm_put(STEPPER_PIO, m->sm,
+                   m->q_buf[m->q_fed & (STEP_QUEUE_LEN - 1)]);
+        m->q_fed++;
+    }
+}
+
+/* Rising-edge bookkeeping for one axis, from the PIO IRQ. */
+static void stepper_step_irq(Stepper *m) {
+    if (!pio_interrupt_get(STEPPER_PIO, m->sm)) return;
+    pio_interrupt_clear(STEPPER_PIO, m->sm);
+    uint32_t word = m->q_buf[m->q_tail & (STEP_QUEUE_LEN - 1)];
+    m->q_tail++;
+    m->position += m->dir;
+    // (x + 3) + (y + 5) ticks from this edge to the next possible one
+    m->idle_at = make_timeout_time_us((word & 0xffffu) + (word >> 16) + 8);
+    stepper_feed(m);
+}
+
+static void stepper_pio_irq_handler(void) {
+    stepper_step_irq(&azimuth);
+    stepper_step_irq(&elevation);
 }
 
 void motor_init(uint8_t app_id) {
+    stepper_offset = pio_add_program(STEPPER_PIO, &stepper_program);
     stepper_init(&azimuth, AZ_DIR_PIN, AZ_PUL_PIN, AZ_EN_PIN, AZ_CW_VAL);
     stepper_init(&elevation, EL_DIR_PIN, EL_PUL_PIN, EL_EN_PIN, EL_CW_VAL);
+    irq_set_exclusive_handler(STEPPER_PIO_IRQ, stepper_pio_irq_handler);
+    irq_set_enabled(STEPPER_PIO_IRQ, true);
     boot_id = get_rand_32() & 0x3fffffff;
 }
 
 /**
- * @brief Perform one step of the motor in the currently set direction.
+ * @brief Discard every queued step that has not started yet.
  *
- * Toggles the pulse pin to advance the motor one increment,
- * updates the internal position counter, and ensures the driver
- * is enabled for the pulse duration.
+ * Drops both the planned ring and the words already in the PIO FIFO. The
+ * SM is paused for the few instructions it takes to count and clear the
+ * FIFO (stretching the current phase by well under a microsecond), so a
+ * word cannot be pulled between the count and the clear. The step in flight
+ * completes, so the axis stops within one step period and `position` is
+ * final once the SM stalls. Used by halt, retarget and set_pos so a command
+ * never waits behind the lookahead.
  *
- * @param m Pointer to the Stepper instance representing the motor.
+ * @param m Pointer to the Stepper instance to flush.
  */
-void stepper_tick(Stepper *m, int extra_delay_us) {
-    gpio_put(m->pulse_pin, 1);
-    sleep_us(m->up_delay_us); // keep active timing tight
-    gpio_put(m->pulse_pin, 0);
-    sleep_us(m->dn_delay_us + extra_delay_us); // to throttle start/stop
-    // Update position
-    m->position += m->dir;
+void stepper_flush(Stepper *m) {
+    uint32_t irq = save_and_disable_interrupts();
+    pio_sm_set_enabled(STEPPER_PIO, m->sm, false);
+    uint32_t in_fifo = pio_sm_get_tx_fifo_level(STEPPER_PIO, m->sm);
+    pio_sm_clear_fifos(STEPPER_PIO, m->sm);
+    pio_sm_set_enabled(STEPPER_PIO, m->sm, true);
+    m->q_fed -= in_fifo;
+    uint32_t dropped = m->q_head - m->q_fed;
+    m->q_head = m->q_fed;
+    restore_interrupts(irq);
+    m->steps_in_direction -= MIN(dropped, m->steps_in_direction);
 }
 
+/**
+ * @brief Top up the step queue toward target_pos and keep the PIO fed.
+ *
+ * Plans from the position the axis will have once everything already queued
+ * has been emitted, so it can be called every main-loop pass and returns in
+ * microseconds. Disables the driver once the last step has finished, and a
+ * reversal waits for that before the direction pin flips.
+ *
+ * @param m Pointer to the Stepper instance to plan for.
+ */
 void stepper_op(Stepper *m) {
-    int new_dir;
-    int remaining_steps = m->target_pos - m->position;
+    uint32_t irq = save_and_disable_interrupts();
+    int32_t position = m->position;
+    uint32_t queued = m->q_head - m->q_tail;
+    absolute_time_t idle_at = m->idle_at;
+    restore_interrupts(irq);
+
+    if (m->running && queued == 0 && time_reached(idle_at)) {
+        stepper_disable(m);
+        m->running = false;
+    }
+
+    int32_t planned_pos = position + m->dir * (int32_t)queued;
+    int remaining_steps = m->target_pos - planned_pos;
     int abs_steps = abs(remaining_steps);
-    int nsteps = MIN(m->max_pulses, abs_steps);  // how many steps to take now
+    int new_dir;
 
     if      (remaining_steps > 0) new_dir =  1;
     else if (remaining_steps < 0) new_dir = -1;
-    else                          new_dir =  0;   // already there
+    else                          new_dir =  0;   // already there (or queued)
 
-    bool change_dir = (new_dir != m->dir);
-    m->dir = new_dir;
-    if (change_dir) m->steps_in_direction = 0;
+    if (new_dir != m->dir) {
+        if (m->running) return;  // let the in-flight step finish first
+        m->dir = new_dir;
+        m->steps_in_direction = 0;
+        gpio_put(m->direction_pin, m->dir > 0 ? m->cw_val : !m->cw_val);
+    }
+    int nsteps = MIN((int)(STEP_QUEUE_LEN - queued), abs_steps);
     if (nsteps == 0) return;  // nothing to do, skip enable/disable toggling
 
-    // Constant-acceleration ramp, evaluated per step. steps_in_direction
-    // accumulates across the 60-step batches and resets on a reversal, so the
-    // accel ramp spans batches and re-ramps after every direction change.
-    // abs_steps is the distance left to the target, giving the decel ramp.
-    // Taking the slower (larger-extra) of the two keeps short moves
-    // (< 2*ramp_steps) triangular instead of overshooting cruise.
-    uint32_t cruise_period = m->up_delay_us + m->dn_delay_us;
-
-    // set correct direction for motor
-    gpio_put(m->direction_pin, m->dir > 0 ? m->cw_val : !m->cw_val);
-
-    stepper_enable(m);
+    // Constant-acceleration ramp, looked up per step as it is queued.
+    // steps_in_direction accumulates across top-ups and resets on a
+    // reversal, so the accel ramp spans the whole move and re-ramps after
+    // every direction change. abs_steps is the distance left to the target
+    // beyond what is already queued, plus through_steps when a blended
+    // waypoint carries on past it, giving the decel ramp. Taking the
+    // slower (larger-extra) of the two keeps short moves (< 2*ramp_steps)
+    // triangular instead of overshooting cruise.
     for (int i = 0; i < nsteps; i++) {
         uint32_t k_up = m->steps_in_direction + i;       // steps since start
-        uint32_t k_dn = (uint32_t)(abs_steps - i - 1);   // steps left to go
+        uint32_t k_dn = (uint32_t)(abs_steps - i - 1)    // steps left to go
+                        + m->through_steps;
         uint32_t k = MIN(k_up, k_dn);
-        int extra_delay_us = (int)ramp_extra(
-            k, m->ramp_steps, m->ramp_start_factor, cruise_period);
-        stepper_tick(m, extra_delay_us);
+        uint32_t low_us = m->dn_delay_us + ramp_table_extra(&m->ramp, k);
+        m->q_buf[(m->q_head + i) & (STEP_QUEUE_LEN - 1)] =
+            stepper_word(m->up_delay_us, low_us);
     }
-    stepper_disable(m);
     m->steps_in_direction += nsteps;
+
+    if (!m->running) {
+        m->running = true;
+        stepper_enable(m);
+    }
+    // Publish and prime the FIFO; afterwards the step IRQ keeps it topped
+    // up from the ring.
+    irq = save_and_disable_interrupts();
+    m->q_head += nsteps;
+    stepper_feed(m);
+    restore_interrupts(irq);
 }
-	
 
 /**
  * @brief Disable the stepper motor and clear outputs.
@@ -146,47 +269,287 @@ void stepper_disable(Stepper *m) {
     gpio_put(m->enable_pin, 1);
 }
 
-// cmd is a JSON command string with pulses and delay_us for az/el
-void motor_server(uint8_t app_id, const char *json_str) {
-    cJSON *item_json;
-    cJSON *root = cJSON_Parse(json_str);
-    if (!root || !cJSON_IsObject(root)) {
-        cJSON_Delete(root);
-        return;
+/* True once every step up to target_pos is queued (not necessarily
+ * emitted). */
+static bool stepper_planned(Stepper *m) {
+    uint32_t irq = save_and_disable_interrupts();
+    int32_t position = m->position;
+    uint32_t queued = m->q_head - m->q_tail;
+    restore_interrupts(irq);
+    return position + m->dir * (int32_t)queued == m->target_pos;
+}
+
+/* True once the axis is at target_pos with its driver released and
+ * direction cleared, so the next move starts a fresh accel ramp. */
+static bool stepper_stopped(const Stepper *m) {
+    return !m->running && m->dir == 0 && m->position == m->target_pos;
+}
+
+/* Steps an axis moving from -> to keeps going past `to` toward `next`
+ * without reversing; 0 if it must stop at `to`. */
+static uint32_t waypoint_through(int32_t from, int32_t to, int32_t next) {
+    int32_t d1 = to - from;
+    int32_t d2 = next - to;
+    if (d1 == 0 || d2 == 0 || (d1 > 0) != (d2 > 0)) return 0;
+    return (uint32_t)abs(d2);
+}
+
+/**
+ * @brief Drop every queued waypoint and hand the axes back to plain targets.
+ *
+ * An axis blending into the next waypoint has cruise-speed steps queued
+ * that assumed it would keep going; those are flushed so stepper_op()
+ * replans the decel ramp to the current target.
+ */
+static void waypoint_clear(void) {
+    wp_head = wp_tail = 0;
+    wp_active = wp_blend = wp_dwelling = false;
+    if (azimuth.through_steps) {
+        azimuth.through_steps = 0;
+        stepper_flush(&azimuth);
     }
-    item_json = cJSON_GetObjectItem(root, "az_set_pos");
-    azimuth.position = item_json ? item_json->valueint : azimuth.position;
-    // if changing position definitions, better reset target too
-    azimuth.target_pos = item_json ? azimuth.position : azimuth.target_pos;
-    item_json = cJSON_GetObjectItem(root, "el_set_pos");
-    elevation.position = item_json ? item_json->valueint : elevation.position;
-    // if changing position definitions, better reset target too
-    elevation.target_pos = item_json ? elevation.position : elevation.target_pos;
-
-    item_json = cJSON_GetObjectItem(root, "az_set_target_pos");
-    azimuth.target_pos = item_json ? item_json->valueint : azimuth.target_pos;
-    item_json = cJSON_GetObjectItem(root, "el_set_target_pos");
-    elevation.target_pos = item_json ? item_json->valueint : elevation.target_pos;
-    // Process halt request
-    item_json = cJSON_GetObjectItem(root, "halt");
-    azimuth.target_pos = item_json ? azimuth.position : azimuth.target_pos;
-    elevation.target_pos = item_json ? elevation.position : elevation.target_pos;
-        
-    item_json = cJSON_GetObjectItem(root, "az_up_delay_us");
-    azimuth.up_delay_us = item_json ? item_json->valueint : azimuth.up_delay_us;
-    item_json = cJSON_GetObjectItem(root, "az_dn_delay_us");
-    azimuth.dn_delay_us = item_json ? item_json->valueint : azimuth.dn_delay_us;
-    item_json = cJSON_GetObjectItem(root, "el_up_delay_us");
-    elevation.up_delay_us = item_json ? item_json->valueint : elevation.up_delay_us;
-    item_json = cJSON_GetObjectItem(root, "el_dn_delay_us");
-    elevation.dn_delay_us = item_json ? item_json->valueint : elevation.dn_delay_us;
-
-    cJSON_Delete(root);
+    if (elevation.through_steps) {
+        elevation.through_steps = 0;
+        stepper_flush(&elevation);
+    }
+}
+
+/**
+ * @brief Append a wp_add list: [[az, el], [az, el, dwell_ms], ...].
+ *
+ * All or nothing: a malformed entry, or more entries than the queue has
+ * room for, rejects the whole list, so the host can retry the same chunk.
+ *
+ * @return false if the list was rejected.
+ */
+static bool waypoint_add(const cJSON *list) {
+    uint32_t room = WAYPOINT_QUEUE_LEN - (wp_head - wp_tail);
+    if (!cJSON_IsArray(list) || cJSON_GetArraySize(list) > (int)room) {
+        return false;
+    }
+    uint32_t n = 0;
+    const cJSON *entry;
+    cJSON_ArrayForEach(entry, list) {
+        int size = cJSON_GetArraySize(entry);
+        if (!cJSON_IsArray(entry) || size < 2 || size > 3) return false;
+        const cJSON *az = cJSON_GetArrayItem(entry, 0);
+        const cJSON *el = cJSON_GetArrayItem(entry, 1);
+        const cJSON *dwell = size == 3 ? cJSON_GetArrayItem(entry, 2) : NULL;
+        if (!cJSON_IsNumber(az) || !cJSON_IsNumber(el)) return false;
+        if (dwell && (!cJSON_IsNumber(dwell) || dwell->valuedouble < 0)) {
+            return false;
+        }
+        // Staged past wp_head; published only once the whole list parsed.
+        Waypoint *w = &wp_buf[(wp_head + n) & (WAYPOINT_QUEUE_LEN - 1)];
+        w->az = az->valueint;
+        w->el = el->valueint;
+        w->dwell_ms = dwell ? (uint32_t)dwell->valueint : 0;
+        n++;
+    }
+    wp_head += n;
+    return true;
+}
+
+/**
+ * @brief Advance the waypoint queue; runs before stepper_op() each pass.
+ *
+ * A waypoint completes once both axes have stopped on it and its dwell has
+ * elapsed. The exception is blending: when a waypoint has no dwell, only
+ * one axis moves, and the next waypoint continues that axis the same way,
+ * the axis plans its decel against the far end (through_steps) and the
+ * next waypoint takes over as soon as the last step to this one is queued,
+ * so collinear raster points run through at cruise speed. Segments that
+ * move both axes always stop: the axes would not finish together, and a
+ * blended axis must never be left waiting at cruise.
+ */
+static void waypoint_op(void) {
+    if (wp_active) {
+        const Waypoint *w = &wp_buf[(wp_tail - 1) & (WAYPOINT_QUEUE_LEN - 1)];
+        if (wp_blend) {
+            if (!stepper_planned(&azimuth) || !stepper_planned(&elevation)) {
+                return;
+            }
+        } else {
+            if (!stepper_stopped(&azimuth) || !stepper_stopped(&elevation)) {
+                return;
+            }
+            if (w->dwell_ms) {
+                if (!wp_dwelling) {
+                    wp_dwelling = true;
+                    wp_dwell_until = make_timeout_time_ms(w->dwell_ms);
+                }
+                if (!time_reached(wp_dwell_until)) return;
+            }
+        }
+        wp_active = wp_blend = wp_dwelling = false;
+        azimuth.through_steps = elevation.through_steps = 0;
+    }
+    if (wp_tail == wp_head) return;
+
+    const Waypoint *w = &wp_buf[wp_tail & (WAYPOINT_QUEUE_LEN - 1)];
+    wp_tail++;
+    wp_active = true;
+    if (w->dwell_ms == 0 && wp_tail != wp_head) {
+        const Waypoint *next = &wp_buf[wp_tail & (WAYPOINT_QUEUE_LEN - 1)];
+        bool az_moves = w->az != azimuth.target_pos;
+        bool el_moves = w->el != elevation.target_pos;
+        if (az_moves != el_moves) {
+            Stepper *m = az_moves ? &azimuth : &elevation;
+            int32_t to = az_moves ? w->az : w->el;
+            int32_t next_to = az_moves ? next->az : next->el;
+            m->through_steps = waypoint_through(m->target_pos, to, next_to);
+            wp_blend = m->through_steps != 0;
+        }
+    }
+    azimuth.target_pos = w->az;
+    elevation.target_pos = w->el;
+}
+
+// Position, target and halt keys stage here and apply in a fixed order
+// (set_pos, then set_target_pos, then halt) whatever order the line has
+// them in: a target sent with a position redefinition sticks, and a halt
+// wins over both.
+typedef struct {
+    Stepper *m;
+    bool set_pos, set_target;
+    int32_t pos, target;
+} AxisCmd;
+
+static AxisCmd az_cmd = { .m = &azimuth };
+static AxisCmd el_cmd = { .m = &elevation };
+static bool halt_cmd;
+
+static void stage_pos(void *ctx, double v) {
+    AxisCmd *c = ctx;
+    c->set_pos = true;
+    c->pos = (int32_t)v;
 }
 
+static void stage_target(void *ctx, double v) {
+    AxisCmd *c = ctx;
+    c->set_target = true;
+    c->target = (int32_t)v;
+}
+
+// Any value halts, as the key's presence always did.
+static void stage_halt(void *ctx, double v) {
+    (void)ctx;
+    (void)v;
+    halt_cmd = true;
+}
+
+static void set_delay(void *ctx, double v) {
+    *(uint32_t *)ctx = (uint32_t)(int32_t)v;
+}
+
+// Steps already queued keep the old shape.
+static void set_ramp_profile(void *ctx, double v) {
+    ((Stepper *)ctx)->ramp_profile = (uint8_t)v;
+}
+
+// Applied as it comes: wp_add is read after the table, so
+// {"wp_clear":0,"wp_add":[...]} replaces the program in either order.
+static void set_wp_clear(void *ctx, double v) {
+    (void)ctx;
+    (void)v;
+    waypoint_clear();
+}
+
+// Anything that redefines position or target discards the queued
+// lookahead first, so the change takes effect within one step period and
+// the next stepper_op() replans (decel ramp included) from where the
+// axis actually is. Each of them also takes the axes back from the
+// waypoint queue.
+static void axis_cmd_apply(AxisCmd *c) {
+    Stepper *m = c->m;
+    if (c->set_pos) {
+        waypoint_clear();
+        stepper_flush(m);
+        m->position = c->pos;
+        // if changing position definitions, better reset target too
+        m->target_pos = m->position;
+    }
+    if (c->set_target) {
+        waypoint_clear();
+        if (c->target != m->target_pos) {
+            stepper_flush(m);
+            m->target_pos = c->target;
+        }
+    }
+    c->set_pos = c->set_target = false;
+}
+
+// Positions and delays take any number, saturated to int32 as cJSON's
+// valueint does; a ramp profile only RAMP_PROFILE_LINEAR or
+// RAMP_PROFILE_SCURVE exactly.
+#define MOTOR_AXIS_KEYS(prefix, m, c)                                      \
+    { prefix "dn_delay_us", CMD_INT, CMD_CLAMP, INT32_MIN, INT32_MAX,      \
+      set_delay, &(m).dn_delay_us },                                       \
+    { prefix "ramp_profile", CMD_ENUM, CMD_REJECT, RAMP_PROFILE_LINEAR,    \
+      RAMP_PROFILE_SCURVE, set_ramp_profile, &(m) },                       \
+    { prefix "set_pos", CMD_INT, CMD_CLAMP, INT32_MIN, INT32_MAX,          \
+      stage_pos, &(c) },                                                   \
+    { prefix "set_target_pos", CMD_INT, CMD_CLAMP, INT32_MIN, INT32_MAX,   \
+      stage_target, &(c) },                                                \
+    { prefix "up_delay_us", CMD_INT, CMD_CLAMP, INT32_MIN, INT32_MAX,      \
+      set_delay, &(m).up_delay_us }
+
+// Sorted by key: "az_" < "el_" < "halt" < "wp_clear". wp_add is a list,
+// not a table type; motor_server() reads it.
+const CmdKey motor_keys[] = {
+    MOTOR_AXIS_KEYS("az_", azimuth, az_cmd),
+    MOTOR_AXIS_KEYS("el_", elevation, el_cmd),
+    { "halt", CMD_BOOL, CMD_CLAMP, 0, 1, stage_halt, NULL },
+    { "wp_clear", CMD_BOOL, CMD_CLAMP, 0, 1, set_wp_clear, NULL },
+};
+const size_t motor_keys_len = CMD_TABLE_LEN(motor_keys);
+
+// root is the command's cJSON tree, parsed once by the caller, with
+// pulses and delay_us for az/el
+void motor_server(uint8_t app_id, const cJSON *root) {
+    if (!cJSON_IsObject(root)) {
+        return;
+    }
+    const uint32_t az_cruise = azimuth.up_delay_us + azimuth.dn_delay_us;
+    const uint32_t el_cruise = elevation.up_delay_us + elevation.dn_delay_us;
+    const uint8_t az_profile = azimuth.ramp_profile;
+    const uint8_t el_profile = elevation.ramp_profile;
+
+    cmd_table_dispatch(motor_keys, motor_keys_len, root);
+    axis_cmd_apply(&az_cmd);
+    axis_cmd_apply(&el_cmd);
+    if (halt_cmd) {
+        halt_cmd = false;
+        waypoint_clear();
+        stepper_flush(&azimuth);
+        stepper_flush(&elevation);
+        azimuth.target_pos = azimuth.position;
+        elevation.target_pos = elevation.position;
+    }
+
+    // Rebake the ramp only when the cruise period or profile (all the
+    // table depends on) actually changed; PicoMotor re-sends its config on
+    // every reconnect.
+    if (azimuth.up_delay_us + azimuth.dn_delay_us != az_cruise ||
+        azimuth.ramp_profile != az_profile) {
+        stepper_build_ramp(&azimuth);
+    }
+    if (elevation.up_delay_us + elevation.dn_delay_us != el_cruise ||
+        elevation.ramp_profile != el_profile) {
+        stepper_build_ramp(&elevation);
+    }
+
+    // Waypoints: wp_add appends, after any wp_clear in the same command.
+    // A refused list counts in wp_rejected, so the host sees it rather
+    // than a stall.
+    const cJSON *wp_json = cJSON_GetObjectItem(root, "wp_add");
+    if (wp_json && !waypoint_add(wp_json)) {
+        wp_rejected++;
+    }
+}
 
 void motor_status(uint8_t app_id) {
-	send_json(8,
+	send_json(13 + CMD_RX_STATUS_FIELDS,
         KV_STR, "sensor_name", "motor",
         KV_STR, "status", "update",
         KV_INT, "app_id", app_id,
@@ -194,17 +557,27 @@ void motor_status(uint8_t app_id) {
         KV_INT, "az_pos", azimuth.position,
         KV_INT, "az_target_pos", azimuth.target_pos,
         KV_INT, "el_pos", elevation.position,
-        KV_INT, "el_target_pos", elevation.target_pos
+        KV_INT, "el_target_pos", elevation.target_pos,
+        KV_INT, "az_ramp_profile", azimuth.ramp_profile,
+        KV_INT, "el_ramp_profile", elevation.ramp_profile,
+        KV_INT, "wp_index", wp_active ? (int)(wp_tail - 1) : -1,
+        KV_INT, "wp_count", (int)wp_head,
+        KV_INT, "wp_rejected", (int)wp_rejected,
+        CMD_RX_STATUS
     );
 }
 
 // No communication watchdog needed for motor app:
-// stepper_op() calls stepper_disable() after every stepping batch, so the
-// driver enable pin is held HIGH (disabled) between calls. Once position
-// reaches target, nsteps=0 and the motor is idle with driver disabled.
-// Loss of host communication causes no continuous power draw or thermal risk.
+// stepper_op() calls stepper_disable() once an axis has nothing queued and
+// idle_at (the end of the last step the PIO emitted) has passed, so the
+// driver enable pin is held HIGH (disabled) whenever the axis is idle.
+// Once position reaches target nothing more is queued and the motor stays
+// idle with driver disabled. Loss of host communication causes no
+// continuous power draw or thermal risk.
 void motor_op(uint8_t app_id) {
-	// move the stepper motors max_move steps
+	// retarget from the waypoint queue, then top up both step queues; the
+	// PIO state machines emit the pulses
+    waypoint_op();
     stepper_op(&elevation);
     stepper_op(&azimuth);
 }
@@ -14,6 +14,9 @@
 #include <stdint.h>
 #include "hardware/gpio.h"
 #include "eigsep_command.h"
+#include "cJSON.h"
+#include "cmd_table.h"
+#include "motor_ramp.h"
 
 /**
  * @param m Pointer to the Stepper instance to initialize.
@@ -42,6 +45,43 @@
 // for gentler starts at the cost of slightly slower short moves.
 #define RAMP_STEPS 100
 #define RAMP_START_FACTOR 2.5f
+// Boot-time ramp shape; the host selects per axis with az_ramp_profile /
+// el_ramp_profile. RAMP_PROFILE_SCURVE (jerk-limited) tolerates shorter
+// cruise periods under load at the same RAMP_STEPS.
+#define RAMP_PROFILE RAMP_PROFILE_LINEAR
+_Static_assert(RAMP_STEPS <= RAMP_TABLE_LEN,
+               "RAMP_STEPS exceeds the RampTable size in motor_ramp.h");
+
+// Step engine lookahead. motor_op() precomputes the ramped step timing into
+// a per-axis ring of this many steps; the PIO step IRQ moves them into the
+// axis' state-machine FIFO, which emits the pulses (src/stepper.pio). Deep
+// enough to ride over a status print or a burst of serial input at cruise
+// speed (~38 ms at the default 1.2 ms period). Halt and retarget discard
+// whatever is queued, including the PIO FIFO, so the depth does not add to
+// stop latency. Must be a power of two.
+#define STEP_QUEUE_LEN 32
+
+// One PIO block drives both axes, one state machine each, so azimuth and
+// elevation pulse concurrently with cycle-exact timing. The per-step IRQ
+// (position count + FIFO refill) is routed to this block's IRQ 0.
+#define STEPPER_PIO      pio0
+#define STEPPER_PIO_IRQ  PIO0_IRQ_0
+
+// Waypoint queue (wp_add). motor_op() retargets both axes from it without
+// a host round trip per point; see waypoint_op() in motor.c. A wp_add line
+// must fit in BUFFER_SIZE, so the host streams longer lists in chunks as
+// the queue drains. Must be a power of two.
+#define WAYPOINT_QUEUE_LEN 32
+
+/**
+ * @struct Waypoint
+ * @brief One queued (az, el) target with an optional dwell after arrival.
+ */
+typedef struct {
+    int32_t  az;       /**< azimuth target, steps */
+    int32_t  el;       /**< elevation target, steps */
+    uint32_t dwell_ms; /**< hold time once both axes have stopped; 0 = none */
+} Waypoint;
 
 /**
  * @struct Stepper
@@ -56,21 +96,42 @@ typedef struct {
     uint32_t dn_delay_us;     /**< delay between steps */    
     uint32_t ramp_steps;       /**< steps over which to accel/decel */
     float    ramp_start_factor; /**< start/stop period = cruise * this factor */
-    uint32_t steps_in_direction;
-    int32_t position;      /**< Current motor position in steps */     
+    uint8_t  ramp_profile;     /**< RAMP_PROFILE_LINEAR or RAMP_PROFILE_SCURVE */
+    RampTable ramp;            /**< ramp profile baked for the current delays */
+    uint32_t steps_in_direction; /**< steps queued since the last reversal */
+    volatile int32_t position; /**< Current motor position in steps (ISR-owned while running) */
     int8_t  dir;           /**< Current direction flag (1 = CW, -1 = CCW) */         
     int32_t target_pos;
-    int32_t max_pulses;    /**< Maximum steps to move in current operation */
+    uint32_t through_steps; /**< steps the move continues past target_pos
+                                 in the same direction (waypoint blending);
+                                 0 = decelerate to a stop at target_pos */
+    uint     sm;            /**< PIO state machine emitting this axis' pulses */
+    /* Step queue, as free-running counters: q_head counts steps planned
+       (motor_op), q_fed steps pushed into the PIO FIFO, q_tail steps whose
+       rising edge has been seen by the step IRQ. Each entry is one packed
+       PIO step word (see stepper_word()). */
+    uint32_t q_buf[STEP_QUEUE_LEN];
+    volatile uint32_t q_head;
+    volatile uint32_t q_fed;
+    volatile uint32_t q_tail;
+    bool     running;         /**< driver enabled for a move in progress */
+    volatile absolute_time_t idle_at; /**< end of the last emitted step */
 } Stepper;
 
 // report motor status
 void motor_init(uint8_t);
-void motor_server(uint8_t, const char *);
+void motor_server(uint8_t, const cJSON *);
 void motor_op(uint8_t);
 void motor_status(uint8_t);
 void stepper_op(Stepper *);
+void stepper_flush(Stepper *);
 void stepper_disable(Stepper *);
 void stepper_enable(Stepper *);
 
+// Command keys, sorted for cmd_table_dispatch() (checked by
+// host/test_cmd_table.c).
+extern const CmdKey motor_keys[];
+extern const size_t motor_keys_len;
+
 #endif // MOTOR_H
 
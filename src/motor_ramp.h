@@ -1,11 +1,13 @@
 /**
  * @file motor_ramp.h
- * @brief Pure constant-acceleration step-delay ramp for the stepper driver.
+ * @brief Pure step-delay ramp profiles for the stepper driver.
  *
  * Kept dependency-free (only <stdint.h>/<math.h>, no pico headers) so the
  * timing math can be compiled and unit-tested on the host independently of
- * the firmware that uses it. `motor.c` includes this and calls ramp_extra()
- * once per step inside stepper_op().
+ * the firmware that uses it (see host/test_motor_ramp.c). `motor.c` bakes
+ * the selected profile (ramp_extra() or scurve_extra()) into a RampTable
+ * whenever the step timing changes and looks it up once per queued step in
+ * stepper_op().
  */
 
 #ifndef MOTOR_RAMP_H
@@ -45,4 +47,94 @@ static inline uint32_t ramp_extra(uint32_t k, uint32_t ramp_steps,
                       + 0.5f);
 }
 
+/**
+ * @brief Extra per-step delay (us) above cruise for a jerk-limited ramp.
+ *
+ * Same endpoints as ramp_extra() (v_cruise/F at k=0, cruise from
+ * k=ramp_steps) but v^2 follows a smoothstep instead of a straight line:
+ *     v(k)^2 / v_cruise^2 = 1/F^2 + (1 - 1/F^2) * s(k/D),
+ *     s(u) = 3u^2 - 2u^3
+ * Since acceleration is proportional to d(v^2)/dx, it rises from zero at
+ * the slow end and falls back to zero at cruise instead of stepping on and
+ * off, removing the torque jump that costs steps under load at short
+ * cruise periods. Peak acceleration (mid-ramp) is 1.5x that of
+ * ramp_extra() over the same distance.
+ *
+ * @param k             steps from the nearer slow end (0 = slowest)
+ * @param ramp_steps    ramp distance D in steps
+ * @param start_factor  F > 1; first/last step runs F times slower than cruise
+ * @param cruise_period cruise step period (up_delay + dn_delay), microseconds
+ * @return extra microseconds to add to the step period (0 at/after cruise)
+ */
+static inline uint32_t scurve_extra(uint32_t k, uint32_t ramp_steps,
+                                    float start_factor,
+                                    uint32_t cruise_period) {
+    if (k >= ramp_steps) {
+        return 0;
+    }
+    float inv_f2 = 1.0f / (start_factor * start_factor);
+    float u = (float)k / (float)ramp_steps;
+    float s = u * u * (3.0f - 2.0f * u);
+    float v_rel = sqrtf(inv_f2 + (1.0f - inv_f2) * s);
+    return (uint32_t)((float)cruise_period / v_rel - (float)cruise_period
+                      + 0.5f);
+}
+
+/* Ramp shapes selectable per axis (az_ramp_profile / el_ramp_profile). */
+#define RAMP_PROFILE_LINEAR 0  /* constant acceleration, ramp_extra() */
+#define RAMP_PROFILE_SCURVE 1  /* jerk-limited, scurve_extra() */
+
+/* Longest ramp a RampTable can hold: one entry per ramp step. RAMP_STEPS
+   in motor.h is checked against this at compile time. */
+#define RAMP_TABLE_LEN 256
+
+/**
+ * @brief A ramp profile baked for one (ramp_steps, start_factor, cruise) set.
+ *
+ * The per-step sqrtf and divides move to ramp_table_build(), which runs
+ * only when the step timing changes; ramp_table_extra() is then a bounds
+ * check and a load, so the planning cost per step no longer depends on
+ * float throughput.
+ *
+ * Entries are fixed point with a resolution of one whole microsecond, not
+ * a fraction of one: the step PIO counts in 1 us ticks (stepper.pio), so
+ * any finer part would be dropped when the step word is packed.
+ */
+typedef struct {
+    uint32_t ramp_steps;
+    uint32_t extra_us[RAMP_TABLE_LEN];  /* profile extra for k < ramp_steps,
+                                           whole us, rounded to nearest */
+} RampTable;
+
+/**
+ * @brief Fill `t` from the analytic curve for `profile`.
+ *
+ * RAMP_PROFILE_SCURVE selects scurve_extra(); any other value falls back to
+ * ramp_extra(). A ramp longer than RAMP_TABLE_LEN is shortened to it: the
+ * whole profile is fitted into RAMP_TABLE_LEN steps, so the period still
+ * falls smoothly to cruise, only sooner than asked. (RAMP_STEPS cannot
+ * ask for more today; motor.h checks it at compile time.)
+ */
+static inline void ramp_table_build(RampTable *t, uint8_t profile,
+                                    uint32_t ramp_steps, float start_factor,
+                                    uint32_t cruise_period) {
+    t->ramp_steps = ramp_steps < RAMP_TABLE_LEN ? ramp_steps : RAMP_TABLE_LEN;
+    for (uint32_t k = 0; k < t->ramp_steps; k++) {
+        t->extra_us[k] = profile == RAMP_PROFILE_SCURVE
+            ? scurve_extra(k, t->ramp_steps, start_factor, cruise_period)
+            : ramp_extra(k, t->ramp_steps, start_factor, cruise_period);
+    }
+}
+
+/**
+ * @brief Table lookup equivalent to the baked profile's extra(k, ...).
+ *
+ * @param t  table filled by ramp_table_build()
+ * @param k  steps from the nearer slow end (0 = slowest)
+ * @return extra microseconds to add to the step period (0 at/after cruise)
+ */
+static inline uint32_t ramp_table_extra(const RampTable *t, uint32_t k) {
+    return k < t->ramp_steps ? t->extra_us[k] : 0;
+}
+
 #endif  /* MOTOR_RAMP_H */
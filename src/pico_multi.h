@@ -20,17 +20,28 @@
 #define APP_RFSWITCH    5
 #define APP_IMU_AZ      6  // emulator: imu
 
-// status reporting cadence
-#define STATUS_CADENCE_MS 200
+// Dual-core mode: core 1 runs the app (init, server, op, status) and
+// core 0 only USB I/O, universal commands and the status timer, so a
+// slow op() no longer delays command receipt or status timing. See
+// core_link.h. Off by default; build with -DPICO_MULTI_DUAL_CORE=ON.
+#ifndef PICO_MULTI_DUAL_CORE
+#define PICO_MULTI_DUAL_CORE 0
+#endif
 
-// Maximum time (µs) to spend reading serial before running app_op().
-// The main loop prioritizes draining the serial FIFO (via continue) so
-// that slow app_op() implementations (e.g. motor stepping at ~144-288ms)
-// don't block command receipt. However, if serial data arrives
-// continuously without a newline terminator, app_op() would be starved
-// indefinitely. This threshold instead guarantees that serial draining
-// will not defer the next app_op() call for more than MAX_READ_ONLY_US
-// after the previous app_op() completes.
-#define MAX_READ_ONLY_US 50000  // 50 ms
+// Status reporting cadence. Every app boots at STATUS_CADENCE_MS; the
+// universal {"cadence_ms":N} command (main.c) moves it within the app's
+// bounds below, clamping out-of-range requests. Minimums sit at what an
+// app can usefully refresh (the IMU and lidar sample fast enough for
+// 50 Hz pointing; tempctrl samples every TEMPCTRL_SAMPLE_MS = 200 ms).
+// The shared maximum keeps a status packet well inside the host's 10 s
+// health timeout.
+#define STATUS_CADENCE_MS 200
+#define CADENCE_MAX_MS    5000
+#define CADENCE_MIN_MS_MOTOR     50
+#define CADENCE_MIN_MS_TEMPCTRL  200
+#define CADENCE_MIN_MS_POTMON    50
+#define CADENCE_MIN_MS_IMU       20
+#define CADENCE_MIN_MS_LIDAR     20
+#define CADENCE_MIN_MS_RFSWITCH  100
 
 #endif // PICO_MULTI_H
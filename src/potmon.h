@@ -3,12 +3,13 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include "hardware/adc.h"
 #include "eigsep_command.h"
-
-#define POTMON_ADC_CH_AZ        0
+#include "cJSON.h"
+#include "adc_sampler.h"
+#include "cmd_table.h"
 
 #define POTMON_GPIO_AZ          26
+#define POTMON_VREF             ADC_SAMPLER_VREF
 
 /* SP1 failsafe termination control. The pin was freed when the el pot
  * was removed. LOW = SHORT cap (failsafe: matches the unpowered state
@@ -18,10 +19,6 @@
 #define POTMON_SP1_TERM_SHORT   0
 #define POTMON_SP1_TERM_OPEN    1
 
-#define POTMON_ADC_BITS         12
-#define POTMON_ADC_MAX          ((1 << POTMON_ADC_BITS) - 1)
-#define POTMON_VREF             3.3f
-
 typedef struct {
     uint    gpio_pin;
     uint    adc_channel;
@@ -31,7 +28,12 @@ typedef struct {
 
 void potmon_init(uint8_t app_id);
 void potmon_op(uint8_t app_id);
-void potmon_server(uint8_t app_id, const char *json_str);
+void potmon_server(uint8_t app_id, const cJSON *root);
 void potmon_status(uint8_t app_id);
 
+/* Command keys, sorted for cmd_table_dispatch() (checked by
+ * host/test_cmd_table.c) */
+extern const CmdKey potmon_keys[];
+extern const size_t potmon_keys_len;
+
 #endif
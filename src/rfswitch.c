@@ -1,9 +1,12 @@
 #include "rfswitch.h"
+#include "cmd_rx.h"
 #include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
 #include "cJSON.h"
 #include <math.h>
 #include <stdlib.h>
-#include "temp_simple.h"
+#include "adc_sampler.h"
 
 static RFSwitch rfswitch;
 
@@ -11,96 +14,290 @@ static RFSwitch rfswitch;
 // the wiring spec for the harness — see "RF Switch Wiring" in README.md.
 static const uint rfswitch_addr_pins[RFSWITCH_ADDR_LINES] = {8, 10, 12, 14, 15};
 
+// Hardware alarm that ends a transition and starts sequence steps. Its
+// IRQ runs on the core that set the callback, i.e. the app core, like
+// every other app IRQ.
+static uint settle_alarm;
+
+/* Everything below that touches transition or sequence state runs with
+ * interrupts off or in the alarm IRQ. */
+
+static void rfswitch_settle(void) {
+    rfswitch.reported_state = rfswitch.commanded_state;
+    rfswitch.in_transition = false;
+    rfswitch.settled_event = true;
+}
+
+// Drive `state` onto A0..A4 at `at` (now, or a sequence step's slot) and
+// time its settle from there.
+static void rfswitch_begin(int state, absolute_time_t at) {
+    if (state == rfswitch.commanded_state && !rfswitch.in_transition) {
+        // Nothing moves; the step still gets its timestamped line.
+        rfswitch.transition_end = at;
+        rfswitch.settled_event = true;
+        return;
+    }
+    rfswitch.commanded_state = state;
+    // All five address lines in one register write, so the EEPROM
+    // never sees a transient intermediate address.
+    uint32_t mask = 0, vals = 0;
+    for (int i = 0; i < RFSWITCH_ADDR_LINES; i++) {
+        mask |= 1u << rfswitch_addr_pins[i];
+        if ((state >> i) & 0x1) {
+            vals |= 1u << rfswitch_addr_pins[i];
+        }
+    }
+    gpio_put_masked(mask, vals);
+    rfswitch.transition_end = delayed_by_us(at, SWITCH_SETTLE_US);
+    rfswitch.in_transition = true;
+}
+
+// Next sequence step, on the dwell grid: a late alarm delays the lines,
+// not the steps after it.
+static void rfswitch_seq_advance(void) {
+    absolute_time_t at = rfswitch.seq_next;
+    int step = rfswitch.seq_step + 1;
+    if (step == (int)rfswitch.seq_len) {
+        step = 0;
+        rfswitch.seq_pass++;
+        if (rfswitch.seq_repeat && rfswitch.seq_pass >= rfswitch.seq_repeat) {
+            // Done; the switch stays on the last step's path, and a
+            // line with seq_step -1 says so.
+            rfswitch.seq_running = false;
+            rfswitch.settled_event = true;
+            return;
+        }
+    }
+    rfswitch.seq_step = step;
+    rfswitch_begin(rfswitch.seq[step].state, at);
+    rfswitch.seq_next = delayed_by_us(at, rfswitch.seq[step].dwell_us);
+}
+
+// Run whatever is due and arm the alarm for whatever comes next.
+static void rfswitch_service(void) {
+    for (;;) {
+        if (rfswitch.in_transition && time_reached(rfswitch.transition_end)) {
+            rfswitch_settle();
+        }
+        if (rfswitch.seq_running && time_reached(rfswitch.seq_next)) {
+            rfswitch_seq_advance();
+            continue;
+        }
+        absolute_time_t next;
+        if (rfswitch.in_transition) {
+            next = rfswitch.transition_end;
+            if (rfswitch.seq_running &&
+                absolute_time_diff_us(rfswitch.seq_next, next) > 0) {
+                next = rfswitch.seq_next;
+            }
+        } else if (rfswitch.seq_running) {
+            next = rfswitch.seq_next;
+        } else {
+            return;
+        }
+        // false: armed. true: the target already passed, go round again.
+        if (!hardware_alarm_set_target(settle_alarm, next)) {
+            return;
+        }
+    }
+}
+
+static void rfswitch_alarm(uint alarm_num) {
+    (void)alarm_num;
+    // An alarm left pending from a target since moved finds nothing due
+    // and re-arms for the current one.
+    rfswitch_service();
+}
+
 void rfswitch_init(uint8_t app_id) {
     rfswitch.commanded_state = RF_PATH_LNA_FEED;
     rfswitch.reported_state = RF_PATH_LNA_FEED;
-    // Boot starts a transition: the physical switch position is not
-    // knowable until the settle timer elapses, even though the address
-    // lines drive to 0 (the LNA->Feed fail-safe) immediately.
     rfswitch.in_transition = true;
-    rfswitch.transition_end = make_timeout_time_ms(SWITCH_SETTLE_MS);
+    rfswitch.settled_event = false;
+    rfswitch.seq_running = false;
     for (int i = 0; i < RFSWITCH_ADDR_LINES; i++) {
         gpio_init(rfswitch_addr_pins[i]);
         gpio_set_dir(rfswitch_addr_pins[i], GPIO_OUT);
     }
+    settle_alarm = (uint)hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(settle_alarm, rfswitch_alarm);
+    // Boot starts a transition: the physical switch position is not
+    // knowable until the settle alarm fires, even though the address
+    // lines drive to 0 (the LNA->Feed fail-safe) immediately.
+    uint32_t irq = save_and_disable_interrupts();
+    rfswitch_begin(RF_PATH_LNA_FEED, get_absolute_time());
+    rfswitch_service();
+    restore_interrupts(irq);
     for (uint i = 0; i < RFSWITCH_NUM_THERM; i++) {
-        uint adc_input;
         // GP26..GP28 are always ADC-capable; adc_input == i by layout.
-        (void)adc_channel_init(RFSWITCH_THERM0_GPIO + i, &adc_input);
+        (void)adc_sampler_add_gpio(RFSWITCH_THERM0_GPIO + i,
+                                   &rfswitch.therm_adc_input[i]);
+        rfswitch.volt_therm[i] = NAN;
     }
+    rfswitch.next_therm_sample = get_absolute_time();  // first op tick samples
 }
 
+// A burned path address: an exact integer below RFSWITCH_NUM_PATHS.
+// Addresses >= RFSWITCH_NUM_PATHS hold 0xFF on the EEPROMs (every switch
+// input closed, noise diode on) and must never be presented on the bus.
+static bool rfswitch_path(const cJSON *item, int *state) {
+    if (!item || !cJSON_IsNumber(item)) {
+        return false;
+    }
+    double value = cJSON_GetNumberValue(item);
+    double integral_part = 0.0;
+    if (!isfinite(value) || modf(value, &integral_part) != 0.0 ||
+        value < 0 || value >= RFSWITCH_NUM_PATHS) {
+        return false;
+    }
+    *state = (int)value;
+    return true;
+}
 
-void rfswitch_server(uint8_t app_id, const char *json_str) {
-    cJSON *root = cJSON_Parse(json_str);
-    if (!root || !cJSON_IsObject(root)) {
-        cJSON_Delete(root);
+/**
+ * @brief Load and start a sw_sequence list: [[state, dwell_ms], ...].
+ *
+ * All or nothing, like wp_add: a malformed entry, or more than
+ * RFSWITCH_SEQ_LEN of them, rejects the whole command and leaves any
+ * running sequence alone. An empty list stops the running sequence.
+ */
+static void rfswitch_seq_load(const cJSON *list, const cJSON *repeat_json) {
+    if (!cJSON_IsArray(list) || cJSON_GetArraySize(list) > RFSWITCH_SEQ_LEN) {
         return;
     }
-    cJSON *sw_state_json = cJSON_GetObjectItem(root, "sw_state");
-    if (sw_state_json && cJSON_IsNumber(sw_state_json)) {
-        double new_state_value = cJSON_GetNumberValue(sw_state_json);
+    int n = cJSON_GetArraySize(list);
+    uint32_t repeat = 1;
+    if (repeat_json) {
+        double r = cJSON_IsNumber(repeat_json)
+            ? cJSON_GetNumberValue(repeat_json) : -1.0;
         double integral_part = 0.0;
-        bool is_exact_int = (
-            isfinite(new_state_value) &&
-            modf(new_state_value, &integral_part) == 0.0
-        );
-        // Addresses >= RFSWITCH_NUM_PATHS hold 0xFF on the EEPROMs
-        // (every switch input closed, noise diode on) and must never
-        // be presented on the bus.
-        bool is_valid_state = (
-            is_exact_int &&
-            new_state_value >= 0 &&
-            new_state_value < RFSWITCH_NUM_PATHS
-        );
-        // Only re-enter a transition when the commanded state actually
-        // changes; repeated commands at the current state are no-ops
-        // so we don't smear a settled position into UNKNOWN.
-        if (is_valid_state) {
-            int new_state = (int)new_state_value;
-            if (new_state != rfswitch.commanded_state) {
-                rfswitch.commanded_state = new_state;
-                rfswitch.transition_end = make_timeout_time_ms(SWITCH_SETTLE_MS);
-                rfswitch.in_transition = true;
-            }
+        if (!isfinite(r) || r < 0 || r > UINT32_MAX ||
+            modf(r, &integral_part) != 0.0) {
+            return;
         }
+        repeat = (uint32_t)r;
+    }
+    RFSwitchStep steps[RFSWITCH_SEQ_LEN];
+    int i = 0;
+    const cJSON *entry;
+    cJSON_ArrayForEach(entry, list) {
+        if (!cJSON_IsArray(entry) || cJSON_GetArraySize(entry) != 2) return;
+        int state;
+        if (!rfswitch_path(cJSON_GetArrayItem(entry, 0), &state)) return;
+        const cJSON *dwell = cJSON_GetArrayItem(entry, 1);
+        if (!cJSON_IsNumber(dwell)) return;
+        double dwell_ms = cJSON_GetNumberValue(dwell);
+        if (!(dwell_ms * 1000.0 >= RFSWITCH_SEQ_MIN_DWELL_US &&
+              dwell_ms <= RFSWITCH_SEQ_MAX_DWELL_MS)) {
+            return;
+        }
+        steps[i].state = (uint8_t)state;
+        steps[i].dwell_us = (uint32_t)llround(dwell_ms * 1000.0);
+        i++;
+    }
+
+    uint32_t irq = save_and_disable_interrupts();
+    rfswitch.seq_running = false;
+    if (n > 0) {
+        for (int k = 0; k < n; k++) {
+            rfswitch.seq[k] = steps[k];
+        }
+        rfswitch.seq_len = (uint)n;
+        rfswitch.seq_repeat = repeat;
+        rfswitch.seq_step = -1;
+        rfswitch.seq_pass = 0;
+        rfswitch.seq_next = get_absolute_time();
+        rfswitch.seq_running = true;
+        rfswitch_service();
+    }
+    restore_interrupts(irq);
+}
+
+static void set_sw_state(void *ctx, double value) {
+    (void)ctx;
+    int new_state = (int)value;
+    // A manual switch ends any running sequence. Only re-enter a
+    // transition when the commanded state actually changes; repeated
+    // commands at the current state are no-ops so we don't smear a
+    // settled position into UNKNOWN.
+    uint32_t irq = save_and_disable_interrupts();
+    rfswitch.seq_running = false;
+    if (new_state != rfswitch.commanded_state) {
+        rfswitch_begin(new_state, get_absolute_time());
+        rfswitch_service();
+    }
+    restore_interrupts(irq);
+}
+
+// sw_state takes a burned path address, as rfswitch_path() does. The
+// sw_sequence list is not a table type; rfswitch_server() reads it.
+const CmdKey rfswitch_keys[] = {
+    { "sw_state", CMD_ENUM, CMD_REJECT, 0, RFSWITCH_NUM_PATHS - 1,
+      set_sw_state, NULL },
+};
+const size_t rfswitch_keys_len = CMD_TABLE_LEN(rfswitch_keys);
+
+void rfswitch_server(uint8_t app_id, const cJSON *root) {
+    if (!cJSON_IsObject(root)) {
+        return;
+    }
+    cmd_table_dispatch(rfswitch_keys, rfswitch_keys_len, root);
+    cJSON *seq_json = cJSON_GetObjectItem(root, "sw_sequence");
+    if (seq_json) {
+        rfswitch_seq_load(seq_json, cJSON_GetObjectItem(root, "sw_repeat"));
     }
-    cJSON_Delete(root);
 }
 
 
 void rfswitch_status(uint8_t app_id) {
-    int reported = rfswitch.in_transition
-        ? SW_STATE_UNKNOWN
-        : rfswitch.reported_state;
-    float volt_therm[RFSWITCH_NUM_THERM];
-    for (uint i = 0; i < RFSWITCH_NUM_THERM; i++) {
-        volt_therm[i] = adc_read_avg_voltage(i);
+    uint32_t irq = save_and_disable_interrupts();
+    bool in_transition = rfswitch.in_transition;
+    int reported = in_transition ? SW_STATE_UNKNOWN : rfswitch.reported_state;
+    // Alarm time of the settle, not when this line went out, as whole
+    // seconds since boot plus microseconds: two ints stay exact where
+    // one float would not. -1 while settling.
+    int settled_s = -1;
+    int settled_us = -1;
+    if (!in_transition) {
+        uint64_t t = to_us_since_boot(rfswitch.transition_end);
+        settled_s = (int)(t / 1000000u);
+        settled_us = (int)(t % 1000000u);
     }
-    send_json(7,
+    bool seq_running = rfswitch.seq_running;
+    int seq_step = seq_running ? rfswitch.seq_step : -1;
+    int seq_pass = seq_running ? (int)rfswitch.seq_pass : -1;
+    restore_interrupts(irq);
+    send_json(11 + CMD_RX_STATUS_FIELDS,
         KV_STR, "sensor_name", "rfswitch",
         KV_STR, "status", "update",
         KV_INT, "app_id", app_id,
         KV_INT, "sw_state", reported,
-        KV_FLOAT, "volt_therm0", volt_therm[0],
-        KV_FLOAT, "volt_therm1", volt_therm[1],
-        KV_FLOAT, "volt_therm2", volt_therm[2]
+        KV_INT, "settled_s", settled_s,
+        KV_INT, "settled_us", settled_us,
+        KV_INT, "seq_step", seq_step,
+        KV_INT, "seq_pass", seq_pass,
+        KV_FLOAT, "volt_therm0", rfswitch.volt_therm[0],
+        KV_FLOAT, "volt_therm1", rfswitch.volt_therm[1],
+        KV_FLOAT, "volt_therm2", rfswitch.volt_therm[2],
+        CMD_RX_STATUS
     );
 }
 
 void rfswitch_op(uint8_t app_id) {
-    // Update all five address lines in one register write so the
-    // EEPROM never sees a transient intermediate address.
-    uint32_t mask = 0, vals = 0;
-    for (int i = 0; i < RFSWITCH_ADDR_LINES; i++) {
-        mask |= 1u << rfswitch_addr_pins[i];
-        if ((rfswitch.commanded_state >> i) & 0x1) {
-            vals |= 1u << rfswitch_addr_pins[i];
-        }
+    // A settle, or a sequence step that did not move the switch, goes
+    // out as a status line on the first pass after the alarm, not at the
+    // next status tick. Steps closer together than a pass share a line.
+    if (rfswitch.settled_event) {
+        rfswitch.settled_event = false;
+        rfswitch_status(app_id);
     }
-    gpio_put_masked(mask, vals);
-    if (rfswitch.in_transition && time_reached(rfswitch.transition_end)) {
-        rfswitch.reported_state = rfswitch.commanded_state;
-        rfswitch.in_transition = false;
+
+    if (time_reached(rfswitch.next_therm_sample)) {
+        rfswitch.next_therm_sample =
+            make_timeout_time_ms(RFSWITCH_THERM_SAMPLE_MS);
+        for (uint i = 0; i < RFSWITCH_NUM_THERM; i++) {
+            rfswitch.volt_therm[i] =
+                adc_sampler_voltage(rfswitch.therm_adc_input[i]);
+        }
     }
 }
@@ -6,6 +6,8 @@
 #include "pico/time.h"
 #include "hardware/gpio.h"
 #include "eigsep_command.h"
+#include "cJSON.h"
+#include "cmd_table.h"
 
 // The RF switch PCB holds two AT28BV64B EEPROMs wired as a live lookup
 // table driving three ADGM1004 switches plus the noise-diode bias: the
@@ -30,6 +32,12 @@
 #define RFSWITCH_NUM_THERM    3
 #define RFSWITCH_THERM0_GPIO  26
 
+// rfswitch_op() latches the three thermistor voltages from the ADC
+// sampler on this cadence, all in the same pass; status only serializes
+// the latched values, so emitting it costs the same whatever the ADC is
+// doing and never sits between a switch command and its settle check.
+#define RFSWITCH_THERM_SAMPLE_MS  200
+
 // Burned path table, for reference; firmware logic only needs the
 // RFSWITCH_NUM_PATHS bound. Names mirror PicoRFSwitch.PATHS in picohost.
 typedef enum {
@@ -56,21 +64,63 @@ typedef enum {
 #define SW_STATE_UNKNOWN (-1)
 
 // Covers EEPROM read access (~200 ns) plus ADGM1004 MEMS actuation
-// (~100 us) with generous margin.
-#define SWITCH_SETTLE_MS 20
+// (~100 us) with generous margin. The settle is timed by a hardware
+// alarm, not by the main loop noticing it, so this is the whole per-path
+// cost. RFSWITCH_FAST_SETTLE (-DRFSWITCH_FAST_SETTLE=ON) cuts it to 5x
+// the datasheet actuation time; the installed switches have not been
+// measured against that, so it is opt-in.
+#ifndef RFSWITCH_FAST_SETTLE
+#define RFSWITCH_FAST_SETTLE 0
+#endif
+#if RFSWITCH_FAST_SETTLE
+#define SWITCH_SETTLE_US 500
+#else
+#define SWITCH_SETTLE_US 20000
+#endif
+
 
+// Sequencer (sw_sequence): up to RFSWITCH_SEQ_LEN (state, dwell) steps,
+// run `sw_repeat` times (0: until stopped) off the settle alarm, so step
+// boundaries sit on a microsecond grid from the command, whatever the
+// host or USB is doing. A step's dwell runs from its address change, so
+// it includes the settle. A sw_sequence line must fit in BUFFER_SIZE.
+#define RFSWITCH_SEQ_LEN            16
+#define RFSWITCH_SEQ_MIN_DWELL_US   (2 * SWITCH_SETTLE_US)
+#define RFSWITCH_SEQ_MAX_DWELL_MS   3600000     // an hour; fits uint32 us
+
+typedef struct {
+    uint8_t  state;
+    uint32_t dwell_us;
+} RFSwitchStep;
 
 typedef struct {
     int commanded_state;        // path address driven to A0..A4 right now
     int reported_state;         // last state the firmware trusts as settled
     bool in_transition;         // true while waiting for settle timer
-    absolute_time_t transition_end;
+    absolute_time_t transition_end; // settle alarm target; the settle time
+                                    // once in_transition is false
+    volatile bool settled_event;    // set by the alarm, emitted by op()
+    RFSwitchStep seq[RFSWITCH_SEQ_LEN];
+    uint seq_len;
+    uint32_t seq_repeat;        // passes to run; 0 = until stopped
+    bool seq_running;
+    int seq_step;               // step on the bus; -1 before the first
+    uint32_t seq_pass;          // passes completed
+    absolute_time_t seq_next;   // start of the next step
+    uint therm_adc_input[RFSWITCH_NUM_THERM];
+    float volt_therm[RFSWITCH_NUM_THERM];   // latched; NAN until sampled
+    absolute_time_t next_therm_sample;
 } RFSwitch;
 
 // report rfswitch status
 void rfswitch_init(uint8_t);
-void rfswitch_server(uint8_t, const char *);
+void rfswitch_server(uint8_t, const cJSON *);
 void rfswitch_op(uint8_t);
 void rfswitch_status(uint8_t);
 
+// Command keys, sorted for cmd_table_dispatch() (checked by
+// host/test_cmd_table.c).
+extern const CmdKey rfswitch_keys[];
+extern const size_t rfswitch_keys_len;
+
 #endif // RFSWITCH_H
@@ -0,0 +1,123 @@
+#include "sh2.h"
+
+static uint16_t le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)le16(p) | ((uint32_t)le16(p + 2) << 16);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+void shtp_header(uint8_t *hdr, size_t payload_len, uint8_t channel,
+                 uint8_t seq) {
+    size_t len = payload_len + SHTP_HEADER_LEN;
+    hdr[0] = (uint8_t)len;
+    hdr[1] = (uint8_t)((len >> 8) & 0x7f);
+    hdr[2] = channel;
+    hdr[3] = seq;
+}
+
+size_t shtp_length(const uint8_t *hdr) {
+    return le16(hdr) & ~SHTP_CONTINUATION;
+}
+
+size_t sh2_set_feature(uint8_t *out, uint8_t report_id, uint32_t interval_us) {
+    for (int i = 0; i < SH2_SET_FEATURE_LEN; i++) {
+        out[i] = 0;
+    }
+    out[0] = SH2_SET_FEATURE;
+    out[1] = report_id;
+    /* [2] flags, [3..4] change sensitivity: none */
+    put_le32(&out[5], interval_us);
+    /* [9..12] batch interval, [13..16] sensor config: none */
+    return SH2_SET_FEATURE_LEN;
+}
+
+uint32_t sh2_interval_us(uint32_t rate_hz) {
+    return rate_hz ? 1000000u / rate_hz : 0;
+}
+
+/* Length of a report on the reports channel, 0 if unknown. */
+static size_t sh2_report_len(uint8_t id) {
+    switch (id) {
+        case SH2_BASE_TIMESTAMP:
+        case SH2_TIMESTAMP_REBASE:
+            return 5;
+        case SH2_ACCELEROMETER:
+        case 0x02:                  /* gyroscope */
+        case 0x03:                  /* magnetic field */
+        case 0x04:                  /* linear acceleration */
+        case SH2_GRAVITY:
+            return 10;
+        case 0x08:                  /* game rotation vector */
+            return 12;
+        case SH2_ROTATION_VECTOR:
+        case 0x09:                  /* geomagnetic rotation vector */
+            return 14;
+        case 0x07:                  /* uncalibrated gyroscope */
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+/* Store the report's `n` Q-format fields in s->v, with its accuracy and
+ * its age from the packet's time base. */
+static void sh2_sample(Sh2Sample *s, const uint8_t *rep, int n, int q,
+                       int32_t base_ticks) {
+    float scale = 1.0f / (float)(1 << q);
+    for (int i = 0; i < n; i++) {
+        s->v[i] = (float)(int16_t)le16(&rep[4 + 2 * i]) * scale;
+    }
+    s->accuracy = rep[2] & 0x03;
+    int32_t delay = ((rep[2] >> 2) << 8) | rep[3];
+    int32_t age = base_ticks - delay;
+    s->age_us = age > 0 ? (uint32_t)age * SH2_TICK_US : 0;
+    s->fresh = true;
+}
+
+int sh2_parse_reports(const uint8_t *buf, size_t len, Sh2Reports *out) {
+    int32_t base = 0;
+    int updated = 0;
+    size_t i = 0;
+    while (i < len) {
+        const uint8_t *rep = &buf[i];
+        size_t n = sh2_report_len(rep[0]);
+        if (n == 0 || i + n > len) {
+            break;
+        }
+        switch (rep[0]) {
+            case SH2_BASE_TIMESTAMP:
+                base = (int32_t)le32(&rep[1]);
+                break;
+            case SH2_TIMESTAMP_REBASE:
+                /* The following reports' base moves by this much */
+                base -= (int32_t)le32(&rep[1]);
+                break;
+            case SH2_ACCELEROMETER:
+                sh2_sample(&out->accel, rep, 3, 8, base);
+                updated++;
+                break;
+            case SH2_GRAVITY:
+                sh2_sample(&out->gravity, rep, 3, 8, base);
+                updated++;
+                break;
+            case SH2_ROTATION_VECTOR:
+                sh2_sample(&out->quat, rep, 4, 14, base);
+                out->quat.error_rad =
+                    (float)(int16_t)le16(&rep[12]) / (float)(1 << 12);
+                updated++;
+                break;
+            default:
+                break;
+        }
+        i += n;
+    }
+    return updated;
+}
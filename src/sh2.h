@@ -0,0 +1,78 @@
+#ifndef SH2_H
+#define SH2_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The BNO08x's SH-2 sensor hub protocol, carried in SHTP (Sensor Hub
+ * Transport Protocol) packets. This is the encoding only: imu.c moves the
+ * packets over I2C. Free of pico-sdk headers so the host tests build it.
+ *
+ * An SHTP packet is a 4-byte header (u16 length including the header, bit
+ * 15 marking a continuation; channel; per-channel sequence number) and a
+ * payload. Sensor reports arrive on SHTP_CHAN_REPORTS, each packet led by
+ * a base timestamp: how long before the packet was ready the reports'
+ * time base lies. Each report then carries its own delay after that base,
+ * so a sample's age when its packet arrived is base - delay. Both are in
+ * 100 us ticks. */
+
+#define SHTP_HEADER_LEN       4
+#define SHTP_CONTINUATION     0x8000u
+#define SHTP_CHANNELS         6
+#define SHTP_CHAN_COMMAND     0
+#define SHTP_CHAN_EXECUTABLE  1
+#define SHTP_CHAN_CONTROL     2
+#define SHTP_CHAN_REPORTS     3
+
+#define SH2_EXEC_RESET_DONE   0x01    /* executable channel: booted */
+#define SH2_SET_FEATURE       0xFD    /* control channel */
+#define SH2_SET_FEATURE_LEN   17
+#define SH2_BASE_TIMESTAMP    0xFB
+#define SH2_TIMESTAMP_REBASE  0xFA
+#define SH2_TICK_US           100u
+
+/* Input reports (sensor IDs) the firmware enables */
+#define SH2_ACCELEROMETER     0x01    /* calibrated, m/s^2, Q8 */
+#define SH2_ROTATION_VECTOR   0x05    /* unit quaternion Q14, error Q12 */
+#define SH2_GRAVITY           0x06    /* m/s^2, Q8 */
+
+/* Fastest report rate the firmware asks for */
+#define SH2_MAX_RATE_HZ       400
+
+/* Latest sample of one report */
+typedef struct {
+    float    v[4];         /* x, y, z; quaternions i, j, k, real */
+    float    error_rad;    /* rotation vector heading accuracy estimate */
+    uint8_t  accuracy;     /* status bits: 0 unreliable .. 3 high */
+    uint32_t age_us;       /* sample age when its packet arrived */
+    bool     fresh;        /* set by sh2_parse_reports() */
+} Sh2Sample;
+
+typedef struct {
+    Sh2Sample quat;        /* SH2_ROTATION_VECTOR */
+    Sh2Sample accel;       /* SH2_ACCELEROMETER */
+    Sh2Sample gravity;     /* SH2_GRAVITY */
+} Sh2Reports;
+
+/* Fill hdr with an SHTP header for `payload_len` bytes of payload. */
+void shtp_header(uint8_t *hdr, size_t payload_len, uint8_t channel,
+                 uint8_t seq);
+
+/* Packet length (header included) from an SHTP header. */
+size_t shtp_length(const uint8_t *hdr);
+
+/* Encode a Set Feature command for `report_id` into out[SH2_SET_FEATURE_LEN]
+ * as an SHTP_CHAN_CONTROL payload; interval_us 0 turns the report off.
+ * Returns the payload length. */
+size_t sh2_set_feature(uint8_t *out, uint8_t report_id, uint32_t interval_us);
+
+/* Report interval for a rate in Hz, 0 for off. */
+uint32_t sh2_interval_us(uint32_t rate_hz);
+
+/* Decode an SHTP_CHAN_REPORTS payload into `out`, setting `fresh` on the
+ * samples it updates. Parsing stops at a report it does not know the
+ * length of. Returns the number of samples updated. */
+int sh2_parse_reports(const uint8_t *buf, size_t len, Sh2Reports *out);
+
+#endif // SH2_H
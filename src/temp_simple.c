@@ -1,75 +1,10 @@
 #include "temp_simple.h"
-#include "hardware/adc.h"
+#include "adc_sampler.h"
 #include "pico/stdlib.h"
-#include <math.h>
 
-#define THERMISTOR_ADC_SAMPLES 16
-
-static bool adc_ready = false;
-
-bool adc_channel_init(uint gpio_pin, uint *adc_input) {
-    if (gpio_pin < 26 || gpio_pin > 29) {
-        return false;
-    }
-    *adc_input = gpio_pin - 26;
-
-    if (!adc_ready) {
-        adc_init();
-        adc_ready = true;
-    }
-    adc_gpio_init(gpio_pin);
-    return true;
-}
-
-float adc_read_avg_voltage(uint adc_input) {
-    uint32_t total = 0;
-
-    adc_select_input(adc_input);
-    (void)adc_read();  // discard first sample after mux switch
-
-    for (uint i = 0; i < THERMISTOR_ADC_SAMPLES; i++) {
-        total += adc_read();
-    }
-
-    float counts = (float)total / (float)THERMISTOR_ADC_SAMPLES;
-    return counts * THERMISTOR_SUPPLY_VOLTS / THERMISTOR_ADC_MAX_COUNTS;
-}
-
-static bool temp_sensor_voltage_to_temperature(float voltage,
-                                               float *resistance,
-                                               float *temperature) {
-    if (!isfinite(voltage) ||
-        voltage <= 0.0f ||
-        voltage >= THERMISTOR_SUPPLY_VOLTS) {
-        return false;
-    }
-
-    float r_thermistor = THERMISTOR_TOP_OHMS
-        * voltage / (THERMISTOR_SUPPLY_VOLTS - voltage);
-    if (!isfinite(r_thermistor) || r_thermistor <= 0.0f) {
-        return false;
-    }
-
-    float log_r = logf(r_thermistor / THERMISTOR_REF_OHMS);
-    float log_r_sq = log_r * log_r;
-    float inverse_kelvin = THERMISTOR_SH_A1
-        + THERMISTOR_SH_B1 * log_r
-        + THERMISTOR_SH_C1 * log_r_sq
-        + THERMISTOR_SH_D1 * log_r_sq * log_r;
-    if (!isfinite(inverse_kelvin) || inverse_kelvin <= 0.0f) {
-        return false;
-    }
-
-    // NTCLE100E3 operating range (and the fit's validity): -40..+125 C.
-    float temp_c = 1.0f / inverse_kelvin - 273.15f;
-    if (!isfinite(temp_c) || temp_c < -40.0f || temp_c > 125.0f) {
-        return false;
-    }
-
-    *resistance = r_thermistor;
-    *temperature = temp_c;
-    return true;
-}
+// Shared by every sensor; built by the first temp_sensor_init().
+static ThermistorLut thermistor_lut;
+static bool thermistor_lut_ready;
 
 void temp_sensor_init(TempSensor *sensor, uint gpio_pin) {
     sensor->gpio_pin = gpio_pin;
@@ -81,7 +16,11 @@ void temp_sensor_init(TempSensor *sensor, uint gpio_pin) {
     sensor->adc_configured = false;
     sensor->read_error = false;
 
-    if (!adc_channel_init(gpio_pin, &sensor->adc_input)) {
+    if (!thermistor_lut_ready) {
+        thermistor_lut_build(&thermistor_lut);
+        thermistor_lut_ready = true;
+    }
+    if (!adc_sampler_add_gpio(gpio_pin, &sensor->adc_input)) {
         sensor->read_error = true;
         return;
     }
@@ -94,20 +33,19 @@ bool temp_sensor_read(TempSensor *sensor) {
         return false;
     }
 
-    float voltage = adc_read_avg_voltage(sensor->adc_input);
+    float voltage = adc_sampler_voltage(sensor->adc_input);
     // Store the measured voltage unconditionally: when the plausibility
     // conversion below fails, the railed/implausible voltage is exactly
     // the field diagnostic (≈supply → open thermistor, ≈0 → short), so
     // it must reach status output instead of freezing at last-good.
     sensor->voltage = voltage;
-    float resistance = 0.0f;
     float temperature = 0.0f;
-    if (!temp_sensor_voltage_to_temperature(voltage, &resistance, &temperature)) {
+    if (!thermistor_lut_temperature(&thermistor_lut, voltage, &temperature)) {
         sensor->read_error = true;
         return false;
     }
 
-    sensor->resistance = resistance;
+    sensor->resistance = thermistor_resistance(voltage);
     sensor->temperature = temperature;
     sensor->last_sample_time = to_ms_since_boot(get_absolute_time());
     sensor->read_error = false;
@@ -1,10 +1,12 @@
 #include "tempctrl.h"
+#include "cmd_rx.h"
 #include "temp_simple.h"
 #include "pico/stdlib.h"
 #include "hardware/pwm.h"
 #include "cJSON.h"
 #include <stdlib.h>
 #include <string.h>
+#include <float.h>
 #include <math.h>
 
 // Static instances
@@ -44,6 +46,10 @@ static void init_single_tempctrl(TempControl *tempctrl,
     pwm_init(tempctrl->pwm_slice, config, true);
 
     temp_sensor_init(&tempctrl->temp_sensor, temp_sensor_pin);
+    adc_sampler_set_oversample(tempctrl->temp_sensor.adc_input,
+                               TEMPCTRL_ADC_OVERSAMPLE);
+    adc_sampler_set_median(tempctrl->temp_sensor.adc_input,
+                           TEMPCTRL_ADC_MEDIAN);
 
     // Initialize Temperature Control structure. Ki defaults to 0 so an
     // un-tuned deployment behaves as pure P + deadband (no integral
@@ -92,11 +98,112 @@ void tempctrl_init(uint8_t app_id) {
     next_sensor_sample = get_absolute_time();  // first op tick samples
 }
 
-void tempctrl_server(uint8_t app_id, const char *json_str) {
-    cJSON *item_json;
-    cJSON *root = cJSON_Parse(json_str);
-    if (!root || !cJSON_IsObject(root)) {
-        cJSON_Delete(root);
+// Command setters, one per key (tempctrl_keys below); ctx is the
+// channel, and the value is already checked by cmd_table_dispatch().
+static void set_temp_target(void *ctx, double v) {
+    ((TempControl *)ctx)->T_target = (float)v;
+}
+
+static void set_installed(void *ctx, double v) {
+    TempControl *tempctrl = ctx;
+    tempctrl->installed = v != 0;
+    adc_sampler_set_active(tempctrl->temp_sensor.adc_input,
+                           tempctrl->installed);
+}
+
+static void set_enable(void *ctx, double v) {
+    tempctrl_apply_enable(ctx, v != 0);
+}
+
+static void set_hysteresis(void *ctx, double v) {
+    ((TempControl *)ctx)->hysteresis = (float)v;
+}
+
+static void set_clamp(void *ctx, double v) {
+    ((TempControl *)ctx)->clamp = (float)v;
+}
+
+static void set_kp(void *ctx, double v) {
+    ((TempControl *)ctx)->Kp = (float)v;
+}
+
+static void set_ki(void *ctx, double v) {
+    TempControl *tempctrl = ctx;
+    float new_ki = (float)v;
+    if (new_ki != tempctrl->Ki) {
+        /* Bumpless retune: drop the accumulator so the next PI step
+           does not multiply a stale integral by a freshly-changed
+           gain. */
+        tempctrl->integral = 0.0f;
+        tempctrl->last_sample_ms = 0;
+    }
+    tempctrl->Ki = new_ki;
+}
+
+static void set_integral_reset(void *ctx, double v) {
+    TempControl *tempctrl = ctx;
+    if (v != 0) {
+        tempctrl->integral = 0.0f;
+        tempctrl->last_sample_ms = 0;
+    }
+}
+
+static void set_cooling_enabled(void *ctx, double v) {
+    ((TempControl *)ctx)->cooling_enabled = v != 0;
+}
+
+// An oversample the sampler cannot do (not a multiple of 64 in
+// 64..1024) is ignored, leaving the filter as it was.
+static void set_adc_oversample(void *ctx, double v) {
+    adc_sampler_set_oversample(((TempControl *)ctx)->temp_sensor.adc_input,
+                               (int)v);
+}
+
+static void set_adc_median(void *ctx, double v) {
+    adc_sampler_set_median(((TempControl *)ctx)->temp_sensor.adc_input,
+                           v != 0);
+}
+
+// Watchdog timeout (0 = disabled); negatives clamp to 0.
+static void set_watchdog_timeout(void *ctx, double v) {
+    (void)ctx;
+    watchdog_timeout_ms = (uint32_t)v;
+}
+
+#define TEMPCTRL_KEYS(prefix, channel)                                      \
+    { prefix "Ki", CMD_FLOAT, CMD_CLAMP, 0, FLT_MAX, set_ki, channel },     \
+    { prefix "Kp", CMD_FLOAT, CMD_CLAMP, 0, FLT_MAX, set_kp, channel },     \
+    { prefix "adc_median", CMD_BOOL, CMD_CLAMP, 0, 1,                       \
+      set_adc_median, channel },                                            \
+    { prefix "adc_oversample", CMD_INT, CMD_REJECT, ADC_SAMPLER_BLOCK,      \
+      ADC_SAMPLER_MAX_BLOCKS * ADC_SAMPLER_BLOCK,                           \
+      set_adc_oversample, channel },                                        \
+    { prefix "clamp", CMD_FLOAT, CMD_CLAMP, 0, 1, set_clamp, channel },     \
+    { prefix "cooling_enabled", CMD_BOOL, CMD_CLAMP, 0, 1,                  \
+      set_cooling_enabled, channel },                                       \
+    { prefix "enable", CMD_BOOL, CMD_CLAMP, 0, 1, set_enable, channel },    \
+    { prefix "hysteresis", CMD_FLOAT, CMD_CLAMP, 0,                         \
+      TEMPCTRL_HYSTERESIS_MAX_C, set_hysteresis, channel },                 \
+    { prefix "installed", CMD_BOOL, CMD_CLAMP, 0, 1,                        \
+      set_installed, channel },                                             \
+    { prefix "integral_reset", CMD_BOOL, CMD_CLAMP, 0, 1,                   \
+      set_integral_reset, channel },                                        \
+    { prefix "temp_target", CMD_FLOAT, CMD_CLAMP, TEMPCTRL_TARGET_MIN_C,    \
+      TEMPCTRL_TARGET_MAX_C, set_temp_target, channel }
+
+// Sorted by key: the per-channel keys sort the same under either prefix
+// (capitals before '_' before lower case), and "LNA_" < "LOAD_" <
+// "watchdog...".
+const CmdKey tempctrl_keys[] = {
+    TEMPCTRL_KEYS("LNA_", &tempctrl_lna),
+    TEMPCTRL_KEYS("LOAD_", &tempctrl_load),
+    { "watchdog_timeout_ms", CMD_INT, CMD_CLAMP, 0, INT32_MAX,
+      set_watchdog_timeout, NULL },
+};
+const size_t tempctrl_keys_len = CMD_TABLE_LEN(tempctrl_keys);
+
+void tempctrl_server(uint8_t app_id, const cJSON *root) {
+    if (!cJSON_IsObject(root)) {
         return;
     }
 
@@ -107,75 +214,9 @@ void tempctrl_server(uint8_t app_id, const char *json_str) {
     // tempctrl_apply_enable), mirroring the stall-trip ack pattern.
     last_cmd_time = get_absolute_time();
 
-    // Parse channel selection (default to both)
-    item_json = cJSON_GetObjectItem(root, "LNA_temp_target");
-    tempctrl_lna.T_target = item_json ? item_json->valuedouble : tempctrl_lna.T_target;
-    item_json = cJSON_GetObjectItem(root, "LNA_installed");
-    if (item_json) tempctrl_lna.installed = item_json->valueint ? true : false;
-    item_json = cJSON_GetObjectItem(root, "LNA_enable");
-    if (item_json) tempctrl_apply_enable(&tempctrl_lna, item_json->valueint ? true : false);
-    item_json = cJSON_GetObjectItem(root, "LNA_hysteresis");
-    tempctrl_lna.hysteresis = item_json ? item_json->valuedouble : tempctrl_lna.hysteresis;
-    item_json = cJSON_GetObjectItem(root, "LNA_clamp");
-    if (item_json) tempctrl_lna.clamp = fminf(1.0, fmaxf(0.0, item_json->valuedouble));
-    item_json = cJSON_GetObjectItem(root, "LNA_Kp");
-    if (item_json) tempctrl_lna.Kp = item_json->valuedouble;
-    item_json = cJSON_GetObjectItem(root, "LNA_Ki");
-    if (item_json) {
-        float new_ki = (float)item_json->valuedouble;
-        if (new_ki != tempctrl_lna.Ki) {
-            /* Bumpless retune: drop the accumulator so the next PI step
-               does not multiply a stale integral by a freshly-changed
-               gain. */
-            tempctrl_lna.integral = 0.0f;
-            tempctrl_lna.last_sample_ms = 0;
-        }
-        tempctrl_lna.Ki = new_ki;
-    }
-    item_json = cJSON_GetObjectItem(root, "LNA_integral_reset");
-    if (item_json && item_json->valueint) {
-        tempctrl_lna.integral = 0.0f;
-        tempctrl_lna.last_sample_ms = 0;
-    }
-    item_json = cJSON_GetObjectItem(root, "LNA_cooling_enabled");
-    if (item_json) tempctrl_lna.cooling_enabled = item_json->valueint ? true : false;
-    item_json = cJSON_GetObjectItem(root, "LOAD_temp_target");
-    tempctrl_load.T_target = item_json ? item_json->valuedouble : tempctrl_load.T_target;
-    item_json = cJSON_GetObjectItem(root, "LOAD_installed");
-    if (item_json) tempctrl_load.installed = item_json->valueint ? true : false;
-    item_json = cJSON_GetObjectItem(root, "LOAD_enable");
-    if (item_json) tempctrl_apply_enable(&tempctrl_load, item_json->valueint ? true : false);
-    item_json = cJSON_GetObjectItem(root, "LOAD_hysteresis");
-    tempctrl_load.hysteresis = item_json ? item_json->valuedouble : tempctrl_load.hysteresis;
-    item_json = cJSON_GetObjectItem(root, "LOAD_clamp");
-    if (item_json) tempctrl_load.clamp = fminf(1.0, fmaxf(0.0, item_json->valuedouble));
-    item_json = cJSON_GetObjectItem(root, "LOAD_Kp");
-    if (item_json) tempctrl_load.Kp = item_json->valuedouble;
-    item_json = cJSON_GetObjectItem(root, "LOAD_Ki");
-    if (item_json) {
-        float new_ki = (float)item_json->valuedouble;
-        if (new_ki != tempctrl_load.Ki) {
-            tempctrl_load.integral = 0.0f;
-            tempctrl_load.last_sample_ms = 0;
-        }
-        tempctrl_load.Ki = new_ki;
-    }
-    item_json = cJSON_GetObjectItem(root, "LOAD_integral_reset");
-    if (item_json && item_json->valueint) {
-        tempctrl_load.integral = 0.0f;
-        tempctrl_load.last_sample_ms = 0;
-    }
-    item_json = cJSON_GetObjectItem(root, "LOAD_cooling_enabled");
-    if (item_json) tempctrl_load.cooling_enabled = item_json->valueint ? true : false;
-
-    // Watchdog timeout configuration (0 = disabled)
-    item_json = cJSON_GetObjectItem(root, "watchdog_timeout_ms");
-    if (item_json && cJSON_IsNumber(item_json)) {
-        int val = item_json->valueint;
-        watchdog_timeout_ms = val < 0 ? 0 : (uint32_t)val;
-    }
-
-    cJSON_Delete(root);
+    // The settings are independent of each other, so the keys apply in
+    // the line's order.
+    cmd_table_dispatch(tempctrl_keys, tempctrl_keys_len, root);
 }
 
 void tempctrl_status(uint8_t app_id) {
@@ -207,10 +248,10 @@ void tempctrl_status(uint8_t app_id) {
     const float R_load =
         tempctrl_load.data_invalid ? NAN : tempctrl_load.temp_sensor.resistance;
 
-    /* 44 KV pairs: 4 device-wide + 20 per channel * 2 channels. send_json
+    /* 48 KV pairs: 4 device-wide + 22 per channel * 2 channels. send_json
        silently truncates if the count argument disagrees with the actual
        entries — re-count when editing. */
-    send_json(44,
+    send_json(48 + CMD_RX_STATUS_FIELDS,
         KV_STR, "sensor_name", "tempctrl",
         KV_INT, "app_id", app_id,
         KV_BOOL, "watchdog_tripped", watchdog_tripped,
@@ -235,6 +276,10 @@ void tempctrl_status(uint8_t app_id) {
         KV_FLOAT, "LNA_Kp", tempctrl_lna.Kp,
         KV_FLOAT, "LNA_Ki", tempctrl_lna.Ki,
         KV_FLOAT, "LNA_integral", tempctrl_lna.integral,
+        KV_INT, "LNA_adc_oversample",
+            adc_sampler_oversample(tempctrl_lna.temp_sensor.adc_input),
+        KV_BOOL, "LNA_adc_median",
+            adc_sampler_median(tempctrl_lna.temp_sensor.adc_input),
         KV_STR, "LOAD_status", status_load,
         KV_FLOAT, "LOAD_T_now", T_load,
         KV_FLOAT, "LOAD_voltage", tempctrl_load.temp_sensor.voltage,
@@ -254,17 +299,22 @@ void tempctrl_status(uint8_t app_id) {
         KV_FLOAT, "LOAD_clamp", tempctrl_load.clamp,
         KV_FLOAT, "LOAD_Kp", tempctrl_load.Kp,
         KV_FLOAT, "LOAD_Ki", tempctrl_load.Ki,
-        KV_FLOAT, "LOAD_integral", tempctrl_load.integral
+        KV_FLOAT, "LOAD_integral", tempctrl_load.integral,
+        KV_INT, "LOAD_adc_oversample",
+            adc_sampler_oversample(tempctrl_load.temp_sensor.adc_input),
+        KV_BOOL, "LOAD_adc_median",
+            adc_sampler_median(tempctrl_load.temp_sensor.adc_input),
+        CMD_RX_STATUS
     );
 }
 
 void tempctrl_update_sensor_drive(TempControl *tempctrl) {
-    // Channel hardware not present: return before temp_sensor_read so the
-    // ADC mux never selects the dead divider (multiplexed-ADC crosstalk —
-    // see the rate-guard comment below) and force drive off. data_invalid
-    // every cycle keeps the reported values null; the rate anchor drops so
-    // a later re-install re-seeds two-to-anchor, exactly like recovery
-    // from a sensor outage.
+    // Channel hardware not present: its ADC input is out of the sampler's
+    // round robin (multiplexed-ADC crosstalk — see the rate-guard comment
+    // below), so return before temp_sensor_read and force drive off.
+    // data_invalid every cycle keeps the reported values null; the rate
+    // anchor drops so a later re-install re-seeds two-to-anchor, exactly
+    // like recovery from a sensor outage.
     if (!tempctrl->installed) {
         tempctrl->data_invalid = true;
         tempctrl->rate_ref_valid = false;
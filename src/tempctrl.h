@@ -8,6 +8,8 @@
 #include "hardware/gpio.h"
 #include "eigsep_command.h"
 #include "temp_simple.h"
+#include "cJSON.h"
+#include "cmd_table.h"
 
 // LNA Temperature Control configuration
 #define TEMP_SENSOR_LNA_PIN     27  // thermistor data pin
@@ -34,6 +36,24 @@
 // or hair-triggered depending on host traffic.
 #define TEMPCTRL_SAMPLE_MS         200
 
+// Thermistor decimation filter (adc_sampler.h), per channel and settable
+// via LNA_/LOAD_adc_oversample and *_adc_median. The thermistors move in
+// seconds, so each reading spends the sampler's longest window: 1024
+// samples (~43 ms with both channels in the round robin), half the noise
+// of the sampler's 256-sample default. The median of the window's 16
+// block means, rather than their mean, keeps a crosstalk burst (see the
+// sensor sanity guard below) out of T_now instead of smearing it in.
+#define TEMPCTRL_ADC_OVERSAMPLE    1024
+#define TEMPCTRL_ADC_MEDIAN        true
+
+// Command ranges (tempctrl_keys in tempctrl.c): a value outside one is
+// clamped to it. A target the thermistor cannot read, or a deadband
+// wider than its whole range, would leave the channel uncontrollable;
+// a negative gain drives the wrong way.
+#define TEMPCTRL_TARGET_MIN_C      THERMISTOR_MIN_C
+#define TEMPCTRL_TARGET_MAX_C      THERMISTOR_MAX_C
+#define TEMPCTRL_HYSTERESIS_MAX_C  (THERMISTOR_MAX_C - THERMISTOR_MIN_C)
+
 // Stall detection: if the channel is actively driving (drive!=0) but T_now
 // fails to move by at least TEMPCTRL_STALL_MIN_DELTA over a
 // TEMPCTRL_STALL_WINDOW_MS window, the sensor or Peltier is stuck and we
@@ -105,12 +125,12 @@ typedef struct {
     // LOAD_installed; firmware never mutates it). Distinct from `enabled`
     // (drive intent for present hardware) and `cooling_enabled` (drive-
     // polarity guard): an uninstalled channel is never sampled — its ADC
-    // input is never mux-selected, so a dead divider cannot crosstalk
-    // into the live channel — and never driven, and the picohost fan-out
-    // suppresses its Redis stream entirely. Default true, so a reboot
-    // behaves exactly as before this flag existed until the host replays
-    // config. Not a trip ack: sticky latches survive uninstall and clear
-    // only via *_enable=true.
+    // input leaves the sampler's round robin, so a dead divider cannot
+    // crosstalk into the live channel — and never driven, and the picohost
+    // fan-out suppresses its Redis stream entirely. Default true, so a
+    // reboot behaves exactly as before this flag existed until the host
+    // replays config. Not a trip ack: sticky latches survive uninstall and
+    // clear only via *_enable=true.
     bool installed;
     // Per-cycle data validity (NOT a latch): true when this sample cycle
     // produced no measurement at all — the plausibility conversion failed
@@ -176,9 +196,14 @@ typedef struct {
     bool sensor_tripped;
 } TempControl;
 
+// Command keys, sorted for cmd_table_dispatch() (checked by
+// host/test_cmd_table.c).
+extern const CmdKey tempctrl_keys[];
+extern const size_t tempctrl_keys_len;
+
 // Standard app interface functions
 void tempctrl_init(uint8_t app_id);
-void tempctrl_server(uint8_t app_id, const char *json_str);
+void tempctrl_server(uint8_t app_id, const cJSON *root);
 void tempctrl_op(uint8_t app_id);
 void tempctrl_status(uint8_t app_id);
 
@@ -0,0 +1,174 @@
+#ifndef THERMISTOR_H
+#define THERMISTOR_H
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Thermistor divider math, shared by temp_simple.c and the host test.
+   Free of pico-sdk headers so it builds and is tested on a workstation
+   (host/test_thermistor.c). */
+
+// Divider: 3.3 V -> fixed resistor (in parallel with the carrier board's
+// pull-up) -> ADC pin -> thermistor -> GND, read by the RP2 ADC against
+// its 3.3 V reference (ADC_SAMPLER_VREF).
+#define THERMISTOR_SUPPLY_VOLTS       3.3f
+#define THERMISTOR_FIXED_OHMS         10680.0f
+#define THERMISTOR_BOARD_PULLUP_OHMS  4700.0f
+#define THERMISTOR_TOP_OHMS           \
+    ((THERMISTOR_FIXED_OHMS * THERMISTOR_BOARD_PULLUP_OHMS) / \
+     (THERMISTOR_FIXED_OHMS + THERMISTOR_BOARD_PULLUP_OHMS))
+
+// Vishay NTCLE100E3103 NTC, 10 kOhm at 25 C, B25/85 = 3977 K.
+// Extended Steinhart-Hart fit from the datasheet (document 29049,
+// "Mat A" coefficient row), specified for -40..+125 C:
+//   1/T = A1 + B1 ln(R/Rref) + C1 ln^2(R/Rref) + D1 ln^3(R/Rref)
+// with T in kelvin and Rref the 25 C resistance.
+#define THERMISTOR_REF_OHMS           10000.0f
+#define THERMISTOR_SH_A1              3.354016e-3f
+#define THERMISTOR_SH_B1              2.569850e-4f
+#define THERMISTOR_SH_C1              2.620131e-6f
+#define THERMISTOR_SH_D1              6.383091e-8f
+
+// NTCLE100E3 operating range (and the fit's validity).
+#define THERMISTOR_MIN_C              -40.0f
+#define THERMISTOR_MAX_C              125.0f
+
+/**
+ * @brief Divider resistance for a pin voltage, in ohms.
+ *
+ * Only meaningful for 0 < voltage < THERMISTOR_SUPPLY_VOLTS.
+ */
+static inline float thermistor_resistance(float voltage) {
+    return THERMISTOR_TOP_OHMS * voltage / (THERMISTOR_SUPPLY_VOLTS - voltage);
+}
+
+/**
+ * @brief Steinhart-Hart conversion in float: the reference the lookup
+ * table below is built from and tested against.
+ *
+ * @return false for a railed divider (voltage at or past either supply
+ * rail, open or shorted thermistor) or a temperature outside the fit's
+ * -40..+125 C; `resistance` and `temperature` are then left untouched
+ */
+static inline bool thermistor_voltage_to_temperature(float voltage,
+                                                     float *resistance,
+                                                     float *temperature) {
+    if (!isfinite(voltage) ||
+        voltage <= 0.0f ||
+        voltage >= THERMISTOR_SUPPLY_VOLTS) {
+        return false;
+    }
+
+    float r_thermistor = thermistor_resistance(voltage);
+    if (!isfinite(r_thermistor) || r_thermistor <= 0.0f) {
+        return false;
+    }
+
+    float log_r = logf(r_thermistor / THERMISTOR_REF_OHMS);
+    float log_r_sq = log_r * log_r;
+    float inverse_kelvin = THERMISTOR_SH_A1
+        + THERMISTOR_SH_B1 * log_r
+        + THERMISTOR_SH_C1 * log_r_sq
+        + THERMISTOR_SH_D1 * log_r_sq * log_r;
+    if (!isfinite(inverse_kelvin) || inverse_kelvin <= 0.0f) {
+        return false;
+    }
+
+    float temp_c = 1.0f / inverse_kelvin - 273.15f;
+    if (!isfinite(temp_c) ||
+        temp_c < THERMISTOR_MIN_C || temp_c > THERMISTOR_MAX_C) {
+        return false;
+    }
+
+    *resistance = r_thermistor;
+    *temperature = temp_c;
+    return true;
+}
+
+/* Voltage -> temperature as a table lookup. The logf and the cubic move
+   to thermistor_lut_build(), which runs once at boot; a conversion is
+   then a scale to fixed-point ADC counts, a load pair and an integer
+   interpolation.
+
+   Knots sit every 2^THERMISTOR_LUT_SHIFT ADC counts across the 12-bit
+   range and hold centi-degrees C. The curve is steepest at the cold end,
+   where one count is ~0.4 C and linear interpolation is worst: ~0.06 C
+   at 8-count spacing, well under a count (host/test_thermistor.c checks
+   the whole -40..+125 C range against the float path). */
+#define THERMISTOR_LUT_SHIFT   3        // a knot every 8 ADC counts
+#define THERMISTOR_LUT_FRAC    5        // sub-count bits of the lookup input
+#define THERMISTOR_LUT_LEN     ((4096 >> THERMISTOR_LUT_SHIFT) + 1)
+#define THERMISTOR_LUT_NONE    INT16_MIN  // knot at or past a supply rail
+// Knots are clamped to this, far outside -40..+125 C, so they fit int16.
+#define THERMISTOR_LUT_LIMIT_CC  30000
+
+typedef struct {
+    int16_t centi_c[THERMISTOR_LUT_LEN];
+} ThermistorLut;
+
+// Fixed-point ADC counts per volt of lookup input.
+#define THERMISTOR_LUT_Q_PER_VOLT \
+    (4095.0f * (float)(1 << THERMISTOR_LUT_FRAC) / THERMISTOR_SUPPLY_VOLTS)
+
+/**
+ * @brief Fill `t` from the Steinhart-Hart constants above.
+ */
+static inline void thermistor_lut_build(ThermistorLut *t) {
+    for (uint32_t k = 0; k < THERMISTOR_LUT_LEN; k++) {
+        float v = (float)(k << THERMISTOR_LUT_SHIFT)
+            * THERMISTOR_SUPPLY_VOLTS / 4095.0f;
+        t->centi_c[k] = THERMISTOR_LUT_NONE;
+        if (v <= 0.0f || v >= THERMISTOR_SUPPLY_VOLTS) {
+            continue;
+        }
+        // The fit itself, without the range check: knots just outside
+        // -40..+125 C are needed to interpolate up to the limits.
+        float log_r = logf(thermistor_resistance(v) / THERMISTOR_REF_OHMS);
+        float inverse_kelvin = THERMISTOR_SH_A1
+            + THERMISTOR_SH_B1 * log_r
+            + THERMISTOR_SH_C1 * log_r * log_r
+            + THERMISTOR_SH_D1 * log_r * log_r * log_r;
+        if (!isfinite(inverse_kelvin) || inverse_kelvin <= 0.0f) {
+            continue;
+        }
+        float cc = (1.0f / inverse_kelvin - 273.15f) * 100.0f;
+        cc = fminf(fmaxf(cc, -THERMISTOR_LUT_LIMIT_CC),
+                   THERMISTOR_LUT_LIMIT_CC);
+        t->centi_c[k] = (int16_t)lroundf(cc);
+    }
+}
+
+/**
+ * @brief Table equivalent of thermistor_voltage_to_temperature()'s
+ * temperature (the resistance is thermistor_resistance()).
+ *
+ * @param t  table filled by thermistor_lut_build()
+ * @return false under the same conditions as the float path
+ */
+static inline bool thermistor_lut_temperature(const ThermistorLut *t,
+                                              float voltage,
+                                              float *temperature) {
+    // Also rejects NaN.
+    if (!(voltage > 0.0f && voltage < THERMISTOR_SUPPLY_VOLTS)) {
+        return false;
+    }
+    const uint32_t bits = THERMISTOR_LUT_SHIFT + THERMISTOR_LUT_FRAC;
+    uint32_t q = (uint32_t)(voltage * THERMISTOR_LUT_Q_PER_VOLT);
+    uint32_t k = q >> bits;
+    int32_t t0 = t->centi_c[k];
+    int32_t t1 = t->centi_c[k + 1];
+    if (t0 == THERMISTOR_LUT_NONE || t1 == THERMISTOR_LUT_NONE) {
+        return false;
+    }
+    int32_t frac = (int32_t)(q & ((1u << bits) - 1u));
+    int32_t cc = t0 + (t1 - t0) * frac / (int32_t)(1u << bits);
+    if (cc < (int32_t)(THERMISTOR_MIN_C * 100.0f) ||
+        cc > (int32_t)(THERMISTOR_MAX_C * 100.0f)) {
+        return false;
+    }
+    *temperature = (float)cc * 0.01f;
+    return true;
+}
+
+#endif  /* THERMISTOR_H */